@@ -21,11 +21,20 @@
   02110-1301, USA.
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <sc_private.h>
 
 #ifdef SC_HAVE_SIGNAL_H
 #include <signal.h>
 #endif
+#if defined SC_ENABLE_MEMTRACK && defined SC_HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+#if defined SC_ENABLE_MEMALIGN && defined SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 typedef void        (*sc_sig_t) (int);
 
@@ -51,6 +60,9 @@ typedef struct sc_package
   int                 log_indent;
   int                 malloc_count;
   int                 free_count;
+  size_t              bytes_current;
+  size_t              bytes_peak;
+  const sc_alloc_backend_t *backend;
   int                 rc_active;
   int                 abort_mismatch;
   const char         *name;
@@ -94,7 +106,13 @@ int                 sc_trace_prio = SC_LP_STATISTICS;
 
 static int          default_malloc_count = 0;
 static int          default_free_count = 0;
+#ifdef SC_ENABLE_MEMTRACK
+static size_t       default_bytes_current = 0;
+static size_t       default_bytes_peak = 0;
+#endif
 static int          default_rc_active = 0;
+static const sc_alloc_backend_t *default_backend = NULL;
+static const sc_alloc_backend_t *sc_global_backend = NULL;
 static int          default_abort_mismatch = 1;
 
 static int          sc_identifier = -1;
@@ -305,8 +323,258 @@ sc_free_count (int package)
   return &sc_packages[package].free_count;
 }
 
+/** Return the allocator backend of a package or NULL for the built-in. */
+static inline const sc_alloc_backend_t *
+sc_alloc_backend (int package)
+{
+  const sc_alloc_backend_t *backend;
+
+  if (package == -1) {
+    backend = default_backend;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    backend = sc_packages[package].backend;
+  }
+  return backend != NULL ? backend : sc_global_backend;
+}
+
+/** Add to an allocation counter without taking the package lock.
+ * With the compiler's atomic builtins the update is lock-free and
+ * scales with the number of threads allocating concurrently.
+ * Otherwise we fall back to an OpenMP atomic or the package mutex.
+ */
+static inline void
+sc_memory_count_add (int package, int *counter, int toadd)
+{
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  (void) __atomic_fetch_add (counter, toadd, __ATOMIC_RELAXED);
+#elif defined SC_ENABLE_OPENMP
+#pragma omp atomic
+  *counter += toadd;
+#elif defined SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+  *counter += toadd;
+  sc_package_unlock (package);
+#else
+  *counter += toadd;
+#endif
+}
+
+/** Read an allocation counter that may be updated concurrently. */
+static inline int
+sc_memory_count_get (const int *counter)
+{
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (counter, __ATOMIC_RELAXED);
+#else
+  return *(volatile const int *) counter;
+#endif
+}
+
+#if defined SC_ENABLE_MEMALIGN && \
+  !(defined SC_HAVE_ANY_MEMALIGN && \
+    (defined SC_HAVE_POSIX_MEMALIGN || defined SC_HAVE_ALIGNED_ALLOC))
+/* sc_malloc_aligned stores the requested size in front of each block */
+#define SC_MEMALIGN_HEADER
+#if defined SC_HAVE_MMAP && defined SC_HAVE_MREMAP && \
+  defined SC_HAVE_SYS_MMAN_H && defined MAP_ANONYMOUS && \
+  defined MREMAP_MAYMOVE
+/* large blocks are mapped directly and grow by remapping their pages */
+#define SC_MEMALIGN_MMAP
+#define SC_MEMALIGN_MMAP_BYTES ((size_t) 1 << 25)
+#endif
+#endif
+
+#ifdef SC_ENABLE_MEMTRACK
+
+/** Return the number of bytes we account for a block from sc_malloc.
+ * We ask the backend if there is one, then use the size stored by the
+ * aligned allocator, otherwise the usable size reported by the system.
+ */
+static size_t
+sc_memory_block_size (const sc_alloc_backend_t * backend, void *ptr)
+{
+  if (ptr == NULL) {
+    return 0;
+  }
+  if (backend != NULL) {
+    return backend->size != NULL ? backend->size (ptr, backend->user) : 0;
+  }
+#if defined SC_MEMALIGN_HEADER
+  return (size_t) ((char **) ptr)[-2];
+#elif defined SC_HAVE_MALLOC_USABLE_SIZE
+  return malloc_usable_size (ptr);
+#else
+  return 0;
+#endif
+}
+
+/** Update the live and peak byte counts of a package. */
+static void
+sc_memory_bytes_update (int package, size_t allocated, size_t freed)
+{
+  size_t             *current, *peak;
+  size_t              now;
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  size_t              seen;
+#endif
+
+  if (package == -1) {
+    current = &default_bytes_current;
+    peak = &default_bytes_peak;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    current = &sc_packages[package].bytes_current;
+    peak = &sc_packages[package].bytes_peak;
+  }
+
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  /* the unsigned addition wraps around correctly for a net decrease */
+  now = __atomic_add_fetch (current, allocated - freed, __ATOMIC_RELAXED);
+  seen = __atomic_load_n (peak, __ATOMIC_RELAXED);
+  while (now > seen &&
+         !__atomic_compare_exchange_n (peak, &seen, now, 1,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    /* seen has been updated with the concurrent peak */
+  }
+#elif defined SC_ENABLE_OPENMP
+#pragma omp critical (sc_memory_bytes)
+  {
+    now = *current += allocated - freed;
+    *peak = SC_MAX (*peak, now);
+  }
+#else
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_lock (package);
+#endif
+  now = *current += allocated - freed;
+  *peak = SC_MAX (*peak, now);
+#ifdef SC_ENABLE_PTHREAD
+  sc_package_unlock (package);
+#endif
+#endif
+}
+
+#endif /* SC_ENABLE_MEMTRACK */
+
 #ifdef SC_ENABLE_MEMALIGN
 
+#ifdef SC_MEMALIGN_HEADER
+
+/** Return the number of raw bytes that hold an aligned block. */
+static size_t
+sc_memalign_alloc_size (size_t alignment, size_t size)
+{
+  return 2 * sizeof (char **) + size + alignment;
+}
+
+/** Return the offset of the aligned data behind the header. */
+static ptrdiff_t
+sc_memalign_shift (const char *alloc_ptr, size_t alignment)
+{
+  const ptrdiff_t     extrasize = (ptrdiff_t) (2 * sizeof (char **));
+  const ptrdiff_t     signalign = (ptrdiff_t) alignment;
+  ptrdiff_t           modu;
+
+  modu = ((ptrdiff_t) alloc_ptr + extrasize) % signalign;
+  return (signalign - modu) % signalign;
+}
+
+#ifdef SC_MEMALIGN_MMAP
+
+/** Return the length of the mapping for a number of raw bytes. */
+static size_t
+sc_memalign_map_length (size_t alloc_size)
+{
+  long                page = sysconf (_SC_PAGESIZE);
+  size_t              unit = page > 0 ? (size_t) page : 4096;
+
+  return (alloc_size + unit - 1) / unit * unit;
+}
+
+#endif
+
+/** Obtain the raw memory for an aligned block of a given size.
+ * Blocks of at least SC_MEMALIGN_MMAP_BYTES are mapped anonymously,
+ * such that sc_realloc_aligned can grow them with mremap (2).
+ */
+static char        *
+sc_memalign_raw_alloc (size_t alignment, size_t size)
+{
+  const size_t        alloc_size = sc_memalign_alloc_size (alignment, size);
+#ifdef SC_MEMALIGN_MMAP
+  char               *p;
+
+  if (size >= SC_MEMALIGN_MMAP_BYTES) {
+    p = (char *) mmap (NULL, sc_memalign_map_length (alloc_size),
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1, 0);
+    return p != (char *) MAP_FAILED ? p : NULL;
+  }
+#endif
+  return (char *) malloc (alloc_size);
+}
+
+/** Release the raw memory of an aligned block of a given size. */
+static void
+sc_memalign_raw_free (char *alloc_ptr, size_t alignment, size_t size)
+{
+#ifdef SC_MEMALIGN_MMAP
+  if (size >= SC_MEMALIGN_MMAP_BYTES) {
+    SC_CHECK_ABORT (munmap (alloc_ptr, sc_memalign_map_length
+                            (sc_memalign_alloc_size (alignment, size))) == 0,
+                    "Memory unmapping");
+    return;
+  }
+#endif
+  free (alloc_ptr);
+}
+
+/** Place an aligned block into raw memory and write its header. */
+static char        *
+sc_memalign_place (char *alloc_ptr, size_t alignment, size_t size)
+{
+  /* We pad to achieve alignment, then write the original pointer and data
+   * size up front, then the real data shifted by at most alignment - 1
+   * bytes.  This way there is always at least one stop byte at the end that
+   * we can use for debugging. */
+  const ptrdiff_t     extrasize = (ptrdiff_t) (2 * sizeof (char **));
+  char               *ptr;
+  ptrdiff_t           shift;
+
+  /* compute shift to the right where we put the actual data */
+  shift = sc_memalign_shift (alloc_ptr, alignment);
+  SC_ASSERT (0 <= shift && shift < (ptrdiff_t) alignment);
+
+  /* make sure the resulting pointer is fine */
+  ptr = alloc_ptr + (extrasize + shift);
+  SC_ASSERT ((ptrdiff_t) ptr % (ptrdiff_t) alignment == 0);
+
+  /* memorize the original pointer that we got from malloc and fill up */
+  SC_ARG_ALIGN (ptr, char *, SC_MEMALIGN_BYTES);
+
+  /* remember parameters of allocation for later use */
+  ((char **) ptr)[-1] = alloc_ptr;
+  ((char **) ptr)[-2] = (char *) size;
+#ifdef SC_ENABLE_DEBUG
+  {
+    const ptrdiff_t     signalign = (ptrdiff_t) alignment;
+
+    memset (alloc_ptr, (char) -2, shift);
+    SC_ASSERT (ptr + ((ptrdiff_t) size + signalign - shift) ==
+               alloc_ptr + sc_memalign_alloc_size (alignment, size));
+    memset (ptr + size, (char) -2, signalign - shift);
+  }
+#endif
+
+  /* and we are done */
+  return ptr;
+}
+
+#endif /* SC_MEMALIGN_HEADER */
+
 /* *INDENT-OFF* */
 static void        *
 sc_malloc_aligned (size_t alignment, size_t size)
@@ -353,43 +621,11 @@ sc_malloc_aligned (size_t alignment, size_t size)
     datastart += shift;
     return (void *) datastart;
 #endif
-    /* We pad to achieve alignment, then write the original pointer and data
-     * size up front, then the real data shifted by at most alignment - 1
-     * bytes.  This way there is always at least one stop byte at the end that
-     * we can use for debugging. */
-    const ptrdiff_t     extrasize = (ptrdiff_t) (2 * sizeof (char **));
-    const ptrdiff_t     signalign = (ptrdiff_t) alignment;
-    const size_t        alloc_size = extrasize + size + alignment;
-    char               *alloc_ptr = (char *) malloc (alloc_size);
-    char               *ptr;
-    ptrdiff_t           shift, modu;
+    /* the raw memory comes from malloc or, for large blocks, from mmap */
+    char               *alloc_ptr = sc_memalign_raw_alloc (alignment, size);
 
     SC_CHECK_ABORT (alloc_ptr != NULL, "Returned NULL from malloc");
-
-    /* compute shift to the right where we put the actual data */
-    modu = ((ptrdiff_t) alloc_ptr + extrasize) % signalign;
-    shift = (signalign - modu) % signalign;
-    SC_ASSERT (0 <= shift && shift < signalign);
-
-    /* make sure the resulting pointer is fine */
-    ptr = alloc_ptr + (extrasize + shift);
-    SC_ASSERT ((ptrdiff_t) ptr % signalign == 0);
-
-    /* memorize the original pointer that we got from malloc and fill up */
-    SC_ARG_ALIGN (ptr, char *, SC_MEMALIGN_BYTES);
-
-    /* remember parameters of allocation for later use */
-    ((char **) ptr)[-1] = alloc_ptr;
-    ((char **) ptr)[-2] = (char *) size;
-#ifdef SC_ENABLE_DEBUG
-    memset (alloc_ptr, (char) -2, shift);
-    SC_ASSERT (ptr + ((ptrdiff_t) size + signalign - shift) ==
-               alloc_ptr + alloc_size);
-    memset (ptr + size, (char) -2, signalign - shift);
-#endif
-
-    /* and we are done */
-    return (void *) ptr;
+    return (void *) sc_memalign_place (alloc_ptr, alignment, size);
   }
 #endif
 }
@@ -416,10 +652,11 @@ sc_free_aligned (void *ptr, size_t alignment)
 #endif
     /* this mirrors the function sc_malloc_aligned above */
     char               *alloc_ptr;
+    size_t              size;
 #ifdef SC_ENABLE_DEBUG
     const ptrdiff_t     extrasize = (ptrdiff_t) (2 * sizeof (char **));
     const ptrdiff_t     signalign = (ptrdiff_t) alignment;
-    ptrdiff_t           shift, modu, ssize, i;
+    ptrdiff_t           shift, ssize, i;
 #endif
 
     /* we excluded these cases earlier */
@@ -427,13 +664,13 @@ sc_free_aligned (void *ptr, size_t alignment)
     SC_ASSERT ((ptrdiff_t) ptr % signalign == 0);
 
     alloc_ptr = ((char **) ptr)[-1];
+    size = (size_t) ((char **) ptr)[-2];
     SC_ASSERT (alloc_ptr != NULL);
 
 #ifdef SC_ENABLE_DEBUG
     /* compute shift to the right where we put the actual data */
-    ssize = (ptrdiff_t) ((char **) ptr)[-2];
-    modu = ((ptrdiff_t) alloc_ptr + extrasize) % signalign;
-    shift = (signalign - modu) % signalign;
+    ssize = (ptrdiff_t) size;
+    shift = sc_memalign_shift (alloc_ptr, alignment);
     SC_ASSERT (0 <= shift && shift < signalign);
     SC_ASSERT ((char *) ptr == alloc_ptr + (extrasize + shift));
     for (i = 0; i < shift; ++i) {
@@ -445,7 +682,7 @@ sc_free_aligned (void *ptr, size_t alignment)
 #endif
 
     /* free the original pointer */
-    free (alloc_ptr);
+    sc_memalign_raw_free (alloc_ptr, alignment, size);
   }
 #endif
 }
@@ -467,14 +704,33 @@ sc_realloc_aligned (void *ptr, size_t alignment, size_t size)
 
 #if defined SC_HAVE_ANY_MEMALIGN && \
    (defined SC_HAVE_POSIX_MEMALIGN || defined SC_HAVE_ALIGNED_ALLOC)
-  /* the result is no longer aligned */
-  return realloc (ptr, size);
+  {
+    void               *new_ptr, *data;
+
+    /* the system realloc usually keeps the alignment */
+    new_ptr = realloc (ptr, size);
+    SC_CHECK_ABORT (new_ptr != NULL, "Returned NULL from realloc");
+    if ((uintptr_t) new_ptr % alignment == 0) {
+      return new_ptr;
+    }
+
+    /* otherwise we copy once more into aligned memory */
+    data = sc_malloc_aligned (alignment, size);
+    memcpy (data, new_ptr, size);
+    free (new_ptr);
+    return data;
+  }
 #else
   {
+    /* We resize the raw memory in place where possible and only move the
+     * data if the new raw memory has a different shift to alignment. */
+    const ptrdiff_t     extrasize = (ptrdiff_t) (2 * sizeof (char **));
 #ifdef SC_ENABLE_DEBUG
     const ptrdiff_t     signalign = (ptrdiff_t) alignment;
 #endif
     size_t              old_size, min_size;
+    ptrdiff_t           old_shift, new_shift;
+    char               *alloc_ptr, *new_alloc;
     void               *new_ptr;
 
     /* we excluded these cases earlier */
@@ -482,20 +738,53 @@ sc_realloc_aligned (void *ptr, size_t alignment, size_t size)
     SC_ASSERT ((ptrdiff_t) ptr % signalign == 0);
 
     /* back out the previously allocated size */
+    alloc_ptr = ((char **) ptr)[-1];
     old_size = (size_t) ((char **) ptr)[-2];
+    old_shift = (char *) ptr - (alloc_ptr + extrasize);
+    min_size = SC_MIN (old_size, size);
 
-    /* create new memory while the old memory is still around */
-    new_ptr = sc_malloc_aligned (alignment, size);
+#ifdef SC_MEMALIGN_MMAP
+    if ((old_size >= SC_MEMALIGN_MMAP_BYTES) !=
+        (size >= SC_MEMALIGN_MMAP_BYTES)) {
+      /* crossing between malloc and mmap takes one copy */
+      new_ptr = sc_malloc_aligned (alignment, size);
+      memcpy (new_ptr, ptr, min_size);
+#ifdef SC_ENABLE_DEBUG
+      memset ((char *) new_ptr + min_size, (char) -3, size - min_size);
+#endif
+      sc_free_aligned (ptr, alignment);
+      return new_ptr;
+    }
+    if (size >= SC_MEMALIGN_MMAP_BYTES) {
+      /* the kernel moves the pages of a mapping without copying */
+      new_alloc = (char *) mremap
+        (alloc_ptr,
+         sc_memalign_map_length (sc_memalign_alloc_size (alignment,
+                                                          old_size)),
+         sc_memalign_map_length (sc_memalign_alloc_size (alignment, size)),
+         MREMAP_MAYMOVE);
+      SC_CHECK_ABORTF (new_alloc != (char *) MAP_FAILED,
+                       "Insufficient memory (mremap size %llu)",
+                       (long long unsigned) size);
+    }
+    else
+#endif
+    {
+      new_alloc = (char *) realloc (alloc_ptr,
+                                    sc_memalign_alloc_size (alignment, size));
+      SC_CHECK_ABORT (new_alloc != NULL, "Returned NULL from realloc");
+    }
 
-    /* copy data */
-    min_size = SC_MIN (old_size, size);
-    memcpy (new_ptr, ptr, min_size);
+    /* the data stays put unless the shift to alignment has changed */
+    new_shift = sc_memalign_shift (new_alloc, alignment);
+    if (new_shift != old_shift) {
+      memmove (new_alloc + extrasize + new_shift,
+               new_alloc + extrasize + old_shift, min_size);
+    }
+    new_ptr = sc_memalign_place (new_alloc, alignment, size);
 #ifdef SC_ENABLE_DEBUG
     memset ((char *) new_ptr + min_size, (char) -3, size - min_size);
 #endif
-
-    /* free old memory and return new pointer */
-    sc_free_aligned (ptr, alignment);
     return new_ptr;
   }
 #endif
@@ -508,30 +797,32 @@ sc_malloc (int package, size_t size)
 {
   void               *ret;
   int                *malloc_count = sc_malloc_count (package);
+  const sc_alloc_backend_t *backend = sc_alloc_backend (package);
 
   /* allocate memory */
+  if (backend != NULL) {
+    ret = backend->alloc (size, backend->user);
+    SC_CHECK_ABORTF (ret != NULL || size == 0,
+                     "Allocation (backend size %lli)", (long long int) size);
+  }
+  else {
 #if defined SC_ENABLE_MEMALIGN
-  ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, size);
+    ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, size);
 #else
-  ret = malloc (size);
-  if (size > 0) {
-    SC_CHECK_ABORTF (ret != NULL, "Allocation (malloc size %lli)",
-                     (long long int) size);
-  }
+    ret = malloc (size);
+    if (size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (malloc size %lli)",
+                       (long long int) size);
+    }
 #endif
+  }
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  if (size > 0) {
-    ++*malloc_count;
+  if (size > 0 || ret != NULL) {
+    sc_memory_count_add (package, malloc_count, 1);
   }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
-  }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
+#ifdef SC_ENABLE_MEMTRACK
+  sc_memory_bytes_update (package, sc_memory_block_size (backend, ret), 0);
 #endif
 
   return ret;
@@ -542,31 +833,37 @@ sc_calloc (int package, size_t nmemb, size_t size)
 {
   void               *ret;
   int                *malloc_count = sc_malloc_count (package);
+  const sc_alloc_backend_t *backend = sc_alloc_backend (package);
 
   /* allocate memory */
+  if (backend != NULL) {
+    ret = backend->alloc (nmemb * size, backend->user);
+    SC_CHECK_ABORTF (ret != NULL || nmemb * size == 0,
+                     "Allocation (backend size %lli)",
+                     (long long int) (nmemb * size));
+    if (ret != NULL) {
+      memset (ret, 0, nmemb * size);
+    }
+  }
+  else {
 #if defined SC_ENABLE_MEMALIGN
-  ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
-  memset (ret, 0, nmemb * size);
+    ret = sc_malloc_aligned (SC_MEMALIGN_BYTES, nmemb * size);
+    memset (ret, 0, nmemb * size);
 #else
-  ret = calloc (nmemb, size);
-  if (nmemb * size > 0) {
-    SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
-                     (long long int) size);
-  }
+    ret = calloc (nmemb, size);
+    if (nmemb * size > 0) {
+      SC_CHECK_ABORTF (ret != NULL, "Allocation (calloc size %lli)",
+                       (long long int) size);
+    }
 #endif
+  }
 
   /* count the allocations */
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_lock (package);
-#endif
-  if (nmemb * size > 0) {
-    ++*malloc_count;
-  }
-  else {
-    *malloc_count += ((ret == NULL) ? 0 : 1);
+  if (nmemb * size > 0 || ret != NULL) {
+    sc_memory_count_add (package, malloc_count, 1);
   }
-#ifdef SC_ENABLE_PTHREAD
-  sc_package_unlock (package);
+#ifdef SC_ENABLE_MEMTRACK
+  sc_memory_bytes_update (package, sc_memory_block_size (backend, ret), 0);
 #endif
 
   return ret;
@@ -584,13 +881,28 @@ sc_realloc (int package, void *ptr, size_t size)
   }
   else {
     void               *ret;
+    const sc_alloc_backend_t *backend = sc_alloc_backend (package);
+#ifdef SC_ENABLE_MEMTRACK
+    size_t              old_size = sc_memory_block_size (backend, ptr);
+#endif
 
+    if (backend != NULL) {
+      ret = backend->realloc (ptr, size, backend->user);
+      SC_CHECK_ABORTF (ret != NULL, "Reallocation (backend size %lli)",
+                       (long long int) size);
+    }
+    else {
 #if defined SC_ENABLE_MEMALIGN
-    ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
+      ret = sc_realloc_aligned (ptr, SC_MEMALIGN_BYTES, size);
 #else
-    ret = realloc (ptr, size);
-    SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
-                     (long long int) size);
+      ret = realloc (ptr, size);
+      SC_CHECK_ABORTF (ret != NULL, "Reallocation (realloc size %lli)",
+                       (long long int) size);
+#endif
+    }
+#ifdef SC_ENABLE_MEMTRACK
+    sc_memory_bytes_update (package, sc_memory_block_size (backend, ret),
+                            old_size);
 #endif
 
     return ret;
@@ -617,6 +929,8 @@ sc_strdup (int package, const char *s)
 void
 sc_free (int package, void *ptr)
 {
+  const sc_alloc_backend_t *backend;
+
   if (ptr == NULL) {
     return;
   }
@@ -624,16 +938,18 @@ sc_free (int package, void *ptr)
     /* uncount the allocations */
     int                *free_count = sc_free_count (package);
 
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_lock (package);
-#endif
-    ++*free_count;
-#ifdef SC_ENABLE_PTHREAD
-    sc_package_unlock (package);
+    backend = sc_alloc_backend (package);
+    sc_memory_count_add (package, free_count, 1);
+#ifdef SC_ENABLE_MEMTRACK
+    sc_memory_bytes_update (package, 0, sc_memory_block_size (backend, ptr));
 #endif
   }
 
   /* free memory */
+  if (backend != NULL) {
+    backend->free (ptr, backend->user);
+    return;
+  }
 #if defined SC_ENABLE_MEMALIGN
   sc_free_aligned (ptr, SC_MEMALIGN_BYTES);
 #else
@@ -641,18 +957,426 @@ sc_free (int package, void *ptr)
 #endif
 }
 
+#ifdef SC_ENABLE_MEMPROF
+
+/** Capacity of the site table, must be a power of two. */
+#define SC_MEMPROF_SITES 4096
+
+/** Number of sites per rank entering the report. */
+#define SC_MEMPROF_TOP 16
+
+/** Statistics of one allocation site. */
+typedef struct sc_memprof_site
+{
+  const char         *file;     /**< file name, NULL for an empty slot */
+  int                 line;     /**< line number */
+  double              samples;  /**< number of samples taken */
+  double              bytes;    /**< estimated bytes allocated */
+  double              calls;    /**< estimated number of calls */
+}
+sc_memprof_site_t;
+
+/** A site record in the report, which is communicated as bytes. */
+typedef struct sc_memprof_record
+{
+  char                site[BUFSIZ / 64];
+  double              samples;
+  double              bytes;
+  double              calls;
+}
+sc_memprof_record_t;
+
+static size_t       sc_memprof_interval = 512 * 1024;
+static size_t       sc_memprof_total = 0;
+static double       sc_memprof_dropped = 0.;
+static sc_memprof_site_t sc_memprof_sites[SC_MEMPROF_SITES];
+
+#ifdef SC_ENABLE_PTHREAD
+static pthread_mutex_t sc_memprof_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/** Add one or more samples to the table entry of a site. */
+static void
+sc_memprof_record (const char *file, int line, size_t size, size_t samples)
+{
+  const double        bytes = (double) samples * sc_memprof_interval;
+  size_t              hash, probe;
+  sc_memprof_site_t  *site;
+
+  /* the file names are string literals, so we hash the pointer */
+  hash = ((size_t) file >> 3) * 31 + (size_t) line * 2654435761U;
+
+#if defined SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_memprof_mutex);
+#elif defined SC_ENABLE_OPENMP
+#pragma omp critical (sc_memprof)
+#endif
+  {
+    for (probe = 0; probe < SC_MEMPROF_SITES; ++probe) {
+      site = sc_memprof_sites + ((hash + probe) & (SC_MEMPROF_SITES - 1));
+      if (site->file == NULL) {
+        site->file = file;
+        site->line = line;
+        break;
+      }
+      if (site->file == file && site->line == line) {
+        break;
+      }
+    }
+    if (probe < SC_MEMPROF_SITES) {
+      /* each sample stands for one interval of the allocated bytes */
+      site->samples += (double) samples;
+      site->bytes += bytes;
+      site->calls += size > 0 ? bytes / (double) size : (double) samples;
+    }
+    else {
+      sc_memprof_dropped += bytes;
+    }
+  }
+#if defined SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_memprof_mutex);
+#endif
+}
+
+/** Sample an allocation each time the total crosses the interval. */
+static void
+sc_memprof_sample (const char *file, int line, size_t size)
+{
+  const size_t        interval = sc_memprof_interval;
+  size_t              before, samples;
+
+  if (interval == 0) {
+    return;
+  }
+
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  before = __atomic_fetch_add (&sc_memprof_total, size, __ATOMIC_RELAXED);
+#elif defined SC_ENABLE_OPENMP
+#pragma omp atomic capture
+  {
+    before = sc_memprof_total;
+    sc_memprof_total += size;
+  }
+#else
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&sc_memprof_mutex);
+#endif
+  before = sc_memprof_total;
+  sc_memprof_total += size;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&sc_memprof_mutex);
+#endif
+#endif
+
+  /* the common case is cheap: no multiple of the interval is crossed */
+  samples = (before + size) / interval - before / interval;
+  if (samples > 0) {
+    sc_memprof_record (file, line, size, samples);
+  }
+}
+
+static int
+sc_memprof_compare_bytes (const void *v1, const void *v2)
+{
+  const double        b1 = ((const sc_memprof_record_t *) v1)->bytes;
+  const double        b2 = ((const sc_memprof_record_t *) v2)->bytes;
+
+  return b1 > b2 ? -1 : b1 < b2;
+}
+
+static int
+sc_memprof_compare_site (const void *v1, const void *v2)
+{
+  return strcmp (((const sc_memprof_record_t *) v1)->site,
+                 ((const sc_memprof_record_t *) v2)->site);
+}
+
+/** Merge records of the same site and sort them by decreasing bytes.
+ * \param [in,out] records Array of records, merged in place.
+ * \param [in] num         Number of input records.
+ * \return                 Number of merged records.
+ */
+static size_t
+sc_memprof_merge (sc_memprof_record_t * records, size_t num)
+{
+  size_t              zz, merged;
+
+  qsort (records, num, sizeof (sc_memprof_record_t),
+         sc_memprof_compare_site);
+  for (zz = 0, merged = 0; zz < num; ++zz) {
+    if (merged > 0 && !strcmp (records[merged - 1].site, records[zz].site)) {
+      records[merged - 1].samples += records[zz].samples;
+      records[merged - 1].bytes += records[zz].bytes;
+      records[merged - 1].calls += records[zz].calls;
+    }
+    else {
+      records[merged++] = records[zz];
+    }
+  }
+  qsort (records, merged, sizeof (sc_memprof_record_t),
+         sc_memprof_compare_bytes);
+
+  return merged;
+}
+
+/** Copy the site table into records sorted by decreasing bytes.
+ * Sites of the same file and line are merged, since a file name may be
+ * stored at different addresses by different compilation units.
+ * \param [out] precords   Records allocated with malloc.
+ * \return                 Number of records.
+ */
+static size_t
+sc_memprof_records (sc_memprof_record_t ** precords)
+{
+  size_t              zz, num;
+  sc_memprof_record_t *records, *r;
+
+  records = (sc_memprof_record_t *)
+    malloc (SC_MEMPROF_SITES * sizeof (sc_memprof_record_t));
+  SC_CHECK_ABORT (records != NULL, "Failed to allocate memory");
+  for (zz = 0, num = 0; zz < SC_MEMPROF_SITES; ++zz) {
+    if (sc_memprof_sites[zz].file != NULL) {
+      r = records + num++;
+      snprintf (r->site, sizeof (r->site), "%s:%d",
+                sc_memprof_sites[zz].file, sc_memprof_sites[zz].line);
+      r->samples = sc_memprof_sites[zz].samples;
+      r->bytes = sc_memprof_sites[zz].bytes;
+      r->calls = sc_memprof_sites[zz].calls;
+    }
+  }
+
+  *precords = records;
+  return sc_memprof_merge (records, num);
+}
+
+/** Log the leading records of a ranked list. */
+static void
+sc_memprof_print (int log_category, int log_priority,
+                  const sc_memprof_record_t * records, size_t num,
+                  double total)
+{
+  size_t              zz;
+
+  SC_GEN_LOGF (sc_package_id, log_category, log_priority,
+               "Allocation sites by volume (interval %llu bytes,"
+               " %.3f MiB sampled):\n",
+               (unsigned long long) sc_memprof_interval, total / 1048576.);
+  for (zz = 0; zz < SC_MIN (num, (size_t) SC_MEMPROF_TOP); ++zz) {
+    SC_GEN_LOGF (sc_package_id, log_category, log_priority,
+                 "   %5.1f%% %10.3f MiB %12.0f calls  %s\n",
+                 total > 0. ? 100. * records[zz].bytes / total : 0.,
+                 records[zz].bytes / 1048576., records[zz].calls,
+                 records[zz].site);
+  }
+}
+
+#endif /* SC_ENABLE_MEMPROF */
+
+void               *
+sc_malloc_site (int package, size_t size, const char *file, int line)
+{
+#ifdef SC_ENABLE_MEMPROF
+  sc_memprof_sample (file, line, size);
+#endif
+  return sc_malloc (package, size);
+}
+
+void               *
+sc_calloc_site (int package, size_t nmemb, size_t size,
+                const char *file, int line)
+{
+#ifdef SC_ENABLE_MEMPROF
+  sc_memprof_sample (file, line, nmemb * size);
+#endif
+  return sc_calloc (package, nmemb, size);
+}
+
+void               *
+sc_realloc_site (int package, void *ptr, size_t size,
+                 const char *file, int line)
+{
+#ifdef SC_ENABLE_MEMPROF
+  sc_memprof_sample (file, line, size);
+#endif
+  return sc_realloc (package, ptr, size);
+}
+
+void
+sc_memprof_set_interval (size_t bytes)
+{
+#ifdef SC_ENABLE_MEMPROF
+  sc_memprof_interval = bytes;
+#endif
+}
+
+void
+sc_memprof_report (int log_priority, int global)
+{
+#ifdef SC_ENABLE_MEMPROF
+  int                 mpiret, num_procs, p;
+  size_t              zz, num, all;
+  double              total;
+  sc_memprof_record_t *records, *top, *gathered;
+
+  /* report of this rank */
+  num = sc_memprof_records (&records);
+  for (zz = 0, total = sc_memprof_dropped; zz < num; ++zz) {
+    total += records[zz].bytes;
+  }
+  sc_memprof_print (SC_LC_NORMAL, log_priority, records, num, total);
+  if (sc_memprof_dropped > 0.) {
+    SC_GEN_LOGF (sc_package_id, SC_LC_NORMAL, log_priority,
+                 "   %.3f MiB of sites beyond the table capacity\n",
+                 sc_memprof_dropped / 1048576.);
+  }
+  if (!global || sc_mpicomm == sc_MPI_COMM_NULL) {
+    free (records);
+    return;
+  }
+
+  /* gather the leading sites of every rank and merge them on rank 0 */
+  mpiret = sc_MPI_Comm_size (sc_mpicomm, &num_procs);
+  SC_CHECK_MPI (mpiret);
+  top = (sc_memprof_record_t *)
+    calloc (SC_MEMPROF_TOP, sizeof (sc_memprof_record_t));
+  SC_CHECK_ABORT (top != NULL, "Failed to allocate memory");
+  memcpy (top, records,
+          SC_MIN (num, (size_t) SC_MEMPROF_TOP) *
+          sizeof (sc_memprof_record_t));
+  gathered = NULL;
+  if (sc_identifier == 0) {
+    gathered = (sc_memprof_record_t *)
+      malloc ((size_t) num_procs * SC_MEMPROF_TOP *
+              sizeof (sc_memprof_record_t));
+    SC_CHECK_ABORT (gathered != NULL, "Failed to allocate memory");
+  }
+  mpiret = sc_MPI_Gather (top, (int) sizeof (sc_memprof_record_t) *
+                          SC_MEMPROF_TOP, sc_MPI_BYTE, gathered,
+                          (int) sizeof (sc_memprof_record_t) *
+                          SC_MEMPROF_TOP, sc_MPI_BYTE, 0, sc_mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  if (sc_identifier == 0) {
+    /* drop empty records and merge the sites of all ranks */
+    for (p = 0, all = 0, total = 0.;
+         p < num_procs * SC_MEMPROF_TOP; ++p) {
+      if (gathered[p].site[0] != '\0') {
+        total += gathered[p].bytes;
+        gathered[all++] = gathered[p];
+      }
+    }
+    num = sc_memprof_merge (gathered, all);
+    SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                 "Allocation sites summed over %d ranks:\n", num_procs);
+    sc_memprof_print (SC_LC_GLOBAL, log_priority, gathered, num, total);
+    free (gathered);
+  }
+  free (top);
+  free (records);
+#endif
+}
+
 int
 sc_memory_status (int package)
 {
   sc_package_t       *p;
 
   if (package == -1) {
-    return (default_malloc_count - default_free_count);
+    return (sc_memory_count_get (&default_malloc_count) -
+            sc_memory_count_get (&default_free_count));
   }
   else {
     SC_ASSERT (sc_package_is_registered (package));
     p = sc_packages + package;
-    return (p->malloc_count - p->free_count);
+    return (sc_memory_count_get (&p->malloc_count) -
+            sc_memory_count_get (&p->free_count));
+  }
+}
+
+size_t
+sc_memory_bytes (int package)
+{
+#ifdef SC_ENABLE_MEMTRACK
+  const size_t       *current;
+
+  if (package == -1) {
+    current = &default_bytes_current;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    current = &sc_packages[package].bytes_current;
+  }
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (current, __ATOMIC_RELAXED);
+#else
+  return *(volatile const size_t *) current;
+#endif
+#else
+  return 0;
+#endif
+}
+
+size_t
+sc_memory_bytes_peak (int package)
+{
+#ifdef SC_ENABLE_MEMTRACK
+  const size_t       *peak;
+
+  if (package == -1) {
+    peak = &default_bytes_peak;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package));
+    peak = &sc_packages[package].bytes_peak;
+  }
+#if defined SC_HAVE_ATOMIC_BUILTINS
+  return __atomic_load_n (peak, __ATOMIC_RELAXED);
+#else
+  return *(volatile const size_t *) peak;
+#endif
+#else
+  return 0;
+#endif
+}
+
+void
+sc_set_alloc_backend (const sc_alloc_backend_t * backend)
+{
+#ifdef SC_ENABLE_DEBUG
+  int                 i;
+#endif
+
+  SC_ASSERT (backend == NULL || (backend->alloc != NULL &&
+                                 backend->realloc != NULL &&
+                                 backend->free != NULL));
+
+#ifdef SC_ENABLE_DEBUG
+  /* no package using the global backend may hold memory */
+  SC_ASSERT (default_backend != NULL || sc_memory_status (-1) == 0);
+  for (i = 0; i < sc_num_packages_alloc; ++i) {
+    SC_ASSERT (!sc_packages[i].is_registered ||
+               sc_packages[i].backend != NULL || sc_memory_status (i) == 0);
+  }
+#endif
+
+  sc_global_backend = backend;
+}
+
+void
+sc_package_set_alloc_backend (int package_id,
+                              const sc_alloc_backend_t * backend)
+{
+  SC_ASSERT (backend == NULL || (backend->alloc != NULL &&
+                                 backend->realloc != NULL &&
+                                 backend->free != NULL));
+  SC_ASSERT (sc_memory_status (package_id) == 0);
+
+  if (package_id == -1) {
+    default_backend = backend;
+  }
+  else {
+    SC_ASSERT (sc_package_is_registered (package_id));
+    sc_packages[package_id].backend = backend;
   }
 }
 
@@ -679,10 +1403,10 @@ sc_memory_check (int package)
   if (package == -1) {
     SC_CHECK_ABORT (default_rc_active == 0, "Leftover references (default)");
     if (default_abort_mismatch) {
-      SC_CHECK_ABORT (default_malloc_count == default_free_count,
+      SC_CHECK_ABORT (sc_memory_status (-1) == 0,
                       "Memory balance (default)");
     }
-    else if (default_malloc_count != default_free_count) {
+    else if (sc_memory_status (-1) != 0) {
       SC_GLOBAL_LERROR ("Memory balance (default)\n");
     }
   }
@@ -691,10 +1415,10 @@ sc_memory_check (int package)
     p = sc_packages + package;
     SC_CHECK_ABORTF (p->rc_active == 0, "Leftover references (%s)", p->name);
     if (p->abort_mismatch) {
-      SC_CHECK_ABORTF (p->malloc_count == p->free_count,
+      SC_CHECK_ABORTF (sc_memory_status (package) == 0,
                        "Memory balance (%s)", p->name);
     }
-    else if (p->malloc_count != p->free_count) {
+    else if (sc_memory_status (package) != 0) {
       SC_GLOBAL_LERRORF ("Memory balance (%s)\n", p->name);
     }
   }
@@ -1061,6 +1785,9 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
       p->log_indent = 0;
       p->malloc_count = 0;
       p->free_count = 0;
+      p->bytes_current = 0;
+      p->bytes_peak = 0;
+      p->backend = NULL;
       p->rc_active = 0;
       p->name = NULL;
       p->full = NULL;
@@ -1073,6 +1800,9 @@ sc_package_register (sc_log_handler_t log_handler, int log_threshold,
   new_package->log_indent = 0;
   new_package->malloc_count = 0;
   new_package->free_count = 0;
+  new_package->bytes_current = 0;
+  new_package->bytes_peak = 0;
+  new_package->backend = NULL;
   new_package->rc_active = 0;
   new_package->abort_mismatch = 1;
   new_package->name = name;
@@ -1131,6 +1861,8 @@ sc_package_unregister (int package_id)
   p->log_handler = NULL;
   p->log_threshold = SC_LP_DEFAULT;
   p->malloc_count = p->free_count = 0;
+  p->bytes_current = p->bytes_peak = 0;
+  p->backend = NULL;
   p->rc_active = 0;
 #ifdef SC_ENABLE_PTHREAD
   i = pthread_mutex_destroy (&p->mutex);
@@ -1141,6 +1873,71 @@ sc_package_unregister (int package_id)
   --sc_num_packages;
 }
 
+void
+sc_package_print_memory (int log_priority)
+{
+#ifdef SC_ENABLE_MEMTRACK
+  int                 i, mpiret;
+  int                 num_slots, local_slots;
+  const char         *name;
+  double             *local, *sum, *max;
+
+  /* slot 0 is the default package, then the registered packages;
+   * ranks with fewer package slots contribute zeros for the others */
+  num_slots = local_slots = sc_num_packages_alloc + 1;
+  if (sc_mpicomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Allreduce (&local_slots, &num_slots, 1, sc_MPI_INT,
+                               sc_MPI_MAX, sc_mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  local = (double *) calloc (6 * num_slots, sizeof (double));
+  SC_CHECK_ABORT (local != NULL, "Failed to allocate memory");
+  sum = local + 2 * num_slots;
+  max = local + 4 * num_slots;
+  for (i = 0; i < local_slots; ++i) {
+    if (i == 0 || sc_packages[i - 1].is_registered) {
+      local[2 * i] = (double) sc_memory_bytes (i - 1);
+      local[2 * i + 1] = (double) sc_memory_bytes_peak (i - 1);
+    }
+  }
+  if (sc_mpicomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Reduce (local, sum, 2 * num_slots, sc_MPI_DOUBLE,
+                            sc_MPI_SUM, 0, sc_mpicomm);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Reduce (local, max, 2 * num_slots, sc_MPI_DOUBLE,
+                            sc_MPI_MAX, 0, sc_mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+  else {
+    memcpy (sum, local, 2 * num_slots * sizeof (double));
+    memcpy (max, local, 2 * num_slots * sizeof (double));
+  }
+
+  /* the names are those registered on the printing rank */
+  SC_GEN_LOG (sc_package_id, SC_LC_GLOBAL, log_priority,
+              "Package memory in MiB (sum and max over ranks):\n");
+  for (i = 0; i < num_slots; ++i) {
+    if (i >= local_slots || (i > 0 && !sc_packages[i - 1].is_registered)) {
+      name = "(unregistered)";
+      if (sum[2 * i + 1] == 0.) {
+        continue;
+      }
+    }
+    else {
+      name = i == 0 ? "default" : sc_packages[i - 1].name;
+    }
+    SC_GEN_LOGF (sc_package_id, SC_LC_GLOBAL, log_priority,
+                 "   %3d: %-15s current %.3f %.3f peak %.3f %.3f\n",
+                 i - 1, name, sum[2 * i] / 1048576., max[2 * i] / 1048576.,
+                 sum[2 * i + 1] / 1048576., max[2 * i + 1] / 1048576.);
+  }
+  free (local);
+#else
+  SC_GEN_LOG (sc_package_id, SC_LC_GLOBAL, log_priority,
+              "Package memory is tracked with --enable-memtrack only\n");
+#endif
+}
+
 void
 sc_package_print_summary (int log_priority)
 {
@@ -1169,6 +1966,9 @@ sc_init (sc_MPI_Comm mpicomm,
   int                 w;
   const char         *trace_file_name;
   const char         *trace_file_prio;
+#ifdef SC_ENABLE_MEMPROF
+  const char         *memprof_interval;
+#endif
 
   sc_identifier = -1;
   sc_mpicomm = sc_MPI_COMM_NULL;
@@ -1232,6 +2032,13 @@ sc_init (sc_MPI_Comm mpicomm,
     }
   }
 
+#ifdef SC_ENABLE_MEMPROF
+  memprof_interval = getenv ("SC_MEMPROF_INTERVAL");
+  if (memprof_interval != NULL) {
+    sc_memprof_set_interval ((size_t) strtoul (memprof_interval, NULL, 10));
+  }
+#endif
+
   w = 24;
   SC_GLOBAL_ESSENTIALF ("This is %s\n", SC_PACKAGE_STRING);
 #if 0
@@ -1282,11 +2089,24 @@ sc_finalize (void)
 {
   int                 i;
   int                 retval;
+#ifdef SC_ENABLE_MEMPROF
+  const char         *memprof_global;
+#endif
 
 #if defined(SC_ENABLE_MPI) && defined(SC_ENABLE_MPICOMMSHARED)
   sc_mpi_comm_detach_node_comms (sc_mpicomm);
 #endif
 
+#ifdef SC_ENABLE_MEMPROF
+  /* report the allocation sites and start over for a future sc_init */
+  memprof_global = getenv ("SC_MEMPROF_GLOBAL");
+  sc_memprof_report (SC_LP_STATISTICS,
+                     memprof_global != NULL && !strcmp (memprof_global, "1"));
+  memset (sc_memprof_sites, 0, sizeof (sc_memprof_sites));
+  sc_memprof_total = 0;
+  sc_memprof_dropped = 0.;
+#endif
+
   /* sc_packages is static and thus initialized to all zeros */
   for (i = sc_num_packages_alloc - 1; i >= 0; --i)
     if (sc_packages[i].is_registered)
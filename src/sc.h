@@ -232,11 +232,21 @@ void                SC_CHECK_ABORTF (int success, const char *fmt, ...)
 
 /* macros for memory allocation, will abort if out of memory */
 
+#ifndef SC_ENABLE_MEMPROF
 #define SC_ALLOC(t,n)         (t *) sc_malloc (sc_package_id, (n) * sizeof(t))
 #define SC_ALLOC_ZERO(t,n)    (t *) sc_calloc (sc_package_id, \
                                                (size_t) (n), sizeof(t))
 #define SC_REALLOC(p,t,n)     (t *) sc_realloc (sc_package_id,          \
                                              (p), (n) * sizeof(t))
+#else
+/* pass the call site to the sampling allocation profiler */
+#define SC_ALLOC(t,n)         (t *) sc_malloc_site (sc_package_id,      \
+                                   (n) * sizeof(t), __FILE__, __LINE__)
+#define SC_ALLOC_ZERO(t,n)    (t *) sc_calloc_site (sc_package_id,      \
+                                   (size_t) (n), sizeof(t), __FILE__, __LINE__)
+#define SC_REALLOC(p,t,n)     (t *) sc_realloc_site (sc_package_id,     \
+                                   (p), (n) * sizeof(t), __FILE__, __LINE__)
+#endif
 #define SC_STRDUP(s)                sc_strdup (sc_package_id, (s))
 #define SC_FREE(p)                  sc_free (sc_package_id, (p))
 
@@ -471,6 +481,25 @@ typedef void        (*sc_log_handler_t) (FILE * log_stream,
                                          int priority, const char *msg);
 typedef void        (*sc_abort_handler_t) (void);
 
+/** Hooks that replace the system allocator behind sc_malloc and friends.
+ * The allocation counts of \ref sc_memory_status and \ref sc_memory_check
+ * are kept by sc_malloc and friends regardless of the backend.
+ * The hooks are called from any thread that allocates memory.
+ */
+typedef struct sc_alloc_backend
+{
+  /** Allocate \a size bytes; may only return NULL for size 0. */
+  void               *(*alloc) (size_t size, void *user);
+  /** Resize a block to size > 0, not called with a NULL pointer. */
+  void               *(*realloc) (void *ptr, size_t size, void *user);
+  /** Free a non-NULL block allocated by this backend. */
+  void                (*free) (void *ptr, void *user);
+  /** Optional: return the usable size of a block for --enable-memtrack. */
+  size_t              (*size) (void *ptr, void *user);
+  void               *user;     /**< passed through to every hook */
+}
+sc_alloc_backend_t;
+
 /* memory allocation functions, will abort if out of memory */
 
 void               *sc_malloc (int package, size_t size);
@@ -481,6 +510,50 @@ void                sc_free (int package, void *ptr);
 int                 sc_memory_status (int package);
 void                sc_memory_check (int package);
 
+/* variants of the allocation functions that record the call site */
+
+void               *sc_malloc_site (int package, size_t size,
+                                    const char *file, int line);
+void               *sc_calloc_site (int package, size_t nmemb, size_t size,
+                                    const char *file, int line);
+void               *sc_realloc_site (int package, void *ptr, size_t size,
+                                     const char *file, int line);
+
+/** Set the sampling interval of the allocation site profiler.
+ * When configured with --enable-memprof, the allocation macros pass their
+ * call site to \ref sc_malloc_site and friends.  Every \a bytes bytes
+ * requested, the allocation crossing the mark is recorded for its site.
+ * The interval is initialized from the environment variable
+ * SC_MEMPROF_INTERVAL in sc_init and defaults to 512 KiB.
+ * Without --enable-memprof this function has no effect.
+ * \param [in] bytes       Sampling interval in bytes, 0 to stop sampling.
+ */
+void                sc_memprof_set_interval (size_t bytes);
+
+/** Print the allocation sites ranked by their estimated volume.
+ * This function is called by sc_finalize, which creates the global
+ * report if the environment variable SC_MEMPROF_GLOBAL is set to 1.
+ * Without --enable-memprof this function prints nothing.
+ * \param [in] log_priority   Priority of the log messages.
+ * \param [in] global         If false, each rank reports its own sites.
+ *                            Otherwise, the sites of all ranks are added
+ *                            up on rank 0, which is a collective call
+ *                            over the communicator passed to sc_init.
+ */
+void                sc_memprof_report (int log_priority, int global);
+
+/** Return the number of bytes currently allocated by a package.
+ * Bytes are only tracked when configured with --enable-memtrack;
+ * otherwise this function returns 0.  Depending on the allocator,
+ * the count includes the padding added by malloc to each request.
+ */
+size_t              sc_memory_bytes (int package);
+
+/** Return the maximum number of bytes allocated by a package so far.
+ * See \ref sc_memory_bytes for when bytes are tracked.
+ */
+size_t              sc_memory_bytes_peak (int package);
+
 /* comparison functions for various integer sizes */
 
 int                 sc_int_compare (const void *v1, const void *v2);
@@ -635,12 +708,43 @@ void                sc_package_set_abort_alloc_mismatch (int package_id,
  */
 void                sc_package_unregister (int package_id);
 
+/** Set the allocator backend used by all packages without their own.
+ * Memory must be freed by the backend that allocated it, so the backend
+ * should be set before any memory is allocated or when all is freed.
+ * In debug mode, this function checks that neither the default package
+ * nor any registered package without its own backend holds memory.
+ * \param [in] backend     Hooks to use, or NULL for the built-in allocator.
+ *                         The structure must stay alive while in use.
+ */
+void                sc_set_alloc_backend (const sc_alloc_backend_t *
+                                          backend);
+
+/** Set the allocator backend of one package.
+ * The package must not hold any memory when its backend is changed.
+ * \param [in] package_id  Must be -1 for the default package or
+ *                         the identifier of a registered package.
+ * \param [in] backend     Hooks to use, or NULL to use the global backend
+ *                         set by \ref sc_set_alloc_backend.  The structure
+ *                         must stay alive while in use.
+ */
+void                sc_package_set_alloc_backend (int package_id,
+                                                  const sc_alloc_backend_t *
+                                                  backend);
+
 /** Print a summary of all packages registered with SC.
  * Uses the SC_LC_GLOBAL log category which by default only prints on rank 0.
  * \param [in] log_priority     Priority passed to sc log functions.
  */
 void                sc_package_print_summary (int log_priority);
 
+/** Print the live and peak bytes of all packages over all ranks.
+ * This function is collective over the communicator passed to sc_init.
+ * Package slots are matched by their id; the names printed are those
+ * registered on rank 0.  Bytes are tracked with --enable-memtrack only.
+ * \param [in] log_priority     Priority passed to sc log functions.
+ */
+void                sc_package_print_memory (int log_priority);
+
 /** Sets the global program identifier (e.g. the MPI rank) and some flags.
  * This function is optional.
  * This function must only be called before additional threads are created.
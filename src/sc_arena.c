@@ -0,0 +1,488 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_arena.h>
+#include <sc_thread.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/** Number of size classes, blocks of 32 bytes to 64 KiB. */
+#define SC_ARENA_CLASSES 12
+
+/** Binary logarithm of the smallest block size including its header. */
+#define SC_ARENA_MIN_SHIFT 5
+
+/** The class index that marks a block passed through to the system. */
+#define SC_ARENA_LARGE SC_ARENA_CLASSES
+
+/** Number of caches without pthreads, must be a power of two. */
+#define SC_ARENA_CACHES 64
+
+/** Number of blocks moved between a cache and the central lists. */
+#define SC_ARENA_BATCH 32
+
+/** Size of the chunks obtained from the system in bytes. */
+#define SC_ARENA_CHUNK ((size_t) 1 << 20)
+
+/** Every block is preceded by this header. */
+typedef struct sc_arena_header
+{
+  size_t              cls;      /**< size class or SC_ARENA_LARGE */
+  size_t              size;     /**< usable size of the block */
+}
+sc_arena_header_t;
+
+/** Free blocks are linked through their first bytes. */
+typedef struct sc_arena_link
+{
+  struct sc_arena_link *next;
+}
+sc_arena_link_t;
+
+/** A cache of free blocks.
+ * With pthreads, every thread owns one cache per arena that it alone
+ * accesses, reached through thread-specific data and released when the
+ * thread exits.  Otherwise, the threads with the same OpenMP thread
+ * number share a cache protected by a mutex.
+ */
+typedef struct sc_arena_cache
+{
+  sc_arena_link_t    *free[SC_ARENA_CLASSES];
+  size_t              count[SC_ARENA_CLASSES];
+#ifdef SC_ENABLE_PTHREAD
+  struct sc_arena    *arena;    /**< owner, for the thread exit */
+  struct sc_arena_cache *prev, *next;   /**< list of the arena's caches */
+#else
+  sc_thread_mutex_t   mutex;
+  char                pad[64];  /**< keep caches on separate cache lines */
+#endif
+}
+sc_arena_cache_t;
+
+struct sc_arena
+{
+  sc_thread_mutex_t   mutex;    /**< protects the lists and chunks below */
+  sc_arena_link_t    *central[SC_ARENA_CLASSES];
+  size_t              central_count[SC_ARENA_CLASSES];
+  sc_arena_link_t    *chunks;   /**< chunks linked by their first bytes */
+  size_t              num_chunks;
+  char               *chunk_pos;        /**< unused rest of the last chunk */
+  char               *chunk_end;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_key_t       key;      /**< the calling thread's cache */
+  sc_arena_cache_t   *caches;   /**< caches of all threads */
+  size_t              num_caches;
+#else
+  sc_arena_cache_t    caches[SC_ARENA_CACHES];
+#endif
+};
+
+#ifdef SC_ENABLE_PTHREAD
+
+/** Return all blocks of a cache to the central lists.
+ * The caller holds the arena mutex.
+ */
+static void
+sc_arena_cache_drain (sc_arena_t * arena, sc_arena_cache_t * cache)
+{
+  size_t              cls;
+  sc_arena_link_t    *last;
+
+  for (cls = 0; cls < SC_ARENA_CLASSES; ++cls) {
+    if (cache->free[cls] == NULL) {
+      continue;
+    }
+    for (last = cache->free[cls]; last->next != NULL; last = last->next) {
+    }
+    last->next = arena->central[cls];
+    arena->central[cls] = cache->free[cls];
+    arena->central_count[cls] += cache->count[cls];
+    cache->free[cls] = NULL;
+    cache->count[cls] = 0;
+  }
+}
+
+/** Release the cache of a thread that exits. */
+static void
+sc_arena_cache_exit (void *data)
+{
+  sc_arena_cache_t   *cache = (sc_arena_cache_t *) data;
+  sc_arena_t         *arena = cache->arena;
+
+  sc_thread_mutex_lock (&arena->mutex);
+  sc_arena_cache_drain (arena, cache);
+  if (cache->prev != NULL) {
+    cache->prev->next = cache->next;
+  }
+  else {
+    arena->caches = cache->next;
+  }
+  if (cache->next != NULL) {
+    cache->next->prev = cache->prev;
+  }
+  --arena->num_caches;
+  sc_thread_mutex_unlock (&arena->mutex);
+  free (cache);
+}
+
+/** Create the cache of the calling thread. */
+static sc_arena_cache_t *
+sc_arena_cache_new (sc_arena_t * arena)
+{
+  sc_arena_cache_t   *cache;
+
+  cache = (sc_arena_cache_t *) calloc (1, sizeof (sc_arena_cache_t));
+  SC_CHECK_ABORT (cache != NULL, "Arena cache allocation");
+  cache->arena = arena;
+
+  sc_thread_mutex_lock (&arena->mutex);
+  cache->next = arena->caches;
+  if (cache->next != NULL) {
+    cache->next->prev = cache;
+  }
+  arena->caches = cache;
+  ++arena->num_caches;
+  sc_thread_mutex_unlock (&arena->mutex);
+
+  SC_CHECK_ABORT (pthread_setspecific (arena->key, cache) == 0,
+                  "Arena cache registration");
+  return cache;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+/** Select the cache of the calling thread. */
+static inline sc_arena_cache_t *
+sc_arena_cache (sc_arena_t * arena)
+{
+#if defined SC_ENABLE_PTHREAD
+  sc_arena_cache_t   *cache;
+
+  cache = (sc_arena_cache_t *) pthread_getspecific (arena->key);
+  return cache != NULL ? cache : sc_arena_cache_new (arena);
+#elif defined SC_ENABLE_OPENMP
+  return arena->caches + (omp_get_thread_num () & (SC_ARENA_CACHES - 1));
+#else
+  return arena->caches;
+#endif
+}
+
+/** Lock a cache if it may be shared between threads. */
+static inline void
+sc_arena_cache_lock (sc_arena_cache_t * cache)
+{
+#ifndef SC_ENABLE_PTHREAD
+  sc_thread_mutex_lock (&cache->mutex);
+#endif
+}
+
+/** Unlock a cache locked by \ref sc_arena_cache_lock. */
+static inline void
+sc_arena_cache_unlock (sc_arena_cache_t * cache)
+{
+#ifndef SC_ENABLE_PTHREAD
+  sc_thread_mutex_unlock (&cache->mutex);
+#endif
+}
+
+/** Return the size class of a block including its header. */
+static inline size_t
+sc_arena_class (size_t size)
+{
+  size_t              cls = 0;
+
+  size = (size + sizeof (sc_arena_header_t) - 1) >> SC_ARENA_MIN_SHIFT;
+  while (size > 0) {
+    size >>= 1;
+    ++cls;
+  }
+  return cls;
+}
+
+/** Move up to one batch of free blocks of a class into a cache.
+ * We take the blocks from the central list or carve new ones.
+ */
+static void
+sc_arena_refill (sc_arena_t * arena, sc_arena_cache_t * cache, size_t cls)
+{
+  const size_t        block = (size_t) 1 << (cls + SC_ARENA_MIN_SHIFT);
+  size_t              n, num;
+  sc_arena_link_t    *link;
+  sc_arena_header_t  *header;
+
+  sc_thread_mutex_lock (&arena->mutex);
+  if (arena->central[cls] != NULL) {
+    for (n = 0; n < SC_ARENA_BATCH && arena->central[cls] != NULL; ++n) {
+      link = arena->central[cls];
+      arena->central[cls] = link->next;
+      link->next = cache->free[cls];
+      cache->free[cls] = link;
+    }
+    arena->central_count[cls] -= n;
+    cache->count[cls] += n;
+  }
+  else {
+    if ((size_t) (arena->chunk_end - arena->chunk_pos) < block) {
+      link = (sc_arena_link_t *) malloc (SC_ARENA_CHUNK);
+      SC_CHECK_ABORT (link != NULL, "Arena chunk allocation");
+      link->next = arena->chunks;
+      arena->chunks = link;
+      ++arena->num_chunks;
+
+      /* the chunk link takes up the space of one header */
+      arena->chunk_pos = (char *) link + sizeof (sc_arena_header_t);
+      arena->chunk_end = (char *) link + SC_ARENA_CHUNK;
+    }
+    num = SC_MIN ((size_t) SC_ARENA_BATCH,
+                  (size_t) (arena->chunk_end - arena->chunk_pos) / block);
+    for (n = 0; n < num; ++n) {
+      header = (sc_arena_header_t *) arena->chunk_pos;
+      arena->chunk_pos += block;
+      header->cls = cls;
+      header->size = block - sizeof (sc_arena_header_t);
+      link = (sc_arena_link_t *) (header + 1);
+      link->next = cache->free[cls];
+      cache->free[cls] = link;
+    }
+    cache->count[cls] += num;
+  }
+  sc_thread_mutex_unlock (&arena->mutex);
+}
+
+/** Return one batch of free blocks of a class to the central list. */
+static void
+sc_arena_flush (sc_arena_t * arena, sc_arena_cache_t * cache, size_t cls)
+{
+  size_t              n;
+  sc_arena_link_t    *first, *last;
+
+  first = last = cache->free[cls];
+  for (n = 1; n < SC_ARENA_BATCH; ++n) {
+    last = last->next;
+  }
+  cache->free[cls] = last->next;
+  cache->count[cls] -= SC_ARENA_BATCH;
+
+  sc_thread_mutex_lock (&arena->mutex);
+  last->next = arena->central[cls];
+  arena->central[cls] = first;
+  arena->central_count[cls] += SC_ARENA_BATCH;
+  sc_thread_mutex_unlock (&arena->mutex);
+}
+
+sc_arena_t         *
+sc_arena_new (void)
+{
+#ifndef SC_ENABLE_PTHREAD
+  int                 i;
+#endif
+  sc_arena_t         *arena;
+
+  /* the arena may serve sc_malloc itself, so we use the system allocator */
+  arena = (sc_arena_t *) calloc (1, sizeof (sc_arena_t));
+  SC_CHECK_ABORT (arena != NULL, "Arena allocation");
+  sc_thread_mutex_init (&arena->mutex);
+#ifdef SC_ENABLE_PTHREAD
+  SC_CHECK_ABORT (pthread_key_create (&arena->key, sc_arena_cache_exit) == 0,
+                  "Arena key creation");
+#else
+  for (i = 0; i < SC_ARENA_CACHES; ++i) {
+    sc_thread_mutex_init (&arena->caches[i].mutex);
+  }
+#endif
+
+  return arena;
+}
+
+void
+sc_arena_destroy (sc_arena_t * arena)
+{
+#ifdef SC_ENABLE_PTHREAD
+  sc_arena_cache_t   *cache;
+#else
+  int                 i;
+#endif
+  sc_arena_link_t    *chunk, *next;
+
+  for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+    next = chunk->next;
+    free (chunk);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  /* threads exiting later no longer run the destructor */
+  SC_CHECK_ABORT (pthread_key_delete (arena->key) == 0, "Arena key deletion");
+  while (arena->caches != NULL) {
+    cache = arena->caches;
+    arena->caches = cache->next;
+    free (cache);
+  }
+#else
+  for (i = 0; i < SC_ARENA_CACHES; ++i) {
+    sc_thread_mutex_destroy (&arena->caches[i].mutex);
+  }
+#endif
+  sc_thread_mutex_destroy (&arena->mutex);
+  free (arena);
+}
+
+size_t
+sc_arena_memory_used (sc_arena_t * arena)
+{
+#ifdef SC_ENABLE_PTHREAD
+  return sizeof (sc_arena_t) + arena->num_chunks * SC_ARENA_CHUNK +
+    arena->num_caches * sizeof (sc_arena_cache_t);
+#else
+  return sizeof (sc_arena_t) + arena->num_chunks * SC_ARENA_CHUNK;
+#endif
+}
+
+void               *
+sc_arena_alloc (sc_arena_t * arena, size_t size)
+{
+  const size_t        cls = sc_arena_class (size);
+  sc_arena_cache_t   *cache;
+  sc_arena_link_t    *link;
+  sc_arena_header_t  *header;
+
+  if (cls >= SC_ARENA_CLASSES) {
+    header = (sc_arena_header_t *) malloc (sizeof (sc_arena_header_t) + size);
+    SC_CHECK_ABORTF (header != NULL, "Arena allocation (size %llu)",
+                     (unsigned long long) size);
+    header->cls = SC_ARENA_LARGE;
+    header->size = size;
+    return (void *) (header + 1);
+  }
+
+  cache = sc_arena_cache (arena);
+  sc_arena_cache_lock (cache);
+  if (cache->free[cls] == NULL) {
+    sc_arena_refill (arena, cache, cls);
+  }
+  link = cache->free[cls];
+  cache->free[cls] = link->next;
+  --cache->count[cls];
+  sc_arena_cache_unlock (cache);
+
+  return (void *) link;
+}
+
+void               *
+sc_arena_realloc (sc_arena_t * arena, void *ptr, size_t size)
+{
+  sc_arena_header_t  *header;
+  void               *ret;
+
+  if (ptr == NULL) {
+    return sc_arena_alloc (arena, size);
+  }
+  header = (sc_arena_header_t *) ptr - 1;
+  if (header->cls == SC_ARENA_LARGE &&
+      sc_arena_class (size) >= SC_ARENA_CLASSES) {
+    header = (sc_arena_header_t *)
+      realloc (header, sizeof (sc_arena_header_t) + size);
+    SC_CHECK_ABORTF (header != NULL, "Arena reallocation (size %llu)",
+                     (unsigned long long) size);
+    header->size = size;
+    return (void *) (header + 1);
+  }
+  if (header->cls != SC_ARENA_LARGE && size <= header->size &&
+      size > header->size / 4) {
+    /* the block stays within its size class */
+    return ptr;
+  }
+
+  ret = sc_arena_alloc (arena, size);
+  memcpy (ret, ptr, SC_MIN (size, header->size));
+  sc_arena_free (arena, ptr);
+  return ret;
+}
+
+void
+sc_arena_free (sc_arena_t * arena, void *ptr)
+{
+  sc_arena_cache_t   *cache;
+  sc_arena_link_t    *link = (sc_arena_link_t *) ptr;
+  sc_arena_header_t  *header;
+  size_t              cls;
+
+  if (ptr == NULL) {
+    return;
+  }
+  header = (sc_arena_header_t *) ptr - 1;
+  cls = header->cls;
+  if (cls == SC_ARENA_LARGE) {
+    free (header);
+    return;
+  }
+  SC_ASSERT (cls < SC_ARENA_CLASSES);
+
+  cache = sc_arena_cache (arena);
+  sc_arena_cache_lock (cache);
+  link->next = cache->free[cls];
+  cache->free[cls] = link;
+  if (++cache->count[cls] >= 2 * SC_ARENA_BATCH) {
+    sc_arena_flush (arena, cache, cls);
+  }
+  sc_arena_cache_unlock (cache);
+}
+
+size_t
+sc_arena_size (void *ptr)
+{
+  return ((sc_arena_header_t *) ptr - 1)->size;
+}
+
+static void        *
+sc_arena_backend_alloc (size_t size, void *user)
+{
+  return sc_arena_alloc ((sc_arena_t *) user, size);
+}
+
+static void        *
+sc_arena_backend_realloc (void *ptr, size_t size, void *user)
+{
+  return sc_arena_realloc ((sc_arena_t *) user, ptr, size);
+}
+
+static void
+sc_arena_backend_free (void *ptr, void *user)
+{
+  sc_arena_free ((sc_arena_t *) user, ptr);
+}
+
+static              size_t
+sc_arena_backend_size (void *ptr, void *user)
+{
+  return sc_arena_size (ptr);
+}
+
+void
+sc_arena_backend (sc_arena_t * arena, sc_alloc_backend_t * backend)
+{
+  backend->alloc = sc_arena_backend_alloc;
+  backend->realloc = sc_arena_backend_realloc;
+  backend->free = sc_arena_backend_free;
+  backend->size = sc_arena_backend_size;
+  backend->user = arena;
+}
@@ -0,0 +1,106 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_arena.h
+ *
+ * A thread-caching arena that can serve as the allocator backend of
+ * sc_malloc and friends, see \ref sc_set_alloc_backend.
+ * Small blocks are rounded up to power-of-two size classes and carved from
+ * large chunks.  Freed blocks are kept in a cache of the calling thread and
+ * exchanged in batches with the arena's central lists under a mutex.
+ * With --enable-pthread, every thread has a private cache for each arena,
+ * such that most allocations and frees take no lock and do not call the
+ * system.  Without pthreads, threads with the same OpenMP thread number
+ * share one cache that is locked on every call.
+ * Large blocks are passed through to the system allocator.
+ * Blocks are aligned to 2 * sizeof (size_t) bytes.
+ */
+
+#ifndef SC_ARENA_H
+#define SC_ARENA_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Opaque arena object. */
+typedef struct sc_arena sc_arena_t;
+
+/** Create a new, empty arena.
+ * \return                 The arena.
+ */
+sc_arena_t         *sc_arena_new (void);
+
+/** Destroy an arena and return its chunks to the system.
+ * All large blocks must have been freed before.  Small blocks still
+ * allocated become invalid.
+ * \param [in,out] arena   The arena.
+ */
+void                sc_arena_destroy (sc_arena_t * arena);
+
+/** Return the memory held by an arena, including cached free blocks.
+ * Large blocks passed through to the system are not included.
+ * \param [in] arena       The arena.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_arena_memory_used (sc_arena_t * arena);
+
+/** Fill a backend structure with the hooks of an arena.
+ * \param [in] arena       The arena.
+ * \param [out] backend    Pass this to \ref sc_set_alloc_backend or
+ *                         \ref sc_package_set_alloc_backend.
+ */
+void                sc_arena_backend (sc_arena_t * arena,
+                                      sc_alloc_backend_t * backend);
+
+/** Allocate a block from an arena.
+ * \param [in,out] arena   The arena.
+ * \param [in] size        Size of the block in bytes.
+ * \return                 The block, aborts if out of memory.
+ */
+void               *sc_arena_alloc (sc_arena_t * arena, size_t size);
+
+/** Resize a block of an arena, in place if it fits its size class.
+ * \param [in,out] arena   The arena.
+ * \param [in] ptr         Block allocated from this arena or NULL.
+ * \param [in] size        New size of the block in bytes.
+ * \return                 The resized block.
+ */
+void               *sc_arena_realloc (sc_arena_t * arena, void *ptr,
+                                      size_t size);
+
+/** Return a block to an arena.
+ * \param [in,out] arena   The arena.
+ * \param [in] ptr         Block allocated from this arena or NULL.
+ */
+void                sc_arena_free (sc_arena_t * arena, void *ptr);
+
+/** Return the usable size of a block of an arena.
+ * \param [in] ptr         Block allocated from an arena.
+ * \return                 Number of bytes that can be used.
+ */
+size_t              sc_arena_size (void *ptr);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_ARENA_H */
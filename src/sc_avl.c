@@ -184,6 +184,7 @@ avl_tree_t *avl_init_tree(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t free
 		rc->top = NULL;
 		rc->cmp = cmp;
 		rc->freeitem = freeitem;
+		rc->pool = NULL;
 	}
 	return rc;
 }
@@ -192,6 +193,30 @@ avl_tree_t *avl_alloc_tree(avl_compare_t cmp, avl_freeitem_t freeitem) {
         return avl_init_tree(SC_ALLOC(avl_tree_t, 1), cmp, freeitem);
 }
 
+avl_tree_t *avl_init_tree_pool(avl_tree_t *rc, avl_compare_t cmp, avl_freeitem_t freeitem, sc_mempool_t *pool) {
+	SC_ASSERT(pool == NULL || pool->elem_size == sizeof(avl_node_t));
+	if(avl_init_tree(rc, cmp, freeitem))
+		rc->pool = pool;
+	return rc;
+}
+
+avl_tree_t *avl_alloc_tree_pool(avl_compare_t cmp, avl_freeitem_t freeitem, sc_mempool_t *pool) {
+        return avl_init_tree_pool(SC_ALLOC(avl_tree_t, 1), cmp, freeitem, pool);
+}
+
+static avl_node_t *avl_new_node(avl_tree_t *avltree) {
+	if(avltree->pool)
+		return (avl_node_t *) sc_mempool_alloc(avltree->pool);
+	return SC_ALLOC(avl_node_t, 1);
+}
+
+static void avl_destroy_node(avl_tree_t *avltree, avl_node_t *avlnode) {
+	if(avltree->pool)
+		sc_mempool_free(avltree->pool, avlnode);
+	else
+		SC_FREE(avlnode);
+}
+
 void avl_clear_tree(avl_tree_t *avltree) {
 	avltree->top = avltree->head = avltree->tail = NULL;
 }
@@ -202,11 +227,21 @@ void avl_free_nodes(avl_tree_t *avltree) {
 
 	freeitem = avltree->freeitem;
 
+	if(avltree->pool && avltree->pool->elem_count == avl_count(avltree)) {
+		/* the pool holds exactly our nodes: release them at once */
+		if(freeitem)
+			for(node = avltree->head; node; node = node->next)
+				freeitem(node->item);
+		sc_mempool_truncate(avltree->pool);
+		avl_clear_tree(avltree);
+		return;
+	}
+
 	for(node = avltree->head; node; node = next) {
 		next = node->next;
 		if(freeitem)
 			freeitem(node->item);
-		SC_FREE(node);
+		avl_destroy_node(avltree, node);
 	}
 
 	avl_clear_tree(avltree);
@@ -324,11 +359,11 @@ avl_node_t *avl_insert_node(avl_tree_t *avltree, avl_node_t *newnode) {
 avl_node_t *avl_insert(avl_tree_t *avltree, void *item) {
 	avl_node_t *newnode;
 
-	newnode = avl_init_node(SC_ALLOC(avl_node_t, 1), item);
+	newnode = avl_init_node(avl_new_node(avltree), item);
 	if(newnode) {
 		if(avl_insert_node(avltree, newnode))
 			return newnode;
-		SC_FREE(newnode);
+		avl_destroy_node(avltree, newnode);
 		/* errno = EEXIST; */
                 return NULL;
 	}
@@ -403,7 +438,7 @@ void *avl_delete_node(avl_tree_t *avltree, avl_node_t *avlnode) {
 		avl_unlink_node(avltree, avlnode);
 		if(avltree->freeitem)
 			avltree->freeitem(item);
-		SC_FREE(avlnode);
+		avl_destroy_node(avltree, avlnode);
 	}
 	return item;
 }
@@ -667,4 +702,78 @@ avl_to_array (avl_tree_t * avltree, sc_array_t * array)
   SC_ASSERT (adata.iz == adata.array->elem_count);
 }
 
+/** Link the nodes of a sorted range into a perfectly balanced subtree.
+ * \param [in,out] nodes   Nodes in increasing order, items already set.
+ * \param [in] lo, hi      Range [lo, hi) to build, must not be empty.
+ * \param [in] parent      Parent node of the subtree.
+ * \return                 The root of the new subtree.
+ */
+static avl_node_t  *
+avl_from_array_recursion (avl_node_t ** nodes, size_t lo, size_t hi,
+                          avl_node_t * parent)
+{
+  const size_t        mid = lo + (hi - lo) / 2;
+  avl_node_t         *node = nodes[mid];
+
+  SC_ASSERT (lo < hi);
+
+  node->parent = parent;
+  node->left = lo < mid ?
+    avl_from_array_recursion (nodes, lo, mid, node) : NULL;
+  node->right = mid + 1 < hi ?
+    avl_from_array_recursion (nodes, mid + 1, hi, node) : NULL;
+  node->count = (unsigned int) (hi - lo);
+#ifdef AVL_DEPTH
+  node->depth = (unsigned char) CALC_DEPTH (node);
+#endif
+
+  return node;
+}
+
+void
+avl_from_array (avl_tree_t * avltree, sc_array_t * array)
+{
+  size_t              zz, n;
+  avl_node_t        **nodes;
+
+  SC_ASSERT (array->elem_size == sizeof (void *));
+  SC_ASSERT (avltree->top == NULL);
+  SC_CHECK_ABORT (array->elem_count <= (size_t) UINT_MAX,
+                  "AVL tree count overflow");
+
+  n = array->elem_count;
+  if (n == 0) {
+    return;
+  }
+#ifdef SC_ENABLE_DEBUG
+  for (zz = 1; zz < n; ++zz) {
+    SC_ASSERT (avltree->cmp (*(void **) sc_array_index (array, zz - 1),
+                             *(void **) sc_array_index (array, zz)) < 0);
+  }
+#endif
+
+  /* allocate all nodes up front, contiguously when using a pool */
+  nodes = SC_ALLOC (avl_node_t *, n);
+  if (avltree->pool != NULL) {
+    sc_mempool_alloc_n (avltree->pool, n, (void **) nodes);
+  }
+  else {
+    for (zz = 0; zz < n; ++zz) {
+      nodes[zz] = SC_ALLOC (avl_node_t, 1);
+    }
+  }
+
+  /* the list of nodes in order */
+  for (zz = 0; zz < n; ++zz) {
+    nodes[zz]->item = *(void **) sc_array_index (array, zz);
+    nodes[zz]->prev = zz > 0 ? nodes[zz - 1] : NULL;
+    nodes[zz]->next = zz + 1 < n ? nodes[zz + 1] : NULL;
+  }
+  avltree->head = nodes[0];
+  avltree->tail = nodes[n - 1];
+  avltree->top = avl_from_array_recursion (nodes, 0, n, NULL);
+
+  SC_FREE (nodes);
+}
+
 #endif /* AVL_COUNT */
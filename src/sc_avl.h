@@ -85,6 +85,7 @@ typedef struct avl_tree_t {
 	avl_node_t *top;
 	avl_compare_t cmp;
 	avl_freeitem_t freeitem;
+	sc_mempool_t *pool;   /* node storage, or NULL to use SC_ALLOC */
 } avl_tree_t;
 
 /* Initializes a new tree for elements that will be ordered using
@@ -99,6 +100,21 @@ extern avl_tree_t *avl_init_tree(avl_tree_t *avltree, avl_compare_t, avl_freeite
  * O(1) */
 extern avl_tree_t *avl_alloc_tree(avl_compare_t, avl_freeitem_t);
 
+/* Initializes a new tree whose nodes are allocated from a memory pool.
+ * The pool must have an element size of sizeof (avl_node_t) and stays
+ * owned by the caller; it is not destroyed together with the tree.
+ * If the pool holds nodes of this tree only, avl_free_nodes truncates it.
+ * With a NULL pool this is the same as avl_init_tree.
+ * O(1) */
+extern avl_tree_t *avl_init_tree_pool(avl_tree_t *avltree, avl_compare_t,
+				      avl_freeitem_t, sc_mempool_t *pool);
+
+/* Allocates and initializes a new tree with nodes from a memory pool.
+ * See avl_init_tree_pool for the requirements on the pool.
+ * O(1) */
+extern avl_tree_t *avl_alloc_tree_pool(avl_compare_t, avl_freeitem_t,
+				       sc_mempool_t *pool);
+
 /* Frees the entire tree efficiently. Nodes will be free()d.
  * If the tree's freeitem is not NULL it will be invoked on every item.
  * O(n) */
@@ -205,6 +221,14 @@ extern unsigned int avl_index(const avl_node_t *);
 * O(n) */
 extern void avl_to_array (avl_tree_t *, sc_array_t *);
 
+/* Fills an empty tree with the items of an array of void *.
+ * The items must be strictly increasing with respect to the tree's
+ * compare function, which is checked in debug mode only.
+ * The tree is built perfectly balanced without any comparisons
+ * and the nodes are allocated in item order.
+ * O(n) */
+extern void avl_from_array (avl_tree_t *, sc_array_t *);
+
 #endif /* AVL_COUNT */
 
 SC_EXTERN_C_END;
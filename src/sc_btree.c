@@ -0,0 +1,834 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_btree.h>
+
+/** The minimum number of entries of a node other than the root. */
+#define SC_BTREE_MIN (SC_BTREE_ORDER / 2)
+
+/** A leaf holds items in ascending order. */
+typedef struct sc_btree_leaf
+{
+  int                 num;
+  void               *items[SC_BTREE_ORDER];
+}
+sc_btree_leaf_t;
+
+/** An inner node holds its children and the number of items below them.
+ * keys[i] is not greater than any item below children[i] and greater than
+ * all items below children[i - 1].  keys[0] is only set when the node
+ * is split off to the right of another one.  The keys are items in the
+ * tree and are replaced when the item they refer to is deleted.
+ */
+typedef struct sc_btree_inner
+{
+  int                 num;
+  void               *keys[SC_BTREE_ORDER];
+  void               *children[SC_BTREE_ORDER];
+  size_t              counts[SC_BTREE_ORDER];
+}
+sc_btree_inner_t;
+
+sc_btree_t         *
+sc_btree_new (sc_btree_compare_t compare, sc_btree_freeitem_t freeitem)
+{
+  sc_btree_t         *tree;
+
+  SC_ASSERT (compare != NULL);
+
+  tree = SC_ALLOC (sc_btree_t, 1);
+  tree->count = 0;
+  tree->compare = compare;
+  tree->freeitem = freeitem;
+  tree->height = 0;
+  tree->root = NULL;
+  tree->leaves = sc_mempool_new_intrusive (sizeof (sc_btree_leaf_t));
+  tree->inners = sc_mempool_new_intrusive (sizeof (sc_btree_inner_t));
+
+  return tree;
+}
+
+static void
+sc_btree_free_items (sc_btree_t * tree, void *node, int level)
+{
+  int                 i;
+  sc_btree_leaf_t    *leaf;
+  sc_btree_inner_t   *inner;
+
+  if (level == tree->height - 1) {
+    leaf = (sc_btree_leaf_t *) node;
+    for (i = 0; i < leaf->num; ++i) {
+      tree->freeitem (leaf->items[i]);
+    }
+  }
+  else {
+    inner = (sc_btree_inner_t *) node;
+    for (i = 0; i < inner->num; ++i) {
+      sc_btree_free_items (tree, inner->children[i], level + 1);
+    }
+  }
+}
+
+void
+sc_btree_clear (sc_btree_t * tree)
+{
+  if (tree->freeitem != NULL && tree->root != NULL) {
+    sc_btree_free_items (tree, tree->root, 0);
+  }
+  sc_mempool_truncate (tree->leaves);
+  sc_mempool_truncate (tree->inners);
+  tree->count = 0;
+  tree->height = 0;
+  tree->root = NULL;
+}
+
+void
+sc_btree_destroy (sc_btree_t * tree)
+{
+  sc_btree_clear (tree);
+  sc_mempool_destroy (tree->leaves);
+  sc_mempool_destroy (tree->inners);
+  SC_FREE (tree);
+}
+
+size_t
+sc_btree_memory_used (sc_btree_t * tree)
+{
+  return sizeof (sc_btree_t) + sc_mempool_memory_used (tree->leaves) +
+    sc_mempool_memory_used (tree->inners);
+}
+
+/** Return the first position in a leaf whose item is not less than item.
+ * \param [out] equal       True if the item at that position is equal.
+ */
+static int
+sc_btree_leaf_lower (const sc_btree_t * tree, const sc_btree_leaf_t * leaf,
+                     const void *item, int *equal)
+{
+  int                 low, high, mid, cmp;
+
+  *equal = 0;
+  low = 0;
+  high = leaf->num;
+  while (low < high) {
+    mid = (low + high) / 2;
+    cmp = tree->compare (leaf->items[mid], item);
+    if (cmp < 0) {
+      low = mid + 1;
+    }
+    else {
+      *equal = cmp == 0;
+      high = mid;
+    }
+  }
+  /* the last comparison with a not smaller item was at position low */
+  return low;
+}
+
+/** Return the index of the child of an inner node that may hold item. */
+static int
+sc_btree_inner_child (const sc_btree_t * tree,
+                      const sc_btree_inner_t * inner, const void *item)
+{
+  int                 low, high, mid;
+
+  /* find the first key greater than item, not counting keys[0] */
+  low = 1;
+  high = inner->num;
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (tree->compare (inner->keys[mid], item) <= 0) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low - 1;
+}
+
+/** Return the number of items below a node. */
+static size_t
+sc_btree_node_count (const sc_btree_t * tree, void *node, int level)
+{
+  int                 i;
+  size_t              count;
+  sc_btree_inner_t   *inner;
+
+  if (level == tree->height - 1) {
+    return (size_t) ((sc_btree_leaf_t *) node)->num;
+  }
+  inner = (sc_btree_inner_t *) node;
+  for (i = 0, count = 0; i < inner->num; ++i) {
+    count += inner->counts[i];
+  }
+  return count;
+}
+
+/** Descend from the root towards the first item not less than item.
+ * The leaf position may be one past the last item of the leaf.
+ * \return                  True if the item at the leaf position is equal.
+ */
+static int
+sc_btree_descend (const sc_btree_t * tree, const void *item,
+                  sc_btree_iter_t * iter)
+{
+  int                 level, equal;
+  void               *node;
+  sc_btree_inner_t   *inner;
+
+  SC_ASSERT (tree->height > 0);
+
+  iter->tree = tree;
+  node = tree->root;
+  for (level = 0; level < tree->height - 1; ++level) {
+    inner = (sc_btree_inner_t *) node;
+    iter->nodes[level] = node;
+    iter->pos[level] = sc_btree_inner_child (tree, inner, item);
+    node = inner->children[iter->pos[level]];
+  }
+  iter->nodes[level] = node;
+  iter->pos[level] = sc_btree_leaf_lower (tree, (sc_btree_leaf_t *) node,
+                                          item, &equal);
+  return equal;
+}
+
+/** Complete a path below a level along the first or the last children. */
+static void *
+sc_btree_descend_edge (sc_btree_iter_t * iter, int level, int last)
+{
+  const int           height = iter->tree->height;
+  sc_btree_inner_t   *inner;
+  sc_btree_leaf_t    *leaf;
+
+  for (; level < height - 1; ++level) {
+    inner = (sc_btree_inner_t *) iter->nodes[level];
+    iter->nodes[level + 1] = inner->children[iter->pos[level]];
+    iter->pos[level + 1] = last ?
+      (level + 1 < height - 1 ?
+       ((sc_btree_inner_t *) iter->nodes[level + 1])->num :
+       ((sc_btree_leaf_t *) iter->nodes[level + 1])->num) - 1 : 0;
+  }
+  leaf = (sc_btree_leaf_t *) iter->nodes[height - 1];
+  return leaf->items[iter->pos[height - 1]];
+}
+
+void               *
+sc_btree_item (const sc_btree_iter_t * iter)
+{
+  const sc_btree_leaf_t *leaf;
+
+  if (iter->tree == NULL) {
+    return NULL;
+  }
+  leaf = (const sc_btree_leaf_t *) iter->nodes[iter->tree->height - 1];
+  SC_ASSERT (0 <= iter->pos[iter->tree->height - 1] &&
+             iter->pos[iter->tree->height - 1] < leaf->num);
+  return leaf->items[iter->pos[iter->tree->height - 1]];
+}
+
+void               *
+sc_btree_first (const sc_btree_t * tree, sc_btree_iter_t * iter)
+{
+  if (tree->height == 0) {
+    iter->tree = NULL;
+    return NULL;
+  }
+  iter->tree = tree;
+  iter->nodes[0] = tree->root;
+  iter->pos[0] = 0;
+  return sc_btree_descend_edge (iter, 0, 0);
+}
+
+void               *
+sc_btree_last (const sc_btree_t * tree, sc_btree_iter_t * iter)
+{
+  if (tree->height == 0) {
+    iter->tree = NULL;
+    return NULL;
+  }
+  iter->tree = tree;
+  iter->nodes[0] = tree->root;
+  iter->pos[0] = (tree->height > 1 ?
+                  ((sc_btree_inner_t *) tree->root)->num :
+                  ((sc_btree_leaf_t *) tree->root)->num) - 1;
+  return sc_btree_descend_edge (iter, 0, 1);
+}
+
+void               *
+sc_btree_next (sc_btree_iter_t * iter)
+{
+  int                 level, height;
+  sc_btree_leaf_t    *leaf;
+
+  SC_ASSERT (iter->tree != NULL);
+
+  height = iter->tree->height;
+  leaf = (sc_btree_leaf_t *) iter->nodes[height - 1];
+  if (++iter->pos[height - 1] < leaf->num) {
+    return leaf->items[iter->pos[height - 1]];
+  }
+
+  /* go up to the first node with a next child and down its left edge */
+  for (level = height - 2; level >= 0; --level) {
+    if (iter->pos[level] + 1 <
+        ((sc_btree_inner_t *) iter->nodes[level])->num) {
+      ++iter->pos[level];
+      return sc_btree_descend_edge (iter, level, 0);
+    }
+  }
+  iter->tree = NULL;
+  return NULL;
+}
+
+void               *
+sc_btree_prev (sc_btree_iter_t * iter)
+{
+  int                 level, height;
+  sc_btree_leaf_t    *leaf;
+
+  SC_ASSERT (iter->tree != NULL);
+
+  height = iter->tree->height;
+  leaf = (sc_btree_leaf_t *) iter->nodes[height - 1];
+  if (--iter->pos[height - 1] >= 0) {
+    return leaf->items[iter->pos[height - 1]];
+  }
+
+  /* go up to the first node with a previous child and down its right edge */
+  for (level = height - 2; level >= 0; --level) {
+    if (iter->pos[level] > 0) {
+      --iter->pos[level];
+      return sc_btree_descend_edge (iter, level, 1);
+    }
+  }
+  iter->tree = NULL;
+  return NULL;
+}
+
+void               *
+sc_btree_search (const sc_btree_t * tree, const void *item,
+                 sc_btree_iter_t * iter)
+{
+  sc_btree_iter_t     it;
+
+  if (iter == NULL) {
+    iter = &it;
+  }
+  if (tree->height == 0 || !sc_btree_descend (tree, item, iter)) {
+    iter->tree = NULL;
+    return NULL;
+  }
+  return sc_btree_item (iter);
+}
+
+int
+sc_btree_search_closest (const sc_btree_t * tree, const void *item,
+                         sc_btree_iter_t * iter)
+{
+  int                 height = tree->height;
+  sc_btree_iter_t     it, last;
+
+  if (iter == NULL) {
+    iter = &it;
+  }
+  if (height == 0) {
+    iter->tree = NULL;
+    return 0;
+  }
+  if (sc_btree_descend (tree, item, iter)) {
+    return 0;
+  }
+  if (iter->pos[height - 1] <
+      ((sc_btree_leaf_t *) iter->nodes[height - 1])->num) {
+    return -1;
+  }
+
+  /* the greater item is in a later leaf, if there is one */
+  --iter->pos[height - 1];
+  last = *iter;
+  if (sc_btree_next (iter) != NULL) {
+    return -1;
+  }
+  *iter = last;
+  return 1;
+}
+
+size_t
+sc_btree_index (const sc_btree_iter_t * iter)
+{
+  int                 level, j;
+  size_t              index;
+  const sc_btree_inner_t *inner;
+
+  SC_ASSERT (iter->tree != NULL);
+
+  index = 0;
+  for (level = 0; level < iter->tree->height - 1; ++level) {
+    inner = (const sc_btree_inner_t *) iter->nodes[level];
+    for (j = 0; j < iter->pos[level]; ++j) {
+      index += inner->counts[j];
+    }
+  }
+  return index + (size_t) iter->pos[level];
+}
+
+size_t
+sc_btree_rank (const sc_btree_t * tree, const void *item)
+{
+  sc_btree_iter_t     it;
+
+  if (tree->height == 0) {
+    return 0;
+  }
+  sc_btree_descend (tree, item, &it);
+  return sc_btree_index (&it);
+}
+
+void               *
+sc_btree_at (const sc_btree_t * tree, size_t index, sc_btree_iter_t * iter)
+{
+  int                 level;
+  void               *node;
+  sc_btree_inner_t   *inner;
+  sc_btree_iter_t     it;
+
+  if (iter == NULL) {
+    iter = &it;
+  }
+  if (index >= tree->count) {
+    iter->tree = NULL;
+    return NULL;
+  }
+
+  iter->tree = tree;
+  node = tree->root;
+  for (level = 0; level < tree->height - 1; ++level) {
+    inner = (sc_btree_inner_t *) node;
+    iter->nodes[level] = node;
+    for (iter->pos[level] = 0; index >= inner->counts[iter->pos[level]];
+         ++iter->pos[level]) {
+      index -= inner->counts[iter->pos[level]];
+    }
+    node = inner->children[iter->pos[level]];
+  }
+  iter->nodes[level] = node;
+  iter->pos[level] = (int) index;
+  return sc_btree_item (iter);
+}
+
+/** Insert into the subtree of a node.
+ * \param [out] split       If the node is split, the new right node.
+ * \param [out] split_key   The separator of the new right node.
+ * \return                  -1 if an equal item exists, 0 if inserted,
+ *                          1 if inserted and the node was split.
+ */
+static int
+sc_btree_insert_node (sc_btree_t * tree, void *node, int level, void *item,
+                      void **split, void **split_key)
+{
+  int                 pos, equal, result, half;
+  void               *child_split, *child_key;
+  sc_btree_leaf_t    *leaf, *right;
+  sc_btree_inner_t   *inner, *iright, *target;
+
+  if (level == tree->height - 1) {
+    leaf = (sc_btree_leaf_t *) node;
+    pos = sc_btree_leaf_lower (tree, leaf, item, &equal);
+    if (equal) {
+      return -1;
+    }
+    result = 0;
+    if (leaf->num == SC_BTREE_ORDER) {
+      /* move the upper half into a new leaf */
+      right = (sc_btree_leaf_t *) sc_mempool_alloc (tree->leaves);
+      right->num = SC_BTREE_ORDER - SC_BTREE_MIN;
+      memcpy (right->items, leaf->items + SC_BTREE_MIN,
+              right->num * sizeof (void *));
+      leaf->num = SC_BTREE_MIN;
+      if (pos > SC_BTREE_MIN) {
+        pos -= SC_BTREE_MIN;
+        leaf = right;
+      }
+      *split = right;
+      result = 1;
+    }
+    memmove (leaf->items + pos + 1, leaf->items + pos,
+             (leaf->num - pos) * sizeof (void *));
+    leaf->items[pos] = item;
+    ++leaf->num;
+    if (result) {
+      *split_key = ((sc_btree_leaf_t *) * split)->items[0];
+    }
+    return result;
+  }
+
+  inner = (sc_btree_inner_t *) node;
+  pos = sc_btree_inner_child (tree, inner, item);
+  result = sc_btree_insert_node (tree, inner->children[pos], level + 1,
+                                 item, &child_split, &child_key);
+  if (result <= 0) {
+    if (result == 0) {
+      ++inner->counts[pos];
+    }
+    return result;
+  }
+
+  /* the child has been split and we add the new one after it */
+  result = 0;
+  target = inner;
+  if (inner->num == SC_BTREE_ORDER) {
+    iright = (sc_btree_inner_t *) sc_mempool_alloc (tree->inners);
+    half = SC_BTREE_MIN;
+    iright->num = SC_BTREE_ORDER - half;
+    memcpy (iright->keys, inner->keys + half, iright->num * sizeof (void *));
+    memcpy (iright->children, inner->children + half,
+            iright->num * sizeof (void *));
+    memcpy (iright->counts, inner->counts + half,
+            iright->num * sizeof (size_t));
+    inner->num = half;
+    if (pos >= half) {
+      pos -= half;
+      target = iright;
+    }
+    *split = iright;
+    *split_key = iright->keys[0];
+    result = 1;
+  }
+  ++pos;
+  memmove (target->keys + pos + 1, target->keys + pos,
+           (target->num - pos) * sizeof (void *));
+  memmove (target->children + pos + 1, target->children + pos,
+           (target->num - pos) * sizeof (void *));
+  memmove (target->counts + pos + 1, target->counts + pos,
+           (target->num - pos) * sizeof (size_t));
+  target->keys[pos] = child_key;
+  target->children[pos] = child_split;
+  target->counts[pos] = sc_btree_node_count (tree, child_split, level + 1);
+  target->counts[pos - 1] += 1 - target->counts[pos];
+  ++target->num;
+  return result;
+}
+
+int
+sc_btree_insert (sc_btree_t * tree, void *item, sc_btree_iter_t * iter)
+{
+  int                 result;
+  void               *split, *split_key;
+  sc_btree_leaf_t    *leaf;
+  sc_btree_inner_t   *root;
+
+  if (tree->height == 0) {
+    leaf = (sc_btree_leaf_t *) sc_mempool_alloc (tree->leaves);
+    leaf->num = 1;
+    leaf->items[0] = item;
+    tree->root = leaf;
+    tree->height = 1;
+    result = 0;
+  }
+  else {
+    result = sc_btree_insert_node (tree, tree->root, 0, item,
+                                   &split, &split_key);
+  }
+  if (result == 1) {
+    /* the root has been split and the tree grows by one level */
+    SC_CHECK_ABORT (tree->height < SC_BTREE_MAX_HEIGHT, "B-tree height");
+    root = (sc_btree_inner_t *) sc_mempool_alloc (tree->inners);
+    root->num = 2;
+    root->keys[0] = NULL;
+    root->keys[1] = split_key;
+    root->children[0] = tree->root;
+    root->children[1] = split;
+    root->counts[1] = sc_btree_node_count (tree, split, 0);
+    root->counts[0] = tree->count + 1 - root->counts[1];
+    tree->root = root;
+    ++tree->height;
+  }
+  if (result >= 0) {
+    ++tree->count;
+  }
+  if (iter != NULL) {
+    sc_btree_search (tree, item, iter);
+  }
+  return result >= 0;
+}
+
+/** Restore the minimum size of the child c of an inner node. */
+static void
+sc_btree_rebalance (sc_btree_t * tree, sc_btree_inner_t * parent,
+                    int c, int child_is_leaf)
+{
+  int                 left, n;
+  sc_btree_leaf_t    *la, *lb;
+  sc_btree_inner_t   *ia, *ib;
+
+  SC_ASSERT (parent->num >= 2);
+
+  if (child_is_leaf) {
+    la = c > 0 ? (sc_btree_leaf_t *) parent->children[c - 1] : NULL;
+    lb = (sc_btree_leaf_t *) parent->children[c];
+    if (la != NULL && la->num > SC_BTREE_MIN) {
+      /* borrow the last item of the left sibling */
+      memmove (lb->items + 1, lb->items, lb->num * sizeof (void *));
+      lb->items[0] = la->items[--la->num];
+      ++lb->num;
+      parent->keys[c] = lb->items[0];
+      --parent->counts[c - 1];
+      ++parent->counts[c];
+      return;
+    }
+    la = lb;
+    lb = c + 1 < parent->num ?
+      (sc_btree_leaf_t *) parent->children[c + 1] : NULL;
+    if (lb != NULL && lb->num > SC_BTREE_MIN) {
+      /* borrow the first item of the right sibling */
+      la->items[la->num++] = lb->items[0];
+      memmove (lb->items, lb->items + 1, --lb->num * sizeof (void *));
+      parent->keys[c + 1] = lb->items[0];
+      ++parent->counts[c];
+      --parent->counts[c + 1];
+      return;
+    }
+
+    /* merge with a sibling */
+    left = c > 0 ? c - 1 : c;
+    la = (sc_btree_leaf_t *) parent->children[left];
+    lb = (sc_btree_leaf_t *) parent->children[left + 1];
+    memcpy (la->items + la->num, lb->items, lb->num * sizeof (void *));
+    la->num += lb->num;
+    sc_mempool_free (tree->leaves, lb);
+  }
+  else {
+    ia = c > 0 ? (sc_btree_inner_t *) parent->children[c - 1] : NULL;
+    ib = (sc_btree_inner_t *) parent->children[c];
+    if (ia != NULL && ia->num > SC_BTREE_MIN) {
+      /* borrow the last child of the left sibling */
+      n = ib->num;
+      memmove (ib->keys + 1, ib->keys, n * sizeof (void *));
+      memmove (ib->children + 1, ib->children, n * sizeof (void *));
+      memmove (ib->counts + 1, ib->counts, n * sizeof (size_t));
+      --ia->num;
+      ib->keys[1] = parent->keys[c];
+      ib->keys[0] = ia->keys[ia->num];
+      ib->children[0] = ia->children[ia->num];
+      ib->counts[0] = ia->counts[ia->num];
+      ++ib->num;
+      parent->keys[c] = ia->keys[ia->num];
+      parent->counts[c - 1] -= ib->counts[0];
+      parent->counts[c] += ib->counts[0];
+      return;
+    }
+    ia = ib;
+    ib = c + 1 < parent->num ?
+      (sc_btree_inner_t *) parent->children[c + 1] : NULL;
+    if (ib != NULL && ib->num > SC_BTREE_MIN) {
+      /* borrow the first child of the right sibling */
+      n = ia->num++;
+      ia->keys[n] = parent->keys[c + 1];
+      ia->children[n] = ib->children[0];
+      ia->counts[n] = ib->counts[0];
+      parent->keys[c + 1] = ib->keys[1];
+      parent->counts[c] += ib->counts[0];
+      parent->counts[c + 1] -= ib->counts[0];
+      n = --ib->num;
+      memmove (ib->keys, ib->keys + 1, n * sizeof (void *));
+      memmove (ib->children, ib->children + 1, n * sizeof (void *));
+      memmove (ib->counts, ib->counts + 1, n * sizeof (size_t));
+      return;
+    }
+
+    /* merge with a sibling */
+    left = c > 0 ? c - 1 : c;
+    ia = (sc_btree_inner_t *) parent->children[left];
+    ib = (sc_btree_inner_t *) parent->children[left + 1];
+    ib->keys[0] = parent->keys[left + 1];
+    memcpy (ia->keys + ia->num, ib->keys, ib->num * sizeof (void *));
+    memcpy (ia->children + ia->num, ib->children, ib->num * sizeof (void *));
+    memcpy (ia->counts + ia->num, ib->counts, ib->num * sizeof (size_t));
+    ia->num += ib->num;
+    sc_mempool_free (tree->inners, ib);
+  }
+
+  /* remove the right one of the merged children from the parent */
+  parent->counts[left] += parent->counts[left + 1];
+  n = parent->num - left - 2;
+  memmove (parent->keys + left + 1, parent->keys + left + 2,
+           n * sizeof (void *));
+  memmove (parent->children + left + 1, parent->children + left + 2,
+           n * sizeof (void *));
+  memmove (parent->counts + left + 1, parent->counts + left + 2,
+           n * sizeof (size_t));
+  --parent->num;
+}
+
+/** Return the smallest item below a node. */
+static void        *
+sc_btree_node_first (const sc_btree_t * tree, void *node, int level)
+{
+  for (; level < tree->height - 1; ++level) {
+    node = ((sc_btree_inner_t *) node)->children[0];
+  }
+  SC_ASSERT (((sc_btree_leaf_t *) node)->num > 0);
+  return ((sc_btree_leaf_t *) node)->items[0];
+}
+
+/** Remove an item from the subtree of a node.
+ * \param [out] found       True if an equal item has been removed.
+ * \return                  The removed item.
+ */
+static void        *
+sc_btree_delete_node (sc_btree_t * tree, void *node, int level,
+                      const void *item, int *found)
+{
+  int                 pos, equal;
+  void               *removed;
+  sc_btree_leaf_t    *leaf;
+  sc_btree_inner_t   *inner;
+
+  if (level == tree->height - 1) {
+    leaf = (sc_btree_leaf_t *) node;
+    pos = sc_btree_leaf_lower (tree, leaf, item, &equal);
+    if (!(*found = equal)) {
+      return NULL;
+    }
+    removed = leaf->items[pos];
+    --leaf->num;
+    memmove (leaf->items + pos, leaf->items + pos + 1,
+             (leaf->num - pos) * sizeof (void *));
+    return removed;
+  }
+
+  inner = (sc_btree_inner_t *) node;
+  pos = sc_btree_inner_child (tree, inner, item);
+  removed = sc_btree_delete_node (tree, inner->children[pos], level + 1,
+                                  item, found);
+  if (*found) {
+    --inner->counts[pos];
+    if (inner->keys[pos] == removed) {
+      /* the separator must not refer to the removed item */
+      inner->keys[pos] = sc_btree_node_first (tree, inner->children[pos],
+                                              level + 1);
+    }
+    if ((level + 1 == tree->height - 1 ?
+         ((sc_btree_leaf_t *) inner->children[pos])->num :
+         ((sc_btree_inner_t *) inner->children[pos])->num) < SC_BTREE_MIN) {
+      sc_btree_rebalance (tree, inner, pos, level + 1 == tree->height - 1);
+    }
+  }
+  return removed;
+}
+
+void               *
+sc_btree_delete (sc_btree_t * tree, const void *item)
+{
+  int                 found;
+  void               *removed, *root;
+
+  if (tree->height == 0) {
+    return NULL;
+  }
+  removed = sc_btree_delete_node (tree, tree->root, 0, item, &found);
+  if (!found) {
+    return NULL;
+  }
+  --tree->count;
+
+  /* shrink the tree from the top */
+  root = tree->root;
+  if (tree->height == 1) {
+    if (((sc_btree_leaf_t *) root)->num == 0) {
+      sc_mempool_free (tree->leaves, root);
+      tree->root = NULL;
+      tree->height = 0;
+    }
+  }
+  else if (((sc_btree_inner_t *) root)->num == 1) {
+    tree->root = ((sc_btree_inner_t *) root)->children[0];
+    sc_mempool_free (tree->inners, root);
+    --tree->height;
+  }
+
+  if (tree->freeitem != NULL) {
+    tree->freeitem (removed);
+    return NULL;
+  }
+  return removed;
+}
+
+void               *
+sc_btree_delete_iter (sc_btree_t * tree, sc_btree_iter_t * iter)
+{
+  void               *item;
+
+  SC_ASSERT (iter->tree == tree);
+
+  item = sc_btree_item (iter);
+  iter->tree = NULL;
+  return sc_btree_delete (tree, item);
+}
+
+static void
+sc_btree_foreach_node (sc_btree_t * tree, void *node, int level,
+                       sc_btree_foreach_t fn, void *data)
+{
+  int                 i;
+  sc_btree_leaf_t    *leaf;
+  sc_btree_inner_t   *inner;
+
+  if (level == tree->height - 1) {
+    leaf = (sc_btree_leaf_t *) node;
+    for (i = 0; i < leaf->num; ++i) {
+      fn (leaf->items[i], data);
+    }
+  }
+  else {
+    inner = (sc_btree_inner_t *) node;
+    for (i = 0; i < inner->num; ++i) {
+      sc_btree_foreach_node (tree, inner->children[i], level + 1, fn, data);
+    }
+  }
+}
+
+void
+sc_btree_foreach (sc_btree_t * tree, sc_btree_foreach_t fn, void *data)
+{
+  if (tree->height > 0) {
+    sc_btree_foreach_node (tree, tree->root, 0, fn, data);
+  }
+}
+
+static void
+sc_btree_to_array_item (void *item, void *data)
+{
+  *(void **) sc_array_push ((sc_array_t *) data) = item;
+}
+
+void
+sc_btree_to_array (sc_btree_t * tree, sc_array_t * array)
+{
+  SC_ASSERT (array->elem_size == sizeof (void *));
+
+  sc_array_resize (array, 0);
+  sc_btree_foreach (tree, sc_btree_to_array_item, array);
+  SC_ASSERT (array->elem_count == tree->count);
+}
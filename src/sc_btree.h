@@ -0,0 +1,220 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_btree.h
+ *
+ * An ordered container of items implemented as a B+-tree.
+ * It offers the operations of the AVL tree in \ref sc_avl.h, including
+ * searching for the closest item, access by rank and in-order iteration.
+ * The items are kept in leaves of up to \ref SC_BTREE_ORDER pointers, which
+ * makes the tree shallow and its nodes dense in the cache.  The nodes are
+ * allocated from memory pools instead of one allocation per item.
+ */
+
+#ifndef SC_BTREE_H
+#define SC_BTREE_H
+
+#include <sc_containers.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** The maximum number of items in a leaf and children of an inner node. */
+#define SC_BTREE_ORDER 32
+
+/** The maximum height of a tree, enough for any number of items. */
+#define SC_BTREE_MAX_HEIGHT 16
+
+/** Compare two items like strcmp does. */
+typedef int         (*sc_btree_compare_t) (const void *, const void *);
+
+/** Free an item when it is removed by the tree, or NULL to leave it. */
+typedef void        (*sc_btree_freeitem_t) (void *);
+
+/** Called for every item in order by \ref sc_btree_foreach. */
+typedef void        (*sc_btree_foreach_t) (void *item, void *data);
+
+/** The sc_btree object provides an ordered set of items. */
+typedef struct sc_btree
+{
+  /* interface variables */
+  size_t              count;            /**< number of items */
+  sc_btree_compare_t  compare;          /**< orders the items */
+  sc_btree_freeitem_t freeitem;         /**< frees removed items or NULL */
+
+  /* implementation variables */
+  int                 height;           /**< 0 if empty, 1 if root is leaf */
+  void               *root;             /**< leaf or inner node */
+  sc_mempool_t       *leaves;           /**< memory for leaf nodes */
+  sc_mempool_t       *inners;           /**< memory for inner nodes */
+}
+sc_btree_t;
+
+/** A position of an item in a tree.
+ * It is invalidated by any insertion into or deletion from the tree.
+ */
+typedef struct sc_btree_iter
+{
+  const sc_btree_t   *tree;             /**< NULL if the position is invalid */
+  void               *nodes[SC_BTREE_MAX_HEIGHT];       /**< path from root */
+  int                 pos[SC_BTREE_MAX_HEIGHT];         /**< child indices */
+}
+sc_btree_iter_t;
+
+/** Create a new empty tree.
+ * \param [in] compare      Orders the items; equal items are not inserted.
+ * \param [in] freeitem     Called on items when they are removed by the
+ *                          tree, including \ref sc_btree_destroy.
+ *                          If NULL, the items are left alone.
+ * \return                  A new tree.
+ */
+sc_btree_t         *sc_btree_new (sc_btree_compare_t compare,
+                                  sc_btree_freeitem_t freeitem);
+
+/** Destroy a tree and free its items as in \ref sc_btree_clear.
+ * This corresponds to avl_free_tree.
+ */
+void                sc_btree_destroy (sc_btree_t * tree);
+
+/** Remove all items from a tree, calling freeitem on them if not NULL.
+ * This corresponds to avl_free_nodes.
+ */
+void                sc_btree_clear (sc_btree_t * tree);
+
+/** Return the number of bytes used by a tree. */
+size_t              sc_btree_memory_used (sc_btree_t * tree);
+
+/** Insert an item into a tree in O(log n).
+ * \param [in] item         Item to insert.
+ * \param [out] iter        If not NULL, the position of the inserted item
+ *                          or of the equal item already in the tree.
+ * \return                  True if inserted, false if an equal item exists,
+ *                          as avl_insert returns a node or NULL.
+ */
+int                 sc_btree_insert (sc_btree_t * tree, void *item,
+                                     sc_btree_iter_t * iter);
+
+/** Remove an item equal to the given one in O(log n).
+ * \param [in] item         Item to search for.
+ * \return                  The removed item, or NULL if none was found or
+ *                          if it has been passed to the tree's freeitem.
+ */
+void               *sc_btree_delete (sc_btree_t * tree, const void *item);
+
+/** Remove the item at a position in O(log n).
+ * \param [in] iter         Valid position, which is invalidated.
+ * \return                  As \ref sc_btree_delete.
+ */
+void               *sc_btree_delete_iter (sc_btree_t * tree,
+                                          sc_btree_iter_t * iter);
+
+/** Search for an item equal to the given one in O(log n).
+ * \param [in] item         Item to search for.
+ * \param [out] iter        If not NULL, the position of the found item
+ *                          or invalid.
+ * \return                  The item in the tree, or NULL if not found.
+ */
+void               *sc_btree_search (const sc_btree_t * tree,
+                                     const void *item,
+                                     sc_btree_iter_t * iter);
+
+/** Search for the item closest to the given one in O(log n).
+ * This is the smallest item not less than the given one, or the largest
+ * item of the tree if all are less.
+ * \param [in] item         Item to search for.
+ * \param [out] iter        If not NULL, the position of the found item,
+ *                          which is invalid if the tree is empty.
+ * \return                  -1 if the found item is greater,
+ *                          0 if it is equal or the tree is empty,
+ *                          1 if it is smaller, as avl_search_closest
+ *                          which compares the given item to the found one.
+ */
+int                 sc_btree_search_closest (const sc_btree_t * tree,
+                                             const void *item,
+                                             sc_btree_iter_t * iter);
+
+/** Return the number of items less than the given one in O(log n).
+ * \param [in] item         Item to compare with.
+ * \return                  The rank the item has or would have.
+ */
+size_t              sc_btree_rank (const sc_btree_t * tree,
+                                   const void *item);
+
+/** Return the item of a given rank in O(log n).
+ * \param [in] index        Rank counted from 0.
+ * \param [out] iter        If not NULL, the position of the item.
+ * \return                  The item, or NULL if index is not less than
+ *                          the number of items, as avl_at.
+ */
+void               *sc_btree_at (const sc_btree_t * tree, size_t index,
+                                 sc_btree_iter_t * iter);
+
+/** Return the rank of the item at a position in O(log n), as avl_index.
+ * \param [in] iter         Valid position.
+ */
+size_t              sc_btree_index (const sc_btree_iter_t * iter);
+
+/** Set a position to the smallest item.
+ * \param [out] iter        Position, invalid if the tree is empty.
+ * \return                  The item or NULL.
+ */
+void               *sc_btree_first (const sc_btree_t * tree,
+                                    sc_btree_iter_t * iter);
+
+/** Set a position to the largest item.
+ * \param [out] iter        Position, invalid if the tree is empty.
+ * \return                  The item or NULL.
+ */
+void               *sc_btree_last (const sc_btree_t * tree,
+                                   sc_btree_iter_t * iter);
+
+/** Advance a position to the next larger item.
+ * \param [in,out] iter     Valid position.  Invalid after the last item.
+ * \return                  The next item or NULL.
+ */
+void               *sc_btree_next (sc_btree_iter_t * iter);
+
+/** Move a position to the next smaller item.
+ * \param [in,out] iter     Valid position.  Invalid before the first item.
+ * \return                  The previous item or NULL.
+ */
+void               *sc_btree_prev (sc_btree_iter_t * iter);
+
+/** Return the item at a position.
+ * \param [in] iter         Position.
+ * \return                  The item, or NULL if the position is invalid.
+ */
+void               *sc_btree_item (const sc_btree_iter_t * iter);
+
+/** Call a function for every item in order. */
+void                sc_btree_foreach (sc_btree_t * tree,
+                                      sc_btree_foreach_t fn, void *data);
+
+/** Copy all items in order into an array of void *, as avl_to_array.
+ * \param [in,out] array    Resized to the number of items.
+ */
+void                sc_btree_to_array (sc_btree_t * tree,
+                                       sc_array_t * array);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_BTREE_H */
@@ -22,12 +22,31 @@
 */
 
 #include <sc_containers.h>
+#include <sc_crc32c.h>
+#include <sc_thread.h>
+#include <sc_uint128.h>
 #ifdef SC_HAVE_ZLIB
 #include <zlib.h>
 #endif
 
 /* array routines */
 
+/** Return the mapped file holding the elements of an array, or NULL. */
+static sc_pages_file_t *
+sc_array_file (const sc_array_t * array)
+{
+  return array->backing != NULL && array->backing->huge == SC_PAGES_MAPFILE ?
+    (sc_pages_file_t *) array->backing : NULL;
+}
+
+/** Return the page policy of an array, or NULL. */
+static const sc_pages_policy_t *
+sc_array_policy (const sc_array_t * array)
+{
+  return array->backing != NULL && array->backing->huge != SC_PAGES_MAPFILE ?
+    array->backing : NULL;
+}
+
 size_t
 sc_array_memory_used (sc_array_t * array, int is_dynamic)
 {
@@ -83,11 +102,68 @@ sc_array_new_data (void *base, size_t elem_size, size_t elem_count)
   return view;
 }
 
+sc_array_t         *
+sc_array_new_file (const char *filename, size_t elem_size, int create)
+{
+  sc_pages_file_t    *file;
+  sc_array_t         *array;
+
+  SC_ASSERT (elem_size > 0);
+
+  file = sc_pages_file_open (filename, create);
+  if (file == NULL) {
+    return NULL;
+  }
+  if (file->length % elem_size != 0) {
+    SC_LERRORF ("File %s is not an array of size %lu\n", filename,
+                (unsigned long) elem_size);
+    sc_pages_file_close (file, file->length);
+    return NULL;
+  }
+
+  array = sc_array_new (elem_size);
+  array->elem_count = file->length / elem_size;
+  array->byte_alloc = (ssize_t) file->length;
+  array->array = (char *) file->data;
+  array->backing = &file->policy;
+
+  return array;
+}
+
+int
+sc_array_flush (sc_array_t * array)
+{
+  SC_ASSERT (sc_array_file (array) != NULL);
+
+  return sc_pages_file_sync (sc_array_file (array),
+                             array->elem_count * array->elem_size);
+}
+
+/** Free the memory of an array that owns it. */
+static void
+sc_array_free_memory (sc_array_t * array)
+{
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (sc_array_file (array) != NULL) {
+    sc_pages_file_close (sc_array_file (array),
+                         array->elem_count * array->elem_size);
+    array->backing = NULL;
+  }
+  else if (array->backing == NULL) {
+    SC_FREE (array->array);
+  }
+  else {
+    sc_pages_free (array->backing, array->array,
+                   (size_t) array->byte_alloc);
+  }
+}
+
 void
 sc_array_destroy (sc_array_t * array)
 {
   if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
+    sc_array_free_memory (array);
   }
   SC_FREE (array);
 }
@@ -111,6 +187,7 @@ sc_array_init (sc_array_t * array, size_t elem_size)
   array->elem_count = 0;
   array->byte_alloc = 0;
   array->array = NULL;
+  array->backing = NULL;
 }
 
 void
@@ -128,6 +205,7 @@ sc_array_init_count (sc_array_t * array, size_t elem_size, size_t elem_count)
   array->elem_count = elem_count;
   array->byte_alloc = (ssize_t) (elem_size * elem_count);
   array->array = SC_ALLOC (char, (size_t) array->byte_alloc);
+  array->backing = NULL;
 }
 
 void
@@ -140,6 +218,7 @@ sc_array_init_view (sc_array_t * view, sc_array_t * array, size_t offset,
   view->elem_count = length;
   view->byte_alloc = -(ssize_t) (length * array->elem_size + 1);
   view->array = array->array + offset * array->elem_size;
+  view->backing = NULL;
 }
 
 void
@@ -152,6 +231,7 @@ sc_array_init_data (sc_array_t * view, void *base, size_t elem_size,
   view->elem_count = elem_count;
   view->byte_alloc = -(ssize_t) (elem_count * elem_size + 1);
   view->array = (char *) base;
+  view->backing = NULL;
 }
 
 void
@@ -164,7 +244,7 @@ void
 sc_array_reset (sc_array_t * array)
 {
   if (SC_ARRAY_IS_OWNER (array)) {
-    SC_FREE (array->array);
+    sc_array_free_memory (array);
   }
   array->array = NULL;
 
@@ -181,7 +261,10 @@ sc_array_truncate (sc_array_t * array)
 
 #if SC_ENABLE_DEBUG
   SC_ASSERT (array->byte_alloc >= 0);
-  memset (array->array, (char) -1, array->byte_alloc);
+  if (sc_array_file (array) == NULL) {
+    /* a mapped file is not filled, which would write back all its pages */
+    memset (array->array, (char) -1, array->byte_alloc);
+  }
 #endif
 }
 
@@ -191,7 +274,8 @@ sc_array_rewind (sc_array_t * array, size_t new_count)
   SC_ASSERT (array != NULL);
   SC_ASSERT (array->elem_count >= new_count);
 
-  if (new_count == 0 && SC_ARRAY_IS_OWNER (array)) {
+  if (new_count == 0 && SC_ARRAY_IS_OWNER (array) &&
+      sc_array_file (array) == NULL) {
     sc_array_reset (array);
   }
   else {
@@ -202,7 +286,7 @@ sc_array_rewind (sc_array_t * array, size_t new_count)
 void
 sc_array_resize (sc_array_t * array, size_t new_count)
 {
-  size_t              newoffs, roundup, newsize;
+  size_t              newoffs, roundup, newsize, oldsize;
 #if !defined SC_ENABLE_USE_REALLOC || defined SC_ENABLE_DEBUG
   size_t              oldoffs, minoffs;
 #endif
@@ -222,6 +306,20 @@ sc_array_resize (sc_array_t * array, size_t new_count)
     return;
   }
 
+  /* A mapped file grows and shrinks like the allocation below. */
+  if (sc_array_file (array) != NULL) {
+    newoffs = new_count * array->elem_size;
+    roundup = newoffs == 0 ? 0 : (size_t) SC_ROUNDUP2_64 (newoffs);
+    array->elem_count = new_count;
+    if (newoffs > (size_t) array->byte_alloc ||
+        roundup < (size_t) array->byte_alloc) {
+      sc_pages_file_resize (sc_array_file (array), roundup);
+      array->byte_alloc = (ssize_t) roundup;
+      array->array = (char *) sc_array_file (array)->data;
+    }
+    return;
+  }
+
   /* We know that this array is not a view now so we can call reset. */
   if (new_count == 0) {
     sc_array_reset (array);
@@ -235,6 +333,7 @@ sc_array_resize (sc_array_t * array, size_t new_count)
   minoffs = SC_MIN (oldoffs, newoffs);
 #endif
   array->elem_count = new_count;
+  oldsize = (size_t) array->byte_alloc;
   roundup = (size_t) SC_ROUNDUP2_64 (newoffs);
   SC_ASSERT (roundup >= newoffs && roundup <= 2 * newoffs);
 
@@ -260,17 +359,23 @@ sc_array_resize (sc_array_t * array, size_t new_count)
   SC_ASSERT ((size_t) array->byte_alloc >= newoffs);
 
   newsize = (size_t) array->byte_alloc;
+  if (array->backing != NULL) {
+    array->array = (char *) sc_pages_realloc (array->backing, array->array,
+                                              oldsize, newsize);
+  }
+  else {
 #ifdef SC_ENABLE_USE_REALLOC
-  array->array = SC_REALLOC (array->array, char, newsize);
+    array->array = SC_REALLOC (array->array, char, newsize);
 #else
-  ptr = SC_ALLOC (char, newsize);
-  if (minoffs > 0) {
-    /* avoid calling memcpy on less well supported corner cases */
-    memcpy (ptr, array->array, minoffs);
-  }
-  SC_FREE (array->array);
-  array->array = ptr;
+    ptr = SC_ALLOC (char, newsize);
+    if (minoffs > 0) {
+      /* avoid calling memcpy on less well supported corner cases */
+      memcpy (ptr, array->array, minoffs);
+    }
+    SC_FREE (array->array);
+    array->array = ptr;
 #endif
+  }
 
 #ifdef SC_ENABLE_DEBUG
   SC_ASSERT (minoffs <= newsize);
@@ -278,6 +383,45 @@ sc_array_resize (sc_array_t * array, size_t new_count)
 #endif
 }
 
+void
+sc_array_set_policy (sc_array_t * array, const sc_pages_policy_t * policy)
+{
+  size_t              size;
+  char               *ptr;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (sc_array_file (array) == NULL);
+  SC_ASSERT (policy == NULL || policy->huge != SC_PAGES_MAPFILE);
+
+  if (array->backing == policy) {
+    return;
+  }
+
+  /* move the contents into memory allocated with the new policy */
+  size = (size_t) array->byte_alloc;
+  if (size > 0) {
+    ptr = policy == NULL ? SC_ALLOC (char, size) :
+      (char *) sc_pages_alloc (policy, size);
+    memcpy (ptr, array->array, size);
+    sc_array_free_memory (array);
+    array->array = ptr;
+  }
+  array->backing = policy;
+}
+
+size_t
+sc_array_huge_bytes (sc_array_t * array)
+{
+  void               *ptr = array->array;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (sc_array_policy (array) == NULL || array->byte_alloc == 0) {
+    return 0;
+  }
+  return sc_pages_huge_bytes (1, &ptr, (size_t) array->byte_alloc);
+}
+
 void
 sc_array_copy (sc_array_t * dest, sc_array_t * src)
 {
@@ -330,6 +474,307 @@ sc_array_sort (sc_array_t * array, int (*compar) (const void *, const void *))
   qsort (array->array, array->elem_count, array->elem_size, compar);
 }
 
+/** Buckets below this size are sorted by insertion. */
+#define SC_ARRAY_RADIX_SMALL 32
+
+/** Locate the byte digits of a key in an array element. */
+typedef struct sc_array_radix
+{
+  size_t              elem_size;
+  size_t              num_digits;
+  size_t              pos[16];  /**< least significant digit first */
+  unsigned char       flip;     /**< applied to the most significant digit */
+}
+sc_array_radix_t;
+
+static void
+sc_array_radix_init (sc_array_radix_t * radix, size_t elem_size,
+                     sc_array_key_t key_type, size_t key_offset)
+{
+  const int           one = 1;
+  int                 bigendian;
+  size_t              width, b, w, num_words;
+  size_t              word_offset[2];
+
+  /* the byte order is probed at run time and needs no configure result */
+  bigendian = *(const unsigned char *) &one == 0;
+
+  word_offset[0] = word_offset[1] = 0;
+  switch (key_type) {
+  case SC_ARRAY_KEY_INT32:
+  case SC_ARRAY_KEY_UINT32:
+    width = 4;
+    num_words = 1;
+    break;
+  case SC_ARRAY_KEY_INT64:
+  case SC_ARRAY_KEY_UINT64:
+    width = 8;
+    num_words = 1;
+    break;
+  case SC_ARRAY_KEY_UINT128:
+    width = 8;
+    num_words = 2;
+    word_offset[0] = offsetof (sc_uint128_t, low_bits);
+    word_offset[1] = offsetof (sc_uint128_t, high_bits);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  SC_ASSERT (key_offset + num_words * width <= elem_size);
+
+  radix->elem_size = elem_size;
+  radix->num_digits = num_words * width;
+  for (w = 0; w < num_words; ++w) {
+    for (b = 0; b < width; ++b) {
+      radix->pos[w * width + b] = key_offset + word_offset[w] +
+        (bigendian ? width - 1 - b : b);
+    }
+  }
+  radix->flip = (key_type == SC_ARRAY_KEY_INT32 ||
+                 key_type == SC_ARRAY_KEY_INT64) ? 0x80 : 0;
+}
+
+/** Return the digit d of the key of an element. */
+static inline unsigned
+sc_array_radix_digit (const sc_array_radix_t * radix, const char *elem,
+                      size_t d)
+{
+  return ((const unsigned char *) elem)[radix->pos[d]] ^
+    (d + 1 == radix->num_digits ? radix->flip : 0);
+}
+
+/** Copy one element, with fixed sizes for the most common cases. */
+static inline void
+sc_array_radix_copy (char *dest, const char *src, size_t elem_size)
+{
+  switch (elem_size) {
+  case 4:
+    memcpy (dest, src, 4);
+    break;
+  case 8:
+    memcpy (dest, src, 8);
+    break;
+  case 16:
+    memcpy (dest, src, 16);
+    break;
+  default:
+    memcpy (dest, src, elem_size);
+  }
+}
+
+/** Stable sort by the least significant digit first. */
+static void
+sc_array_radix_lsd (const sc_array_radix_t * radix, char *data,
+                    size_t count)
+{
+  const size_t        es = radix->elem_size;
+  const size_t        nd = radix->num_digits;
+  size_t              zz, d, sum, c;
+  size_t             *hist, *h;
+  unsigned            digit;
+  char               *buffer, *src, *dest, *swap;
+
+  /* count the digits of all positions in one sweep */
+  hist = SC_ALLOC_ZERO (size_t, 256 * nd);
+  for (zz = 0; zz < count; ++zz) {
+    for (d = 0; d < nd; ++d) {
+      ++hist[256 * d + sc_array_radix_digit (radix, data + zz * es, d)];
+    }
+  }
+
+  buffer = SC_ALLOC (char, count * es);
+  src = data;
+  dest = buffer;
+  for (d = 0; d < nd; ++d) {
+    h = hist + 256 * d;
+    if (h[sc_array_radix_digit (radix, src, d)] == count) {
+      /* all keys share this digit */
+      continue;
+    }
+    for (digit = 0, sum = 0; digit < 256; ++digit) {
+      c = h[digit];
+      h[digit] = sum;
+      sum += c;
+    }
+    for (zz = 0; zz < count; ++zz) {
+      digit = sc_array_radix_digit (radix, src + zz * es, d);
+      sc_array_radix_copy (dest + h[digit]++ * es, src + zz * es, es);
+    }
+    swap = src;
+    src = dest;
+    dest = swap;
+  }
+  if (src != data) {
+    memcpy (data, src, count * es);
+  }
+
+  SC_FREE (buffer);
+  SC_FREE (hist);
+}
+
+/** Return true if the key of a is less than the key of b.
+ * Only the digits d and below are compared.
+ */
+static inline int
+sc_array_radix_less (const sc_array_radix_t * radix, const char *a,
+                     const char *b, size_t d)
+{
+  unsigned            da, db;
+
+  for (;; --d) {
+    da = sc_array_radix_digit (radix, a, d);
+    db = sc_array_radix_digit (radix, b, d);
+    if (da != db) {
+      return da < db;
+    }
+    if (d == 0) {
+      return 0;
+    }
+  }
+}
+
+/** Unstable sort in place by the most significant digit first.
+ * \param [in] d       The digit to sort by; the higher ones are equal.
+ * \param [in] temp    Memory for one element.
+ */
+static void
+sc_array_radix_msd (const sc_array_radix_t * radix, char *data,
+                    size_t count, size_t d, char *temp)
+{
+  const size_t        es = radix->elem_size;
+  size_t              zz, yy, sum;
+  size_t              head[256], tail[256];
+  unsigned            digit, b;
+
+  for (;;) {
+    if (count < SC_ARRAY_RADIX_SMALL) {
+      /* insertion sort */
+      for (zz = 1; zz < count; ++zz) {
+        for (yy = zz; yy > 0 && sc_array_radix_less
+             (radix, data + zz * es, data + (yy - 1) * es, d); --yy);
+        if (yy < zz) {
+          memcpy (temp, data + zz * es, es);
+          memmove (data + (yy + 1) * es, data + yy * es, (zz - yy) * es);
+          memcpy (data + yy * es, temp, es);
+        }
+      }
+      return;
+    }
+
+    memset (head, 0, 256 * sizeof (size_t));
+    for (zz = 0; zz < count; ++zz) {
+      ++head[sc_array_radix_digit (radix, data + zz * es, d)];
+    }
+    digit = sc_array_radix_digit (radix, data, d);
+    if (head[digit] < count) {
+      break;
+    }
+    if (d == 0) {
+      /* all keys are equal */
+      return;
+    }
+    --d;
+  }
+
+  /* permute the elements into their buckets by cycles */
+  for (b = 0, sum = 0; b < 256; ++b) {
+    tail[b] = sum + head[b];
+    head[b] = sum;
+    sum = tail[b];
+  }
+  for (b = 0; b < 256; ++b) {
+    while (head[b] < tail[b]) {
+      digit = sc_array_radix_digit (radix, data + head[b] * es, d);
+      if (digit == b) {
+        ++head[b];
+        continue;
+      }
+      memcpy (temp, data + head[b] * es, es);
+      memcpy (data + head[b] * es, data + head[digit] * es, es);
+      memcpy (data + head[digit]++ * es, temp, es);
+    }
+  }
+
+  /* every bucket now ends where the next one begins */
+  if (d > 0) {
+    for (b = 0, sum = 0; b < 256; ++b) {
+      if (tail[b] - sum > 1) {
+        sc_array_radix_msd (radix, data + sum * es, tail[b] - sum, d - 1,
+                            temp);
+      }
+      sum = tail[b];
+    }
+  }
+}
+
+/** Stable sort of large elements by way of records of key and index. */
+static void
+sc_array_radix_indexed (const sc_array_radix_t * radix, char *data,
+                        size_t count, size_t key_offset, size_t key_size)
+{
+  const size_t        es = radix->elem_size;
+  const size_t        rs = key_size + sizeof (size_t);
+  size_t              zz, d, index;
+  char               *records, *sorted;
+  sc_array_radix_t    rradix;
+
+  /* the key bytes keep their layout inside the records */
+  rradix = *radix;
+  rradix.elem_size = rs;
+  for (d = 0; d < radix->num_digits; ++d) {
+    rradix.pos[d] = radix->pos[d] - key_offset;
+  }
+  records = SC_ALLOC (char, count * rs);
+  for (zz = 0; zz < count; ++zz) {
+    memcpy (records + zz * rs, data + zz * es + key_offset, key_size);
+    memcpy (records + zz * rs + key_size, &zz, sizeof (size_t));
+  }
+  sc_array_radix_lsd (&rradix, records, count);
+
+  /* gather the elements in sorted order */
+  sorted = SC_ALLOC (char, count * es);
+  for (zz = 0; zz < count; ++zz) {
+    memcpy (&index, records + zz * rs + key_size, sizeof (size_t));
+    memcpy (sorted + zz * es, data + index * es, es);
+  }
+  memcpy (data, sorted, count * es);
+
+  SC_FREE (sorted);
+  SC_FREE (records);
+}
+
+void
+sc_array_sort_radix (sc_array_t * array, sc_array_key_t key_type,
+                     size_t key_offset, int stable)
+{
+  const size_t        count = array->elem_count;
+  const size_t        es = array->elem_size;
+  size_t              key_size;
+  char               *temp;
+  sc_array_radix_t    radix;
+
+  if (count <= 1) {
+    return;
+  }
+  sc_array_radix_init (&radix, es, key_type, key_offset);
+  key_size = radix.num_digits;
+
+  if (!stable || count < SC_ARRAY_RADIX_SMALL) {
+    /* this is stable for few elements since they are sorted by insertion */
+    temp = SC_ALLOC (char, es);
+    sc_array_radix_msd (&radix, array->array, count, key_size - 1, temp);
+    SC_FREE (temp);
+  }
+  else if (es >= 2 * (key_size + sizeof (size_t))) {
+    /* moving small records in every pass is cheaper */
+    sc_array_radix_indexed (&radix, array->array, count, key_offset,
+                            key_size);
+  }
+  else {
+    sc_array_radix_lsd (&radix, array->array, count);
+  }
+}
+
 int
 sc_array_is_sorted (sc_array_t * array,
                     int (*compar) (const void *, const void *))
@@ -516,73 +961,736 @@ sc_array_split (sc_array_t * array, sc_array_t * offsets, size_t num_types,
   }
 }
 
-int
-sc_array_is_permutation (sc_array_t * newindices)
+/* parallel array routines */
+
+/** Runs shorter than this are sorted by insertion before merging. */
+#define SC_ARRAY_MERGE_RUN 16
+
+/** Merge two sorted ranges stably into a third one. */
+static void
+sc_array_merge (int (*compar) (const void *, const void *), size_t es,
+                const char *a, size_t m, const char *b, size_t k, char *out)
 {
-  size_t              count = newindices->elem_count;
-  int                *counted = SC_ALLOC_ZERO (int, count);
-  size_t              zi;
-  size_t              zj;
-  size_t             *newind;
+  while (m > 0 && k > 0) {
+    if (compar (b, a) < 0) {
+      memcpy (out, b, es);
+      b += es;
+      --k;
+    }
+    else {
+      memcpy (out, a, es);
+      a += es;
+      --m;
+    }
+    out += es;
+  }
+  memcpy (out, a, m * es);
+  memcpy (out + m * es, b, k * es);
+}
 
-  SC_ASSERT (newindices->elem_size == sizeof (size_t));
-  if (!newindices->elem_count) {
-    SC_FREE (counted);
-    return 1;
+/** Return how many of the first i merged elements are taken from a. */
+static size_t
+sc_array_merge_corank (int (*compar) (const void *, const void *),
+                       size_t es, const char *a, size_t m,
+                       const char *b, size_t k, size_t i)
+{
+  size_t              low, high, j;
+
+  SC_ASSERT (i <= m + k);
+
+  low = i > k ? i - k : 0;
+  high = SC_MIN (i, m);
+  while (low < high) {
+    j = low + (high - low) / 2;
+    if (compar (a + j * es, b + (i - j - 1) * es) <= 0) {
+      /* a[j] precedes b[i - j - 1] in the merged order */
+      low = j + 1;
+    }
+    else {
+      high = j;
+    }
   }
-  newind = (size_t *) sc_array_index (newindices, 0);
+  return low;
+}
 
-  for (zi = 0; zi < count; zi++) {
-    zj = newind[zi];
-    if (zj >= count) {
-      SC_FREE (counted);
-      return 0;
+/** Stable merge sort with a buffer of the same size. */
+static void
+sc_array_mergesort (int (*compar) (const void *, const void *), size_t es,
+                    char *data, char *buffer, size_t n)
+{
+  size_t              zz, yy, s, w, m, k;
+  char               *src, *dest, *swap;
+
+  /* sort short runs by insertion, using the buffer for the moved element */
+  for (s = 0; s < n; s += SC_ARRAY_MERGE_RUN) {
+    m = SC_MIN (n, s + SC_ARRAY_MERGE_RUN);
+    for (zz = s + 1; zz < m; ++zz) {
+      for (yy = zz; yy > s && compar (data + (yy - 1) * es,
+                                      data + zz * es) > 0; --yy);
+      if (yy < zz) {
+        memcpy (buffer, data + zz * es, es);
+        memmove (data + (yy + 1) * es, data + yy * es, (zz - yy) * es);
+        memcpy (data + yy * es, buffer, es);
+      }
     }
-    counted[zj]++;
   }
 
-  for (zi = 0; zi < count; zi++) {
-    if (counted[zi] != 1) {
-      SC_FREE (counted);
-      return 0;
+  /* merge runs of doubling width */
+  src = data;
+  dest = buffer;
+  for (w = SC_ARRAY_MERGE_RUN; w < n; w *= 2) {
+    for (s = 0; s < n; s += 2 * w) {
+      m = SC_MIN (w, n - s);
+      k = SC_MIN (w, n - s - m);
+      sc_array_merge (compar, es, src + s * es, m, src + (s + m) * es, k,
+                      dest + s * es);
     }
+    swap = src;
+    src = dest;
+    dest = swap;
+  }
+  if (src != data) {
+    memcpy (data, src, n * es);
   }
+}
 
-  SC_FREE (counted);
-  return 1;
+/** Shared state of the threads of a parallel array operation. */
+typedef struct sc_array_team
+{
+  int                 (*compar) (const void *, const void *);
+  size_t              es;
+  size_t              count;
+  char               *src;
+  char               *dest;
+  size_t             *runs;     /**< offsets of the sorted runs */
+  size_t              num_runs;
+  size_t             *counts;   /**< per thread, or per thread and type */
+  size_t              num_types;
+  sc_array_t         *array;
+  sc_array_type_t     type_fn;
+  void               *data;
+}
+sc_array_team_t;
+
+static void
+sc_array_team_range (sc_array_team_t * team, int thread_id, int num_threads,
+                     size_t *begin, size_t *end)
+{
+  *begin = team->count * thread_id / num_threads;
+  *end = team->count * (thread_id + 1) / num_threads;
+}
+
+static void
+sc_array_sort_chunk (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  sc_array_mergesort (team->compar, team->es, team->src + begin * team->es,
+                      team->dest + begin * team->es, end - begin);
+}
+
+/** Every thread writes an equal share of the output of a merge round. */
+static void
+sc_array_merge_round (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  const size_t        es = team->es;
+  size_t              begin, end, lo, hi, p;
+  size_t              first, middle, last, m, k, ja, jb;
+  char               *a, *b;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  for (p = 0; p < team->num_runs; p += 2) {
+    first = team->runs[p];
+    middle = team->runs[p + 1];
+    last = p + 2 <= team->num_runs ? team->runs[p + 2] : middle;
+    lo = SC_MAX (begin, first);
+    hi = SC_MIN (end, last);
+    if (lo >= hi) {
+      continue;
+    }
+    a = team->src + first * es;
+    b = team->src + middle * es;
+    m = middle - first;
+    k = last - middle;
+    ja = sc_array_merge_corank (team->compar, es, a, m, b, k, lo - first);
+    jb = sc_array_merge_corank (team->compar, es, a, m, b, k, hi - first);
+    sc_array_merge (team->compar, es, a + ja * es, jb - ja,
+                    b + (lo - first - ja) * es,
+                    (hi - first - jb) - (lo - first - ja),
+                    team->dest + lo * es);
+  }
+}
+
+static void
+sc_array_copy_range (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  memcpy (team->dest + begin * team->es, team->src + begin * team->es,
+          (end - begin) * team->es);
 }
 
-/** permute an array in place.  newind[i] is the new index for the data that
- * is currently at index i. entries in newind will be altered by this
- * procedure */
 void
-sc_array_permute (sc_array_t * array, sc_array_t * newindices, int keepperm)
+sc_array_sort_threads (sc_array_t * array,
+                       int (*compar) (const void *, const void *),
+                       int num_threads)
 {
-  size_t              zi, zj, zk;
-  char               *temp = SC_ALLOC (char, array->elem_size);
-  char               *carray = array->array;
-  size_t              esize = array->elem_size * sizeof (char);
-  size_t              count = array->elem_count;
-  size_t             *newind;
+  int                 t;
+  size_t              p, num_runs;
+  char               *buffer, *swap;
+  sc_array_team_t     team;
 
-  SC_ASSERT (newindices->elem_size == sizeof (size_t));
-  SC_ASSERT (newindices->elem_count == count);
-  SC_ASSERT (sc_array_is_permutation (newindices));
-  if (!count) {
-    SC_FREE (temp);
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  team.compar = compar;
+  team.es = array->elem_size;
+  team.count = array->elem_count;
+  if (team.count <= 1) {
     return;
   }
-
-  if (!keepperm) {
-    newind = (size_t *) sc_array_index (newindices, 0);
+  num_threads = (int) SC_MIN ((size_t) num_threads, team.count);
+
+  /* every thread sorts one chunk */
+  buffer = SC_ALLOC (char, team.count * team.es);
+  team.src = array->array;
+  team.dest = buffer;
+  team.runs = SC_ALLOC (size_t, num_threads + 1);
+  for (t = 0; t <= num_threads; ++t) {
+    team.runs[t] = team.count * t / num_threads;
   }
-  else {
-    newind = SC_ALLOC (size_t, count);
-    memcpy (newind, sc_array_index (newindices, 0), count * sizeof (size_t));
+  team.num_runs = (size_t) num_threads;
+  sc_thread_team_run (num_threads, sc_array_sort_chunk, &team);
+
+  /* merge pairs of runs until one is left */
+  while (team.num_runs > 1) {
+    sc_thread_team_run (num_threads, sc_array_merge_round, &team);
+    num_runs = (team.num_runs + 1) / 2;
+    for (p = 0; p < num_runs; ++p) {
+      team.runs[p] = team.runs[2 * p];
+    }
+    team.runs[num_runs] = team.count;
+    team.num_runs = num_runs;
+    swap = team.src;
+    team.src = team.dest;
+    team.dest = swap;
+  }
+  if (team.src != array->array) {
+    team.dest = array->array;
+    sc_thread_team_run (num_threads, sc_array_copy_range, &team);
   }
 
-  zi = 0;
-  zj = 0;
+  SC_FREE (team.runs);
+  SC_FREE (buffer);
+}
+
+/** Return true if the element is the last one of its run of equal ones. */
+static inline int
+sc_array_uniq_keep (sc_array_team_t * team, size_t i)
+{
+  return i + 1 == team->count ||
+    team->compar (team->src + i * team->es,
+                  team->src + (i + 1) * team->es) != 0;
+}
+
+static void
+sc_array_uniq_count (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end, zz, kept;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  for (zz = begin, kept = 0; zz < end; ++zz) {
+    kept += sc_array_uniq_keep (team, zz);
+  }
+  team->counts[thread_id] = kept;
+}
+
+static void
+sc_array_uniq_copy (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end, zz, pos;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  pos = team->counts[thread_id];
+  for (zz = begin; zz < end; ++zz) {
+    if (sc_array_uniq_keep (team, zz)) {
+      memcpy (team->dest + pos++ * team->es, team->src + zz * team->es,
+              team->es);
+    }
+  }
+}
+
+void
+sc_array_uniq_threads (sc_array_t * array,
+                       int (*compar) (const void *, const void *),
+                       int num_threads)
+{
+  int                 t;
+  size_t              sum, c;
+  char               *buffer;
+  sc_array_team_t     team;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  team.compar = compar;
+  team.es = array->elem_size;
+  team.count = array->elem_count;
+  if (team.count <= 1) {
+    return;
+  }
+  num_threads = (int) SC_MIN ((size_t) num_threads, team.count);
+
+  /* count the kept elements of every thread and compute their offsets */
+  team.src = array->array;
+  team.counts = SC_ALLOC (size_t, num_threads);
+  sc_thread_team_run (num_threads, sc_array_uniq_count, &team);
+  for (t = 0, sum = 0; t < num_threads; ++t) {
+    c = team.counts[t];
+    team.counts[t] = sum;
+    sum += c;
+  }
+
+  /* compact into a buffer and copy back */
+  buffer = SC_ALLOC (char, sum * team.es);
+  team.dest = buffer;
+  sc_thread_team_run (num_threads, sc_array_uniq_copy, &team);
+  team.src = buffer;
+  team.dest = array->array;
+  team.count = sum;
+  sc_thread_team_run ((int) SC_MIN ((size_t) num_threads, SC_MAX (sum, 1)),
+                      sc_array_copy_range, &team);
+  sc_array_resize (array, sum);
+
+  SC_FREE (buffer);
+  SC_FREE (team.counts);
+}
+
+static void
+sc_array_split_count (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end, zz, type;
+  size_t             *counts = team->counts + thread_id * team->num_types;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  memset (counts, 0, team->num_types * sizeof (size_t));
+  for (zz = begin; zz < end; ++zz) {
+    type = team->type_fn (team->array, zz, team->data);
+    SC_ASSERT (type < team->num_types);
+    ++counts[type];
+  }
+}
+
+static void
+sc_array_split_scatter (int thread_id, int num_threads, void *v)
+{
+  sc_array_team_t    *team = (sc_array_team_t *) v;
+  size_t              begin, end, zz, type;
+  size_t             *counts = team->counts + thread_id * team->num_types;
+
+  sc_array_team_range (team, thread_id, num_threads, &begin, &end);
+  for (zz = begin; zz < end; ++zz) {
+    type = team->type_fn (team->array, zz, team->data);
+    memcpy (team->dest + counts[type]++ * team->es,
+            team->src + zz * team->es, team->es);
+  }
+}
+
+void
+sc_array_split_threads (sc_array_t * array, sc_array_t * offsets,
+                        size_t num_types, sc_array_type_t type_fn,
+                        void *data, int num_threads)
+{
+  int                 t;
+  size_t              type, sum, c;
+  size_t             *zp;
+  char               *buffer;
+  sc_array_team_t     team;
+
+  SC_ASSERT (SC_ARRAY_IS_OWNER (array));
+  SC_ASSERT (offsets->elem_size == sizeof (size_t));
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  team.es = array->elem_size;
+  team.count = array->elem_count;
+  team.num_types = num_types;
+  team.array = array;
+  team.type_fn = type_fn;
+  team.data = data;
+  num_threads = (int) SC_MIN ((size_t) num_threads, SC_MAX (team.count, 1));
+
+  /* count the types of every thread */
+  sc_array_resize (offsets, num_types + 1);
+  zp = (size_t *) offsets->array;
+  team.counts = SC_ALLOC (size_t, num_threads * SC_MAX (num_types, 1));
+  if (team.count > 0) {
+    sc_thread_team_run (num_threads, sc_array_split_count, &team);
+  }
+
+  /* the objects of one type are ordered by thread */
+  for (type = 0, sum = 0; type < num_types; ++type) {
+    zp[type] = sum;
+    for (t = 0; t < num_threads; ++t) {
+      c = team.count > 0 ? team.counts[t * num_types + type] : 0;
+      team.counts[t * num_types + type] = sum;
+      sum += c;
+    }
+  }
+  zp[num_types] = sum;
+  SC_ASSERT (sum == team.count);
+
+  /* scatter into a buffer and copy back */
+  if (team.count > 0) {
+    buffer = SC_ALLOC (char, team.count * team.es);
+    team.src = array->array;
+    team.dest = buffer;
+    sc_thread_team_run (num_threads, sc_array_split_scatter, &team);
+    team.src = buffer;
+    team.dest = array->array;
+    sc_thread_team_run (num_threads, sc_array_copy_range, &team);
+    SC_FREE (buffer);
+  }
+  SC_FREE (team.counts);
+}
+
+int
+sc_array_is_permutation (sc_array_t * newindices)
+{
+  size_t              count = newindices->elem_count;
+  int                *counted = SC_ALLOC_ZERO (int, count);
+  size_t              zi;
+  size_t              zj;
+  size_t             *newind;
+
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+  if (!newindices->elem_count) {
+    SC_FREE (counted);
+    return 1;
+  }
+  newind = (size_t *) sc_array_index (newindices, 0);
+
+  for (zi = 0; zi < count; zi++) {
+    zj = newind[zi];
+    if (zj >= count) {
+      SC_FREE (counted);
+      return 0;
+    }
+    counted[zj]++;
+  }
+
+  for (zi = 0; zi < count; zi++) {
+    if (counted[zi] != 1) {
+      SC_FREE (counted);
+      return 0;
+    }
+  }
+
+  SC_FREE (counted);
+  return 1;
+}
+
+/** Destination blocks of a bucketed permutation fit into this many bytes. */
+#define SC_ARRAY_PERMUTE_BLOCK ((size_t) 1 << 18)
+
+/** Upper bound on the number of buckets, each one written as a stream. */
+#define SC_ARRAY_PERMUTE_BUCKETS ((size_t) 1 << 12)
+
+/** Shared state of the threads of a bucketed permutation. */
+typedef struct sc_array_permute
+{
+  size_t              es;       /**< zero when staging only the indices */
+  size_t              count;
+  const char         *src;
+  char               *dest;
+  const size_t       *newind;
+  int                 shift;    /**< bucket of index i is i >> shift */
+  size_t              num_buckets;
+  size_t             *counts;   /**< per thread and bucket */
+  size_t             *offsets;  /**< start of each bucket in the stage */
+  size_t             *stage_ind;
+  char               *stage;
+  char               *flags;    /**< one block per thread */
+  int                *valid;    /**< per thread */
+}
+sc_array_permute_t;
+
+static void
+sc_array_permute_init (sc_array_permute_t * perm, sc_array_t * newindices,
+                       size_t es, int num_threads)
+{
+  const size_t        unit = SC_MAX (es, 1);
+
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+
+  memset (perm, 0, sizeof (*perm));
+  perm->es = es;
+  perm->count = newindices->elem_count;
+  perm->newind = (const size_t *) newindices->array;
+
+  /* a destination block fits into the cache unless there are too many */
+  for (perm->shift = 0;
+       ((size_t) 2 << perm->shift) * unit <= SC_ARRAY_PERMUTE_BLOCK;
+       ++perm->shift);
+  while ((perm->count >> perm->shift) >= SC_ARRAY_PERMUTE_BUCKETS) {
+    ++perm->shift;
+  }
+  perm->num_buckets = perm->count == 0 ? 0 :
+    ((perm->count - 1) >> perm->shift) + 1;
+
+  perm->counts = SC_ALLOC_ZERO (size_t, num_threads * perm->num_buckets);
+  perm->offsets = SC_ALLOC (size_t, perm->num_buckets + 1);
+  perm->stage_ind = SC_ALLOC (size_t, perm->count);
+  perm->valid = SC_ALLOC (int, num_threads);
+}
+
+static void
+sc_array_permute_reset (sc_array_permute_t * perm)
+{
+  SC_FREE (perm->counts);
+  SC_FREE (perm->offsets);
+  SC_FREE (perm->stage_ind);
+  SC_FREE (perm->stage);
+  SC_FREE (perm->flags);
+  SC_FREE (perm->valid);
+}
+
+static void
+sc_array_permute_range (sc_array_permute_t * perm, int thread_id,
+                        int num_threads, size_t *begin, size_t *end)
+{
+  *begin = perm->count * thread_id / num_threads;
+  *end = perm->count * (thread_id + 1) / num_threads;
+}
+
+static void
+sc_array_permute_count (int thread_id, int num_threads, void *v)
+{
+  sc_array_permute_t *perm = (sc_array_permute_t *) v;
+  size_t              begin, end, zz, j;
+  size_t             *counts = perm->counts + thread_id * perm->num_buckets;
+
+  sc_array_permute_range (perm, thread_id, num_threads, &begin, &end);
+  perm->valid[thread_id] = 1;
+  for (zz = begin; zz < end; ++zz) {
+    j = perm->newind[zz];
+    if (j >= perm->count) {
+      perm->valid[thread_id] = 0;
+      return;
+    }
+    ++counts[j >> perm->shift];
+  }
+}
+
+/** Turn the counts into stage positions, ordered by bucket and thread. */
+static void
+sc_array_permute_offsets (sc_array_permute_t * perm, int num_threads)
+{
+  int                 t;
+  size_t              b, sum, c, *zp;
+
+  for (b = 0, sum = 0; b < perm->num_buckets; ++b) {
+    perm->offsets[b] = sum;
+    for (t = 0; t < num_threads; ++t) {
+      zp = perm->counts + t * perm->num_buckets + b;
+      c = *zp;
+      *zp = sum;
+      sum += c;
+    }
+  }
+  perm->offsets[perm->num_buckets] = sum;
+  SC_ASSERT (sum == perm->count);
+}
+
+static void
+sc_array_permute_stage (int thread_id, int num_threads, void *v)
+{
+  sc_array_permute_t *perm = (sc_array_permute_t *) v;
+  const size_t        es = perm->es;
+  size_t              begin, end, zz, j, pos;
+  size_t             *counts = perm->counts + thread_id * perm->num_buckets;
+
+  sc_array_permute_range (perm, thread_id, num_threads, &begin, &end);
+  for (zz = begin; zz < end; ++zz) {
+    j = perm->newind[zz];
+    pos = counts[j >> perm->shift]++;
+    perm->stage_ind[pos] = j;
+    if (es > 0) {
+      memcpy (perm->stage + pos * es, perm->src + zz * es, es);
+    }
+  }
+}
+
+static void
+sc_array_permute_scatter (int thread_id, int num_threads, void *v)
+{
+  sc_array_permute_t *perm = (sc_array_permute_t *) v;
+  const size_t        es = perm->es;
+  size_t              b, pos;
+
+  for (b = perm->num_buckets * thread_id / num_threads;
+       b < perm->num_buckets * (thread_id + 1) / num_threads; ++b) {
+    for (pos = perm->offsets[b]; pos < perm->offsets[b + 1]; ++pos) {
+      memcpy (perm->dest + perm->stage_ind[pos] * es, perm->stage + pos * es,
+              es);
+    }
+  }
+}
+
+/** Every bucket must contain each index of its block exactly once. */
+static void
+sc_array_permute_check (int thread_id, int num_threads, void *v)
+{
+  sc_array_permute_t *perm = (sc_array_permute_t *) v;
+  char               *flags = perm->flags + ((size_t) thread_id <<
+                                             perm->shift);
+  size_t              b, pos, first, size, j;
+
+  perm->valid[thread_id] = 1;
+  for (b = perm->num_buckets * thread_id / num_threads;
+       b < perm->num_buckets * (thread_id + 1) / num_threads; ++b) {
+    first = b << perm->shift;
+    size = SC_MIN (perm->count - first, (size_t) 1 << perm->shift);
+    if (perm->offsets[b + 1] - perm->offsets[b] != size) {
+      perm->valid[thread_id] = 0;
+      return;
+    }
+    memset (flags, 0, size);
+    for (pos = perm->offsets[b]; pos < perm->offsets[b + 1]; ++pos) {
+      j = perm->stage_ind[pos] - first;
+      if (flags[j]) {
+        perm->valid[thread_id] = 0;
+        return;
+      }
+      flags[j] = 1;
+    }
+  }
+}
+
+static int
+sc_array_permute_valid (sc_array_permute_t * perm, int num_threads)
+{
+  int                 t;
+
+  for (t = 0; t < num_threads; ++t) {
+    if (!perm->valid[t]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int
+sc_array_is_permutation_threads (sc_array_t * newindices, int num_threads)
+{
+  int                 valid;
+  sc_array_permute_t  perm;
+
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  if (newindices->elem_count == 0) {
+    return 1;
+  }
+  num_threads = (int) SC_MIN ((size_t) num_threads, newindices->elem_count);
+
+  /* check the range and stage the values by bucket */
+  sc_array_permute_init (&perm, newindices, 0, num_threads);
+  sc_thread_team_run (num_threads, sc_array_permute_count, &perm);
+  if ((valid = sc_array_permute_valid (&perm, num_threads))) {
+    sc_array_permute_offsets (&perm, num_threads);
+    sc_thread_team_run (num_threads, sc_array_permute_stage, &perm);
+
+    /* look for duplicates in every bucket */
+    num_threads = (int) SC_MIN ((size_t) num_threads, perm.num_buckets);
+    perm.flags = SC_ALLOC (char, (size_t) num_threads << perm.shift);
+    sc_thread_team_run (num_threads, sc_array_permute_check, &perm);
+    valid = sc_array_permute_valid (&perm, num_threads);
+  }
+  sc_array_permute_reset (&perm);
+
+  return valid;
+}
+
+void
+sc_array_permute_copy (sc_array_t * dest, sc_array_t * src,
+                       sc_array_t * newindices, int num_threads)
+{
+  sc_array_permute_t  perm;
+
+  SC_ASSERT (dest != src);
+  SC_ASSERT (dest->elem_size == src->elem_size);
+  SC_ASSERT (newindices->elem_count == src->elem_count);
+  SC_ASSERT (sc_array_is_permutation (newindices));
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  sc_array_resize (dest, src->elem_count);
+  if (src->elem_count == 0) {
+    return;
+  }
+  num_threads = (int) SC_MIN ((size_t) num_threads, src->elem_count);
+
+  /* stage the elements by destination block */
+  sc_array_permute_init (&perm, newindices, src->elem_size, num_threads);
+  perm.src = src->array;
+  perm.dest = dest->array;
+  perm.stage = SC_ALLOC (char, perm.count * perm.es);
+  sc_thread_team_run (num_threads, sc_array_permute_count, &perm);
+  sc_array_permute_offsets (&perm, num_threads);
+  sc_thread_team_run (num_threads, sc_array_permute_stage, &perm);
+
+  /* write one destination block after the other */
+  num_threads = (int) SC_MIN ((size_t) num_threads, perm.num_buckets);
+  sc_thread_team_run (num_threads, sc_array_permute_scatter, &perm);
+  sc_array_permute_reset (&perm);
+}
+
+/** permute an array in place.  newind[i] is the new index for the data that
+ * is currently at index i. entries in newind will be altered by this
+ * procedure */
+void
+sc_array_permute (sc_array_t * array, sc_array_t * newindices, int keepperm)
+{
+  size_t              zi, zj, zk;
+  char               *temp = SC_ALLOC (char, array->elem_size);
+  char               *carray = array->array;
+  size_t              esize = array->elem_size * sizeof (char);
+  size_t              count = array->elem_count;
+  size_t             *newind;
+
+  SC_ASSERT (newindices->elem_size == sizeof (size_t));
+  SC_ASSERT (newindices->elem_count == count);
+  SC_ASSERT (sc_array_is_permutation (newindices));
+  if (!count) {
+    SC_FREE (temp);
+    return;
+  }
+
+  if (!keepperm) {
+    newind = (size_t *) sc_array_index (newindices, 0);
+  }
+  else {
+    newind = SC_ALLOC (size_t, count);
+    memcpy (newind, sc_array_index (newindices, 0), count * sizeof (size_t));
+  }
+
+  zi = 0;
+  zj = 0;
 
   while (zi < count) {
     /* zi is the index of the current pivot slot */
@@ -640,6 +1748,44 @@ sc_array_checksum (sc_array_t * array)
 #endif
 }
 
+uint32_t
+sc_array_checksum_crc32c (sc_array_t * array, int num_threads)
+{
+  return sc_crc32c_threads (array->array,
+                            array->elem_count * array->elem_size,
+                            num_threads);
+}
+
+uint32_t
+sc_array_checksum_crc32c_global (sc_array_t * array, sc_MPI_Comm mpicomm,
+                                 int num_threads)
+{
+  int                 mpiret, mpisize, q;
+  uint32_t            crc;
+  uint64_t            local[2], *all;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* exchange the checksum and the byte count of every process */
+  local[0] = sc_array_checksum_crc32c (array, num_threads);
+  local[1] = array->elem_count * array->elem_size;
+  all = SC_ALLOC (uint64_t, 2 * mpisize);
+  mpiret = sc_MPI_Allgather (local, 2, sc_MPI_UNSIGNED_LONG_LONG,
+                             all, 2, sc_MPI_UNSIGNED_LONG_LONG, mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* combine them in the order of the ranks */
+  crc = (uint32_t) all[0];
+  for (q = 1; q < mpisize; ++q) {
+    crc = sc_crc32c_combine (crc, (uint32_t) all[2 * q],
+                             (size_t) all[2 * q + 1]);
+  }
+  SC_FREE (all);
+
+  return crc;
+}
+
 size_t
 sc_array_pqueue_add (sc_array_t * array, void *temp,
                      int (*compar) (const void *, const void *))
@@ -653,9 +1799,6 @@ sc_array_pqueue_add (sc_array_t * array, void *temp,
   SC_ASSERT (SC_ARRAY_IS_OWNER (array));
   SC_ASSERT (array->elem_count > 0);
 
-  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
-  SC_ABORT_NOT_REACHED ();
-
   swaps = 0;
   child = array->elem_count - 1;
   c = array->array + (size * child);
@@ -698,9 +1841,6 @@ sc_array_pqueue_pop (sc_array_t * array, void *result,
   SC_ASSERT (SC_ARRAY_IS_OWNER (array));
   SC_ASSERT (array->elem_count > 0);
 
-  /* PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED. */
-  SC_ABORT_NOT_REACHED ();
-
   swaps = 0;
   new_count = array->elem_count - 1;
 
@@ -752,54 +1892,361 @@ sc_array_pqueue_pop (sc_array_t * array, void *result,
   return swaps;
 }
 
-/* memory stamp routines */
+/* d-ary heap routines */
 
-static void
-sc_mstamp_stamp (sc_mstamp_t * mst)
+/** Marks a handle that is not in the heap. */
+#define SC_DHEAP_NONE ((size_t) -1)
+
+static inline char *
+sc_dheap_elem (sc_dheap_t * heap, size_t pos)
 {
-  SC_ASSERT (mst != NULL);
-  SC_ASSERT (mst->elem_size > 0);
-  SC_ASSERT (mst->stamp_size > 0);
+  return heap->elems.array + pos * heap->elem_size;
+}
 
-  /* make new stamp; the pointer is aligned to any builtin type */
-  mst->cur_snext = 0;
-  *(void **) sc_array_push (&mst->remember) =
-    mst->current = SC_ALLOC (char, mst->stamp_size);
+/** Places an element and its handle at a position of the heap. */
+static inline void
+sc_dheap_place (sc_dheap_t * heap, size_t pos, const void *elem,
+                size_t handle)
+{
+  memcpy (sc_dheap_elem (heap, pos), elem, heap->elem_size);
+  ((size_t *) heap->handles.array)[pos] = handle;
+  ((size_t *) heap->positions.array)[handle] = pos;
 }
 
-void
-sc_mstamp_init (sc_mstamp_t * mst, size_t stamp_unit, size_t elem_size)
+/** Moves the element at position from into the hole at position to. */
+static inline void
+sc_dheap_move (sc_dheap_t * heap, size_t to, size_t from)
 {
-  SC_ASSERT (mst != NULL);
+  sc_dheap_place (heap, to, sc_dheap_elem (heap, from),
+                  ((size_t *) heap->handles.array)[from]);
+}
 
-  /* basic initialization */
-  memset (mst, 0, sizeof (sc_mstamp_t));
-  mst->elem_size = elem_size;
-  sc_array_init (&mst->remember, sizeof (void *));
+/** Returns the smallest child of a node that has at least one child. */
+static inline size_t
+sc_dheap_min_child (sc_dheap_t * heap, size_t first, size_t count)
+{
+  size_t              child, last, min;
 
-  /* how many items per stamp we use */
-  if (elem_size > 0) {
-    mst->per_stamp = stamp_unit / elem_size;
-    if (mst->per_stamp == 0) {
-      /* Each item uses more memory than we had specified for one stamp */
-      mst->per_stamp = 1;
+  last = SC_MIN (first + heap->arity, count);
+  for (min = first, child = first + 1; child < last; ++child) {
+    if (heap->compar (sc_dheap_elem (heap, child),
+                      sc_dheap_elem (heap, min)) < 0) {
+      min = child;
     }
-    mst->stamp_size = mst->per_stamp * elem_size;
-    sc_mstamp_stamp (mst);
   }
+  return min;
 }
 
-void
-sc_mstamp_reset (sc_mstamp_t * mst)
+/** Moves the hole at pos upwards until temp with handle fits into it. */
+static void
+sc_dheap_sift_up (sc_dheap_t * heap, size_t pos, size_t handle)
 {
-  size_t              znum, zz;
-
-  SC_ASSERT (mst != NULL);
+  size_t              parent;
 
-  /* free all memory stamps we have created */
-  znum = mst->remember.elem_count;
-  for (zz = 0; zz < znum; zz++) {
-    SC_FREE (*(void **) sc_array_index (&mst->remember, zz));
+  while (pos > 0) {
+    parent = (pos - 1) / heap->arity;
+    if (heap->compar (heap->temp, sc_dheap_elem (heap, parent)) >= 0) {
+      break;
+    }
+    sc_dheap_move (heap, pos, parent);
+    pos = parent;
+  }
+  sc_dheap_place (heap, pos, heap->temp, handle);
+}
+
+/** Moves the hole at pos downwards until temp with handle fits into it. */
+static void
+sc_dheap_sift_down (sc_dheap_t * heap, size_t pos, size_t handle)
+{
+  const size_t        count = heap->elems.elem_count;
+  size_t              first, min;
+
+  while ((first = heap->arity * pos + 1) < count) {
+    min = sc_dheap_min_child (heap, first, count);
+    if (heap->compar (sc_dheap_elem (heap, min), heap->temp) >= 0) {
+      break;
+    }
+    sc_dheap_move (heap, pos, min);
+    pos = min;
+  }
+  sc_dheap_place (heap, pos, heap->temp, handle);
+}
+
+sc_dheap_t         *
+sc_dheap_new (size_t elem_size, size_t arity,
+              int (*compar) (const void *, const void *))
+{
+  sc_dheap_t         *heap;
+
+  SC_ASSERT (elem_size > 0);
+  SC_ASSERT (arity != 1);
+
+  heap = SC_ALLOC (sc_dheap_t, 1);
+  heap->elem_size = elem_size;
+  heap->arity = arity == 0 ? SC_DHEAP_ARITY : arity;
+  heap->compar = compar;
+  sc_array_init (&heap->elems, elem_size);
+  sc_array_init (&heap->handles, sizeof (size_t));
+  sc_array_init (&heap->positions, sizeof (size_t));
+  sc_array_init (&heap->unused, sizeof (size_t));
+  heap->temp = SC_ALLOC (char, elem_size);
+
+  return heap;
+}
+
+sc_dheap_t         *
+sc_dheap_new_array (sc_array_t * array, size_t arity,
+                    int (*compar) (const void *, const void *))
+{
+  const size_t        count = array->elem_count;
+  size_t              zz;
+  sc_dheap_t         *heap;
+
+  heap = sc_dheap_new (array->elem_size, arity, compar);
+  sc_array_copy (&heap->elems, array);
+  sc_array_resize (&heap->handles, count);
+  sc_array_resize (&heap->positions, count);
+  for (zz = 0; zz < count; ++zz) {
+    ((size_t *) heap->handles.array)[zz] = zz;
+    ((size_t *) heap->positions.array)[zz] = zz;
+  }
+
+  /* sift down every inner node from the bottom up */
+  for (zz = count > 1 ? (count - 2) / heap->arity + 1 : 0; zz-- > 0;) {
+    memcpy (heap->temp, sc_dheap_elem (heap, zz), heap->elem_size);
+    sc_dheap_sift_down (heap, zz, zz);
+  }
+
+  return heap;
+}
+
+void
+sc_dheap_destroy (sc_dheap_t * heap)
+{
+  sc_array_reset (&heap->elems);
+  sc_array_reset (&heap->handles);
+  sc_array_reset (&heap->positions);
+  sc_array_reset (&heap->unused);
+  SC_FREE (heap->temp);
+  SC_FREE (heap);
+}
+
+size_t
+sc_dheap_push (sc_dheap_t * heap, const void *elem)
+{
+  size_t              handle, pos;
+
+  if (heap->unused.elem_count > 0) {
+    handle = *(size_t *) sc_array_pop (&heap->unused);
+  }
+  else {
+    handle = heap->positions.elem_count;
+    sc_array_push (&heap->positions);
+  }
+
+  pos = heap->elems.elem_count;
+  sc_array_push (&heap->elems);
+  sc_array_push (&heap->handles);
+  memcpy (heap->temp, elem, heap->elem_size);
+  sc_dheap_sift_up (heap, pos, handle);
+
+  return handle;
+}
+
+void               *
+sc_dheap_top (sc_dheap_t * heap, size_t *handle)
+{
+  SC_ASSERT (heap->elems.elem_count > 0);
+
+  if (handle != NULL) {
+    *handle = *(size_t *) heap->handles.array;
+  }
+  return heap->elems.array;
+}
+
+size_t
+sc_dheap_pop (sc_dheap_t * heap, void *elem)
+{
+  const size_t        last = heap->elems.elem_count - 1;
+  size_t              handle, last_handle, pos, first;
+
+  SC_ASSERT (heap->elems.elem_count > 0);
+
+  handle = *(size_t *) heap->handles.array;
+  if (elem != NULL) {
+    memcpy (elem, heap->elems.array, heap->elem_size);
+  }
+  ((size_t *) heap->positions.array)[handle] = SC_DHEAP_NONE;
+  *(size_t *) sc_array_push (&heap->unused) = handle;
+
+  if (last > 0) {
+    /* move the hole to a leaf along the smallest children, which saves one
+       comparison per level, and let the last element rise from there */
+    memcpy (heap->temp, sc_dheap_elem (heap, last), heap->elem_size);
+    last_handle = ((size_t *) heap->handles.array)[last];
+    for (pos = 0; (first = heap->arity * pos + 1) < last;) {
+      first = sc_dheap_min_child (heap, first, last);
+      sc_dheap_move (heap, pos, first);
+      pos = first;
+    }
+    sc_dheap_sift_up (heap, pos, last_handle);
+  }
+  sc_array_resize (&heap->elems, last);
+  sc_array_resize (&heap->handles, last);
+
+  return handle;
+}
+
+size_t
+sc_dheap_pop_n (sc_dheap_t * heap, size_t k, sc_array_t * out)
+{
+  const size_t        count = heap->elems.elem_count;
+  size_t              zz, offset, handle;
+
+  SC_ASSERT (out->elem_size == heap->elem_size);
+
+  offset = out->elem_count;
+  if (k >= count) {
+    /* sorting is faster than popping everything */
+    sc_array_push_count (out, count);
+    memcpy (out->array + offset * heap->elem_size, heap->elems.array,
+            count * heap->elem_size);
+    if (count > 1) {
+      qsort (out->array + offset * heap->elem_size, count, heap->elem_size,
+             heap->compar);
+    }
+    for (zz = 0; zz < count; ++zz) {
+      handle = ((size_t *) heap->handles.array)[zz];
+      ((size_t *) heap->positions.array)[handle] = SC_DHEAP_NONE;
+      *(size_t *) sc_array_push (&heap->unused) = handle;
+    }
+    sc_array_resize (&heap->elems, 0);
+    sc_array_resize (&heap->handles, 0);
+    return count;
+  }
+
+  sc_array_push_count (out, k);
+  for (zz = 0; zz < k; ++zz) {
+    sc_dheap_pop (heap, out->array + (offset + zz) * heap->elem_size);
+  }
+  return k;
+}
+
+int
+sc_dheap_contains (sc_dheap_t * heap, size_t handle)
+{
+  return handle < heap->positions.elem_count &&
+    ((size_t *) heap->positions.array)[handle] != SC_DHEAP_NONE;
+}
+
+void               *
+sc_dheap_lookup (sc_dheap_t * heap, size_t handle)
+{
+  SC_ASSERT (sc_dheap_contains (heap, handle));
+
+  return sc_dheap_elem (heap, ((size_t *) heap->positions.array)[handle]);
+}
+
+void
+sc_dheap_update (sc_dheap_t * heap, size_t handle, const void *elem)
+{
+  size_t              pos;
+
+  SC_ASSERT (sc_dheap_contains (heap, handle));
+
+  pos = ((size_t *) heap->positions.array)[handle];
+  memcpy (heap->temp, elem, heap->elem_size);
+  if (pos > 0 && heap->compar (heap->temp, sc_dheap_elem
+                               (heap, (pos - 1) / heap->arity)) < 0) {
+    sc_dheap_sift_up (heap, pos, handle);
+  }
+  else {
+    sc_dheap_sift_down (heap, pos, handle);
+  }
+}
+
+/* memory stamp routines */
+
+static void
+sc_mstamp_stamp (sc_mstamp_t * mst)
+{
+  SC_ASSERT (mst != NULL);
+  SC_ASSERT (mst->elem_size > 0);
+  SC_ASSERT (mst->stamp_size > 0);
+
+  /* make new stamp; the pointer is aligned to any builtin type */
+  mst->cur_snext = 0;
+  *(void **) sc_array_push (&mst->remember) = mst->current =
+    mst->policy == NULL ? SC_ALLOC (char, mst->stamp_size) :
+    (char *) sc_pages_alloc (mst->policy, mst->stamp_size);
+}
+
+static void
+sc_mstamp_stamp_free (sc_mstamp_t * mst, void *stamp)
+{
+  if (mst->policy == NULL) {
+    SC_FREE (stamp);
+  }
+  else {
+    sc_pages_free (mst->policy, stamp, mst->stamp_size);
+  }
+}
+
+/** Compute the number of items per stamp and the stamp size.
+ * With a policy, the stamps are rounded up to be mapped by it.
+ */
+static void
+sc_mstamp_size (sc_mstamp_t * mst)
+{
+  size_t              min_size;
+
+  SC_ASSERT (mst->elem_size > 0);
+
+  /* how many items per stamp we use */
+  mst->per_stamp = mst->stamp_unit / mst->elem_size;
+  if (mst->per_stamp == 0) {
+    /* Each item uses more memory than we had specified for one stamp */
+    mst->per_stamp = 1;
+  }
+  if (mst->policy != NULL) {
+    min_size = SC_MAX (sc_pages_unit (mst->policy), mst->policy->min_bytes);
+    if (mst->per_stamp * mst->elem_size < min_size) {
+      mst->per_stamp = (min_size + mst->elem_size - 1) / mst->elem_size;
+    }
+  }
+  mst->stamp_size = mst->per_stamp * mst->elem_size;
+}
+
+void
+sc_mstamp_init (sc_mstamp_t * mst, size_t stamp_unit, size_t elem_size)
+{
+  SC_ASSERT (mst != NULL);
+
+  /* basic initialization */
+  memset (mst, 0, sizeof (sc_mstamp_t));
+  mst->elem_size = elem_size;
+  mst->stamp_unit = stamp_unit;
+  sc_array_init (&mst->remember, sizeof (void *));
+
+  if (elem_size > 0) {
+    sc_mstamp_size (mst);
+    sc_mstamp_stamp (mst);
+  }
+}
+
+void
+sc_mstamp_reset (sc_mstamp_t * mst)
+{
+  size_t              znum, zz;
+  void              **stamps;
+
+  SC_ASSERT (mst != NULL);
+
+  /* free all memory stamps we have created */
+  znum = mst->remember.elem_count;
+  stamps = (void **) mst->remember.array;
+  for (zz = 0; zz < znum; zz++) {
+    sc_mstamp_stamp_free (mst, stamps[zz]);
   }
   sc_array_reset (&mst->remember);
 }
@@ -840,6 +2287,63 @@ sc_mstamp_alloc (sc_mstamp_t * mst)
   return ret;
 }
 
+void
+sc_mstamp_set_policy (sc_mstamp_t * mst, const sc_pages_policy_t * policy)
+{
+  SC_ASSERT (mst != NULL);
+  SC_ASSERT (mst->remember.elem_count <= 1 && mst->cur_snext == 0);
+
+  if (mst->elem_size == 0) {
+    mst->policy = policy;
+    return;
+  }
+
+  /* replace the unused current stamp */
+  sc_mstamp_reset (mst);
+  mst->policy = policy;
+  sc_mstamp_size (mst);
+  sc_mstamp_stamp (mst);
+}
+
+size_t
+sc_mstamp_huge_bytes (sc_mstamp_t * mst)
+{
+  SC_ASSERT (mst != NULL);
+
+  if (mst->policy == NULL) {
+    return 0;
+  }
+  return sc_pages_huge_bytes (mst->remember.elem_count,
+                              (void *const *) mst->remember.array,
+                              mst->stamp_size);
+}
+
+void               *
+sc_mstamp_alloc_n (sc_mstamp_t * mst, size_t n, size_t *num)
+{
+  void               *ret;
+
+  SC_ASSERT (mst != NULL);
+  SC_ASSERT (num != NULL);
+
+  if (mst->elem_size == 0 || n == 0) {
+    *num = 0;
+    return NULL;
+  }
+
+  /* hand out the rest of the current stamp at most */
+  SC_ASSERT (mst->current != NULL);
+  SC_ASSERT (mst->cur_snext < mst->per_stamp);
+  ret = mst->current + mst->cur_snext * mst->elem_size;
+  *num = SC_MIN (n, mst->per_stamp - mst->cur_snext);
+
+  mst->cur_snext += *num;
+  if (mst->cur_snext == mst->per_stamp) {
+    sc_mstamp_stamp (mst);
+  }
+  return ret;
+}
+
 size_t
 sc_mstamp_memory_used (sc_mstamp_t * mst)
 {
@@ -853,8 +2357,258 @@ sc_mstamp_memory_used (sc_mstamp_t * mst)
   return s;
 }
 
+/** Address of a stamp, used to locate the stamp of an item. */
+typedef struct sc_mstamp_base
+{
+  char               *base;
+  size_t              index;
+}
+sc_mstamp_base_t;
+
+/** Number of live items of a stamp, used to order stamps by occupancy. */
+typedef struct sc_mstamp_live
+{
+  size_t              live;
+  size_t              index;
+}
+sc_mstamp_live_t;
+
+static int
+sc_mstamp_base_compare (const void *v1, const void *v2)
+{
+  const char         *b1 = ((const sc_mstamp_base_t *) v1)->base;
+  const char         *b2 = ((const sc_mstamp_base_t *) v2)->base;
+
+  return b1 < b2 ? -1 : b1 > b2;
+}
+
+static int
+sc_mstamp_live_compare (const void *v1, const void *v2)
+{
+  const sc_mstamp_live_t *l1 = (const sc_mstamp_live_t *) v1;
+  const sc_mstamp_live_t *l2 = (const sc_mstamp_live_t *) v2;
+
+  /* most occupied stamps first, ties broken by age */
+  if (l1->live != l2->live) {
+    return l1->live > l2->live ? -1 : 1;
+  }
+  return l1->index < l2->index ? -1 : l1->index > l2->index;
+}
+
+/** Return the index of the stamp that contains an item. */
+static size_t
+sc_mstamp_find (sc_mstamp_t * mst, sc_array_t * bases, const char *item)
+{
+  size_t              low, high, mid;
+  sc_mstamp_base_t   *b;
+
+  /* find the last stamp that begins at or before the item */
+  low = 0;
+  high = bases->elem_count;
+  while (high - low > 1) {
+    mid = low + (high - low) / 2;
+    b = (sc_mstamp_base_t *) sc_array_index (bases, mid);
+    if (b->base <= item) {
+      low = mid;
+    }
+    else {
+      high = mid;
+    }
+  }
+  b = (sc_mstamp_base_t *) sc_array_index (bases, low);
+  SC_ASSERT (b->base <= item && item < b->base + mst->stamp_size);
+  SC_ASSERT ((size_t) (item - b->base) % mst->elem_size == 0);
+
+  return b->index;
+}
+
+size_t
+sc_mstamp_compact (sc_mstamp_t * mst, sc_array_t * free_items,
+                   sc_mstamp_relocate_t relocate, void *user_data)
+{
+  size_t              num_stamps, num_items, per_stamp;
+  size_t              zz, jj, kk, slot, idx;
+  size_t              capacity, live_rest, released;
+  size_t             *num_free, *item_stamp;
+  char               *is_free, *release, *from, *to;
+  char              **stamps;
+  sc_array_t         *bases, *order;
+  sc_mstamp_base_t   *b;
+  sc_mstamp_live_t   *l;
+
+  SC_ASSERT (mst != NULL);
+  SC_ASSERT (free_items != NULL);
+  SC_ASSERT (free_items->elem_size == sizeof (void *));
+
+  num_stamps = mst->remember.elem_count;
+  if (mst->elem_size == 0 || num_stamps <= 1) {
+    /* we never release the current stamp */
+    return 0;
+  }
+  per_stamp = mst->per_stamp;
+  stamps = (char **) mst->remember.array;
+  SC_ASSERT (stamps[num_stamps - 1] == mst->current);
+
+  /* locate the stamp and slot of every free item */
+  bases = sc_array_new_count (sizeof (sc_mstamp_base_t), num_stamps);
+  for (zz = 0; zz < num_stamps; ++zz) {
+    b = (sc_mstamp_base_t *) sc_array_index (bases, zz);
+    b->base = stamps[zz];
+    b->index = zz;
+  }
+  sc_array_sort (bases, sc_mstamp_base_compare);
+  num_free = SC_ALLOC_ZERO (size_t, num_stamps);
+  is_free = SC_ALLOC_ZERO (char, num_stamps * per_stamp);
+  num_items = free_items->elem_count;
+  item_stamp = SC_ALLOC (size_t, num_items);
+  for (zz = 0; zz < num_items; ++zz) {
+    from = *(char **) sc_array_index (free_items, zz);
+    idx = sc_mstamp_find (mst, bases, from);
+    slot = (size_t) (from - stamps[idx]) / mst->elem_size;
+    SC_ASSERT (!is_free[idx * per_stamp + slot]);
+    is_free[idx * per_stamp + slot] = 1;
+    ++num_free[idx];
+    item_stamp[zz] = idx;
+  }
+  sc_array_destroy (bases);
+
+  /* decide which stamps to release */
+  release = SC_ALLOC_ZERO (char, num_stamps);
+  if (relocate == NULL) {
+    for (zz = 0; zz < num_stamps - 1; ++zz) {
+      release[zz] = (num_free[zz] == per_stamp);
+    }
+  }
+  else {
+    order = sc_array_new_count (sizeof (sc_mstamp_live_t), num_stamps - 1);
+    live_rest = 0;
+    for (zz = 0; zz < num_stamps - 1; ++zz) {
+      l = (sc_mstamp_live_t *) sc_array_index (order, zz);
+      l->live = per_stamp - num_free[zz];
+      l->index = zz;
+      live_rest += l->live;
+    }
+    sc_array_sort (order, sc_mstamp_live_compare);
+
+    /* keep the fewest most occupied stamps that can take all other items */
+    capacity = num_free[num_stamps - 1];
+    for (kk = 0; kk < num_stamps - 1 && capacity < live_rest; ++kk) {
+      l = (sc_mstamp_live_t *) sc_array_index (order, kk);
+      capacity += per_stamp - l->live;
+      live_rest -= l->live;
+    }
+    for (zz = kk; zz < num_stamps - 1; ++zz) {
+      l = (sc_mstamp_live_t *) sc_array_index (order, zz);
+      release[l->index] = 1;
+    }
+    sc_array_destroy (order);
+
+    /* move the live items of released stamps into kept free items */
+    jj = 0;
+    for (idx = 0; idx < num_stamps - 1; ++idx) {
+      if (!release[idx] || num_free[idx] == per_stamp) {
+        continue;
+      }
+      for (slot = 0; slot < per_stamp; ++slot) {
+        if (is_free[idx * per_stamp + slot]) {
+          continue;
+        }
+        while (jj < num_items && release[item_stamp[jj]]) {
+          ++jj;
+        }
+        SC_ASSERT (jj < num_items);
+        from = stamps[idx] + slot * mst->elem_size;
+        to = *(char **) sc_array_index (free_items, jj);
+        memcpy (to, from, mst->elem_size);
+        relocate (from, to, user_data);
+
+        /* the target item is no longer free */
+        item_stamp[jj++] = idx;
+      }
+    }
+  }
+
+  /* free the released stamps and keep the order of the others */
+  released = 0;
+  for (zz = jj = 0; zz < num_stamps; ++zz) {
+    if (release[zz]) {
+      sc_mstamp_stamp_free (mst, stamps[zz]);
+      ++released;
+    }
+    else {
+      stamps[jj++] = stamps[zz];
+    }
+  }
+  sc_array_resize (&mst->remember, jj);
+
+  /* keep the free items of the remaining stamps */
+  for (zz = jj = 0; zz < num_items; ++zz) {
+    if (!release[item_stamp[zz]]) {
+      *(void **) sc_array_index (free_items, jj++) =
+        *(void **) sc_array_index (free_items, zz);
+    }
+  }
+  sc_array_resize (free_items, jj);
+
+  SC_FREE (release);
+  SC_FREE (item_stamp);
+  SC_FREE (is_free);
+  SC_FREE (num_free);
+
+  return released * mst->stamp_size;
+}
+
 /* mempool routines */
 
+/** Number of element pointers in one magazine of a thread cache. */
+#define SC_MEMPOOL_MAGAZINE_SIZE 64
+
+/** A magazine is a stack of free elements moved as a whole. */
+typedef struct sc_mempool_magazine
+{
+  size_t              count;
+  struct sc_mempool_magazine *next;
+  void               *elems[SC_MEMPOOL_MAGAZINE_SIZE];
+}
+sc_mempool_magazine_t;
+
+/** Each thread owns two magazines and its own statistics. */
+typedef struct sc_mempool_cache
+{
+  sc_mempool_magazine_t *loaded;
+  sc_mempool_magazine_t *previous;
+  size_t              num_alloc;
+  size_t              num_free;
+  size_t              num_get;
+  size_t              num_put;
+  char                padding[64];      /* avoid false sharing */
+}
+sc_mempool_cache_t;
+
+/** The depot holds the magazines not owned by any thread. */
+typedef struct sc_mempool_depot
+{
+  sc_thread_mutex_t   mutex;
+  int                 num_threads;
+  size_t              num_magazines;
+  size_t              num_full;
+  sc_mempool_magazine_t *full;
+  sc_mempool_magazine_t *empty;
+  sc_mempool_cache_t *caches;
+}
+sc_mempool_depot_t;
+
+static size_t
+sc_mempool_depot_memory_used (sc_mempool_depot_t * depot)
+{
+  if (depot == NULL) {
+    return 0;
+  }
+  return sizeof (sc_mempool_depot_t) +
+    depot->num_threads * sizeof (sc_mempool_cache_t) +
+    depot->num_magazines * sizeof (sc_mempool_magazine_t);
+}
+
 size_t
 sc_mempool_memory_used (sc_mempool_t * mempool)
 {
@@ -864,7 +2618,8 @@ sc_mempool_memory_used (sc_mempool_t * mempool)
 #else
     obstack_memory_used (&mempool->obstack) +
 #endif
-    sc_array_memory_used (&mempool->freed, 0);
+    sc_array_memory_used (&mempool->freed, 0) +
+    sc_mempool_depot_memory_used (mempool->depot);
 }
 
 #ifndef SC_MEMPOOL_MSTAMP
@@ -895,6 +2650,7 @@ sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
   mempool->elem_size = elem_size;
   mempool->elem_count = 0;
   mempool->zero_and_persist = zero_and_persist;
+  mempool->intrusive = 0;
 
 #ifdef SC_MEMPOOL_MSTAMP
   sc_mstamp_init (&mempool->mstamp, 4096, elem_size);
@@ -902,6 +2658,8 @@ sc_mempool_init_ext (sc_mempool_t * mempool, size_t elem_size,
   obstack_init (&mempool->obstack);
 #endif
   sc_array_init (&mempool->freed, sizeof (void *));
+  mempool->freelist = NULL;
+  mempool->depot = NULL;
 }
 
 void
@@ -938,10 +2696,98 @@ sc_mempool_new_zero_and_persist (size_t elem_size)
   return sc_mempool_new_ext (elem_size, 1);
 }
 
-void
-sc_mempool_reset (sc_mempool_t * mempool)
+sc_mempool_t       *
+sc_mempool_new_intrusive (size_t elem_size)
 {
-  sc_array_reset (&mempool->freed);
+  sc_mempool_t       *mempool;
+
+  mempool = sc_mempool_new_ext (elem_size, 0);
+  mempool->intrusive = (elem_size >= sizeof (void *));
+
+  return mempool;
+}
+
+static sc_mempool_magazine_t *
+sc_mempool_magazine_new (sc_mempool_depot_t * depot)
+{
+  sc_mempool_magazine_t *mag;
+
+  mag = SC_ALLOC (sc_mempool_magazine_t, 1);
+  mag->count = 0;
+  mag->next = NULL;
+  ++depot->num_magazines;
+
+  return mag;
+}
+
+static void
+sc_mempool_magazine_destroy (sc_mempool_magazine_t * mag)
+{
+  sc_mempool_magazine_t *next;
+
+  for (; mag != NULL; mag = next) {
+    next = mag->next;
+    SC_FREE (mag);
+  }
+}
+
+static sc_mempool_depot_t *
+sc_mempool_depot_new (int num_threads)
+{
+  int                 t;
+  sc_mempool_depot_t *depot;
+  sc_mempool_cache_t *cache;
+
+  SC_ASSERT (num_threads >= 1);
+
+  depot = SC_ALLOC_ZERO (sc_mempool_depot_t, 1);
+  sc_thread_mutex_init (&depot->mutex);
+  depot->num_threads = num_threads;
+  depot->caches = SC_ALLOC_ZERO (sc_mempool_cache_t, num_threads);
+  for (t = 0; t < num_threads; ++t) {
+    cache = depot->caches + t;
+    cache->loaded = sc_mempool_magazine_new (depot);
+    cache->previous = sc_mempool_magazine_new (depot);
+  }
+
+  return depot;
+}
+
+static void
+sc_mempool_depot_destroy (sc_mempool_depot_t * depot)
+{
+  int                 t;
+
+  for (t = 0; t < depot->num_threads; ++t) {
+    SC_FREE (depot->caches[t].loaded);
+    SC_FREE (depot->caches[t].previous);
+  }
+  sc_mempool_magazine_destroy (depot->full);
+  sc_mempool_magazine_destroy (depot->empty);
+  SC_FREE (depot->caches);
+  sc_thread_mutex_destroy (&depot->mutex);
+  SC_FREE (depot);
+}
+
+sc_mempool_t       *
+sc_mempool_new_threads (size_t elem_size, int num_threads)
+{
+  sc_mempool_t       *mempool;
+
+  mempool = sc_mempool_new_ext (elem_size, 0);
+  mempool->depot = sc_mempool_depot_new (num_threads);
+
+  return mempool;
+}
+
+void
+sc_mempool_reset (sc_mempool_t * mempool)
+{
+  if (mempool->depot != NULL) {
+    sc_mempool_depot_destroy (mempool->depot);
+    mempool->depot = NULL;
+  }
+  sc_array_reset (&mempool->freed);
 #ifdef SC_MEMPOOL_MSTAMP
   sc_mstamp_reset (&mempool->mstamp);
 #else
@@ -969,7 +2815,16 @@ sc_mempool_destroy_null (sc_mempool_t ** pmempool)
 void
 sc_mempool_truncate (sc_mempool_t * mempool)
 {
+  int                 num_threads;
+
+  if (mempool->depot != NULL) {
+    /* the cached elements are invalidated as well */
+    num_threads = mempool->depot->num_threads;
+    sc_mempool_depot_destroy (mempool->depot);
+    mempool->depot = sc_mempool_depot_new (num_threads);
+  }
   sc_array_reset (&mempool->freed);
+  mempool->freelist = NULL;
 #ifdef SC_MEMPOOL_MSTAMP
   sc_mstamp_truncate (&mempool->mstamp);
 #else
@@ -979,6 +2834,361 @@ sc_mempool_truncate (sc_mempool_t * mempool)
   mempool->elem_count = 0;
 }
 
+void
+sc_mempool_alloc_n (sc_mempool_t * mempool, size_t n, void **elems)
+{
+  size_t              zz, num;
+  char               *run;
+  sc_array_t         *freed = &mempool->freed;
+
+  SC_ASSERT (n == 0 || elems != NULL);
+
+  mempool->elem_count += n;
+
+  /* recycle the freed elements */
+  for (zz = 0; zz < n && mempool->freelist != NULL; ++zz) {
+    elems[zz] = mempool->freelist;
+    memcpy (&mempool->freelist, elems[zz], sizeof (void *));
+  }
+  num = SC_MIN (n - zz, freed->elem_count);
+  if (num > 0) {
+    memcpy (elems + zz, sc_array_index (freed, freed->elem_count - num),
+            num * sizeof (void *));
+    freed->elem_count -= num;   /* like sc_array_pop, keep the memory */
+    zz += num;
+  }
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    for (num = 0; num < zz; ++num) {
+      memset (elems[num], -1, mempool->elem_size);
+    }
+  }
+#endif
+
+  /* take the remaining elements in runs from the stamps */
+  while (zz < n) {
+#ifdef SC_MEMPOOL_MSTAMP
+    run = (char *) sc_mstamp_alloc_n (&mempool->mstamp, n - zz, &num);
+#else
+    run = (char *) obstack_alloc (&mempool->obstack,
+                                  (int) mempool->elem_size);
+    num = 1;
+#endif
+    SC_ASSERT (num > 0);
+    if (mempool->zero_and_persist) {
+      memset (run, 0, num * mempool->elem_size);
+    }
+#ifdef SC_ENABLE_DEBUG
+    else {
+      memset (run, -1, num * mempool->elem_size);
+    }
+#endif
+    for (; num > 0; --num) {
+      elems[zz++] = run;
+      run += mempool->elem_size;
+    }
+  }
+}
+
+void
+sc_mempool_free_n (sc_mempool_t * mempool, size_t n, void **elems)
+{
+  size_t              zz;
+
+  SC_ASSERT (mempool->elem_count >= n);
+  SC_ASSERT (n == 0 || elems != NULL);
+
+#ifdef SC_ENABLE_DEBUG
+  if (!mempool->zero_and_persist) {
+    for (zz = 0; zz < n; ++zz) {
+      memset (elems[zz], -1, mempool->elem_size);
+    }
+  }
+#endif
+
+  mempool->elem_count -= n;
+
+  if (mempool->intrusive) {
+    for (zz = 0; zz < n; ++zz) {
+      memcpy (elems[zz], &mempool->freelist, sizeof (void *));
+      mempool->freelist = elems[zz];
+    }
+  }
+  else if (n > 0) {
+    memcpy (sc_array_push_count (&mempool->freed, n), elems,
+            n * sizeof (void *));
+  }
+}
+
+/** Move the elements of all magazines into an array of free elements. */
+static void
+sc_mempool_depot_flush (sc_mempool_depot_t * depot, sc_array_t * freed)
+{
+  int                 t;
+  sc_mempool_cache_t *cache;
+  sc_mempool_magazine_t *mag;
+
+  for (t = 0; t < depot->num_threads; ++t) {
+    cache = depot->caches + t;
+    memcpy (sc_array_push_count (freed, cache->loaded->count),
+            cache->loaded->elems, cache->loaded->count * sizeof (void *));
+    memcpy (sc_array_push_count (freed, cache->previous->count),
+            cache->previous->elems,
+            cache->previous->count * sizeof (void *));
+    cache->loaded->count = cache->previous->count = 0;
+  }
+  while (depot->full != NULL) {
+    mag = depot->full;
+    depot->full = mag->next;
+    memcpy (sc_array_push_count (freed, mag->count), mag->elems,
+            mag->count * sizeof (void *));
+    mag->count = 0;
+    mag->next = depot->empty;
+    depot->empty = mag;
+  }
+  depot->num_full = 0;
+}
+
+void
+sc_mempool_set_policy (sc_mempool_t * mempool,
+                       const sc_pages_policy_t * policy)
+{
+  SC_ASSERT (mempool->elem_count == 0);
+
+  /* elements freed earlier point into stamps that are replaced below */
+  sc_mempool_truncate (mempool);
+
+#ifdef SC_MEMPOOL_MSTAMP
+  sc_mstamp_set_policy (&mempool->mstamp, policy);
+#else
+  /* the obstack allocates its chunks itself */
+#endif
+}
+
+size_t
+sc_mempool_huge_bytes (sc_mempool_t * mempool)
+{
+#ifdef SC_MEMPOOL_MSTAMP
+  return sc_mstamp_huge_bytes (&mempool->mstamp);
+#else
+  return 0;
+#endif
+}
+
+size_t
+sc_mempool_compact (sc_mempool_t * mempool,
+                    sc_mstamp_relocate_t relocate, void *user_data)
+{
+#ifdef SC_MEMPOOL_MSTAMP
+  size_t              zz, released;
+  void               *elem;
+  sc_array_t         *freed = &mempool->freed;
+
+  /* collect all free elements in one array */
+  if (mempool->depot != NULL) {
+    sc_mempool_depot_flush (mempool->depot, freed);
+  }
+  while (mempool->freelist != NULL) {
+    elem = mempool->freelist;
+    memcpy (&mempool->freelist, elem, sizeof (void *));
+    *(void **) sc_array_push (freed) = elem;
+  }
+
+  released = sc_mstamp_compact (&mempool->mstamp, freed, relocate,
+                                user_data);
+
+  /* restore the intrusive list */
+  if (mempool->intrusive) {
+    for (zz = 0; zz < freed->elem_count; ++zz) {
+      elem = *(void **) sc_array_index (freed, zz);
+      memcpy (elem, &mempool->freelist, sizeof (void *));
+      mempool->freelist = elem;
+    }
+    sc_array_reset (freed);
+  }
+  return released;
+#else
+  /* the obstack releases memory only in the order of allocation */
+  return 0;
+#endif
+}
+
+/** Refill the empty loaded magazine of a thread cache.
+ * We take a full magazine from the depot if there is one.
+ * Otherwise we fill the magazine with fresh elements.
+ */
+static void
+sc_mempool_depot_get (sc_mempool_t * mempool, sc_mempool_cache_t * cache)
+{
+  size_t              zz;
+  sc_mempool_depot_t *depot = mempool->depot;
+  sc_mempool_magazine_t *mag = cache->loaded;
+
+  SC_ASSERT (cache->loaded->count == 0);
+  SC_ASSERT (cache->previous->count == 0);
+
+  sc_thread_mutex_lock (&depot->mutex);
+  if (depot->full != NULL) {
+    /* exchange the empty magazine for a full one */
+    mag->next = depot->empty;
+    depot->empty = mag;
+    cache->loaded = depot->full;
+    depot->full = depot->full->next;
+    --depot->num_full;
+    ++cache->num_get;
+  }
+  else {
+    /* the storage of the pool is protected by the depot lock as well */
+    for (zz = 0; zz < SC_MEMPOOL_MAGAZINE_SIZE; ++zz) {
+#ifdef SC_MEMPOOL_MSTAMP
+      mag->elems[zz] = sc_mstamp_alloc (&mempool->mstamp);
+#else
+      mag->elems[zz] = obstack_alloc (&mempool->obstack,
+                                      (int) mempool->elem_size);
+#endif
+    }
+    mag->count = SC_MEMPOOL_MAGAZINE_SIZE;
+  }
+  sc_thread_mutex_unlock (&depot->mutex);
+}
+
+/** Replace the full loaded magazine of a thread cache by an empty one.
+ * The full previous magazine is returned to the depot.
+ */
+static void
+sc_mempool_depot_put (sc_mempool_t * mempool, sc_mempool_cache_t * cache)
+{
+  sc_mempool_depot_t *depot = mempool->depot;
+  sc_mempool_magazine_t *mag = cache->previous;
+
+  SC_ASSERT (cache->loaded->count == SC_MEMPOOL_MAGAZINE_SIZE);
+  SC_ASSERT (cache->previous->count == SC_MEMPOOL_MAGAZINE_SIZE);
+
+  sc_thread_mutex_lock (&depot->mutex);
+  mag->next = depot->full;
+  depot->full = mag;
+  ++depot->num_full;
+  cache->previous = cache->loaded;
+  if (depot->empty != NULL) {
+    cache->loaded = depot->empty;
+    depot->empty = depot->empty->next;
+  }
+  else {
+    cache->loaded = sc_mempool_magazine_new (depot);
+  }
+  ++cache->num_put;
+  sc_thread_mutex_unlock (&depot->mutex);
+}
+
+void               *
+sc_mempool_alloc_thread (sc_mempool_t * mempool, int thread_id)
+{
+  void               *ret;
+  sc_mempool_cache_t *cache;
+  sc_mempool_magazine_t *swap;
+
+  SC_ASSERT (mempool->depot != NULL);
+  SC_ASSERT (0 <= thread_id && thread_id < mempool->depot->num_threads);
+
+  cache = mempool->depot->caches + thread_id;
+  if (cache->loaded->count == 0) {
+    if (cache->previous->count > 0) {
+      swap = cache->loaded;
+      cache->loaded = cache->previous;
+      cache->previous = swap;
+    }
+    else {
+      sc_mempool_depot_get (mempool, cache);
+    }
+  }
+  ret = cache->loaded->elems[--cache->loaded->count];
+  ++cache->num_alloc;
+
+#ifdef SC_ENABLE_DEBUG
+  memset (ret, -1, mempool->elem_size);
+#endif
+
+  return ret;
+}
+
+void
+sc_mempool_free_thread (sc_mempool_t * mempool, int thread_id, void *elem)
+{
+  sc_mempool_cache_t *cache;
+  sc_mempool_magazine_t *swap;
+
+  SC_ASSERT (mempool->depot != NULL);
+  SC_ASSERT (0 <= thread_id && thread_id < mempool->depot->num_threads);
+
+#ifdef SC_ENABLE_DEBUG
+  memset (elem, -1, mempool->elem_size);
+#endif
+
+  cache = mempool->depot->caches + thread_id;
+  if (cache->loaded->count == SC_MEMPOOL_MAGAZINE_SIZE) {
+    if (cache->previous->count < SC_MEMPOOL_MAGAZINE_SIZE) {
+      swap = cache->loaded;
+      cache->loaded = cache->previous;
+      cache->previous = swap;
+    }
+    else {
+      sc_mempool_depot_put (mempool, cache);
+    }
+  }
+  cache->loaded->elems[cache->loaded->count++] = elem;
+  ++cache->num_free;
+}
+
+size_t
+sc_mempool_count_threads (sc_mempool_t * mempool)
+{
+  int                 t;
+  size_t              count;
+  sc_mempool_cache_t *cache;
+
+  count = mempool->elem_count;
+  if (mempool->depot != NULL) {
+    for (t = 0; t < mempool->depot->num_threads; ++t) {
+      cache = mempool->depot->caches + t;
+      count += cache->num_alloc - cache->num_free;
+    }
+  }
+  return count;
+}
+
+void
+sc_mempool_print_statistics (int package_id, int log_priority,
+                             sc_mempool_t * mempool)
+{
+  int                 t;
+  sc_mempool_depot_t *depot = mempool->depot;
+  sc_mempool_cache_t *cache;
+
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Mempool elements %lu memory %lu\n",
+               (unsigned long) sc_mempool_count_threads (mempool),
+               (unsigned long) sc_mempool_memory_used (mempool));
+  if (depot == NULL) {
+    return;
+  }
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Mempool depot magazines %lu full %lu\n",
+               (unsigned long) depot->num_magazines,
+               (unsigned long) depot->num_full);
+  for (t = 0; t < depot->num_threads; ++t) {
+    cache = depot->caches + t;
+    SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+                 "Mempool thread %d alloc %lu free %lu get %lu put %lu"
+                 " cached %lu\n", t,
+                 (unsigned long) cache->num_alloc,
+                 (unsigned long) cache->num_free,
+                 (unsigned long) cache->num_get,
+                 (unsigned long) cache->num_put,
+                 (unsigned long) (cache->loaded->count +
+                                  cache->previous->count));
+  }
+}
+
 /* list routines */
 
 size_t
@@ -1005,7 +3215,7 @@ sc_list_new (sc_mempool_t * allocator)
     list->allocator_owned = 0;
   }
   else {
-    list->allocator = sc_mempool_new (sizeof (sc_link_t));
+    list->allocator = sc_mempool_new_intrusive (sizeof (sc_link_t));
     list->allocator_owned = 1;
   }
 
@@ -1166,156 +3376,472 @@ sc_list_pop (sc_list_t * list)
   return data;
 }
 
-/* hash table routines */
+/* deque routines */
 
-unsigned int
-sc_hash_function_string (const void *s, const void *u)
+/** Preferred minimum size of one deque chunk in bytes. */
+#define SC_DEQUE_CHUNK_BYTES 4096
+
+size_t
+sc_deque_memory_used (sc_deque_t * deque, int is_dynamic)
 {
-  int                 j;
-  unsigned int        h;
-  unsigned int        a, b, c;
-  const char         *sp = (const char *) s;
+  return (is_dynamic ? sizeof (sc_deque_t) : 0) +
+    deque->map_size * sizeof (char *) +
+    (deque->chunk_count * deque->elem_size << deque->chunk_shift);
+}
 
-  j = 0;
-  h = 0;
-  a = b = c = 0;
-  for (;;) {
-    if (*sp) {
-      h += *sp++;
-    }
+sc_deque_t         *
+sc_deque_new (size_t elem_size)
+{
+  sc_deque_t         *deque;
 
-    if (++j == 4) {
-      a += h;
-      h = 0;
-    }
-    else if (j == 8) {
-      b += h;
-      h = 0;
-    }
-    else if (j == 12) {
-      c += h;
-      sc_hash_mix (a, b, c);
-      if (!*sp) {
-        sc_hash_final (a, b, c);
-        return c;
-      }
-      j = 0;
-      h = 0;
-    }
-    else {
-      h <<= 8;
-    }
-  }
+  deque = SC_ALLOC (sc_deque_t, 1);
+  sc_deque_init (deque, elem_size);
+
+  return deque;
 }
 
-size_t
-sc_hash_memory_used (sc_hash_t * hash)
+void
+sc_deque_destroy (sc_deque_t * deque)
 {
-  return sizeof (sc_hash_t) +
-    sc_array_memory_used (hash->slots, 1) +
-    (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
+  sc_deque_reset (deque);
+  SC_FREE (deque);
 }
 
-static const size_t sc_hash_minimal_size = (size_t) ((1 << 8) - 1);
-static const size_t sc_hash_shrink_interval = (size_t) (1 << 8);
-
-static void
-sc_hash_maybe_resize (sc_hash_t * hash)
+void
+sc_deque_init (sc_deque_t * deque, size_t elem_size)
 {
-  size_t              i, j;
-  size_t              new_size, new_count;
-  sc_list_t          *old_list, *new_list;
-  sc_link_t          *lynk, *temp;
-  sc_array_t         *new_slots;
-  sc_array_t         *old_slots = hash->slots;
+  SC_ASSERT (elem_size > 0);
 
-  SC_ASSERT (old_slots->elem_count > 0);
+  deque->elem_size = elem_size;
+  deque->elem_count = 0;
 
-  ++hash->resize_checks;
-  if (hash->elem_count >= 4 * old_slots->elem_count) {
-    new_size = 4 * old_slots->elem_count - 1;
-  }
-  else if (hash->elem_count <= old_slots->elem_count / 4) {
-    new_size = old_slots->elem_count / 4 + 1;
-    if (new_size < sc_hash_minimal_size) {
-      return;
-    }
-  }
-  else {
-    return;
+  /* at least 16 elements per chunk and one page for small elements */
+  deque->chunk_shift = 4;
+  while ((elem_size << deque->chunk_shift) < SC_DEQUE_CHUNK_BYTES) {
+    ++deque->chunk_shift;
   }
-  ++hash->resize_actions;
+  deque->head = 0;
+  deque->map_size = 0;
+  deque->chunk_count = 0;
+  deque->map = NULL;
+}
 
-  /* allocate new slot array */
-  new_slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (new_slots, new_size);
-  for (i = 0; i < new_size; ++i) {
-    new_list = (sc_list_t *) sc_array_index (new_slots, i);
-    sc_list_init (new_list, hash->allocator);
-  }
-
-  /* go through the old slots and move data to the new slots */
-  new_count = 0;
-  for (i = 0; i < old_slots->elem_count; ++i) {
-    old_list = (sc_list_t *) sc_array_index (old_slots, i);
-    lynk = old_list->first;
-    while (lynk != NULL) {
-      /* insert data into new slot list */
-      j = hash->hash_fn (lynk->data, hash->user_data) % new_size;
-      new_list = (sc_list_t *) sc_array_index (new_slots, j);
-      (void) sc_list_prepend (new_list, lynk->data);
-      ++new_count;
-
-      /* remove old list element */
-      temp = lynk->next;
-      sc_mempool_free (old_list->allocator, lynk);
-      lynk = temp;
-      --old_list->elem_count;
-    }
-    SC_ASSERT (old_list->elem_count == 0);
-    old_list->first = old_list->last = NULL;
+void
+sc_deque_reset (sc_deque_t * deque)
+{
+  size_t              zz;
+
+  for (zz = 0; zz < deque->map_size; ++zz) {
+    SC_FREE (deque->map[zz]);
   }
-  SC_ASSERT (new_count == hash->elem_count);
+  SC_FREE (deque->map);
 
-  /* replace old slots by new slots */
-  sc_array_destroy (old_slots);
-  hash->slots = new_slots;
+  deque->elem_count = 0;
+  deque->head = 0;
+  deque->map_size = 0;
+  deque->chunk_count = 0;
+  deque->map = NULL;
+}
+
+void
+sc_deque_truncate (sc_deque_t * deque)
+{
+  deque->elem_count = 0;
+  deque->head = 0;
+}
+
+/** Double the capacity of a full deque.
+ * The chunks are rotated such that the one holding the first element comes
+ * first in the new map.  If this chunk also holds the last elements, these
+ * are copied into a fresh chunk appended after the old ones.
+ */
+static void
+sc_deque_grow (sc_deque_t * deque)
+{
+  const int           shift = deque->chunk_shift;
+  const size_t        old_size = deque->map_size;
+  const size_t        offset = deque->head & (((size_t) 1 << shift) - 1);
+  size_t              zz, hc;
+  char              **map;
+
+  SC_ASSERT (deque->elem_count == (old_size << shift));
+
+  if (old_size == 0) {
+    deque->map_size = 1;
+    deque->map = SC_ALLOC_ZERO (char *, 1);
+    deque->head = 0;
+    return;
+  }
+
+  map = SC_ALLOC_ZERO (char *, 2 * old_size);
+  hc = deque->head >> shift;
+  for (zz = 0; zz < old_size; ++zz) {
+    map[zz] = deque->map[(hc + zz) & (old_size - 1)];
+    SC_ASSERT (map[zz] != NULL);
+  }
+  if (offset > 0) {
+    map[old_size] = SC_ALLOC (char, deque->elem_size << shift);
+    ++deque->chunk_count;
+    memcpy (map[old_size], map[0], offset * deque->elem_size);
+  }
+  SC_FREE (deque->map);
+
+  deque->map = map;
+  deque->map_size = 2 * old_size;
+  deque->head = offset;
+}
+
+/** Return the element at a position of the circular buffer.
+ * The chunk holding it is allocated if necessary.
+ */
+static inline void *
+sc_deque_position (sc_deque_t * deque, size_t pos)
+{
+  char              **chunk = deque->map + (pos >> deque->chunk_shift);
+
+  if (*chunk == NULL) {
+    *chunk = SC_ALLOC (char, deque->elem_size << deque->chunk_shift);
+    ++deque->chunk_count;
+  }
+  return (void *) (*chunk + deque->elem_size *
+                   (pos & (((size_t) 1 << deque->chunk_shift) - 1)));
+}
+
+void               *
+sc_deque_push_back (sc_deque_t * deque)
+{
+  size_t              pos;
+
+  if (deque->elem_count == (deque->map_size << deque->chunk_shift)) {
+    sc_deque_grow (deque);
+  }
+  pos = (deque->head + deque->elem_count) &
+    ((deque->map_size << deque->chunk_shift) - 1);
+  ++deque->elem_count;
+
+  return sc_deque_position (deque, pos);
+}
+
+void               *
+sc_deque_push_front (sc_deque_t * deque)
+{
+  if (deque->elem_count == (deque->map_size << deque->chunk_shift)) {
+    sc_deque_grow (deque);
+  }
+  deque->head = (deque->head - 1) &
+    ((deque->map_size << deque->chunk_shift) - 1);
+  ++deque->elem_count;
+
+  return sc_deque_position (deque, deque->head);
+}
+
+void               *
+sc_deque_pop_back (sc_deque_t * deque)
+{
+  void               *elem;
+
+  SC_ASSERT (deque->elem_count > 0);
+
+  elem = sc_deque_index (deque, deque->elem_count - 1);
+  --deque->elem_count;
+
+  return elem;
+}
+
+void               *
+sc_deque_pop_front (sc_deque_t * deque)
+{
+  void               *elem;
+
+  SC_ASSERT (deque->elem_count > 0);
+
+  elem = sc_deque_index (deque, 0);
+  deque->head = (deque->head + 1) &
+    ((deque->map_size << deque->chunk_shift) - 1);
+  --deque->elem_count;
+
+  return elem;
+}
+
+void               *
+sc_deque_chunk (sc_deque_t * deque, size_t iz, size_t *count)
+{
+  const size_t        chunk_elems = (size_t) 1 << deque->chunk_shift;
+  size_t              offset;
+
+  SC_ASSERT (iz < deque->elem_count);
+
+  if (count != NULL) {
+    offset = (deque->head + iz) & (chunk_elems - 1);
+    *count = SC_MIN (chunk_elems - offset, deque->elem_count - iz);
+  }
+  return sc_deque_index (deque, iz);
+}
+
+/* hash table routines */
+
+unsigned int
+sc_hash_function_string (const void *s, const void *u)
+{
+  int                 j;
+  unsigned int        h;
+  unsigned int        a, b, c;
+  const char         *sp = (const char *) s;
+
+  j = 0;
+  h = 0;
+  a = b = c = 0;
+  for (;;) {
+    if (*sp) {
+      h += *sp++;
+    }
+
+    if (++j == 4) {
+      a += h;
+      h = 0;
+    }
+    else if (j == 8) {
+      b += h;
+      h = 0;
+    }
+    else if (j == 12) {
+      c += h;
+      sc_hash_mix (a, b, c);
+      if (!*sp) {
+        sc_hash_final (a, b, c);
+        return c;
+      }
+      j = 0;
+      h = 0;
+    }
+    else {
+      h <<= 8;
+    }
+  }
+}
+
+uint64_t
+sc_hash_bytes (const void *data, size_t length, uint64_t seed)
+{
+  const char         *p = (const char *) data;
+  const char         *end = p + (length & ~(size_t) 7);
+  uint64_t            h, w;
+
+  h = seed + SC_HASH_PRIME64_3 + (uint64_t) length;
+  for (; p < end; p += 8) {
+    h = sc_hash_round64 (h, sc_hash_load64 (p));
+  }
+  if (length & 7) {
+    /* the remaining bytes are padded with zeros */
+    w = 0;
+    memcpy (&w, p, length & 7);
+    h = sc_hash_round64 (h, w);
+  }
+  return sc_hash_mix64 (h);
+}
+
+unsigned int
+sc_hash_function_string64 (const void *s, const void *u)
+{
+  return sc_hash_fold64 (sc_hash_bytes (s, strlen ((const char *) s), 0));
+}
+
+unsigned int
+sc_hash_function_bytes8 (const void *v, const void *u)
+{
+  return sc_hash_fold64 (sc_hash_bytes8 (v));
+}
+
+unsigned int
+sc_hash_function_bytes16 (const void *v, const void *u)
+{
+  return sc_hash_fold64 (sc_hash_bytes16 (v));
+}
+
+unsigned int
+sc_hash_function_bytes24 (const void *v, const void *u)
+{
+  return sc_hash_fold64 (sc_hash_bytes24 (v));
+}
+
+unsigned int
+sc_hash_function_bytes (const void *v, const void *u)
+{
+  SC_ASSERT (u != NULL);
+  return sc_hash_fold64 (sc_hash_bytes (v, *(const size_t *) u, 0));
+}
+
+size_t
+sc_hash_memory_used (sc_hash_t * hash)
+{
+  return sizeof (sc_hash_t) +
+    sc_array_memory_used (hash->slots, 1) +
+    (hash->old_slots != NULL ? sc_array_memory_used (hash->old_slots, 1) : 0)
+    + (hash->allocator_owned ? sc_mempool_memory_used (hash->allocator) : 0);
+}
+
+static const size_t sc_hash_minimal_size = (size_t) ((1 << 8) - 1);
+static const size_t sc_hash_shrink_interval = (size_t) (1 << 8);
+
+/* number of old slots moved to the new slot array per insert or remove */
+static const size_t sc_hash_migrate_slots = 8;
+
+static sc_array_t  *
+sc_hash_new_slots (size_t count)
+{
+  sc_array_t         *slots;
+
+  slots = sc_array_new_count (sizeof (sc_hash_link_t *), count);
+  memset (slots->array, 0, count * sizeof (sc_hash_link_t *));
+
+  return slots;
+}
+
+/** Return the hash value of a linked object, from the cache if present. */
+static inline unsigned int
+sc_hash_link_hval (sc_hash_t * hash, sc_hash_link_t * lynk)
+{
+  return hash->cache_hval ? lynk->hval :
+    hash->hash_fn (lynk->data, hash->user_data);
+}
+
+/** Test whether a linked object equals an object of a given hash value.
+ * The cached hash value, if present, avoids most calls to equal_fn.
+ */
+static inline int
+sc_hash_link_equal (sc_hash_t * hash, sc_hash_link_t * lynk, void *v,
+                    unsigned int hval)
+{
+  return (!hash->cache_hval || lynk->hval == hval) &&
+    hash->equal_fn (lynk->data, v, hash->user_data);
+}
+
+/** Return the address of the chain head responsible for a hash value.
+ * While a resize is in progress, slots that have not been migrated yet
+ * are looked up in the old slot array.
+ */
+static sc_hash_link_t **
+sc_hash_chain (sc_hash_t * hash, unsigned int hval)
+{
+  size_t              i;
+
+  if (hash->old_slots != NULL) {
+    i = hval % hash->old_slots->elem_count;
+    if (i >= hash->migrate_next) {
+      return (sc_hash_link_t **) sc_array_index (hash->old_slots, i);
+    }
+  }
+  i = hval % hash->slots->elem_count;
+  return (sc_hash_link_t **) sc_array_index (hash->slots, i);
+}
+
+/** Move up to a given number of old slots into the new slot array.
+ * The links are reused and keep their addresses.  If the hash values
+ * are cached, it is unnecessary to call hash_fn.
+ */
+static void
+sc_hash_migrate (sc_hash_t * hash, size_t num_slots)
+{
+  size_t              i, end;
+  sc_hash_link_t    **old_head, **new_head;
+  sc_hash_link_t     *lynk, *temp;
+  sc_array_t         *old_slots = hash->old_slots;
+  sc_array_t         *new_slots = hash->slots;
+
+  SC_ASSERT (old_slots != NULL);
+
+  end = SC_MIN (hash->migrate_next + num_slots, old_slots->elem_count);
+  for (i = hash->migrate_next; i < end; ++i) {
+    old_head = (sc_hash_link_t **) sc_array_index (old_slots, i);
+    for (lynk = *old_head; lynk != NULL; lynk = temp) {
+      temp = lynk->next;
+      new_head = (sc_hash_link_t **)
+        sc_array_index (new_slots,
+                        sc_hash_link_hval (hash, lynk) %
+                        new_slots->elem_count);
+      lynk->next = *new_head;
+      *new_head = lynk;
+    }
+    *old_head = NULL;
+  }
+  hash->migrate_next = end;
+
+  if (end == old_slots->elem_count) {
+    sc_array_destroy (old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_next = 0;
+  }
+}
+
+/** Start a resize if the load calls for it.
+ * The elements are moved incrementally by subsequent insertions and removals.
+ */
+static void
+sc_hash_maybe_resize (sc_hash_t * hash)
+{
+  size_t              new_size;
+  size_t              old_size = hash->slots->elem_count;
+
+  SC_ASSERT (old_size > 0);
+
+  ++hash->resize_checks;
+  if (hash->elem_count >= 4 * old_size) {
+    new_size = 4 * old_size - 1;
+  }
+  else if (hash->elem_count <= old_size / 4) {
+    new_size = old_size / 4 + 1;
+    if (new_size < sc_hash_minimal_size) {
+      return;
+    }
+  }
+  else {
+    return;
+  }
+  ++hash->resize_actions;
+
+  /* a previous migration that has not finished is completed first */
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, hash->old_slots->elem_count);
+  }
+  SC_ASSERT (hash->old_slots == NULL && hash->migrate_next == 0);
+
+  hash->old_slots = hash->slots;
+  hash->slots = sc_hash_new_slots (new_size);
+  sc_hash_migrate (hash, sc_hash_migrate_slots);
 }
 
 sc_hash_t          *
 sc_hash_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
              void *user_data, sc_mempool_t * allocator)
 {
-  size_t              i;
   sc_hash_t          *hash;
-  sc_list_t          *list;
-  sc_array_t         *slots;
 
   hash = SC_ALLOC (sc_hash_t, 1);
 
   if (allocator != NULL) {
-    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t));
+    SC_ASSERT (allocator->elem_size == sizeof (sc_link_t) ||
+               allocator->elem_size == sizeof (sc_hash_link_t));
     hash->allocator = allocator;
     hash->allocator_owned = 0;
   }
   else {
-    hash->allocator = sc_mempool_new (sizeof (sc_link_t));
+    hash->allocator = sc_mempool_new_intrusive (sizeof (sc_hash_link_t));
     hash->allocator_owned = 1;
   }
+  /* the smaller sc_link_t shared by many tables has no room for hval */
+  hash->cache_hval = hash->allocator->elem_size == sizeof (sc_hash_link_t);
 
   hash->elem_count = 0;
   hash->resize_checks = 0;
   hash->resize_actions = 0;
+  hash->chain_max = 0;
   hash->hash_fn = hash_fn;
   hash->equal_fn = equal_fn;
   hash->user_data = user_data;
 
-  hash->slots = slots = sc_array_new (sizeof (sc_list_t));
-  sc_array_resize (slots, sc_hash_minimal_size);
-  for (i = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    sc_list_init (list, hash->allocator);
-  }
+  hash->slots = sc_hash_new_slots (sc_hash_minimal_size);
+  hash->old_slots = NULL;
+  hash->migrate_next = 0;
 
   return hash;
 }
@@ -1331,6 +3857,9 @@ sc_hash_destroy (sc_hash_t * hash)
     /* return all list elements to the allocator: requires O(N) */
     sc_hash_truncate (hash);
   }
+  if (hash->old_slots != NULL) {
+    sc_array_destroy (hash->old_slots);
+  }
   sc_array_destroy (hash->slots);
 
   SC_FREE (hash);
@@ -1346,13 +3875,35 @@ sc_hash_destroy_null (sc_hash_t ** phash)
   *phash = NULL;
 }
 
+/** Unlink all chains of a slot array and optionally free the links.
+ * \return      The number of links encountered.
+ */
+static size_t
+sc_hash_clear_slots (sc_hash_t * hash, sc_array_t * slots, int free_links)
+{
+  size_t              i, count;
+  sc_hash_link_t    **head;
+  sc_hash_link_t     *lynk, *temp;
+
+  for (i = 0, count = 0; i < slots->elem_count; ++i) {
+    head = (sc_hash_link_t **) sc_array_index (slots, i);
+    for (lynk = *head; lynk != NULL; lynk = temp) {
+      temp = lynk->next;
+      if (free_links) {
+        sc_mempool_free (hash->allocator, lynk);
+      }
+      ++count;
+    }
+    *head = NULL;
+  }
+
+  return count;
+}
+
 void
 sc_hash_truncate (sc_hash_t * hash)
 {
-  size_t              i;
   size_t              count;
-  sc_list_t          *list;
-  sc_array_t         *slots = hash->slots;
 
   if (hash->elem_count == 0) {
     return;
@@ -1365,10 +3916,12 @@ sc_hash_truncate (sc_hash_t * hash)
   }
 
   /* return all list elements to the outside memory allocator */
-  for (i = 0, count = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    count += list->elem_count;
-    sc_list_reset (list);
+  count = sc_hash_clear_slots (hash, hash->slots, 1);
+  if (hash->old_slots != NULL) {
+    count += sc_hash_clear_slots (hash, hash->old_slots, 1);
+    sc_array_destroy (hash->old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_next = 0;
   }
   SC_ASSERT (count == hash->elem_count);
 
@@ -1378,14 +3931,14 @@ sc_hash_truncate (sc_hash_t * hash)
 void
 sc_hash_unlink (sc_hash_t * hash)
 {
-  size_t              i, count;
-  sc_list_t          *list;
-  sc_array_t         *slots = hash->slots;
+  size_t              count;
 
-  for (i = 0, count = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    count += list->elem_count;
-    sc_list_unlink (list);
+  count = sc_hash_clear_slots (hash, hash->slots, 0);
+  if (hash->old_slots != NULL) {
+    count += sc_hash_clear_slots (hash, hash->old_slots, 0);
+    sc_array_destroy (hash->old_slots);
+    hash->old_slots = NULL;
+    hash->migrate_next = 0;
   }
   SC_ASSERT (count == hash->elem_count);
 
@@ -1398,149 +3951,910 @@ sc_hash_unlink_destroy (sc_hash_t * hash)
   if (hash->allocator_owned) {
     sc_mempool_destroy (hash->allocator);
   }
+  if (hash->old_slots != NULL) {
+    sc_array_destroy (hash->old_slots);
+  }
   sc_array_destroy (hash->slots);
 
   SC_FREE (hash);
 }
 
+/** Look up an object whose hash value is already known. */
+static int
+sc_hash_lookup_hval (sc_hash_t * hash, void *v, unsigned int hval,
+                     void ***found)
+{
+  sc_hash_link_t     *lynk;
+
+  /* a pending migration is left to insert and remove */
+  for (lynk = *sc_hash_chain (hash, hval); lynk != NULL; lynk = lynk->next) {
+    /* check if an equal object is contained in the hash table */
+    if (sc_hash_link_equal (hash, lynk, v, hval)) {
+      if (found != NULL) {
+        *found = &lynk->data;
+      }
+      return 1;
+    }
+  }
+  return 0;
+}
+
 int
 sc_hash_lookup (sc_hash_t * hash, void *v, void ***found)
 {
-  size_t              hval;
-  sc_list_t          *list;
-  sc_link_t          *lynk;
+  return sc_hash_lookup_hval (hash, v, hash->hash_fn (v, hash->user_data),
+                              found);
+}
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+/** Insert an object whose hash value is already known. */
+static int
+sc_hash_insert_unique_hval (sc_hash_t * hash, void *v, unsigned int hval,
+                            void ***found)
+{
+  size_t              length;
+  sc_hash_link_t    **pnext;
+  sc_hash_link_t     *lynk;
 
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    /* check if an equal object is contained in the hash table */
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, sc_hash_migrate_slots);
+  }
+
+  /* check if an equal object is already contained in the hash table */
+  length = 1;
+  for (pnext = sc_hash_chain (hash, hval); *pnext != NULL;
+       pnext = &(*pnext)->next, ++length) {
+    lynk = *pnext;
+    if (sc_hash_link_equal (hash, lynk, v, hval)) {
       if (found != NULL) {
         *found = &lynk->data;
       }
+      return 0;
+    }
+  }
+
+  /* append new object to the chain; links never move during a resize */
+  lynk = (sc_hash_link_t *) sc_mempool_alloc (hash->allocator);
+  lynk->data = v;
+  lynk->next = NULL;
+  if (hash->cache_hval) {
+    lynk->hval = hval;
+  }
+  *pnext = lynk;
+  if (found != NULL) {
+    *found = &lynk->data;
+  }
+  ++hash->elem_count;
+  hash->chain_max = SC_MAX (hash->chain_max, length);
+
+  /* check for resize at specific intervals */
+  if (hash->elem_count % hash->slots->elem_count == 0) {
+    sc_hash_maybe_resize (hash);
+  }
+
+  return 1;
+}
+
+int
+sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
+{
+  return sc_hash_insert_unique_hval (hash, v,
+                                     hash->hash_fn (v, hash->user_data),
+                                     found);
+}
+
+/** Grow the slot array at once such that a number of objects fits.
+ * The sizes follow the growth sequence of \ref sc_hash_maybe_resize.
+ */
+static void
+sc_hash_presize (sc_hash_t * hash, size_t count)
+{
+  size_t              new_size = hash->slots->elem_count;
+
+  while (count >= 4 * new_size) {
+    new_size = 4 * new_size - 1;
+  }
+  if (new_size == hash->slots->elem_count) {
+    return;
+  }
+  ++hash->resize_actions;
+
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, hash->old_slots->elem_count);
+  }
+  hash->old_slots = hash->slots;
+  hash->slots = sc_hash_new_slots (new_size);
+  sc_hash_migrate (hash, hash->old_slots->elem_count);
+  SC_ASSERT (hash->old_slots == NULL);
+}
+
+/** Prefetch the chain head responsible for a hash value. */
+static inline void
+sc_hash_prefetch (sc_hash_t * hash, unsigned int hval)
+{
+#ifdef __GNUC__
+  __builtin_prefetch (sc_hash_chain (hash, hval));
+#endif
+}
+
+int
+sc_hash_remove (sc_hash_t * hash, void *v, void **found)
+{
+  unsigned int        hval;
+  sc_hash_link_t    **pnext;
+  sc_hash_link_t     *lynk;
+
+  hval = hash->hash_fn (v, hash->user_data);
+  if (hash->old_slots != NULL) {
+    sc_hash_migrate (hash, sc_hash_migrate_slots);
+  }
+
+  for (pnext = sc_hash_chain (hash, hval); *pnext != NULL;
+       pnext = &(*pnext)->next) {
+    lynk = *pnext;
+    /* check if an equal object is contained in the hash table */
+    if (sc_hash_link_equal (hash, lynk, v, hval)) {
+      if (found != NULL) {
+        *found = lynk->data;
+      }
+      *pnext = lynk->next;
+      sc_mempool_free (hash->allocator, lynk);
+      --hash->elem_count;
+
+      /* check for resize at specific intervals and return */
+      if (hash->elem_count % sc_hash_shrink_interval == 0) {
+        sc_hash_maybe_resize (hash);
+      }
       return 1;
     }
   }
-  return 0;
+  return 0;
+}
+
+/** Invoke a callback for the chains of a range of slots.
+ * \return      False if the callback requested to stop, true otherwise.
+ */
+static int
+sc_hash_foreach_slots (sc_hash_t * hash, sc_array_t * slots,
+                       size_t first, sc_hash_foreach_t fn)
+{
+  size_t              slot;
+  sc_hash_link_t     *lynk;
+
+  for (slot = first; slot < slots->elem_count; ++slot) {
+    lynk = *(sc_hash_link_t **) sc_array_index (slots, slot);
+    for (; lynk != NULL; lynk = lynk->next) {
+      if (!fn (&lynk->data, hash->user_data)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+void
+sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
+{
+  if (sc_hash_foreach_slots (hash, hash->slots, 0, fn) &&
+      hash->old_slots != NULL) {
+    (void) sc_hash_foreach_slots (hash, hash->old_slots,
+                                  hash->migrate_next, fn);
+  }
+}
+
+/** Accumulate the chain lengths of a range of slots. */
+static void
+sc_hash_chain_statistics (sc_array_t * slots, size_t first,
+                          double *sum, double *squaresum, size_t *longest)
+{
+  size_t              i, length;
+  double              a;
+  sc_hash_link_t     *lynk;
+
+  for (i = first; i < slots->elem_count; ++i) {
+    length = 0;
+    for (lynk = *(sc_hash_link_t **) sc_array_index (slots, i);
+         lynk != NULL; lynk = lynk->next) {
+      ++length;
+    }
+    a = (double) length;
+    *sum += a;
+    *squaresum += a * a;
+    *longest = SC_MAX (*longest, length);
+  }
+}
+
+void
+sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
+{
+  size_t              longest, migrated, pending;
+  double              sum, squaresum;
+  double              divide, avg, sqr, std;
+  sc_array_t         *slots = hash->slots;
+
+  sum = 0.;
+  squaresum = 0.;
+  longest = 0;
+  sc_hash_chain_statistics (slots, 0, &sum, &squaresum, &longest);
+  migrated = pending = 0;
+  if (hash->old_slots != NULL) {
+    migrated = hash->migrate_next;
+    pending = hash->old_slots->elem_count - migrated;
+    sc_hash_chain_statistics (hash->old_slots, migrated,
+                              &sum, &squaresum, &longest);
+  }
+  SC_ASSERT ((size_t) sum == hash->elem_count);
+
+  divide = (double) (slots->elem_count + pending);
+  avg = sum / divide;
+  sqr = squaresum / divide - avg * avg;
+  std = sqrt (sqr);
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Hash size %lu avg %.3g std %.3g checks %lu %lu\n",
+               (unsigned long) slots->elem_count, avg, std,
+               (unsigned long) hash->resize_checks,
+               (unsigned long) hash->resize_actions);
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Hash chain longest %lu seen %lu migrated %lu of %lu\n",
+               (unsigned long) longest, (unsigned long) hash->chain_max,
+               (unsigned long) migrated,
+               (unsigned long) (migrated + pending));
+}
+
+/* open addressing hash table routines */
+
+typedef struct sc_hash_open_slot
+{
+  void               *data;     /* the stored object */
+  unsigned int        hval;     /* full hash value of the object */
+  unsigned int        dist;     /* probe distance plus one, 0 if empty */
+}
+sc_hash_open_slot_t;
+
+static const int    sc_hash_open_minimal_bits = 8;
+
+/* the slot count is a power of two and the table is kept at most 7/8 full */
+#define SC_HASH_OPEN_MAX_LOAD(bits) ((((size_t) 1) << (bits)) / 8 * 7)
+
+/** Map the hash value to its home slot by Fibonacci hashing.
+ * This uses the high bits of a multiplicative mix, which protects against
+ * hash functions of poor quality in the low bits.
+ */
+static inline size_t
+sc_hash_open_home (unsigned int hval, int bits)
+{
+  return (size_t) ((((uint64_t) hval) * 0x9E3779B97F4A7C15ULL)
+                   >> (64 - bits));
+}
+
+size_t
+sc_hash_open_memory_used (sc_hash_open_t * hash)
+{
+  return sizeof (sc_hash_open_t) + sc_array_memory_used (hash->slots, 1);
+}
+
+static void
+sc_hash_open_resize (sc_hash_open_t * hash, int new_bits)
+{
+  size_t              zz, pos, mask;
+  size_t              old_count, new_count;
+  unsigned int        dist;
+  sc_hash_open_slot_t *old_slot, *new_slots, *slot, carry, temp;
+  sc_array_t         *old_slots = hash->slots;
+
+  SC_ASSERT (new_bits >= sc_hash_open_minimal_bits);
+  SC_ASSERT (hash->elem_count <= SC_HASH_OPEN_MAX_LOAD (new_bits));
+
+  ++hash->resize_actions;
+  old_count = old_slots->elem_count;
+  new_count = ((size_t) 1) << new_bits;
+  mask = new_count - 1;
+
+  hash->slots = sc_array_new_count (sizeof (sc_hash_open_slot_t), new_count);
+  hash->slot_bits = new_bits;
+  new_slots = (sc_hash_open_slot_t *) hash->slots->array;
+  memset (new_slots, 0, new_count * sizeof (sc_hash_open_slot_t));
+
+  /* reinsert every object with its cached hash value */
+  for (zz = 0; zz < old_count; ++zz) {
+    old_slot = (sc_hash_open_slot_t *) sc_array_index (old_slots, zz);
+    if (old_slot->dist == 0) {
+      continue;
+    }
+    carry = *old_slot;
+    pos = sc_hash_open_home (carry.hval, new_bits);
+    for (dist = 1;; ++dist, pos = (pos + 1) & mask) {
+      slot = new_slots + pos;
+      if (slot->dist == 0) {
+        carry.dist = dist;
+        *slot = carry;
+        break;
+      }
+      if (slot->dist < dist) {
+        /* the resident is closer to home: displace it */
+        carry.dist = dist;
+        temp = *slot;
+        *slot = carry;
+        carry = temp;
+        dist = carry.dist;
+      }
+    }
+  }
+
+  sc_array_destroy (old_slots);
+}
+
+sc_hash_open_t     *
+sc_hash_open_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+                  void *user_data)
+{
+  size_t              count;
+  sc_hash_open_t     *hash;
+
+  hash = SC_ALLOC (sc_hash_open_t, 1);
+
+  hash->elem_count = 0;
+  hash->resize_checks = 0;
+  hash->resize_actions = 0;
+  hash->hash_fn = hash_fn;
+  hash->equal_fn = equal_fn;
+  hash->user_data = user_data;
+
+  count = ((size_t) 1) << sc_hash_open_minimal_bits;
+  hash->slot_bits = sc_hash_open_minimal_bits;
+  hash->slots = sc_array_new_count (sizeof (sc_hash_open_slot_t), count);
+  memset (hash->slots->array, 0, count * sizeof (sc_hash_open_slot_t));
+
+  return hash;
+}
+
+void
+sc_hash_open_destroy (sc_hash_open_t * hash)
+{
+  sc_array_destroy (hash->slots);
+
+  SC_FREE (hash);
+}
+
+void
+sc_hash_open_destroy_null (sc_hash_open_t ** phash)
+{
+  SC_ASSERT (phash != NULL);
+  SC_ASSERT (*phash != NULL);
+
+  sc_hash_open_destroy (*phash);
+  *phash = NULL;
+}
+
+void
+sc_hash_open_truncate (sc_hash_open_t * hash)
+{
+  if (hash->elem_count == 0) {
+    return;
+  }
+
+  memset (hash->slots->array, 0,
+          hash->slots->elem_count * sizeof (sc_hash_open_slot_t));
+  hash->elem_count = 0;
+}
+
+/** Find the slot position of an object equal to v.
+ * \return      The position if found, or -1 otherwise.
+ */
+static              ssize_t
+sc_hash_open_find (sc_hash_open_t * hash, void *v, unsigned int hval)
+{
+  const size_t        mask = hash->slots->elem_count - 1;
+  size_t              pos;
+  unsigned int        dist;
+  sc_hash_open_slot_t *slots = (sc_hash_open_slot_t *) hash->slots->array;
+  sc_hash_open_slot_t *slot;
+
+  pos = sc_hash_open_home (hval, hash->slot_bits);
+  for (dist = 1;; ++dist, pos = (pos + 1) & mask) {
+    slot = slots + pos;
+
+    /* an empty slot or a resident closer to its home ends the search */
+    if (slot->dist < dist) {
+      return -1;
+    }
+    if (slot->hval == hval &&
+        hash->equal_fn (slot->data, v, hash->user_data)) {
+      return (ssize_t) pos;
+    }
+  }
+}
+
+int
+sc_hash_open_lookup (sc_hash_open_t * hash, void *v, void ***found)
+{
+  ssize_t             pos;
+  sc_hash_open_slot_t *slot;
+
+  pos = sc_hash_open_find (hash, v, hash->hash_fn (v, hash->user_data));
+  if (pos < 0) {
+    return 0;
+  }
+  if (found != NULL) {
+    slot = (sc_hash_open_slot_t *) sc_array_index_ssize_t (hash->slots, pos);
+    *found = &slot->data;
+  }
+  return 1;
 }
 
 int
-sc_hash_insert_unique (sc_hash_t * hash, void *v, void ***found)
+sc_hash_open_insert_unique (sc_hash_open_t * hash, void *v, void ***found)
 {
-  size_t              hval;
-  sc_list_t          *list;
-  sc_link_t          *lynk;
+  size_t              pos, mask;
+  unsigned int        hval, dist;
+  sc_hash_open_slot_t *slots, *slot, *placed, carry, temp;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  hval = hash->hash_fn (v, hash->user_data);
 
-  /* check if an equal object is already contained in the hash table */
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
+  /* grow the table before the search such that no slot moves afterwards */
+  if (hash->elem_count + 1 > SC_HASH_OPEN_MAX_LOAD (hash->slot_bits)) {
+    ++hash->resize_checks;
+    if (sc_hash_open_find (hash, v, hval) < 0) {
+      sc_hash_open_resize (hash, hash->slot_bits + 1);
+    }
+  }
+
+  mask = hash->slots->elem_count - 1;
+  slots = (sc_hash_open_slot_t *) hash->slots->array;
+  pos = sc_hash_open_home (hval, hash->slot_bits);
+  for (dist = 1;; ++dist, pos = (pos + 1) & mask) {
+    slot = slots + pos;
+    if (slot->dist < dist) {
+      break;
+    }
+    if (slot->hval == hval &&
+        hash->equal_fn (slot->data, v, hash->user_data)) {
       if (found != NULL) {
-        *found = &lynk->data;
+        *found = &slot->data;
       }
       return 0;
     }
   }
 
-  /* append new object to the list */
-  (void) sc_list_append (list, v);
+  /* the object is new: place it here and shift residents towards the end */
+  placed = slot;
+  carry.data = v;
+  carry.hval = hval;
+  for (;; ++dist, pos = (pos + 1) & mask) {
+    slot = slots + pos;
+    if (slot->dist == 0) {
+      carry.dist = dist;
+      *slot = carry;
+      break;
+    }
+    if (slot->dist < dist) {
+      carry.dist = dist;
+      temp = *slot;
+      *slot = carry;
+      carry = temp;
+      dist = carry.dist;
+    }
+  }
   if (found != NULL) {
-    *found = &list->last->data;
+    *found = &placed->data;
   }
   ++hash->elem_count;
 
-  /* check for resize at specific intervals and reassign output */
-  if (hash->elem_count % hash->slots->elem_count == 0) {
-    sc_hash_maybe_resize (hash);
-    if (found != NULL) {
-      SC_EXECUTE_ASSERT_TRUE (sc_hash_lookup (hash, v, found));
-    }
-  }
-
   return 1;
 }
 
 int
-sc_hash_remove (sc_hash_t * hash, void *v, void **found)
+sc_hash_open_remove (sc_hash_open_t * hash, void *v, void **found)
 {
-  size_t              hval;
-  sc_list_t          *list;
-  sc_link_t          *lynk, *prev;
+  ssize_t             spos;
+  size_t              pos, next, mask;
+  sc_hash_open_slot_t *slots;
 
-  hval = hash->hash_fn (v, hash->user_data) % hash->slots->elem_count;
-  list = (sc_list_t *) sc_array_index (hash->slots, hval);
+  spos = sc_hash_open_find (hash, v, hash->hash_fn (v, hash->user_data));
+  if (spos < 0) {
+    return 0;
+  }
 
-  prev = NULL;
-  for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-    /* check if an equal object is contained in the hash table */
-    if (hash->equal_fn (lynk->data, v, hash->user_data)) {
-      if (found != NULL) {
-        *found = lynk->data;
-      }
-      (void) sc_list_remove (list, prev);
-      --hash->elem_count;
+  mask = hash->slots->elem_count - 1;
+  slots = (sc_hash_open_slot_t *) hash->slots->array;
+  pos = (size_t) spos;
+  if (found != NULL) {
+    *found = slots[pos].data;
+  }
 
-      /* check for resize at specific intervals and return */
-      if (hash->elem_count % sc_hash_shrink_interval == 0) {
-        sc_hash_maybe_resize (hash);
-      }
-      return 1;
+  /* shift the following displaced residents back by one slot */
+  for (next = (pos + 1) & mask; slots[next].dist > 1;
+       pos = next, next = (next + 1) & mask) {
+    slots[pos] = slots[next];
+    --slots[pos].dist;
+  }
+  slots[pos].dist = 0;
+  --hash->elem_count;
+
+  /* shrink the table if it has become sparse */
+  if (hash->slot_bits > sc_hash_open_minimal_bits &&
+      hash->elem_count % sc_hash_shrink_interval == 0) {
+    ++hash->resize_checks;
+    if (hash->elem_count < hash->slots->elem_count / 8) {
+      sc_hash_open_resize (hash, hash->slot_bits - 1);
     }
-    prev = lynk;
   }
-  return 0;
+
+  return 1;
 }
 
 void
-sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn)
+sc_hash_open_foreach (sc_hash_open_t * hash, sc_hash_foreach_t fn)
 {
-  size_t              slot;
-  sc_list_t          *list;
-  sc_link_t          *lynk;
+  size_t              zz;
+  sc_hash_open_slot_t *slot;
 
-  for (slot = 0; slot < hash->slots->elem_count; ++slot) {
-    list = (sc_list_t *) sc_array_index (hash->slots, slot);
-    for (lynk = list->first; lynk != NULL; lynk = lynk->next) {
-      if (!fn (&lynk->data, hash->user_data)) {
-        return;
-      }
+  for (zz = 0; zz < hash->slots->elem_count; ++zz) {
+    slot = (sc_hash_open_slot_t *) sc_array_index (hash->slots, zz);
+    if (slot->dist > 0 && !fn (&slot->data, hash->user_data)) {
+      return;
     }
   }
 }
 
 void
-sc_hash_print_statistics (int package_id, int log_priority, sc_hash_t * hash)
+sc_hash_open_print_statistics (int package_id, int log_priority,
+                               sc_hash_open_t * hash)
 {
-  size_t              i;
+  size_t              zz, count, maxdist;
   double              a, sum, squaresum;
   double              divide, avg, sqr, std;
-  sc_list_t          *list;
+  sc_hash_open_slot_t *slot;
   sc_array_t         *slots = hash->slots;
 
+  count = maxdist = 0;
   sum = 0.;
   squaresum = 0.;
-  for (i = 0; i < slots->elem_count; ++i) {
-    list = (sc_list_t *) sc_array_index (slots, i);
-    a = (double) list->elem_count;
-    sum += a;
-    squaresum += a * a;
+  for (zz = 0; zz < slots->elem_count; ++zz) {
+    slot = (sc_hash_open_slot_t *) sc_array_index (slots, zz);
+    if (slot->dist > 0) {
+      ++count;
+      a = (double) slot->dist;
+      sum += a;
+      squaresum += a * a;
+      maxdist = SC_MAX (maxdist, (size_t) slot->dist);
+    }
   }
-  SC_ASSERT ((size_t) sum == hash->elem_count);
+  SC_ASSERT (count == hash->elem_count);
 
-  divide = (double) slots->elem_count;
+  divide = (double) SC_MAX (count, (size_t) 1);
   avg = sum / divide;
   sqr = squaresum / divide - avg * avg;
-  std = sqrt (sqr);
+  std = sqrt (SC_MAX (sqr, 0.));
   SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
-               "Hash size %lu avg %.3g std %.3g checks %lu %lu\n",
-               (unsigned long) slots->elem_count, avg, std,
+               "Open hash size %lu load %.3g probes avg %.3g std %.3g"
+               " max %lu checks %lu %lu\n",
+               (unsigned long) slots->elem_count,
+               count / (double) slots->elem_count, avg, std,
+               (unsigned long) maxdist,
                (unsigned long) hash->resize_checks,
                (unsigned long) hash->resize_actions);
 }
 
+/* frozen hash index routines */
+
+typedef struct sc_hash_frozen_entry
+{
+  unsigned int        hval;
+  void               *data;
+}
+sc_hash_frozen_entry_t;
+
+/* average number of distinct hash values per pilot bucket */
+static const size_t sc_hash_frozen_bucket_size = 3;
+
+/* minimum number of pilots tried for a bucket before choosing another seed */
+static const uint64_t sc_hash_frozen_min_pilots = (uint64_t) 1 << 20;
+
+static int
+sc_hash_frozen_entry_compare (const void *v1, const void *v2)
+{
+  const sc_hash_frozen_entry_t *e1 = (const sc_hash_frozen_entry_t *) v1;
+  const sc_hash_frozen_entry_t *e2 = (const sc_hash_frozen_entry_t *) v2;
+
+  return e1->hval < e2->hval ? -1 : e1->hval > e2->hval ? 1 : 0;
+}
+
+static inline uint64_t
+sc_hash_frozen_key (uint64_t seed, unsigned int hval)
+{
+  return sc_hash_mix64 ((uint64_t) hval + seed);
+}
+
+static inline size_t
+sc_hash_frozen_bucket (uint64_t key, size_t num_buckets)
+{
+  return (size_t) ((key >> 32) % num_buckets);
+}
+
+static inline size_t
+sc_hash_frozen_slot (uint64_t key, uint32_t pilot, size_t num_slots)
+{
+  return (size_t) (sc_hash_mix64 (key ^ (SC_HASH_PRIME64_2 *
+                                         ((uint64_t) pilot + 1)))
+                   % num_slots);
+}
+
+/** Find a pilot for every bucket such that all slots are hit exactly once.
+ * \param [in] keys     The scrambled distinct hash values.
+ * \param [out] pilots  On success, the pilot of every bucket.
+ * \param [out] slot_of On success, the slot of every key.
+ * \return              True on success, false if the seed is unusable.
+ */
+static int
+sc_hash_frozen_pilots (uint64_t * keys, size_t num_slots,
+                       size_t num_buckets, uint32_t * pilots,
+                       size_t *slot_of)
+{
+  int                 success;
+  size_t              zz, b, j, k, size, max_size;
+  size_t             *bucket_start, *bucket_keys, *size_start, *order;
+  uint32_t            pilot, max_pilot;
+  char               *taken;
+
+  /* the last singleton buckets need about num_slots attempts */
+  max_pilot = (uint32_t) SC_MIN (SC_MAX (sc_hash_frozen_min_pilots,
+                                         16 * (uint64_t) num_slots),
+                                 (uint64_t) UINT32_MAX);
+
+  /* group the keys by bucket */
+  bucket_start = SC_ALLOC_ZERO (size_t, num_buckets + 1);
+  bucket_keys = SC_ALLOC (size_t, num_slots);
+  for (zz = 0; zz < num_slots; ++zz) {
+    ++bucket_start[sc_hash_frozen_bucket (keys[zz], num_buckets) + 1];
+  }
+  for (b = 0, max_size = 0; b < num_buckets; ++b) {
+    max_size = SC_MAX (max_size, bucket_start[b + 1]);
+    bucket_start[b + 1] += bucket_start[b];
+  }
+  for (zz = 0; zz < num_slots; ++zz) {
+    b = sc_hash_frozen_bucket (keys[zz], num_buckets);
+    bucket_keys[bucket_start[b]++] = zz;
+  }
+  for (b = num_buckets; b > 0; --b) {
+    bucket_start[b] = bucket_start[b - 1];
+  }
+  bucket_start[0] = 0;
+
+  /* order the buckets by decreasing size */
+  size_start = SC_ALLOC_ZERO (size_t, max_size + 2);
+  order = SC_ALLOC (size_t, num_buckets);
+  for (b = 0; b < num_buckets; ++b) {
+    size = bucket_start[b + 1] - bucket_start[b];
+    ++size_start[max_size - size + 1];
+  }
+  for (k = 0; k <= max_size; ++k) {
+    size_start[k + 1] += size_start[k];
+  }
+  for (b = 0; b < num_buckets; ++b) {
+    size = bucket_start[b + 1] - bucket_start[b];
+    order[size_start[max_size - size]++] = b;
+  }
+
+  /* place the buckets one by one, the large ones while the table is empty */
+  success = 1;
+  taken = SC_ALLOC_ZERO (char, num_slots);
+  for (zz = 0; zz < num_buckets && success; ++zz) {
+    b = order[zz];
+    pilots[b] = 0;
+    if (bucket_start[b] == bucket_start[b + 1]) {
+      continue;
+    }
+    for (pilot = 0;; ++pilot) {
+      if (pilot == max_pilot) {
+        success = 0;
+        break;
+      }
+      for (j = bucket_start[b]; j < bucket_start[b + 1]; ++j) {
+        k = bucket_keys[j];
+        slot_of[k] = sc_hash_frozen_slot (keys[k], pilot, num_slots);
+        if (taken[slot_of[k]]) {
+          break;
+        }
+        taken[slot_of[k]] = 1;
+      }
+      if (j == bucket_start[b + 1]) {
+        pilots[b] = pilot;
+        break;
+      }
+      /* release the slots of this unsuccessful attempt */
+      while (j-- > bucket_start[b]) {
+        taken[slot_of[bucket_keys[j]]] = 0;
+      }
+    }
+  }
+
+  SC_FREE (taken);
+  SC_FREE (order);
+  SC_FREE (size_start);
+  SC_FREE (bucket_keys);
+  SC_FREE (bucket_start);
+
+  return success;
+}
+
+/** Copy the objects and hash values of a range of slots.
+ * \return      The position after the last entry written.
+ */
+static sc_hash_frozen_entry_t *
+sc_hash_frozen_gather (sc_hash_t * hash, sc_array_t * slots, size_t first,
+                       sc_hash_frozen_entry_t * e)
+{
+  size_t              zz;
+  sc_hash_link_t     *lynk;
+
+  for (zz = first; zz < slots->elem_count; ++zz) {
+    for (lynk = *(sc_hash_link_t **) sc_array_index (slots, zz);
+         lynk != NULL; lynk = lynk->next) {
+      e->hval = sc_hash_link_hval (hash, lynk);
+      e->data = lynk->data;
+      ++e;
+    }
+  }
+  return e;
+}
+
+sc_hash_frozen_t   *
+sc_hash_freeze (sc_hash_t * hash)
+{
+  size_t              zz, i, m, o, nb;
+  size_t              off_items, off_overflow, off_pilots;
+  size_t              off_hvals, off_overflow_hvals, total;
+  size_t             *slot_of;
+  uint64_t            seed, *keys;
+  char               *block;
+  sc_hash_frozen_entry_t *entries, *e;
+  sc_hash_frozen_t   *frozen;
+
+  /* gather the objects with their hash values */
+  entries = SC_ALLOC (sc_hash_frozen_entry_t, hash->elem_count);
+  e = sc_hash_frozen_gather (hash, hash->slots, 0, entries);
+  if (hash->old_slots != NULL) {
+    e = sc_hash_frozen_gather (hash, hash->old_slots,
+                               hash->migrate_next, e);
+  }
+  SC_ASSERT ((size_t) (e - entries) == hash->elem_count);
+  qsort (entries, hash->elem_count, sizeof (sc_hash_frozen_entry_t),
+         sc_hash_frozen_entry_compare);
+
+  /* count distinct hash values */
+  for (zz = 0, m = 0; zz < hash->elem_count; ++zz) {
+    if (zz == 0 || entries[zz].hval != entries[zz - 1].hval) {
+      ++m;
+    }
+  }
+  o = hash->elem_count - m;
+  nb = m / sc_hash_frozen_bucket_size + 1;
+
+  /* allocate all arrays behind the header, pointer arrays first */
+  off_items = (sizeof (sc_hash_frozen_t) + 7) & ~(size_t) 7;
+  off_overflow = off_items + m * sizeof (void *);
+  off_pilots = off_overflow + o * sizeof (void *);
+  off_hvals = off_pilots + nb * sizeof (uint32_t);
+  off_overflow_hvals = off_hvals + m * sizeof (unsigned int);
+  total = off_overflow_hvals + o * sizeof (unsigned int);
+  block = SC_ALLOC (char, total);
+
+  frozen = (sc_hash_frozen_t *) block;
+  frozen->elem_count = hash->elem_count;
+  frozen->num_slots = m;
+  frozen->num_buckets = nb;
+  frozen->num_overflow = o;
+  frozen->byte_alloc = total;
+  frozen->user_data = hash->user_data;
+  frozen->hash_fn = hash->hash_fn;
+  frozen->equal_fn = hash->equal_fn;
+  frozen->items = (void **) (block + off_items);
+  frozen->overflow_items = (void **) (block + off_overflow);
+  frozen->pilots = (uint32_t *) (block + off_pilots);
+  frozen->hvals = (unsigned int *) (block + off_hvals);
+  frozen->overflow_hvals = (unsigned int *) (block + off_overflow_hvals);
+
+  /* compute the perfect hash of the distinct values */
+  keys = SC_ALLOC (uint64_t, m);
+  slot_of = SC_ALLOC (size_t, m);
+  for (seed = 0;; ++seed) {
+    for (zz = 0, i = 0; zz < hash->elem_count; ++zz) {
+      if (zz == 0 || entries[zz].hval != entries[zz - 1].hval) {
+        keys[i++] = sc_hash_frozen_key (seed, entries[zz].hval);
+      }
+    }
+    if (sc_hash_frozen_pilots (keys, m, nb, frozen->pilots, slot_of)) {
+      break;
+    }
+  }
+  frozen->seed = seed;
+
+  /* distribute the objects into the slots and the overflow */
+  for (zz = 0, i = 0, o = 0; zz < hash->elem_count; ++zz) {
+    if (zz == 0 || entries[zz].hval != entries[zz - 1].hval) {
+      frozen->items[slot_of[i]] = entries[zz].data;
+      frozen->hvals[slot_of[i]] = entries[zz].hval;
+      ++i;
+    }
+    else {
+      frozen->overflow_items[o] = entries[zz].data;
+      frozen->overflow_hvals[o] = entries[zz].hval;
+      ++o;
+    }
+  }
+  SC_ASSERT (i == m && o == frozen->num_overflow);
+
+  SC_FREE (slot_of);
+  SC_FREE (keys);
+  SC_FREE (entries);
+
+  return frozen;
+}
+
+size_t
+sc_hash_frozen_memory_used (sc_hash_frozen_t * frozen)
+{
+  return frozen->byte_alloc;
+}
+
+void
+sc_hash_frozen_destroy (sc_hash_frozen_t * frozen)
+{
+  SC_FREE (frozen);
+}
+
+int
+sc_hash_frozen_lookup (sc_hash_frozen_t * frozen, void *v, void **found)
+{
+  size_t              slot, low, high, mid;
+  unsigned int        hval;
+  uint64_t            key;
+
+  if (frozen->num_slots == 0) {
+    return 0;
+  }
+
+  /* probe the only slot that the hash value can occupy */
+  hval = frozen->hash_fn (v, frozen->user_data);
+  key = sc_hash_frozen_key (frozen->seed, hval);
+  slot = sc_hash_frozen_slot
+    (key, frozen->pilots[sc_hash_frozen_bucket (key, frozen->num_buckets)],
+     frozen->num_slots);
+  if (frozen->hvals[slot] != hval) {
+    return 0;
+  }
+  if (frozen->equal_fn (frozen->items[slot], v, frozen->user_data)) {
+    if (found != NULL) {
+      *found = frozen->items[slot];
+    }
+    return 1;
+  }
+
+  /* search the objects with a repeated hash value */
+  low = 0;
+  high = frozen->num_overflow;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (frozen->overflow_hvals[mid] < hval) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  for (; low < frozen->num_overflow && frozen->overflow_hvals[low] == hval;
+       ++low) {
+    if (frozen->equal_fn (frozen->overflow_items[low], v,
+                          frozen->user_data)) {
+      if (found != NULL) {
+        *found = frozen->overflow_items[low];
+      }
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /* hash array routines */
 
 size_t
@@ -1684,6 +4998,170 @@ sc_hash_array_insert_unique (sc_hash_array_t * hash_array, void *v,
   }
 }
 
+/* distance in keys at which batch operations prefetch the hash chains */
+#define SC_HASH_ARRAY_PREFETCH 8
+
+/** Compute the hash values of a batch of keys.
+ * \return      Array of unsigned int, to be destroyed by the caller.
+ */
+static sc_array_t  *
+sc_hash_array_prehash (sc_hash_array_t * hash_array, sc_array_t * keys)
+{
+  size_t              zz;
+  unsigned int       *hvals;
+  sc_array_t         *hv;
+  sc_hash_array_data_t *internal_data = &hash_array->internal_data;
+
+  SC_ASSERT (keys->elem_size == hash_array->a.elem_size);
+
+  hv = sc_array_new_count (sizeof (unsigned int), keys->elem_count);
+  hvals = (unsigned int *) hv->array;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    hvals[zz] = internal_data->hash_fn (sc_array_index (keys, zz),
+                                        internal_data->user_data);
+  }
+
+  return hv;
+}
+
+/** Estimate the number of distinct keys in a batch from their hash values.
+ * This is linear counting: we set one bit per scrambled hash value in a
+ * bitmap of at least as many bits as keys and count the bits left unset.
+ * Distinct keys with equal hash values are counted once.
+ */
+static size_t
+sc_hash_array_estimate_distinct (const unsigned int *hvals, size_t count)
+{
+  int                 shift;
+  size_t              zz, num_bits, num_zero, estimate;
+  unsigned int        bit, byte;
+  unsigned char      *bitmap;
+
+  if (count <= 1) {
+    return count;
+  }
+  for (shift = 3; shift < 32 && ((size_t) 1 << shift) < count; ++shift) {
+  }
+  num_bits = (size_t) 1 << shift;
+  bitmap = SC_ALLOC_ZERO (unsigned char, num_bits / 8);
+  for (zz = 0; zz < count; ++zz) {
+    /* the multiplicative scramble takes the well-mixed high bits */
+    bit = (unsigned int) (hvals[zz] * 2654435761U) >> (32 - shift);
+    bitmap[bit >> 3] |= (unsigned char) (1 << (bit & 7));
+  }
+  num_zero = num_bits;
+  for (zz = 0; zz < num_bits / 8; ++zz) {
+    for (byte = bitmap[zz]; byte != 0; byte &= byte - 1) {
+      --num_zero;
+    }
+  }
+  SC_FREE (bitmap);
+
+  if (num_zero == 0) {
+    /* the bitmap is saturated and we cannot tell */
+    return count;
+  }
+  estimate = (size_t) ceil (num_bits * log ((double) num_bits / num_zero));
+  return SC_MIN (estimate, count);
+}
+
+size_t
+sc_hash_array_insert_batch (sc_hash_array_t * hash_array, sc_array_t * keys,
+                            sc_array_t * positions)
+{
+  int                 added;
+  size_t              zz, num_added, position;
+  unsigned int       *hvals;
+  void              **found_void;
+  void               *key;
+  sc_array_t         *hv;
+  sc_hash_t          *h = hash_array->h;
+
+  SC_ASSERT (hash_array->a.elem_count == h->elem_count);
+  SC_ASSERT (keys != &hash_array->a);
+  SC_ASSERT (positions == NULL || positions->elem_size == sizeof (size_t));
+
+  if (positions != NULL) {
+    sc_array_resize (positions, keys->elem_count);
+  }
+  hv = sc_hash_array_prehash (hash_array, keys);
+  hvals = (unsigned int *) hv->array;
+
+  /* size the hash table for the distinct keys; the estimate may be off
+   * a little, which the regular incremental resizing takes care of */
+  sc_hash_presize (h, h->elem_count +
+                   sc_hash_array_estimate_distinct (hvals, keys->elem_count));
+
+  num_added = 0;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    if (zz + SC_HASH_ARRAY_PREFETCH < keys->elem_count) {
+      sc_hash_prefetch (h, hvals[zz + SC_HASH_ARRAY_PREFETCH]);
+    }
+    key = sc_array_index (keys, zz);
+    hash_array->internal_data.current_item = key;
+    added = sc_hash_insert_unique_hval (h, (void *) (-1L), hvals[zz],
+                                        &found_void);
+    hash_array->internal_data.current_item = NULL;
+
+    if (added) {
+      position = hash_array->a.elem_count;
+      *found_void = (void *) position;
+      memcpy (sc_array_push (&hash_array->a), key, keys->elem_size);
+      ++num_added;
+    }
+    else {
+      position = (size_t) (*found_void);
+    }
+    if (positions != NULL) {
+      *(size_t *) sc_array_index (positions, zz) = position;
+    }
+  }
+
+  sc_array_destroy (hv);
+  return num_added;
+}
+
+size_t
+sc_hash_array_lookup_batch (sc_hash_array_t * hash_array, sc_array_t * keys,
+                            sc_array_t * positions)
+{
+  size_t              zz, num_found, position;
+  unsigned int       *hvals;
+  void              **found_void;
+  sc_array_t         *hv;
+  sc_hash_t          *h = hash_array->h;
+
+  SC_ASSERT (positions == NULL || positions->elem_size == sizeof (size_t));
+
+  if (positions != NULL) {
+    sc_array_resize (positions, keys->elem_count);
+  }
+  hv = sc_hash_array_prehash (hash_array, keys);
+  hvals = (unsigned int *) hv->array;
+
+  num_found = 0;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    if (zz + SC_HASH_ARRAY_PREFETCH < keys->elem_count) {
+      sc_hash_prefetch (h, hvals[zz + SC_HASH_ARRAY_PREFETCH]);
+    }
+    hash_array->internal_data.current_item = sc_array_index (keys, zz);
+    if (sc_hash_lookup_hval (h, (void *) (-1L), hvals[zz], &found_void)) {
+      position = (size_t) (*found_void);
+      ++num_found;
+    }
+    else {
+      position = (size_t) -1;
+    }
+    hash_array->internal_data.current_item = NULL;
+    if (positions != NULL) {
+      *(size_t *) sc_array_index (positions, zz) = position;
+    }
+  }
+
+  sc_array_destroy (hv);
+  return num_found;
+}
+
 void
 sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
 {
@@ -1693,6 +5171,64 @@ sc_hash_array_rip (sc_hash_array_t * hash_array, sc_array_t * rip)
   SC_FREE (hash_array);
 }
 
+sc_hash_array_frozen_t *
+sc_hash_array_freeze (sc_hash_array_t * hash_array)
+{
+  sc_hash_array_frozen_t *fha;
+
+  fha = SC_ALLOC (sc_hash_array_frozen_t, 1);
+
+  memcpy (&fha->a, &hash_array->a, sizeof (sc_array_t));
+  fha->internal_data = hash_array->internal_data;
+  fha->internal_data.pa = &fha->a;
+  fha->internal_data.current_item = NULL;
+  fha->f = sc_hash_freeze (hash_array->h);
+  fha->f->user_data = &fha->internal_data;
+
+  sc_hash_destroy (hash_array->h);
+  SC_FREE (hash_array);
+
+  return fha;
+}
+
+size_t
+sc_hash_array_frozen_memory_used (sc_hash_array_frozen_t * fha)
+{
+  return sizeof (sc_hash_array_frozen_t) +
+    sc_array_memory_used (&fha->a, 0) + sc_hash_frozen_memory_used (fha->f);
+}
+
+void
+sc_hash_array_frozen_destroy (sc_hash_array_frozen_t * fha)
+{
+  sc_hash_frozen_destroy (fha->f);
+  sc_array_reset (&fha->a);
+
+  SC_FREE (fha);
+}
+
+int
+sc_hash_array_frozen_lookup (sc_hash_array_frozen_t * fha, void *v,
+                             size_t *position)
+{
+  int                 found;
+  void               *found_void;
+
+  fha->internal_data.current_item = v;
+  found = sc_hash_frozen_lookup (fha->f, (void *) (-1L), &found_void);
+  fha->internal_data.current_item = NULL;
+
+  if (found) {
+    if (position != NULL) {
+      *position = (size_t) found_void;
+    }
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
+
 void
 sc_recycle_array_init (sc_recycle_array_t * rec_array, size_t elem_size)
 {
@@ -46,6 +46,7 @@
 #else
 #include <sc.h>
 #endif
+#include <sc_pages.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -94,7 +95,8 @@ typedef int         (*sc_hash_foreach_t) (void **v, const void *u);
  * \ref sc_array_resize and \ref sc_array_rewind.
  * Elements can be sorted with \ref sc_array_sort.
  * If the array is sorted, it can be searched with \ref sc_array_bsearch.
- * A priority queue is implemented with pqueue_add and pqueue_pop (untested).
+ * A priority queue is implemented with pqueue_add and pqueue_pop.
+ * See \ref sc_dheap_t for a faster one that supports changing keys.
  */
 typedef struct sc_array
 {
@@ -109,6 +111,9 @@ typedef struct sc_array
                                            distinguishes an array of size 0
                                            from a view of size 0 */
   char               *array;    /**< linear array to store elements */
+  const sc_pages_policy_t *backing;     /**< memory policy, or the policy
+                                             member of a mapped file holding
+                                             the elements, or NULL */
 }
 sc_array_t;
 
@@ -162,6 +167,31 @@ sc_array_t         *sc_array_new_view (sc_array_t * array,
 sc_array_t         *sc_array_new_data (void *base,
                                        size_t elem_size, size_t elem_count);
 
+/** Creates a new array whose elements are stored in a memory-mapped file.
+ * The elements are accessed like those of any other array and may be larger
+ * than the main memory.  Views of the array are allowed.  When the array is
+ * resized, the file is extended or truncated and remapped.  Its capacity may
+ * exceed the elements until the array is reset or destroyed, which closes the
+ * file and cuts it to the exact size of the elements.  Thus, a file written
+ * by \ref sc_array_new_file can be opened again without copying the data.
+ * \param [in] filename     Name of the file.
+ * \param [in] elem_size    Size of one array element in bytes.
+ * \param [in] create       If true, create or truncate the file and start
+ *                          with zero elements.  Otherwise, the existing file
+ *                          is opened and its length must be a multiple of
+ *                          \a elem_size.
+ * \return                  A new array, or NULL if the file cannot be opened
+ *                          or mapped.
+ */
+sc_array_t         *sc_array_new_file (const char *filename,
+                                       size_t elem_size, int create);
+
+/** Write the elements of a file-backed array to the file and wait.
+ * \param [in] array        Array created by \ref sc_array_new_file.
+ * \return                  0 on success, -1 on error.
+ */
+int                 sc_array_flush (sc_array_t * array);
+
 /** Destroys an array structure.
  * \param [in] array    The array to be destroyed.
  */
@@ -275,6 +305,24 @@ void                sc_array_rewind (sc_array_t * array, size_t new_count);
  */
 void                sc_array_resize (sc_array_t * array, size_t new_count);
 
+/** Allocate the memory of an array according to a page policy.
+ * The current contents are moved into memory allocated by the policy.
+ * The policy remains in effect for all later allocations of the array,
+ * including those after \ref sc_array_reset, until the array is
+ * initialized anew.
+ * \param [in,out] array    Array that is not a view or backed by a file.
+ * \param [in] policy       Must remain valid as long as it is used.
+ *                          If NULL, the memory is allocated normally.
+ */
+void                sc_array_set_policy (sc_array_t * array,
+                                         const sc_pages_policy_t * policy);
+
+/** Return the number of bytes of an array that reside on huge pages.
+ * \param [in] array        Array that is not a view.
+ * \return                  See \ref sc_pages_huge_bytes.
+ */
+size_t              sc_array_huge_bytes (sc_array_t * array);
+
 /** Copy the contents of one array into another.
  * Both arrays must have equal element sizes.
  * The source array may be a view.
@@ -323,6 +371,51 @@ void                sc_array_sort (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Sorts the array in ascending order using multiple threads.
+ * The chunks of each thread are sorted by merging, and the sorted chunks
+ * are merged in parallel rounds.  The sort is stable, thus the result is
+ * the same for any number of threads.
+ * \param [in,out] array    The array to sort.
+ * \param [in] compar       The comparison function to be used.
+ *                          It must be safe to call from multiple threads.
+ * \param [in] num_threads  Number of threads; if not positive, we use
+ *                          \ref sc_thread_max_threads.
+ */
+void                sc_array_sort_threads (sc_array_t * array,
+                                           int (*compar) (const void *,
+                                                          const void *),
+                                           int num_threads);
+
+/** The types of integer keys understood by \ref sc_array_sort_radix. */
+typedef enum
+{
+  SC_ARRAY_KEY_INT32,   /**< int32_t, ordered as signed integer */
+  SC_ARRAY_KEY_UINT32,  /**< uint32_t */
+  SC_ARRAY_KEY_INT64,   /**< int64_t, ordered as signed integer */
+  SC_ARRAY_KEY_UINT64,  /**< uint64_t */
+  SC_ARRAY_KEY_UINT128, /**< sc_uint128_t */
+  SC_ARRAY_KEY_LAST     /**< Invalid entry to close list */
+}
+sc_array_key_t;
+
+/** Sorts the array in ascending order of an integer key in each element.
+ * The key is read at a fixed byte offset and does not need to be aligned.
+ * This radix sort makes no calls to a comparison function and takes time
+ * linear in the number of elements.
+ * \param [in,out] array    The array to sort.
+ * \param [in] key_type     The type of the key.
+ * \param [in] key_offset   Byte offset of the key in each element.
+ * \param [in] stable       If true, elements with equal keys keep their
+ *                          relative order.  We sort by the least
+ *                          significant digit first and need temporary
+ *                          memory of the size of the array.  Otherwise
+ *                          we sort by the most significant digit first
+ *                          in place.
+ */
+void                sc_array_sort_radix (sc_array_t * array,
+                                         sc_array_key_t key_type,
+                                         size_t key_offset, int stable);
+
 /** Check whether the array is sorted wrt. the comparison function.
  * \param [in] array    The array to check.
  * \param [in] compar   The comparison function to be used.
@@ -350,6 +443,19 @@ void                sc_array_uniq (sc_array_t * array,
                                    int (*compar) (const void *,
                                                   const void *));
 
+/** Remove duplicate entries from a sorted array using multiple threads.
+ * The result is the same as that of \ref sc_array_uniq.
+ * \param [in,out] array    The array size will be reduced as necessary.
+ * \param [in] compar       The comparison function to be used.
+ *                          It must be safe to call from multiple threads.
+ * \param [in] num_threads  Number of threads; if not positive, we use
+ *                          \ref sc_thread_max_threads.
+ */
+void                sc_array_uniq_threads (sc_array_t * array,
+                                           int (*compar) (const void *,
+                                                          const void *),
+                                           int num_threads);
+
 /** Performs a binary search on an array. The array must be sorted.
  * \param [in] array   A sorted array to search in.
  * \param [in] key     An element to be searched for.
@@ -389,6 +495,28 @@ void                sc_array_split (sc_array_t * array, sc_array_t * offsets,
                                     size_t num_types, sc_array_type_t type_fn,
                                     void *data);
 
+/** Group the objects of an array by type and compute the offsets of groups.
+ * Unlike \ref sc_array_split, the array does not need to be sorted by type.
+ * The objects are reordered by a stable counting sort on multiple threads.
+ * If the array is sorted by type, it is not changed and the offsets equal
+ * those computed by \ref sc_array_split.
+ * \param [in,out] array     Array that is not a view.  On output, it is
+ *                           sorted in ascending order by type.
+ * \param [in,out] offsets   As in \ref sc_array_split.
+ * \param [in] num_types     The number of possible types of objects.
+ * \param [in] type_fn       Returns the type of an object in the array.
+ *                           It is called twice for every object and must be
+ *                           safe to call from multiple threads.
+ * \param [in] data          Arbitrary user data passed to \a type_fn.
+ * \param [in] num_threads   Number of threads; if not positive, we use
+ *                           \ref sc_thread_max_threads.
+ */
+void                sc_array_split_threads (sc_array_t * array,
+                                            sc_array_t * offsets,
+                                            size_t num_types,
+                                            sc_array_type_t type_fn,
+                                            void *data, int num_threads);
+
 /** Determine whether \a array is an array of size_t's whose entries include
  * every integer 0 <= i < array->elem_count.
  * \param [in] array         An array.
@@ -398,6 +526,17 @@ void                sc_array_split (sc_array_t * array, sc_array_t * offsets,
  */
 int                 sc_array_is_permutation (sc_array_t * array);
 
+/** Determine in parallel whether \a array is a permutation.
+ * The values are bucketed by their range and every bucket is validated
+ * separately, which needs O(\a array->elem_count) temporary memory.
+ * \param [in] array         An array.
+ * \param [in] num_threads   Number of threads to use.  If this is less than
+ *                           or equal to zero, use sc_thread_max_threads.
+ * \return                   The same result as sc_array_is_permutation.
+ */
+int                 sc_array_is_permutation_threads (sc_array_t * array,
+                                                     int num_threads);
+
 /** Given permutation \a newindices, permute \a array in place.  The data that
  * on input is contained in \a array[i] will be contained in \a
  * array[newindices[i]] on output.  The entries of newindices will be altered
@@ -412,13 +551,55 @@ int                 sc_array_is_permutation (sc_array_t * array);
 void                sc_array_permute (sc_array_t * array,
                                       sc_array_t * newindices, int keepperm);
 
+/** Given permutation \a newindices, permute \a src into \a dest.
+ * The data that is contained in \a src[i] will be contained in \a
+ * dest[newindices[i]] on output.  Instead of writing to random locations of
+ * the whole array, the elements are first staged in buckets of destination
+ * blocks that fit into the cache, and every block is written in a second
+ * pass.  This uses O(\a src->elem_count) temporary memory; callers short
+ * on memory should use sc_array_permute.
+ * \param [in,out] dest       Array with the element size of \a src.
+ *                            It is resized to the count of \a src.
+ * \param [in] src            An array different from \a dest.
+ * \param [in] newindices     Permutation array (see sc_array_is_permutation).
+ * \param [in] num_threads    Number of threads to use.  If this is less than
+ *                            or equal to zero, use sc_thread_max_threads.
+ */
+void                sc_array_permute_copy (sc_array_t * dest,
+                                           sc_array_t * src,
+                                           sc_array_t * newindices,
+                                           int num_threads);
+
 /** Computes the adler32 checksum of array data (see zlib documentation).
  * This is a faster checksum than crc32, and it works with zeros as data.
  */
 unsigned int        sc_array_checksum (sc_array_t * array);
 
+/** Computes the CRC32C checksum of array data (see \ref sc_crc32c).
+ * The array is split into blocks that are processed by multiple threads.
+ * This does not require zlib.
+ * \param [in] array        Array of any element size.
+ * \param [in] num_threads  Number of threads to use.  If this is less than
+ *                          or equal to zero, use sc_thread_max_threads.
+ * \return                  The checksum of the array's bytes.
+ */
+uint32_t            sc_array_checksum_crc32c (sc_array_t * array,
+                                              int num_threads);
+
+/** Computes the CRC32C checksum of an array distributed over processes.
+ * This function is collective.  The result equals the checksum of the
+ * concatenation of all local arrays in the order of the ranks.
+ * \param [in] array        Local array of any element size.
+ * \param [in] mpicomm      The array is distributed over this communicator.
+ * \param [in] num_threads  Number of threads to use on each process, see
+ *                          \ref sc_array_checksum_crc32c.
+ * \return                  The global checksum on all processes.
+ */
+uint32_t            sc_array_checksum_crc32c_global (sc_array_t * array,
+                                                     sc_MPI_Comm mpicomm,
+                                                     int num_threads);
+
 /** Adds an element to a priority queue.
- * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
  * The priority queue is implemented as a heap in ascending order.
  * A heap is a binary tree where the children are not less than their parent.
@@ -436,7 +617,6 @@ size_t              sc_array_pqueue_add (sc_array_t * array,
                                                         const void *));
 
 /** Pops the smallest element from a priority queue.
- * PQUEUE FUNCTIONS ARE UNTESTED AND CURRENTLY DISABLED.
  * This function is not allowed for views.
  * This function assumes that the array forms a valid heap in ascending order.
  * \param [out] result  Pointer to unused allocated memory of elem_size.
@@ -595,6 +775,121 @@ sc_array_push (sc_array_t * array)
   return sc_array_push_count (array, 1);
 }
 
+/** The default number of children of a node in \ref sc_dheap_t. */
+#define SC_DHEAP_ARITY 4
+
+/** The sc_dheap object provides a d-ary heap of equal-size elements.
+ * The smallest element with respect to the comparison function is on top.
+ * A wider tree than the binary one is shallower and keeps the children of a
+ * node in fewer cache lines, which makes sifting down faster.
+ * Every element is identified by a handle that stays valid while it is in
+ * the heap, such that its key can be changed, for example decreased, later.
+ * Handles are reused after their element has been popped.
+ */
+typedef struct sc_dheap
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of a single element */
+  size_t              arity;            /**< number of children per node */
+  int                 (*compar) (const void *, const void *);
+
+  /* implementation variables */
+  sc_array_t          elems;            /**< elements in heap order */
+  sc_array_t          handles;          /**< handles in heap order */
+  sc_array_t          positions;        /**< heap position of each handle */
+  sc_array_t          unused;           /**< handles available for reuse */
+  char               *temp;             /**< storage for one element */
+}
+sc_dheap_t;
+
+/** Creates a new empty d-ary heap.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] arity        Number of children per node, at least 2.
+ *                          If this is zero, use \ref SC_DHEAP_ARITY.
+ * \param [in] compar       The comparison function to be used.
+ * \return                  A new heap.
+ */
+sc_dheap_t         *sc_dheap_new (size_t elem_size, size_t arity,
+                                  int (*compar) (const void *,
+                                                 const void *));
+
+/** Creates a new heap from the elements of an array in O(n) time.
+ * The handle of every element is its index in the array.
+ * \param [in] array        The elements are copied, the array is unchanged.
+ * \param [in] arity        Number of children per node, or zero.
+ * \param [in] compar       The comparison function to be used.
+ * \return                  A new heap.
+ */
+sc_dheap_t         *sc_dheap_new_array (sc_array_t * array, size_t arity,
+                                        int (*compar) (const void *,
+                                                       const void *));
+
+/** Destroys a heap and all of its elements.
+ * \param [in] heap         The heap is invalid after this call.
+ */
+void                sc_dheap_destroy (sc_dheap_t * heap);
+
+/** Returns the number of elements in a heap. */
+/*@unused@*/
+static inline size_t
+sc_dheap_count (sc_dheap_t * heap)
+{
+  return heap->elems.elem_count;
+}
+
+/** Adds an element to a heap in O(log_d n) time.
+ * \param [in] elem         The element is copied.
+ * \return                  The handle of the element.
+ */
+size_t              sc_dheap_push (sc_dheap_t * heap, const void *elem);
+
+/** Returns the smallest element of a heap.
+ * \param [in] heap         A heap that must not be empty.
+ * \param [out] handle      If not NULL, the handle of the element.
+ * \return                  Pointer to the element, which may be read until
+ *                          the heap is modified.
+ */
+void               *sc_dheap_top (sc_dheap_t * heap, size_t *handle);
+
+/** Removes the smallest element from a heap in O(d log_d n) time.
+ * \param [in] heap         A heap that must not be empty.
+ * \param [out] elem        If not NULL, the element is copied here.
+ * \return                  The handle of the element, which is reused by
+ *                          later calls to \ref sc_dheap_push.
+ */
+size_t              sc_dheap_pop (sc_dheap_t * heap, void *elem);
+
+/** Removes the smallest \a k elements from a heap.
+ * If \a k is at least the number of elements, all of them are sorted at
+ * once.  Otherwise, the elements are popped one by one.
+ * \param [in] heap         A heap.
+ * \param [in] k            Maximum number of elements to remove.
+ * \param [in,out] out      Array of the heap's element size.  The removed
+ *                          elements are appended in ascending order.
+ * \return                  The number of elements removed.
+ */
+size_t              sc_dheap_pop_n (sc_dheap_t * heap, size_t k,
+                                    sc_array_t * out);
+
+/** Determine whether a handle belongs to an element of a heap. */
+int                 sc_dheap_contains (sc_dheap_t * heap, size_t handle);
+
+/** Returns the element of a handle.
+ * \param [in] handle       The handle of an element in the heap.
+ * \return                  Pointer to the element, which must not be
+ *                          modified directly; use \ref sc_dheap_update.
+ */
+void               *sc_dheap_lookup (sc_dheap_t * heap, size_t handle);
+
+/** Replaces the element of a handle and restores the heap order.
+ * Decreasing the key of an element takes O(log_d n) time, increasing it
+ * O(d log_d n).
+ * \param [in] handle       The handle of an element in the heap.
+ * \param [in] elem         The new element is copied.
+ */
+void                sc_dheap_update (sc_dheap_t * heap, size_t handle,
+                                     const void *elem);
+
 /** A data container to create memory items of the same size.
  * Allocations are bundled so it's fast for small memory sizes.
  * The items created will remain valid until the container is destroyed.
@@ -604,11 +899,13 @@ sc_array_push (sc_array_t * array)
 typedef struct sc_mstamp
 {
   size_t              elem_size;   /**< Input parameter: size per item */
+  size_t              stamp_unit;  /**< Input parameter: size of a stamp */
   size_t              per_stamp;   /**< Number of items per stamp */
   size_t              stamp_size;  /**< Bytes allocated in a stamp */
   size_t              cur_snext;   /**< Next number within a stamp */
   char               *current;     /**< Memory of current stamp */
   sc_array_t          remember;    /**< Collects all stamps */
+  const sc_pages_policy_t *policy; /**< Memory policy of the stamps */
 }
 sc_mstamp_t;
 
@@ -665,6 +962,71 @@ void               *sc_mstamp_alloc (sc_mstamp_t * mst);
  */
 size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
 
+/** Allocate the stamps according to a page policy.
+ * The stamps are enlarged to hold whole items of at least the policy's
+ * allocation unit and its min_bytes if necessary, such that they are
+ * mapped.  When the policy is reset to NULL, the stamps shrink back to
+ * the size they had after \ref sc_mstamp_init.
+ * This function must be called before any item is allocated.
+ * \param [in,out] mst          Properly initialized stamp container.
+ * \param [in] policy           Must remain valid as long as it is used.
+ *                              If NULL, the stamps are allocated normally.
+ */
+void                sc_mstamp_set_policy (sc_mstamp_t * mst,
+                                          const sc_pages_policy_t * policy);
+
+/** Return the number of bytes of all stamps that reside on huge pages.
+ * \param [in]                  Properly initialized stamp container.
+ * \return                      See \ref sc_pages_huge_bytes.
+ */
+size_t              sc_mstamp_huge_bytes (sc_mstamp_t * mst);
+
+/** Return a contiguous run of new items from the current stamp.
+ * The run ends at the end of the current stamp, thus it may be shorter
+ * than requested.  Call this function repeatedly to obtain more items.
+ * \param [in,out]              Properly initialized stamp container.
+ * \param [in] n                Maximum number of items requested.
+ * \param [out] num             On output, the number of items in the run.
+ *                              It is positive if n and elem_size are.
+ * \return                      Pointer to the first item of the run,
+ *                              the items being elem_size bytes apart.
+ */
+void               *sc_mstamp_alloc_n (sc_mstamp_t * mst, size_t n,
+                                       size_t *num);
+
+/** Function to notify the owner of an item that it has been moved.
+ * When called, the contents of the item have already been copied.
+ * \param [in] from         Previous address of the item, now invalid.
+ * \param [in] to           New address of the item.
+ * \param [in] user_data    Pointer passed through the compaction call.
+ */
+typedef void        (*sc_mstamp_relocate_t) (void *from, void *to,
+                                             void *user_data);
+
+/** Release the stamps that no longer hold any live item.
+ * The caller passes the items that have been returned and may be reused.
+ * Each stamp except the current one whose items are all free is freed.
+ * If a relocation callback is given, the live items of the least occupied
+ * stamps are first moved into free items of the other stamps,
+ * such that as many stamps as possible can be released.
+ * Without a page policy, see \ref sc_mstamp_set_policy, the stamps are
+ * freed to the heap of the C library, which usually keeps them for reuse
+ * rather than returning them to the operating system.  Pages are only
+ * unmapped if a policy is set whose min_bytes is at most the stamp size.
+ * \param [in,out] mst          Properly initialized stamp container.
+ * \param [in,out] free_items   Array of pointers to the free items.
+ *                              On output, contains the remaining free
+ *                              items in unspecified order.
+ * \param [in] relocate         If NULL, no items are moved.  Otherwise
+ *                              called for every item that is moved.
+ * \param [in] user_data        Passed through to the callback.
+ * \return                      Number of bytes of the stamps freed.
+ */
+size_t              sc_mstamp_compact (sc_mstamp_t * mst,
+                                       sc_array_t * free_items,
+                                       sc_mstamp_relocate_t relocate,
+                                       void *user_data);
+
 /** The sc_mempool object provides a large pool of equal-size elements.
  * The pool grows dynamically for element allocation.
  * Elements are referenced by their address which never changes.
@@ -673,6 +1035,8 @@ size_t              sc_mstamp_memory_used (sc_mstamp_t * mst);
  * If the zero_and_persist option is selected, new elements are initialized to
  * all zeros on creation, and the contents of an element are not touched
  * between freeing and re-returning it.
+ * If the intrusive option is selected, the freed elements are linked through
+ * their own memory instead of being remembered in a separate array.
  */
 typedef struct sc_mempool
 {
@@ -680,6 +1044,7 @@ typedef struct sc_mempool
   size_t              elem_size;        /**< size of a single element */
   size_t              elem_count;       /**< number of valid elements */
   int                 zero_and_persist; /**< Boolean; is set in constructor. */
+  int                 intrusive;        /**< Boolean; is set in constructor. */
 
   /* implementation variables */
 #ifdef SC_MEMPOOL_MSTAMP
@@ -688,6 +1053,8 @@ typedef struct sc_mempool
   struct obstack      obstack;  /**< holds the allocated elements */
 #endif
   sc_array_t          freed;    /**< buffers the freed elements */
+  void               *freelist; /**< freed elements in intrusive mode */
+  struct sc_mempool_depot *depot;       /**< thread caches, may be NULL */
 }
 sc_mempool_t;
 
@@ -712,6 +1079,32 @@ sc_mempool_t       *sc_mempool_new (size_t elem_size);
  */
 sc_mempool_t       *sc_mempool_new_zero_and_persist (size_t elem_size);
 
+/** Creates a new mempool structure with the intrusive option on.
+ * The freed elements are kept in a list threaded through the elements.
+ * This saves the memory and the reallocations of a separate array.
+ * If the element size is less than the size of a pointer,
+ * the option is ignored.  The zero_and_persist option is off.
+ * \param [in] elem_size  Size of one element in bytes.
+ * \return Returns an allocated and initialized memory pool.
+ */
+sc_mempool_t       *sc_mempool_new_intrusive (size_t elem_size);
+
+/** Creates a new mempool structure that is usable by multiple threads.
+ * Each thread owns a cache of elements that is accessed without locking by
+ * \ref sc_mempool_alloc_thread and \ref sc_mempool_free_thread.
+ * The caches exchange magazines of elements with a shared depot.
+ * The depot is locked only when a cache runs empty or full.
+ * The functions \ref sc_mempool_alloc and \ref sc_mempool_free remain
+ * legal, but must not run concurrently with any other pool operation.
+ * The zero_and_persist option is off.
+ * \param [in] elem_size    Size of one element in bytes.
+ * \param [in] num_threads  Number of threads using the pool, at least 1.
+ *                          Thread ids range from 0 to num_threads - 1.
+ * \return                  Returns an allocated and initialized memory pool.
+ */
+sc_mempool_t       *sc_mempool_new_threads (size_t elem_size,
+                                            int num_threads);
+
 /** Same as sc_mempool_new, but for an already allocated sc_mempool_t pointer. */
 void                sc_mempool_init (sc_mempool_t * mempool,
                                      size_t elem_size);
@@ -736,6 +1129,42 @@ void                sc_mempool_reset (sc_mempool_t * mempool);
  */
 void                sc_mempool_truncate (sc_mempool_t * mempool);
 
+/** Allocate the memory of a pool according to a page policy.
+ * This function must be called while no element is allocated.
+ * Elements allocated and freed earlier are discarded from the pool.
+ * \param [in,out] mempool  The memory pool.
+ * \param [in] policy       Must remain valid as long as it is used.
+ *                          If NULL, the memory is allocated normally.
+ */
+void                sc_mempool_set_policy (sc_mempool_t * mempool,
+                                           const sc_pages_policy_t * policy);
+
+/** Return the number of bytes of a pool that reside on huge pages.
+ * \param [in] mempool      The memory pool.
+ * \return                  See \ref sc_pages_huge_bytes.
+ */
+size_t              sc_mempool_huge_bytes (sc_mempool_t * mempool);
+
+/** Return memory of elements no longer used to the system.
+ * The memory of all stamps without valid elements is freed.
+ * The operating system gets the memory back only with a page policy,
+ * see \ref sc_mempool_set_policy and \ref sc_mstamp_compact;
+ * otherwise it stays with the C library for reuse.
+ * If a relocation callback is given, valid elements are moved out of the
+ * least occupied stamps first, such that fewer stamps remain in use.
+ * The callback must update all references to a moved element.
+ * The elements cached by the threads of \ref sc_mempool_new_threads are
+ * returned to the pool first; the function must not run concurrently with
+ * any other operation on the pool.
+ * \param [in,out] mempool  The memory pool.
+ * \param [in] relocate     If NULL, no elements are moved.
+ * \param [in] user_data    Passed through to the callback.
+ * \return                  Number of bytes of the stamps freed.
+ */
+size_t              sc_mempool_compact (sc_mempool_t * mempool,
+                                        sc_mstamp_relocate_t relocate,
+                                        void *user_data);
+
 /** Allocate a single element.
  * Elements previously returned to the pool are recycled.
  * \return Returns a new or recycled element pointer.
@@ -749,7 +1178,11 @@ sc_mempool_alloc (sc_mempool_t * mempool)
 
   ++mempool->elem_count;
 
-  if (freed->elem_count > 0) {
+  if (mempool->freelist != NULL) {
+    ret = mempool->freelist;
+    memcpy (&mempool->freelist, ret, sizeof (void *));
+  }
+  else if (freed->elem_count > 0) {
     ret = *(void **) sc_array_pop (freed);
   }
   else {
@@ -791,9 +1224,68 @@ sc_mempool_free (sc_mempool_t * mempool, void *elem)
 
   --mempool->elem_count;
 
-  *(void **) sc_array_push (freed) = elem;
+  if (mempool->intrusive) {
+    memcpy (elem, &mempool->freelist, sizeof (void *));
+    mempool->freelist = elem;
+  }
+  else {
+    *(void **) sc_array_push (freed) = elem;
+  }
 }
 
+/** Allocate multiple elements at once.
+ * Elements previously returned to the pool are recycled first.
+ * New elements are taken in contiguous runs from the current stamp.
+ * \param [in,out] mempool  The memory pool.
+ * \param [in] n            Number of elements to allocate.
+ * \param [out] elems       Array of n pointers, filled with the elements.
+ */
+void                sc_mempool_alloc_n (sc_mempool_t * mempool, size_t n,
+                                        void **elems);
+
+/** Return multiple previously allocated elements to the pool.
+ * \param [in,out] mempool  The memory pool.
+ * \param [in] n            Number of elements to free.
+ * \param [in] elems        Array of n element pointers.
+ */
+void                sc_mempool_free_n (sc_mempool_t * mempool, size_t n,
+                                       void **elems);
+
+/** Allocate a single element from the cache of one thread.
+ * This function may be called concurrently with distinct thread ids.
+ * The element counter of the pool is not updated;
+ * each thread counts its allocations separately.
+ * \param [in,out] mempool  Memory pool created by \ref sc_mempool_new_threads.
+ * \param [in] thread_id    Id of the calling thread.
+ * \return                  Returns a new or recycled element pointer.
+ */
+void               *sc_mempool_alloc_thread (sc_mempool_t * mempool,
+                                             int thread_id);
+
+/** Return an element to the cache of one thread.
+ * The element may have been allocated by any thread.
+ * \param [in,out] mempool  Memory pool created by \ref sc_mempool_new_threads.
+ * \param [in] thread_id    Id of the calling thread.
+ * \param [in] elem         The element to be returned to the pool.
+ */
+void                sc_mempool_free_thread (sc_mempool_t * mempool,
+                                            int thread_id, void *elem);
+
+/** Return the number of valid elements summed over all threads.
+ * \param [in] mempool      The memory pool.
+ * \return                  The element count plus the thread counts, if any.
+ */
+size_t              sc_mempool_count_threads (sc_mempool_t * mempool);
+
+/** Log the usage of a memory pool, including per-thread cache statistics.
+ * \param [in] package_id   Registered package id or -1.
+ * \param [in] log_priority Priority of the log messages.
+ * \param [in] mempool      The memory pool.
+ */
+void                sc_mempool_print_statistics (int package_id,
+                                                 int log_priority,
+                                                 sc_mempool_t * mempool);
+
 /** The sc_link structure is one link of a linked list.
  */
 typedef struct sc_link
@@ -897,8 +1389,145 @@ void               *sc_list_remove (sc_list_t * list, sc_link_t * pred);
  */
 void               *sc_list_pop (sc_list_t * list);
 
+/** The sc_deque object provides a double-ended queue of fixed-size elements.
+ * The elements are stored in contiguous chunks of a power-of-two size
+ * that are referenced by a circular map, such that pushing and popping at
+ * both ends is amortized O(1) and access by position is O(1).
+ * Chunks are kept when the queue shrinks and reused when it grows again.
+ * Element pointers stay valid across pops of other elements and across
+ * pushes that find the queue below its capacity.  A push into a full
+ * queue grows it and may move up to one chunk of elements, so it
+ * invalidates all element pointers.  A pointer returned by a pop is
+ * only valid until the next push.
+ */
+typedef struct sc_deque
+{
+  /* interface variables */
+  size_t              elem_size;        /**< size of a single element */
+  size_t              elem_count;       /**< number of valid elements */
+
+  /* implementation variables */
+  int                 chunk_shift;      /**< log2 of elements per chunk */
+  size_t              head;     /**< position of the first element */
+  size_t              map_size; /**< number of chunk slots in the map */
+  size_t              chunk_count;      /**< number of allocated chunks */
+  char              **map;      /**< circular map of chunk pointers */
+}
+sc_deque_t;
+
+/** Calculate the memory used by a deque.
+ * \param [in] deque       The deque.
+ * \param [in] is_dynamic  True if created with sc_deque_new,
+ *                         false if initialized with sc_deque_init
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_deque_memory_used (sc_deque_t * deque,
+                                          int is_dynamic);
+
+/** Allocate a new, empty deque.
+ * \param [in] elem_size   Size of one element in bytes.
+ * \return                 Pointer to a newly allocated, empty deque.
+ */
+sc_deque_t         *sc_deque_new (size_t elem_size);
+
+/** Destroy a deque and free all its memory.
+ * \param [in,out] deque   Deque created by sc_deque_new.
+ */
+void                sc_deque_destroy (sc_deque_t * deque);
+
+/** Initialize an empty deque.  No memory is allocated.
+ * \param [out] deque      Deque structure to be initialized.
+ * \param [in] elem_size   Size of one element in bytes.
+ */
+void                sc_deque_init (sc_deque_t * deque, size_t elem_size);
+
+/** Remove all elements and free the memory of a deque.
+ * \param [in,out] deque   The deque is empty and can be reused afterwards.
+ * \note Calling sc_deque_init, then any deque operations,
+ *       then sc_deque_reset is memory neutral.
+ */
+void                sc_deque_reset (sc_deque_t * deque);
+
+/** Remove all elements from a deque but keep its memory for reuse.
+ * \param [in,out] deque   The deque is empty afterwards.
+ */
+void                sc_deque_truncate (sc_deque_t * deque);
+
+/** Add an element to the end of a deque.
+ * If the deque is full, it grows and all element pointers are invalidated.
+ * \param [in,out] deque   The deque.
+ * \return                 Pointer to the uninitialized new element.
+ */
+void               *sc_deque_push_back (sc_deque_t * deque);
+
+/** Add an element to the front of a deque.
+ * If the deque is full, it grows and all element pointers are invalidated.
+ * \param [in,out] deque   The deque.
+ * \return                 Pointer to the uninitialized new element.
+ */
+void               *sc_deque_push_front (sc_deque_t * deque);
+
+/** Remove the last element of a deque.
+ * \param [in,out] deque   A deque with at least one element.
+ * \return                 Pointer to the removed element,
+ *                         valid until the next push.
+ */
+void               *sc_deque_pop_back (sc_deque_t * deque);
+
+/** Remove the first element of a deque.
+ * \param [in,out] deque   A deque with at least one element.
+ * \return                 Pointer to the removed element,
+ *                         valid until the next push.
+ */
+void               *sc_deque_pop_front (sc_deque_t * deque);
+
+/** Return a pointer to a deque element and its contiguous successors.
+ * Iterating with this function over chunks is faster than by index.
+ * \param [in] deque       The deque.
+ * \param [in] iz          Index in [0, elem_count).
+ * \param [out] count      If not NULL, set to the number of elements
+ *                         stored contiguously from index \a iz on.
+ * \return                 Pointer to the element at index \a iz.
+ */
+void               *sc_deque_chunk (sc_deque_t * deque, size_t iz,
+                                    size_t *count);
+
+/** Returns a pointer to a deque element.
+ * \param [in] deque       Valid deque.
+ * \param [in] iz          Needs to be in [0]..[elem_count-1].
+ * \return                 Pointer to the indexed element.
+ */
+/*@unused@*/
+static inline void *
+sc_deque_index (sc_deque_t * deque, size_t iz)
+{
+  size_t              pos;
+
+  SC_ASSERT (iz < deque->elem_count);
+
+  pos = (deque->head + iz) &
+    ((deque->map_size << deque->chunk_shift) - 1);
+  return (void *) (deque->map[pos >> deque->chunk_shift] +
+                   deque->elem_size *
+                   (pos & (((size_t) 1 << deque->chunk_shift) - 1)));
+}
+
+/** The sc_hash_link is a list link that caches the hash value of its object.
+ * The hash value is used to skip mismatches and to move the link on resize.
+ */
+typedef struct sc_hash_link
+{
+  void               *data;
+  struct sc_hash_link *next;
+  unsigned int        hval;
+}
+sc_hash_link_t;
+
 /** The sc_hash implements a hash table.
- * It uses an array which has linked lists as elements.
+ * It uses an array which has singly linked chains as elements.
+ * A resize allocates a new slot array and moves the chains of a few old slots
+ * on every subsequent insertion and removal, such that its cost is amortized.
+ * Lookups do not modify the table.
  */
 typedef struct sc_hash
 {
@@ -907,12 +1536,17 @@ typedef struct sc_hash
 
   /* implementation variables */
   sc_array_t         *slots;    /**< the slot count is slots->elem_count */
+  sc_array_t         *old_slots;        /**< slots being migrated or NULL */
+  size_t              migrate_next;     /**< first old slot not migrated */
   void               *user_data;        /**< user data passed to hash function */
   sc_hash_function_t  hash_fn;
   sc_equal_function_t equal_fn;
   size_t              resize_checks, resize_actions;
+  size_t              chain_max;        /**< longest chain seen on insertion */
   int                 allocator_owned;
-  sc_mempool_t       *allocator;        /**< must allocate sc_link_t */
+  int                 cache_hval;       /**< links are sc_hash_link_t */
+  sc_mempool_t       *allocator;        /**< allocates sc_hash_link_t
+                                             or sc_link_t */
 }
 sc_hash_t;
 
@@ -924,6 +1558,144 @@ sc_hash_t;
  */
 unsigned int        sc_hash_function_string (const void *s, const void *u);
 
+/* Constants for the 64-bit hash functions below. */
+#define SC_HASH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define SC_HASH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define SC_HASH_PRIME64_3 0x165667B19E3779F9ULL
+#define sc_hash_rot64(x,k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+/** Scramble the bits of a 64-bit integer such that every input bit
+ * affects every output bit (the finalizer of MurmurHash3).
+ * \param [in] h        The value to scramble.
+ * \return              The scrambled value.
+ */
+static inline uint64_t
+sc_hash_mix64 (uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/** Accumulate one 64-bit word into a running hash state. */
+static inline uint64_t
+sc_hash_round64 (uint64_t h, uint64_t w)
+{
+  h += w * SC_HASH_PRIME64_2;
+  h = sc_hash_rot64 (h, 31);
+  return h * SC_HASH_PRIME64_1;
+}
+
+/** Load a 64-bit word from a possibly unaligned address. */
+static inline uint64_t
+sc_hash_load64 (const void *p)
+{
+  uint64_t            w;
+
+  memcpy (&w, p, sizeof (uint64_t));
+  return w;
+}
+
+/** Fold a 64-bit hash value into the unsigned int of \ref sc_hash_function_t.
+ */
+static inline unsigned int
+sc_hash_fold64 (uint64_t h)
+{
+  return (unsigned int) (h ^ (h >> 32));
+}
+
+/** Compute a 64-bit hash value of an arbitrary byte sequence.
+ * The data is consumed one 64-bit word at a time.  The result depends on
+ * the byte order of the machine and should not be stored persistently.
+ * This hash function is NOT cryptographically safe!
+ * \param [in] data     Pointer to the bytes, alignment is not required.
+ * \param [in] length   Number of bytes to hash.
+ * \param [in] seed     Arbitrary value to select a member of the family.
+ * \return              The computed 64-bit hash value.
+ */
+uint64_t            sc_hash_bytes (const void *data, size_t length,
+                                   uint64_t seed);
+
+/** Compute a 64-bit hash value of an 8-byte key, such as an int64_t.
+ * The result equals \ref sc_hash_bytes with length 8 and seed 0.
+ */
+static inline uint64_t
+sc_hash_bytes8 (const void *data)
+{
+  return sc_hash_mix64 (sc_hash_round64 (SC_HASH_PRIME64_3 + 8,
+                                         sc_hash_load64 (data)));
+}
+
+/** Compute a 64-bit hash value of a 16-byte key, such as two int64_t.
+ * The result equals \ref sc_hash_bytes with length 16 and seed 0.
+ */
+static inline uint64_t
+sc_hash_bytes16 (const void *data)
+{
+  const char         *p = (const char *) data;
+  uint64_t            h = SC_HASH_PRIME64_3 + 16;
+
+  h = sc_hash_round64 (h, sc_hash_load64 (p));
+  h = sc_hash_round64 (h, sc_hash_load64 (p + 8));
+  return sc_hash_mix64 (h);
+}
+
+/** Compute a 64-bit hash value of a 24-byte key, such as three int64_t.
+ * The result equals \ref sc_hash_bytes with length 24 and seed 0.
+ */
+static inline uint64_t
+sc_hash_bytes24 (const void *data)
+{
+  const char         *p = (const char *) data;
+  uint64_t            h = SC_HASH_PRIME64_3 + 24;
+
+  h = sc_hash_round64 (h, sc_hash_load64 (p));
+  h = sc_hash_round64 (h, sc_hash_load64 (p + 8));
+  h = sc_hash_round64 (h, sc_hash_load64 (p + 16));
+  return sc_hash_mix64 (h);
+}
+
+/** Compute a hash value from a null-terminated string.
+ * The string is consumed one 64-bit word at a time by \ref sc_hash_bytes,
+ * which is considerably faster than \ref sc_hash_function_string.
+ * This hash function is NOT cryptographically safe! Use libcrypt then.
+ * \param [in] s        Null-terminated string to be hashed.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_string64 (const void *s, const void *u);
+
+/** Compute a hash value from an 8-byte key by \ref sc_hash_bytes8.
+ * \param [in] v        Pointer to the key, alignment is not required.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_bytes8 (const void *v, const void *u);
+
+/** Compute a hash value from a 16-byte key by \ref sc_hash_bytes16.
+ * \param [in] v        Pointer to the key, alignment is not required.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_bytes16 (const void *v, const void *u);
+
+/** Compute a hash value from a 24-byte key by \ref sc_hash_bytes24.
+ * \param [in] v        Pointer to the key, alignment is not required.
+ * \param [in] u        Not used.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_bytes24 (const void *v, const void *u);
+
+/** Compute a hash value from a key of arbitrary fixed size.
+ * \param [in] v        Pointer to the key, alignment is not required.
+ * \param [in] u        Pointer to a size_t holding the key size in bytes.
+ * \return              The computed hash value as an unsigned integer.
+ */
+unsigned int        sc_hash_function_bytes (const void *v, const void *u);
+
 /** Calculate the memory used by a hash table.
  * \param [in] hash        The hash table.
  * \return                 Memory used in bytes.
@@ -935,7 +1707,10 @@ size_t              sc_hash_memory_used (sc_hash_t * hash);
  * \param [in] hash_fn     Function to compute the hash value.
  * \param [in] equal_fn    Function to test two objects for equality.
  * \param [in] user_data   User data passed through to the hash function.
- * \param [in] allocator   Memory allocator for sc_link_t, can be NULL.
+ * \param [in] allocator   Memory allocator for sc_link_t or for
+ *                         sc_hash_link_t, can be NULL.  The hash values
+ *                         are only cached in links of sc_hash_link_t,
+ *                         which saves calls to hash_fn when resizing.
  */
 sc_hash_t          *sc_hash_new (sc_hash_function_t hash_fn,
                                  sc_equal_function_t equal_fn,
@@ -958,7 +1733,7 @@ void                sc_hash_destroy_null (sc_hash_t ** phash);
 /** Remove all entries from a hash table in O(N).
  *
  * If the allocator is owned, it calls sc_hash_unlink and sc_mempool_truncate.
- * Otherwise, it calls sc_list_reset on every hash slot which is slower.
+ * Otherwise, it returns every link to the allocator which is slower.
  */
 void                sc_hash_truncate (sc_hash_t * hash);
 
@@ -981,7 +1756,9 @@ void                sc_hash_unlink_destroy (sc_hash_t * hash);
  * \param [out] found  If found != NULL, *found is set to the address of the
  *                     pointer to the already contained object if the object
  *                     is found.  You can assign to **found to override.
+ *                     The address is valid until the object is removed.
  * \return Returns true if object is found, false otherwise.
+ * Lookups do not modify the table and may run concurrently with each other.
  */
 int                 sc_hash_lookup (sc_hash_t * hash, void *v, void ***found);
 
@@ -990,6 +1767,7 @@ int                 sc_hash_lookup (sc_hash_t * hash, void *v, void ***found);
  * \param [out] found  If found != NULL, *found is set to the address of the
  *                     pointer to the already contained, or if not present,
  *                     the new object.  You can assign to **found to override.
+ *                     The address is valid until the object is removed.
  * \return Returns true if object is added, false if it is already contained.
  */
 int                 sc_hash_insert_unique (sc_hash_t * hash, void *v,
@@ -1009,11 +1787,172 @@ int                 sc_hash_remove (sc_hash_t * hash, void *v, void **found);
 void                sc_hash_foreach (sc_hash_t * hash, sc_hash_foreach_t fn);
 
 /** Compute and print statistical information about the occupancy.
+ * This includes the longest chain and the progress of a pending resize.
  */
 void                sc_hash_print_statistics (int package_id,
                                               int log_priority,
                                               sc_hash_t * hash);
 
+/** The sc_hash_open implements a hash table with open addressing.
+ * All objects are stored in one contiguous array of slots whose count is a
+ * power of two.  Collisions are resolved by linear probing with Robin Hood
+ * displacement, which bounds the variance of the probe lengths.  Each slot
+ * caches the full hash value of its object, such that most mismatching
+ * probes are rejected without calling the equality function.
+ * It uses the same callbacks as \ref sc_hash_t and can replace it wherever
+ * no shared link allocator is required.
+ */
+typedef struct sc_hash_open
+{
+  /* interface variables */
+  size_t              elem_count;       /**< total number of objects contained */
+
+  /* implementation variables */
+  sc_array_t         *slots;    /**< the slot count is a power of two */
+  int                 slot_bits;        /**< binary logarithm of slot count */
+  void               *user_data;        /**< user data passed to hash function */
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  size_t              resize_checks, resize_actions;
+}
+sc_hash_open_t;
+
+/** Calculate the memory used by an open addressing hash table.
+ * \param [in] hash        The hash table.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_hash_open_memory_used (sc_hash_open_t * hash);
+
+/** Create a new open addressing hash table.
+ * The number of hash slots is chosen dynamically.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ * \param [in] user_data   User data passed through to the hash function.
+ */
+sc_hash_open_t     *sc_hash_open_new (sc_hash_function_t hash_fn,
+                                      sc_equal_function_t equal_fn,
+                                      void *user_data);
+
+/** Destroy an open addressing hash table in O(1).
+ * The objects referenced by the table are not touched.
+ */
+void                sc_hash_open_destroy (sc_hash_open_t * hash);
+
+/** Destroy an open addressing hash table and set its pointer to NULL.
+ * Destruction is done using \ref sc_hash_open_destroy.
+ * \param [in,out] phash        Address of pointer to hash table.
+ *                              On output, pointer is NULLed.
+ */
+void                sc_hash_open_destroy_null (sc_hash_open_t ** phash);
+
+/** Remove all entries from an open addressing hash table.
+ * The slot array keeps its current size.
+ */
+void                sc_hash_open_truncate (sc_hash_open_t * hash);
+
+/** Check if an object is contained in the hash table.
+ * \param [in]  v      The object to be looked up.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     pointer to the already contained object if the object
+ *                     is found.  You can assign to **found to override.
+ *                     The address is valid until the next insertion or
+ *                     removal, which may move objects between slots.
+ * \return Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_open_lookup (sc_hash_open_t * hash, void *v,
+                                         void ***found);
+
+/** Insert an object into a hash table if it is not contained already.
+ * \param [in]  v      The object to be inserted.
+ * \param [out] found  If found != NULL, *found is set to the address of the
+ *                     pointer to the already contained, or if not present,
+ *                     the new object.  You can assign to **found to override.
+ *                     The address is valid until the next insertion or
+ *                     removal, which may move objects between slots.
+ * \return Returns true if object is added, false if it is already contained.
+ */
+int                 sc_hash_open_insert_unique (sc_hash_open_t * hash,
+                                                void *v, void ***found);
+
+/** Remove an object from a hash table.
+ * \param [in]  v      The object to be removed.
+ * \param [out] found  If found != NULL, *found is set to the object
+                       that is removed if that exists.
+ * \return Returns true if object is found, false if is not contained.
+ */
+int                 sc_hash_open_remove (sc_hash_open_t * hash, void *v,
+                                         void **found);
+
+/** Invoke a callback for every member of the hash table.
+ * The functions hash_fn and equal_fn are not called by this function.
+ */
+void                sc_hash_open_foreach (sc_hash_open_t * hash,
+                                          sc_hash_foreach_t fn);
+
+/** Compute and print statistical information about the probe lengths.
+ */
+void                sc_hash_open_print_statistics (int package_id,
+                                                   int log_priority,
+                                                   sc_hash_open_t * hash);
+
+/** The sc_hash_frozen is an immutable index built from a populated hash table.
+ * It stores the objects in a minimal perfect hash: every distinct hash value
+ * owns exactly one slot, which is found with one displacement (pilot) lookup
+ * and one slot probe.  Objects whose hash value repeats that of another one
+ * are kept in a small overflow array sorted by hash value.
+ * The structure and all of its arrays live in one contiguous allocation.
+ */
+typedef struct sc_hash_frozen
+{
+  /* interface variables */
+  size_t              elem_count;       /**< total number of objects contained */
+
+  /* implementation variables */
+  size_t              num_slots;        /**< number of distinct hash values */
+  size_t              num_buckets;      /**< number of pilot values */
+  size_t              num_overflow;     /**< objects in the overflow array */
+  size_t              byte_alloc;       /**< size of the allocation */
+  uint64_t            seed;     /**< seed of the bucket assignment */
+  void               *user_data;        /**< user data passed to hash function */
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+  void              **items;    /**< one object per slot */
+  void              **overflow_items;   /**< objects with repeated hash */
+  uint32_t           *pilots;   /**< displacement value per bucket */
+  unsigned int       *hvals;    /**< hash value of the object per slot */
+  unsigned int       *overflow_hvals;   /**< sorted hash values of overflow */
+}
+sc_hash_frozen_t;
+
+/** Create an immutable perfect hash index of the objects in a hash table.
+ * The hash values cached in the table are reused.  The table is not
+ * modified and may be destroyed afterwards, while its callbacks and
+ * user data must stay valid for lookups in the frozen index.
+ * \param [in] hash        The populated hash table.
+ * \return                 The frozen index in one contiguous allocation.
+ */
+sc_hash_frozen_t   *sc_hash_freeze (sc_hash_t * hash);
+
+/** Calculate the memory used by a frozen hash index.
+ * \param [in] frozen      The frozen index.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_hash_frozen_memory_used (sc_hash_frozen_t * frozen);
+
+/** Destroy a frozen hash index.
+ * The objects referenced by the index are not touched.
+ */
+void                sc_hash_frozen_destroy (sc_hash_frozen_t * frozen);
+
+/** Check if an object is contained in a frozen hash index.
+ * \param [in]  v      The object to be looked up.
+ * \param [out] found  If found != NULL, *found is set to the contained
+ *                     object if the object is found.
+ * \return Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_frozen_lookup (sc_hash_frozen_t * frozen,
+                                           void *v, void **found);
+
 typedef struct sc_hash_array_data
 {
   sc_array_t         *pa;
@@ -1090,6 +2029,38 @@ int                 sc_hash_array_lookup (sc_hash_array_t * hash_array,
 void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
                                                  void *v, size_t *position);
 
+/** Insert a batch of objects into a hash array.
+ * All hash values are computed first, the hash table is sized once for the
+ * whole batch, and the hash chains are prefetched ahead of their use.
+ * Unlike \ref sc_hash_array_insert_unique, new objects are copied into the
+ * array.  They are appended in the order of their first occurrence in the
+ * batch, which is the same result as inserting them one by one.
+ *
+ * \param [in]  keys       Array of objects of the hash array element size.
+ *                         Must not be a view of the hash array itself.
+ * \param [out] positions  If positions != NULL, it must have element size
+ *                         sizeof (size_t) and is resized to the number of
+ *                         keys.  Each entry is set to the array position of
+ *                         the already contained or the new object.
+ * \return                 Returns the number of objects added.
+ */
+size_t              sc_hash_array_insert_batch (sc_hash_array_t * hash_array,
+                                                sc_array_t * keys,
+                                                sc_array_t * positions);
+
+/** Look up a batch of objects in a hash array.
+ *
+ * \param [in]  keys       Array of objects of the hash array element size.
+ * \param [out] positions  If positions != NULL, it must have element size
+ *                         sizeof (size_t) and is resized to the number of
+ *                         keys.  Each entry is set to the array position of
+ *                         the contained object or to (size_t) -1.
+ * \return                 Returns the number of objects found.
+ */
+size_t              sc_hash_array_lookup_batch (sc_hash_array_t * hash_array,
+                                                sc_array_t * keys,
+                                                sc_array_t * positions);
+
 /** Extract the array data from a hash array and destroy everything else.
  * \param [in] hash_array   The hash array is destroyed after extraction.
  * \param [in] rip          Array structure that will be overwritten.
@@ -1099,6 +2070,51 @@ void               *sc_hash_array_insert_unique (sc_hash_array_t * hash_array,
 void                sc_hash_array_rip (sc_hash_array_t * hash_array,
                                        sc_array_t * rip);
 
+/** The sc_hash_array_frozen is a read-only hash array.
+ * It holds the array of a hash array together with a frozen hash index.
+ */
+typedef struct sc_hash_array_frozen
+{
+  /* interface variables */
+  sc_array_t          a;        /**< the array elements, do not modify */
+
+  /* implementation variables */
+  sc_hash_array_data_t internal_data;
+  sc_hash_frozen_t   *f;
+}
+sc_hash_array_frozen_t;
+
+/** Convert a hash array into a read-only hash array.
+ * The array data is moved over and the hash table is destroyed.
+ * \param [in] hash_array   The hash array is destroyed by this function.
+ * \return                  The read-only hash array.
+ */
+sc_hash_array_frozen_t *sc_hash_array_freeze (sc_hash_array_t * hash_array);
+
+/** Calculate the memory used by a read-only hash array.
+ * \param [in] fha          The read-only hash array.
+ * \return                  Memory used in bytes.
+ */
+size_t              sc_hash_array_frozen_memory_used (sc_hash_array_frozen_t *
+                                                      fha);
+
+/** Destroy a read-only hash array including its array data.
+ */
+void                sc_hash_array_frozen_destroy (sc_hash_array_frozen_t *
+                                                  fha);
+
+/** Check if an object is contained in a read-only hash array.
+ *
+ * \param [in]  v          A pointer to the object.
+ * \param [out] position   If position != NULL, *position is set to the
+ *                         array position of the already contained object
+ *                         if found.
+ * \return                 Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_array_frozen_lookup (sc_hash_array_frozen_t *
+                                                 fha, void *v,
+                                                 size_t *position);
+
 /** The sc_recycle_array object provides an array of slots that can be reused.
  *
  * It keeps a list of free slots in the array which will be used for insertion
@@ -0,0 +1,318 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_crc32c.h>
+#include <sc_thread.h>
+#ifdef __ARM_FEATURE_CRC32
+#include <arm_acle.h>
+#endif
+
+#if defined __GNUC__ && defined __x86_64__
+#define SC_CRC32C_SSE42
+#elif defined __ARM_FEATURE_CRC32 && defined __aarch64__
+#define SC_CRC32C_ARMV8
+#endif
+
+/** The reflected Castagnoli polynomial. */
+#define SC_CRC32C_POLY 0x82f63b78U
+
+/** The instructions are interleaved on blocks of this many bytes. */
+#define SC_CRC32C_BLOCK ((size_t) 4096)
+
+/** Below this length, a buffer is not split between threads. */
+#define SC_CRC32C_MIN_THREAD ((size_t) 1 << 16)
+
+/** The checksum of every byte value for the table-driven computation. */
+static const uint32_t sc_crc32c_table[256] = {
+  0x00000000U, 0xf26b8303U, 0xe13b70f7U, 0x1350f3f4U,
+  0xc79a971fU, 0x35f1141cU, 0x26a1e7e8U, 0xd4ca64ebU,
+  0x8ad958cfU, 0x78b2dbccU, 0x6be22838U, 0x9989ab3bU,
+  0x4d43cfd0U, 0xbf284cd3U, 0xac78bf27U, 0x5e133c24U,
+  0x105ec76fU, 0xe235446cU, 0xf165b798U, 0x030e349bU,
+  0xd7c45070U, 0x25afd373U, 0x36ff2087U, 0xc494a384U,
+  0x9a879fa0U, 0x68ec1ca3U, 0x7bbcef57U, 0x89d76c54U,
+  0x5d1d08bfU, 0xaf768bbcU, 0xbc267848U, 0x4e4dfb4bU,
+  0x20bd8edeU, 0xd2d60dddU, 0xc186fe29U, 0x33ed7d2aU,
+  0xe72719c1U, 0x154c9ac2U, 0x061c6936U, 0xf477ea35U,
+  0xaa64d611U, 0x580f5512U, 0x4b5fa6e6U, 0xb93425e5U,
+  0x6dfe410eU, 0x9f95c20dU, 0x8cc531f9U, 0x7eaeb2faU,
+  0x30e349b1U, 0xc288cab2U, 0xd1d83946U, 0x23b3ba45U,
+  0xf779deaeU, 0x05125dadU, 0x1642ae59U, 0xe4292d5aU,
+  0xba3a117eU, 0x4851927dU, 0x5b016189U, 0xa96ae28aU,
+  0x7da08661U, 0x8fcb0562U, 0x9c9bf696U, 0x6ef07595U,
+  0x417b1dbcU, 0xb3109ebfU, 0xa0406d4bU, 0x522bee48U,
+  0x86e18aa3U, 0x748a09a0U, 0x67dafa54U, 0x95b17957U,
+  0xcba24573U, 0x39c9c670U, 0x2a993584U, 0xd8f2b687U,
+  0x0c38d26cU, 0xfe53516fU, 0xed03a29bU, 0x1f682198U,
+  0x5125dad3U, 0xa34e59d0U, 0xb01eaa24U, 0x42752927U,
+  0x96bf4dccU, 0x64d4cecfU, 0x77843d3bU, 0x85efbe38U,
+  0xdbfc821cU, 0x2997011fU, 0x3ac7f2ebU, 0xc8ac71e8U,
+  0x1c661503U, 0xee0d9600U, 0xfd5d65f4U, 0x0f36e6f7U,
+  0x61c69362U, 0x93ad1061U, 0x80fde395U, 0x72966096U,
+  0xa65c047dU, 0x5437877eU, 0x4767748aU, 0xb50cf789U,
+  0xeb1fcbadU, 0x197448aeU, 0x0a24bb5aU, 0xf84f3859U,
+  0x2c855cb2U, 0xdeeedfb1U, 0xcdbe2c45U, 0x3fd5af46U,
+  0x7198540dU, 0x83f3d70eU, 0x90a324faU, 0x62c8a7f9U,
+  0xb602c312U, 0x44694011U, 0x5739b3e5U, 0xa55230e6U,
+  0xfb410cc2U, 0x092a8fc1U, 0x1a7a7c35U, 0xe811ff36U,
+  0x3cdb9bddU, 0xceb018deU, 0xdde0eb2aU, 0x2f8b6829U,
+  0x82f63b78U, 0x709db87bU, 0x63cd4b8fU, 0x91a6c88cU,
+  0x456cac67U, 0xb7072f64U, 0xa457dc90U, 0x563c5f93U,
+  0x082f63b7U, 0xfa44e0b4U, 0xe9141340U, 0x1b7f9043U,
+  0xcfb5f4a8U, 0x3dde77abU, 0x2e8e845fU, 0xdce5075cU,
+  0x92a8fc17U, 0x60c37f14U, 0x73938ce0U, 0x81f80fe3U,
+  0x55326b08U, 0xa759e80bU, 0xb4091bffU, 0x466298fcU,
+  0x1871a4d8U, 0xea1a27dbU, 0xf94ad42fU, 0x0b21572cU,
+  0xdfeb33c7U, 0x2d80b0c4U, 0x3ed04330U, 0xccbbc033U,
+  0xa24bb5a6U, 0x502036a5U, 0x4370c551U, 0xb11b4652U,
+  0x65d122b9U, 0x97baa1baU, 0x84ea524eU, 0x7681d14dU,
+  0x2892ed69U, 0xdaf96e6aU, 0xc9a99d9eU, 0x3bc21e9dU,
+  0xef087a76U, 0x1d63f975U, 0x0e330a81U, 0xfc588982U,
+  0xb21572c9U, 0x407ef1caU, 0x532e023eU, 0xa145813dU,
+  0x758fe5d6U, 0x87e466d5U, 0x94b49521U, 0x66df1622U,
+  0x38cc2a06U, 0xcaa7a905U, 0xd9f75af1U, 0x2b9cd9f2U,
+  0xff56bd19U, 0x0d3d3e1aU, 0x1e6dcdeeU, 0xec064eedU,
+  0xc38d26c4U, 0x31e6a5c7U, 0x22b65633U, 0xd0ddd530U,
+  0x0417b1dbU, 0xf67c32d8U, 0xe52cc12cU, 0x1747422fU,
+  0x49547e0bU, 0xbb3ffd08U, 0xa86f0efcU, 0x5a048dffU,
+  0x8ecee914U, 0x7ca56a17U, 0x6ff599e3U, 0x9d9e1ae0U,
+  0xd3d3e1abU, 0x21b862a8U, 0x32e8915cU, 0xc083125fU,
+  0x144976b4U, 0xe622f5b7U, 0xf5720643U, 0x07198540U,
+  0x590ab964U, 0xab613a67U, 0xb831c993U, 0x4a5a4a90U,
+  0x9e902e7bU, 0x6cfbad78U, 0x7fab5e8cU, 0x8dc0dd8fU,
+  0xe330a81aU, 0x115b2b19U, 0x020bd8edU, 0xf0605beeU,
+  0x24aa3f05U, 0xd6c1bc06U, 0xc5914ff2U, 0x37faccf1U,
+  0x69e9f0d5U, 0x9b8273d6U, 0x88d28022U, 0x7ab90321U,
+  0xae7367caU, 0x5c18e4c9U, 0x4f48173dU, 0xbd23943eU,
+  0xf36e6f75U, 0x0105ec76U, 0x12551f82U, 0xe03e9c81U,
+  0x34f4f86aU, 0xc69f7b69U, 0xd5cf889dU, 0x27a40b9eU,
+  0x79b737baU, 0x8bdcb4b9U, 0x988c474dU, 0x6ae7c44eU,
+  0xbe2da0a5U, 0x4c4623a6U, 0x5f16d052U, 0xad7d5351U
+};
+
+/** Multiply two polynomials modulo the CRC polynomial in reflected order. */
+static uint32_t
+sc_crc32c_multiply (uint32_t a, uint32_t b)
+{
+  uint32_t            m, p;
+
+  for (m = 1U << 31, p = 0; m != 0; m >>= 1) {
+    if (a & m) {
+      p ^= b;
+    }
+    b = b & 1 ? (b >> 1) ^ SC_CRC32C_POLY : b >> 1;
+  }
+  return p;
+}
+
+/** Return x to the power of 8 * length modulo the CRC polynomial. */
+static uint32_t
+sc_crc32c_shift (size_t length)
+{
+  uint32_t            p, y;
+
+  /* in reflected order, 1 is the highest bit and x^8 the ninth highest */
+  for (p = 1U << 31, y = 1U << 23; length > 0; length >>= 1) {
+    if (length & 1) {
+      p = sc_crc32c_multiply (y, p);
+    }
+    y = sc_crc32c_multiply (y, y);
+  }
+  return p;
+}
+
+/** Update the CRC register byte by byte with the table. */
+static uint32_t
+sc_crc32c_bytes (uint32_t crc, const unsigned char *p, size_t length)
+{
+  while (length-- > 0) {
+    crc = sc_crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#ifdef SC_CRC32C_SSE42
+
+/** Update the CRC register with one stream of the CRC32 instruction. */
+static uint32_t __attribute__ ((target ("sse4.2")))
+sc_crc32c_stream (uint32_t crc, const unsigned char *p, size_t length)
+{
+  unsigned long long  c = crc, v;
+
+  for (; length > 0 && ((uintptr_t) p & 7); --length) {
+    c = __builtin_ia32_crc32qi ((unsigned) c, *p++);
+  }
+  for (; length >= 8; length -= 8, p += 8) {
+    memcpy (&v, p, 8);
+    c = __builtin_ia32_crc32di (c, v);
+  }
+  for (; length > 0; --length) {
+    c = __builtin_ia32_crc32qi ((unsigned) c, *p++);
+  }
+  return (uint32_t) c;
+}
+
+/** Update the CRC register with three interleaved streams.
+ * The instruction has a latency of three cycles but can start every cycle,
+ * so we process three blocks at once and combine their checksums.
+ */
+static uint32_t __attribute__ ((target ("sse4.2")))
+sc_crc32c_instructions (uint32_t crc, const unsigned char *p,
+                        size_t length)
+{
+  const size_t        block = SC_CRC32C_BLOCK;
+  uint32_t            shift1, shift2;
+  unsigned long long  c0, c1, c2, v0, v1, v2;
+  size_t              zz;
+
+  if (length >= 3 * block) {
+    shift1 = sc_crc32c_shift (block);
+    shift2 = sc_crc32c_shift (2 * block);
+    for (; length >= 3 * block; length -= 3 * block, p += 3 * block) {
+      c0 = crc;
+      c1 = c2 = 0;
+      for (zz = 0; zz < block; zz += 8) {
+        memcpy (&v0, p + zz, 8);
+        memcpy (&v1, p + block + zz, 8);
+        memcpy (&v2, p + 2 * block + zz, 8);
+        c0 = __builtin_ia32_crc32di (c0, v0);
+        c1 = __builtin_ia32_crc32di (c1, v1);
+        c2 = __builtin_ia32_crc32di (c2, v2);
+      }
+      crc = sc_crc32c_multiply (shift2, (uint32_t) c0) ^
+        sc_crc32c_multiply (shift1, (uint32_t) c1) ^ (uint32_t) c2;
+    }
+  }
+  return sc_crc32c_stream (crc, p, length);
+}
+
+#elif defined SC_CRC32C_ARMV8
+
+/** Update the CRC register with the ARMv8 CRC32C instructions. */
+static uint32_t
+sc_crc32c_instructions (uint32_t crc, const unsigned char *p,
+                        size_t length)
+{
+  uint64_t            v;
+
+  for (; length > 0 && ((uintptr_t) p & 7); --length) {
+    crc = __crc32cb (crc, *p++);
+  }
+  for (; length >= 8; length -= 8, p += 8) {
+    memcpy (&v, p, 8);
+    crc = __crc32cd (crc, v);
+  }
+  for (; length > 0; --length) {
+    crc = __crc32cb (crc, *p++);
+  }
+  return crc;
+}
+
+#endif
+
+int
+sc_crc32c_hardware (void)
+{
+#ifdef SC_CRC32C_SSE42
+  return __builtin_cpu_supports ("sse4.2") != 0;
+#elif defined SC_CRC32C_ARMV8
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+uint32_t
+sc_crc32c (uint32_t crc, const void *data, size_t length)
+{
+  const unsigned char *p = (const unsigned char *) data;
+
+  /* the register is kept inverted between calls */
+  crc = ~crc;
+#if defined SC_CRC32C_SSE42 || defined SC_CRC32C_ARMV8
+  if (sc_crc32c_hardware ()) {
+    return ~sc_crc32c_instructions (crc, p, length);
+  }
+#endif
+  return ~sc_crc32c_bytes (crc, p, length);
+}
+
+uint32_t
+sc_crc32c_combine (uint32_t crc1, uint32_t crc2, size_t length2)
+{
+  /* the inversions at the start and the end of the second buffer cancel */
+  return sc_crc32c_multiply (sc_crc32c_shift (length2), crc1) ^ crc2;
+}
+
+/** The data of a team of threads computing a checksum. */
+typedef struct sc_crc32c_team
+{
+  const unsigned char *data;
+  size_t              length;
+  uint32_t           *crcs;     /**< the checksum of each thread */
+}
+sc_crc32c_team_t;
+
+static void
+sc_crc32c_block (int thread_id, int num_threads, void *v)
+{
+  sc_crc32c_team_t   *team = (sc_crc32c_team_t *) v;
+  size_t              begin, end;
+
+  begin = team->length * thread_id / num_threads;
+  end = team->length * (thread_id + 1) / num_threads;
+  team->crcs[thread_id] = sc_crc32c (0, team->data + begin, end - begin);
+}
+
+uint32_t
+sc_crc32c_threads (const void *data, size_t length, int num_threads)
+{
+  int                 t;
+  uint32_t            crc;
+  sc_crc32c_team_t    team;
+
+  if (num_threads <= 0) {
+    num_threads = sc_thread_max_threads ();
+  }
+  num_threads = (int) SC_MIN ((size_t) num_threads,
+                              length / SC_CRC32C_MIN_THREAD);
+  if (num_threads <= 1) {
+    return sc_crc32c (0, data, length);
+  }
+
+  team.data = (const unsigned char *) data;
+  team.length = length;
+  team.crcs = SC_ALLOC (uint32_t, num_threads);
+  sc_thread_team_run (num_threads, sc_crc32c_block, &team);
+
+  /* combine the blocks in order */
+  crc = team.crcs[0];
+  for (t = 1; t < num_threads; ++t) {
+    crc = sc_crc32c_combine (crc, team.crcs[t],
+                             length * (t + 1) / num_threads -
+                             length * t / num_threads);
+  }
+  SC_FREE (team.crcs);
+
+  return crc;
+}
@@ -0,0 +1,82 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_crc32c.h
+ *
+ * The CRC32C checksum (Castagnoli polynomial) of memory buffers.
+ * It uses the CRC instructions of SSE 4.2 or ARMv8 where available and a
+ * lookup table otherwise.  Checksums of consecutive buffers can be combined,
+ * which allows computing the checksum of one large buffer block by block in
+ * parallel and that of an array distributed over several processes.
+ * This does not require zlib.
+ */
+
+#ifndef SC_CRC32C_H
+#define SC_CRC32C_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Update a CRC32C checksum with the bytes of a buffer.
+ * This follows the conventions of the zlib crc32 function.
+ * \param [in] crc          The checksum of the preceding data, or 0.
+ * \param [in] data         The buffer, may be NULL if \a length is 0.
+ * \param [in] length       Number of bytes in the buffer.
+ * \return                  The checksum of the preceding data followed by
+ *                          the buffer.  The checksum of "123456789" is
+ *                          0xe3069283.
+ */
+uint32_t            sc_crc32c (uint32_t crc, const void *data,
+                               size_t length);
+
+/** Combine the checksums of two consecutive buffers.
+ * \param [in] crc1         Checksum of the first buffer.
+ * \param [in] crc2         Checksum of the second buffer.
+ * \param [in] length2      Number of bytes in the second buffer.
+ * \return                  Checksum of both buffers, one after the other.
+ */
+uint32_t            sc_crc32c_combine (uint32_t crc1, uint32_t crc2,
+                                       size_t length2);
+
+/** Compute the CRC32C checksum of a buffer with multiple threads.
+ * Every thread computes the checksum of one block, and the results are
+ * combined.  The result equals that of \ref sc_crc32c starting from 0.
+ * \param [in] data         The buffer, may be NULL if \a length is 0.
+ * \param [in] length       Number of bytes in the buffer.
+ * \param [in] num_threads  Number of threads to use.  If this is less than
+ *                          or equal to zero, use sc_thread_max_threads.
+ * \return                  The checksum of the buffer.
+ */
+uint32_t            sc_crc32c_threads (const void *data, size_t length,
+                                       int num_threads);
+
+/** Determine whether the checksum is computed by CRC instructions.
+ * \return                  True if the processor's instructions are used,
+ *                          false if the lookup table is used.
+ */
+int                 sc_crc32c_hardware (void);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_CRC32C_H */
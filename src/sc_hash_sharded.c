@@ -0,0 +1,239 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_hash_sharded.h>
+
+/* The shard tables call their hash function only for the query object,
+ * since they reuse cached hash values when resizing.  We compute that
+ * hash value once to select the shard and pass it on under the lock. */
+
+static unsigned int
+sc_hash_shard_hash_fn (const void *v, const void *u)
+{
+  const sc_hash_shard_t *shard = (const sc_hash_shard_t *) u;
+
+  return shard->current_hval;
+}
+
+static int
+sc_hash_shard_equal_fn (const void *v1, const void *v2, const void *u)
+{
+  const sc_hash_sharded_t *hash = ((const sc_hash_shard_t *) u)->owner;
+
+  return hash->equal_fn (v1, v2, hash->user_data);
+}
+
+sc_hash_sharded_t  *
+sc_hash_sharded_new (sc_hash_function_t hash_fn, sc_equal_function_t equal_fn,
+                     void *user_data, int num_shards)
+{
+  int                 i;
+  sc_hash_shard_t    *shard;
+  sc_hash_sharded_t  *hash;
+
+  if (num_shards <= 0) {
+    num_shards = 4 * sc_thread_max_threads ();
+  }
+
+  hash = SC_ALLOC (sc_hash_sharded_t, 1);
+  hash->hash_fn = hash_fn;
+  hash->equal_fn = equal_fn;
+  hash->user_data = user_data;
+  hash->shard_bits = 0;
+  while ((1 << hash->shard_bits) < num_shards) {
+    ++hash->shard_bits;
+  }
+  hash->num_shards = 1 << hash->shard_bits;
+
+  hash->shards = SC_ALLOC (sc_hash_shard_t, hash->num_shards);
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = hash->shards + i;
+    sc_thread_mutex_init (&shard->mutex);
+    shard->table = sc_hash_open_new (sc_hash_shard_hash_fn,
+                                     sc_hash_shard_equal_fn, shard);
+    shard->current_hval = 0;
+    shard->owner = hash;
+  }
+
+  return hash;
+}
+
+void
+sc_hash_sharded_destroy (sc_hash_sharded_t * hash)
+{
+  int                 i;
+
+  for (i = 0; i < hash->num_shards; ++i) {
+    sc_hash_open_destroy (hash->shards[i].table);
+    sc_thread_mutex_destroy (&hash->shards[i].mutex);
+  }
+  SC_FREE (hash->shards);
+  SC_FREE (hash);
+}
+
+size_t
+sc_hash_sharded_count (sc_hash_sharded_t * hash)
+{
+  int                 i;
+  size_t              count;
+  sc_hash_shard_t    *shard;
+
+  for (i = 0, count = 0; i < hash->num_shards; ++i) {
+    shard = hash->shards + i;
+    sc_thread_mutex_lock (&shard->mutex);
+    count += shard->table->elem_count;
+    sc_thread_mutex_unlock (&shard->mutex);
+  }
+
+  return count;
+}
+
+size_t
+sc_hash_sharded_memory_used (sc_hash_sharded_t * hash)
+{
+  int                 i;
+  size_t              mem;
+  sc_hash_shard_t    *shard;
+
+  mem = sizeof (sc_hash_sharded_t) +
+    hash->num_shards * sizeof (sc_hash_shard_t);
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = hash->shards + i;
+    sc_thread_mutex_lock (&shard->mutex);
+    mem += sc_hash_open_memory_used (shard->table);
+    sc_thread_mutex_unlock (&shard->mutex);
+  }
+
+  return mem;
+}
+
+/** Compute the hash value of an object and lock the shard it belongs to.
+ * \return      The locked shard with its current hash value assigned.
+ */
+static sc_hash_shard_t *
+sc_hash_sharded_lock (sc_hash_sharded_t * hash, void *v)
+{
+  unsigned int        hval;
+  sc_hash_shard_t    *shard;
+
+  hval = hash->hash_fn (v, hash->user_data);
+  shard = hash->shards;
+  if (hash->shard_bits > 0) {
+    /* use bits independent of those selecting the slot within the shard */
+    shard += (size_t) (sc_hash_mix64 (hval) >> (64 - hash->shard_bits));
+  }
+  sc_thread_mutex_lock (&shard->mutex);
+  shard->current_hval = hval;
+
+  return shard;
+}
+
+int
+sc_hash_sharded_lookup (sc_hash_sharded_t * hash, void *v, void **found)
+{
+  int                 contained;
+  void              **slot;
+  sc_hash_shard_t    *shard;
+
+  shard = sc_hash_sharded_lock (hash, v);
+  contained = sc_hash_open_lookup (shard->table, v, &slot);
+  if (contained && found != NULL) {
+    *found = *slot;
+  }
+  sc_thread_mutex_unlock (&shard->mutex);
+
+  return contained;
+}
+
+int
+sc_hash_sharded_insert_unique (sc_hash_sharded_t * hash, void *v,
+                               void **found)
+{
+  int                 added;
+  void              **slot;
+  sc_hash_shard_t    *shard;
+
+  shard = sc_hash_sharded_lock (hash, v);
+  added = sc_hash_open_insert_unique (shard->table, v, &slot);
+  if (found != NULL) {
+    *found = *slot;
+  }
+  sc_thread_mutex_unlock (&shard->mutex);
+
+  return added;
+}
+
+int
+sc_hash_sharded_remove (sc_hash_sharded_t * hash, void *v, void **found)
+{
+  int                 removed;
+  sc_hash_shard_t    *shard;
+
+  shard = sc_hash_sharded_lock (hash, v);
+  removed = sc_hash_open_remove (shard->table, v, found);
+  sc_thread_mutex_unlock (&shard->mutex);
+
+  return removed;
+}
+
+void
+sc_hash_sharded_foreach (sc_hash_sharded_t * hash, sc_hash_foreach_t fn)
+{
+  int                 i;
+  sc_hash_shard_t    *shard;
+
+  /* the callback receives the user data of the sharded table */
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = hash->shards + i;
+    sc_thread_mutex_lock (&shard->mutex);
+    shard->table->user_data = hash->user_data;
+    sc_hash_open_foreach (shard->table, fn);
+    shard->table->user_data = shard;
+    sc_thread_mutex_unlock (&shard->mutex);
+  }
+}
+
+void
+sc_hash_sharded_print_statistics (int package_id, int log_priority,
+                                  sc_hash_sharded_t * hash)
+{
+  int                 i;
+  size_t              count, total, minimum, maximum;
+  sc_hash_shard_t    *shard;
+
+  total = maximum = 0;
+  minimum = (size_t) -1;
+  for (i = 0; i < hash->num_shards; ++i) {
+    shard = hash->shards + i;
+    sc_thread_mutex_lock (&shard->mutex);
+    count = shard->table->elem_count;
+    sc_thread_mutex_unlock (&shard->mutex);
+    total += count;
+    minimum = SC_MIN (minimum, count);
+    maximum = SC_MAX (maximum, count);
+  }
+  SC_GEN_LOGF (package_id, SC_LC_NORMAL, log_priority,
+               "Sharded hash shards %d count %lu min %lu max %lu\n",
+               hash->num_shards, (unsigned long) total,
+               (unsigned long) minimum, (unsigned long) maximum);
+}
@@ -0,0 +1,147 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_hash_sharded.h
+ *
+ * A hash table that can be used concurrently by multiple threads.
+ * The objects are distributed over a number of shards by their hash value.
+ * Every shard is an open addressing hash table protected by its own mutex,
+ * such that threads only contend when they access the same shard.
+ * The callbacks follow the contract of \ref sc_hash_t.
+ */
+
+#ifndef SC_HASH_SHARDED_H
+#define SC_HASH_SHARDED_H
+
+#include <sc_containers.h>
+#include <sc_thread.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** One shard of a sharded hash table, padded to avoid false sharing. */
+typedef struct sc_hash_shard
+{
+  sc_thread_mutex_t   mutex;    /**< protects all other members */
+  sc_hash_open_t     *table;    /**< the objects of this shard */
+  unsigned int        current_hval;     /**< hash value of the query object */
+  struct sc_hash_sharded *owner;        /**< the table containing the shard */
+  char                padding[64];
+}
+sc_hash_shard_t;
+
+/** The sc_hash_sharded implements a hash table for concurrent use. */
+typedef struct sc_hash_sharded
+{
+  /* implementation variables */
+  int                 num_shards;       /**< a power of two */
+  int                 shard_bits;       /**< binary logarithm of num_shards */
+  sc_hash_shard_t    *shards;
+  void               *user_data;        /**< user data passed to hash function */
+  sc_hash_function_t  hash_fn;
+  sc_equal_function_t equal_fn;
+}
+sc_hash_sharded_t;
+
+/** Create a new sharded hash table.
+ * This function is not thread-safe.
+ * \param [in] hash_fn     Function to compute the hash value.
+ * \param [in] equal_fn    Function to test two objects for equality.
+ *                         Both functions may be called concurrently.
+ * \param [in] user_data   User data passed through to the hash function.
+ * \param [in] num_shards  Minimum number of shards.  It is rounded up to a
+ *                         power of two.  If not positive, it is chosen as
+ *                         four times \ref sc_thread_max_threads.
+ */
+sc_hash_sharded_t  *sc_hash_sharded_new (sc_hash_function_t hash_fn,
+                                         sc_equal_function_t equal_fn,
+                                         void *user_data, int num_shards);
+
+/** Destroy a sharded hash table.
+ * This function is not thread-safe.
+ */
+void                sc_hash_sharded_destroy (sc_hash_sharded_t * hash);
+
+/** Return the number of objects contained in a sharded hash table.
+ * This function is thread-safe.  Concurrent modifications may or may not
+ * be accounted for.
+ */
+size_t              sc_hash_sharded_count (sc_hash_sharded_t * hash);
+
+/** Calculate the memory used by a sharded hash table.
+ * This function is thread-safe.
+ * \param [in] hash        The hash table.
+ * \return                 Memory used in bytes.
+ */
+size_t              sc_hash_sharded_memory_used (sc_hash_sharded_t * hash);
+
+/** Check if an object is contained in the hash table.
+ * This function is thread-safe.
+ * \param [in]  v      The object to be looked up.
+ * \param [out] found  If found != NULL, *found is set to the already
+ *                     contained object if the object is found.  Unlike
+ *                     \ref sc_hash_lookup, this is not the address of a slot,
+ *                     since other threads may move the slots at any time.
+ * \return Returns true if object is found, false otherwise.
+ */
+int                 sc_hash_sharded_lookup (sc_hash_sharded_t * hash,
+                                            void *v, void **found);
+
+/** Insert an object into a hash table if it is not contained already.
+ * This function is thread-safe.  If several threads insert equal objects
+ * concurrently, exactly one of them succeeds.
+ * \param [in]  v      The object to be inserted.
+ * \param [out] found  If found != NULL, *found is set to the already
+ *                     contained object, or if not present, to v.
+ * \return Returns true if object is added, false if it is already contained.
+ */
+int                 sc_hash_sharded_insert_unique (sc_hash_sharded_t * hash,
+                                                   void *v, void **found);
+
+/** Remove an object from a hash table.
+ * This function is thread-safe.
+ * \param [in]  v      The object to be removed.
+ * \param [out] found  If found != NULL, *found is set to the object
+                       that is removed if that exists.
+ * \return Returns true if object is found, false if is not contained.
+ */
+int                 sc_hash_sharded_remove (sc_hash_sharded_t * hash,
+                                            void *v, void **found);
+
+/** Invoke a callback for every member of the hash table.
+ * Each shard is locked while it is traversed.  The callback must not call
+ * other functions on the same hash table.
+ */
+void                sc_hash_sharded_foreach (sc_hash_sharded_t * hash,
+                                             sc_hash_foreach_t fn);
+
+/** Print statistical information about the distribution over the shards.
+ * This function is thread-safe.
+ */
+void                sc_hash_sharded_print_statistics (int package_id,
+                                                      int log_priority,
+                                                      sc_hash_sharded_t *
+                                                      hash);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_HASH_SHARDED_H */
@@ -49,7 +49,7 @@ sc_keyvalue_entry_hash (const void *v, const void *u)
 {
   const sc_keyvalue_entry_t *ov = (const sc_keyvalue_entry_t *) v;
 
-  return sc_hash_function_string (ov->key, NULL);
+  return sc_hash_function_string64 (ov->key, NULL);
 }
 
 static int
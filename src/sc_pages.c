@@ -0,0 +1,471 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sc_pages.h>
+#include <sc_thread.h>
+#ifdef SC_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef SC_HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#ifdef SC_HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#if defined SC_HAVE_MMAP && defined SC_HAVE_SYS_MMAN_H && \
+  defined MAP_ANONYMOUS
+#define SC_PAGES_MMAP
+#endif
+
+#if defined SC_PAGES_MMAP && defined SC_HAVE_FCNTL_H && \
+  defined SC_HAVE_FTRUNCATE
+#define SC_PAGES_FILE
+#endif
+
+/* The memory policy of the Linux mbind (2) system call. */
+#define SC_PAGES_MPOL_BIND 2
+
+void
+sc_pages_policy_init (sc_pages_policy_t * policy)
+{
+  SC_ASSERT (policy != NULL);
+
+  policy->huge = SC_PAGES_TRANSPARENT;
+  policy->numa_node = -1;
+  policy->first_touch = 0;
+  policy->min_bytes = SC_PAGES_HUGE_SIZE;
+}
+
+size_t
+sc_pages_unit (const sc_pages_policy_t * policy)
+{
+  long                page;
+
+  SC_ASSERT (policy != NULL);
+
+  if (policy->huge != SC_PAGES_NORMAL) {
+    return SC_PAGES_HUGE_SIZE;
+  }
+  page = sysconf (_SC_PAGESIZE);
+  return page > 0 ? (size_t) page : 4096;
+}
+
+/** Return true if a buffer of this size is obtained by mmap (2). */
+static int
+sc_pages_is_mapped (const sc_pages_policy_t * policy, size_t size)
+{
+#ifdef SC_PAGES_MMAP
+  return size > 0 && size >= policy->min_bytes;
+#else
+  return 0;
+#endif
+}
+
+/** Return the length of the mapping for a buffer of this size. */
+static size_t
+sc_pages_length (const sc_pages_policy_t * policy, size_t size)
+{
+  size_t              unit = sc_pages_unit (policy);
+
+  return (size + unit - 1) / unit * unit;
+}
+
+#ifdef SC_PAGES_MMAP
+
+static void        *
+sc_pages_map (const sc_pages_policy_t * policy, size_t length)
+{
+  const int           prot = PROT_READ | PROT_WRITE;
+  const int           flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  size_t              unit, head;
+  char               *p;
+
+#ifdef MAP_HUGETLB
+  if (policy->huge == SC_PAGES_EXPLICIT) {
+    /* the length is a multiple of the huge page size requested */
+#ifdef MAP_HUGE_2MB
+    p = (char *) mmap (NULL, length, prot,
+                       flags | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+#else
+    p = (char *) mmap (NULL, length, prot, flags | MAP_HUGETLB, -1, 0);
+#endif
+    if (p != (char *) MAP_FAILED) {
+      return p;
+    }
+    /* the system has no huge pages reserved; use transparent ones */
+  }
+#endif
+
+  if (policy->huge == SC_PAGES_NORMAL) {
+    p = (char *) mmap (NULL, length, prot, flags, -1, 0);
+    return p != (char *) MAP_FAILED ? p : NULL;
+  }
+
+  /* map one more huge page and trim the mapping to an aligned one */
+  unit = sc_pages_unit (policy);
+  p = (char *) mmap (NULL, length + unit, prot, flags, -1, 0);
+  if (p == (char *) MAP_FAILED) {
+    return NULL;
+  }
+  head = (unit - (size_t) ((uintptr_t) p % unit)) % unit;
+  if (head > 0) {
+    munmap (p, head);
+  }
+  munmap (p + head + length, unit - head);
+  p += head;
+#if defined SC_HAVE_MADVISE && defined MADV_HUGEPAGE
+  madvise (p, length, MADV_HUGEPAGE);
+#endif
+
+  return p;
+}
+
+static void
+sc_pages_bind (const sc_pages_policy_t * policy, void *ptr, size_t length)
+{
+#ifdef SYS_mbind
+  const int           bits = 8 * sizeof (unsigned long);
+  unsigned long       mask[16];
+  long                ret;
+
+  if (policy->numa_node < 0) {
+    return;
+  }
+  if (policy->numa_node >= 16 * bits) {
+    SC_LERRORF ("NUMA node %d out of range\n", policy->numa_node);
+    return;
+  }
+  memset (mask, 0, sizeof (mask));
+  mask[policy->numa_node / bits] = 1UL << (policy->numa_node % bits);
+  ret = syscall (SYS_mbind, ptr, length, SC_PAGES_MPOL_BIND,
+                 mask, (unsigned long) (16 * bits + 1), 0);
+  if (ret != 0) {
+    SC_LERRORF ("Binding to NUMA node %d failed\n", policy->numa_node);
+  }
+#else
+  if (policy->numa_node >= 0) {
+    SC_LERROR ("Binding to NUMA nodes is not supported\n");
+  }
+#endif
+}
+
+typedef struct sc_pages_touch
+{
+  char               *ptr;
+  size_t              length;
+  size_t              unit;
+}
+sc_pages_touch_t;
+
+/** Every thread writes a contiguous share of the pages first. */
+static void
+sc_pages_touch (int thread_id, int num_threads, void *data)
+{
+  sc_pages_touch_t   *touch = (sc_pages_touch_t *) data;
+  size_t              num_pages, begin, end;
+
+  num_pages = touch->length / touch->unit;
+  begin = num_pages * thread_id / num_threads;
+  end = num_pages * (thread_id + 1) / num_threads;
+  if (begin < end) {
+    memset (touch->ptr + begin * touch->unit, 0,
+            (end - begin) * touch->unit);
+  }
+}
+
+#endif /* SC_PAGES_MMAP */
+
+void               *
+sc_pages_alloc (const sc_pages_policy_t * policy, size_t size)
+{
+#ifdef SC_PAGES_MMAP
+  size_t              length;
+  char               *ptr;
+  sc_pages_touch_t    touch;
+#endif
+
+  SC_ASSERT (policy != NULL && policy->huge != SC_PAGES_MAPFILE);
+
+  if (size == 0) {
+    return NULL;
+  }
+  if (!sc_pages_is_mapped (policy, size)) {
+    return sc_malloc (sc_package_id, size);
+  }
+
+#ifdef SC_PAGES_MMAP
+  length = sc_pages_length (policy, size);
+  ptr = (char *) sc_pages_map (policy, length);
+  SC_CHECK_ABORT (ptr != NULL, "Memory mapping");
+  sc_pages_bind (policy, ptr, length);
+  if (policy->first_touch > 0) {
+    touch.ptr = ptr;
+    touch.length = length;
+    touch.unit = sc_pages_unit (policy);
+    sc_thread_team_run (policy->first_touch, sc_pages_touch, &touch);
+  }
+  return ptr;
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+}
+
+void
+sc_pages_free (const sc_pages_policy_t * policy, void *ptr, size_t size)
+{
+  SC_ASSERT (policy != NULL);
+
+  if (ptr == NULL) {
+    return;
+  }
+  if (!sc_pages_is_mapped (policy, size)) {
+    sc_free (sc_package_id, ptr);
+    return;
+  }
+
+#ifdef SC_PAGES_MMAP
+  SC_CHECK_ABORT (munmap (ptr, sc_pages_length (policy, size)) == 0,
+                  "Memory unmapping");
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+}
+
+void               *
+sc_pages_realloc (const sc_pages_policy_t * policy, void *ptr,
+                  size_t old_size, size_t new_size)
+{
+  int                 old_mapped, new_mapped;
+  void               *new_ptr;
+
+  SC_ASSERT (policy != NULL);
+
+  if (ptr == NULL) {
+    return sc_pages_alloc (policy, new_size);
+  }
+  if (new_size == 0) {
+    sc_pages_free (policy, ptr, old_size);
+    return NULL;
+  }
+
+  old_mapped = sc_pages_is_mapped (policy, old_size);
+  new_mapped = sc_pages_is_mapped (policy, new_size);
+  if (!old_mapped && !new_mapped) {
+    return sc_realloc (sc_package_id, ptr, new_size);
+  }
+  if (old_mapped && new_mapped &&
+      sc_pages_length (policy, old_size) ==
+      sc_pages_length (policy, new_size)) {
+    /* the mapping is large enough already */
+    return ptr;
+  }
+
+  new_ptr = sc_pages_alloc (policy, new_size);
+  memcpy (new_ptr, ptr, SC_MIN (old_size, new_size));
+  sc_pages_free (policy, ptr, old_size);
+  return new_ptr;
+}
+
+sc_pages_file_t    *
+sc_pages_file_open (const char *filename, int create)
+{
+#ifdef SC_PAGES_FILE
+  int                 fd;
+  off_t               length;
+  sc_pages_file_t    *file;
+
+  fd = open (filename, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0666);
+  if (fd < 0) {
+    SC_LERRORF ("Opening file %s failed\n", filename);
+    return NULL;
+  }
+  length = lseek (fd, 0, SEEK_END);
+  if (length < 0) {
+    SC_LERRORF ("Seeking file %s failed\n", filename);
+    close (fd);
+    return NULL;
+  }
+
+  file = SC_ALLOC (sc_pages_file_t, 1);
+  sc_pages_policy_init (&file->policy);
+  file->policy.huge = SC_PAGES_MAPFILE;
+  file->fd = fd;
+  file->length = 0;
+  file->data = NULL;
+  if (length > 0) {
+    file->data = mmap (NULL, (size_t) length, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+    if (file->data == MAP_FAILED) {
+      SC_LERRORF ("Mapping file %s failed\n", filename);
+      close (fd);
+      SC_FREE (file);
+      return NULL;
+    }
+    file->length = (size_t) length;
+  }
+  return file;
+#else
+  SC_LERROR ("Mapping files is not supported\n");
+  return NULL;
+#endif
+}
+
+void
+sc_pages_file_resize (sc_pages_file_t * file, size_t length)
+{
+#ifdef SC_PAGES_FILE
+  void               *data;
+
+  SC_ASSERT (file != NULL);
+
+  if (length == file->length) {
+    return;
+  }
+
+  /* the mapping must not extend beyond the end of the file */
+  if (length > file->length) {
+    SC_CHECK_ABORT (ftruncate (file->fd, (off_t) length) == 0,
+                    "File extension");
+  }
+  if (length == 0) {
+    SC_CHECK_ABORT (munmap (file->data, file->length) == 0,
+                    "File unmapping");
+    data = NULL;
+  }
+  else if (file->length == 0) {
+    data = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 file->fd, 0);
+  }
+  else {
+#if defined SC_HAVE_MREMAP && defined MREMAP_MAYMOVE
+    data = mremap (file->data, file->length, length, MREMAP_MAYMOVE);
+#else
+    /* the contents are in the file, so we do not need to copy them */
+    SC_CHECK_ABORT (munmap (file->data, file->length) == 0,
+                    "File unmapping");
+    data = mmap (NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 file->fd, 0);
+#endif
+  }
+  SC_CHECK_ABORT (data != MAP_FAILED, "File mapping");
+  if (length < file->length) {
+    SC_CHECK_ABORT (ftruncate (file->fd, (off_t) length) == 0,
+                    "File truncation");
+  }
+  file->data = data;
+  file->length = length;
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+}
+
+int
+sc_pages_file_sync (sc_pages_file_t * file, size_t length)
+{
+  SC_ASSERT (file != NULL);
+  SC_ASSERT (length <= file->length);
+
+  if (length == 0) {
+    return 0;
+  }
+#if defined SC_PAGES_FILE && defined SC_HAVE_MSYNC
+  return msync (file->data, length, MS_SYNC) == 0 ? 0 : -1;
+#elif defined SC_HAVE_FSYNC
+  return fsync (file->fd) == 0 ? 0 : -1;
+#else
+  return -1;
+#endif
+}
+
+void
+sc_pages_file_close (sc_pages_file_t * file, size_t length)
+{
+#ifdef SC_PAGES_FILE
+  SC_ASSERT (file != NULL);
+  SC_ASSERT (length <= file->length);
+
+  if (file->length > 0) {
+    SC_CHECK_ABORT (munmap (file->data, file->length) == 0,
+                    "File unmapping");
+  }
+  if (length < file->length) {
+    SC_CHECK_ABORT (ftruncate (file->fd, (off_t) length) == 0,
+                    "File truncation");
+  }
+  SC_CHECK_ABORT (close (file->fd) == 0, "File closing");
+  SC_FREE (file);
+#else
+  SC_ABORT_NOT_REACHED ();
+#endif
+}
+
+size_t
+sc_pages_huge_bytes (size_t num, void *const *ptrs, size_t size)
+{
+  size_t              zz, huge, overlap;
+  unsigned long       vstart, vend, a, b, lo, hi, kb;
+  char                line[BUFSIZ];
+  FILE               *file;
+
+  SC_ASSERT (num == 0 || ptrs != NULL);
+
+  file = fopen ("/proc/self/smaps", "r");
+  if (file == NULL) {
+    return 0;
+  }
+
+  /* each mapping starts with its address range followed by its fields */
+  huge = overlap = 0;
+  vstart = vend = 0;
+  while (fgets (line, BUFSIZ, file) != NULL) {
+    if (sscanf (line, "%lx-%lx ", &a, &b) == 2) {
+      /* a field name may begin with hexadecimal digits, too */
+      vstart = a;
+      vend = b;
+      overlap = 0;
+      for (zz = 0; zz < num; ++zz) {
+        if (ptrs[zz] == NULL) {
+          continue;
+        }
+        lo = SC_MAX (vstart, (unsigned long) ptrs[zz]);
+        hi = SC_MIN (vend, (unsigned long) ptrs[zz] + size);
+        if (lo < hi) {
+          overlap += hi - lo;
+        }
+      }
+    }
+    else if (overlap > 0 &&
+             (sscanf (line, "AnonHugePages: %lu kB", &kb) == 1 ||
+              sscanf (line, "Private_Hugetlb: %lu kB", &kb) == 1 ||
+              sscanf (line, "Shared_Hugetlb: %lu kB", &kb) == 1)) {
+      huge += (size_t) ((double) kb * 1024. * overlap / (vend - vstart));
+    }
+  }
+  fclose (file);
+
+  return huge;
+}
@@ -0,0 +1,174 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_pages.h
+ *
+ * Allocation of large buffers directly from the operating system.
+ * A policy selects huge pages and the placement of memory on NUMA nodes.
+ * Policies are attached to arrays by \ref sc_array_set_policy and to
+ * memory pools by \ref sc_mempool_set_policy.  Without mmap (2), or for
+ * buffers smaller than the policy's threshold, the memory is obtained
+ * from \ref sc_malloc as usual.
+ * Files can be mapped into memory, for example to hold the elements of an
+ * array created by \ref sc_array_new_file.
+ */
+
+#ifndef SC_PAGES_H
+#define SC_PAGES_H
+
+#include <sc.h>
+
+SC_EXTERN_C_BEGIN;
+
+/** Size of a huge page assumed for alignment and rounding. */
+#define SC_PAGES_HUGE_SIZE ((size_t) 1 << 21)
+
+/** Use mmap (2) with the regular page size, for example to bind nodes. */
+#define SC_PAGES_NORMAL 0
+/** Align the memory to huge pages and advise transparent huge pages. */
+#define SC_PAGES_TRANSPARENT 1
+/** Request explicit huge pages, falling back to transparent ones. */
+#define SC_PAGES_EXPLICIT 2
+/** Marks the policy that begins a \ref sc_pages_file_t. */
+#define SC_PAGES_MAPFILE 3
+
+/** Describe how the memory of large buffers is obtained. */
+typedef struct sc_pages_policy
+{
+  int                 huge;             /**< One of SC_PAGES_NORMAL,
+                                             SC_PAGES_TRANSPARENT or
+                                             SC_PAGES_EXPLICIT. */
+  int                 numa_node;        /**< Bind the pages to this node,
+                                             or -1 for no binding. */
+  int                 first_touch;      /**< If positive, the number of
+                                             threads that zero the new pages
+                                             to place them near themselves. */
+  size_t              min_bytes;        /**< Smaller buffers are allocated
+                                             with \ref sc_malloc. */
+}
+sc_pages_policy_t;
+
+/** Initialize a policy for transparent huge pages without NUMA binding.
+ * Buffers of at least one huge page are mapped.
+ * \param [out] policy      The members are set to their defaults.
+ */
+void                sc_pages_policy_init (sc_pages_policy_t * policy);
+
+/** Return the unit that mapped buffers are rounded up to.
+ * \param [in] policy       Valid policy.
+ * \return                  The huge or the regular page size.
+ */
+size_t              sc_pages_unit (const sc_pages_policy_t * policy);
+
+/** Allocate memory according to a policy.
+ * \param [in] policy       Valid policy.
+ * \param [in] size         Number of bytes, may be 0.
+ * \return                  Memory aligned to a page if it is mapped.
+ *                          NULL if size is 0.
+ */
+void               *sc_pages_alloc (const sc_pages_policy_t * policy,
+                                    size_t size);
+
+/** Free memory allocated with \ref sc_pages_alloc.
+ * \param [in] policy       The same policy used for the allocation.
+ * \param [in] ptr          Memory to free, may be NULL.
+ * \param [in] size         The same size used for the allocation.
+ */
+void                sc_pages_free (const sc_pages_policy_t * policy,
+                                   void *ptr, size_t size);
+
+/** Change the size of memory allocated with \ref sc_pages_alloc.
+ * The contents are preserved up to the smaller of the two sizes.
+ * \param [in] policy       The same policy used for the allocation.
+ * \param [in] ptr          Memory to resize, may be NULL.
+ * \param [in] old_size     The size used for the allocation.
+ * \param [in] new_size     The new size, may be 0.
+ * \return                  The resized memory, NULL if new_size is 0.
+ */
+void               *sc_pages_realloc (const sc_pages_policy_t * policy,
+                                      void *ptr, size_t old_size,
+                                      size_t new_size);
+
+/** Count the bytes of memory ranges that reside on huge pages.
+ * The information is taken from /proc/self/smaps on Linux.
+ * Where the kernel reports huge pages for a larger mapping,
+ * they are attributed to the ranges in proportion to their overlap.
+ * \param [in] num          Number of ranges.
+ * \param [in] ptrs         Array of num start addresses, NULL is ignored.
+ * \param [in] size         Length of each range in bytes.
+ * \return                  Bytes on huge pages, 0 if unknown.
+ */
+size_t              sc_pages_huge_bytes (size_t num, void *const *ptrs,
+                                         size_t size);
+
+/** A file whose contents are mapped into memory with write access.
+ * Changes to the memory are written to the file by the operating system.
+ * The file begins with a policy such that a single pointer can refer
+ * to either, as the backing store of an array does.
+ */
+typedef struct sc_pages_file
+{
+  sc_pages_policy_t   policy;           /**< Its huge is SC_PAGES_MAPFILE,
+                                             not to be allocated from */
+  int                 fd;               /**< Descriptor of the open file */
+  size_t              length;           /**< Length of file and mapping */
+  void               *data;             /**< Mapped contents of the file,
+                                             NULL if the length is 0 */
+}
+sc_pages_file_t;
+
+/** Open a file and map its contents into memory.
+ * \param [in] filename     Name of the file.
+ * \param [in] create       If true, the file is created or truncated.
+ *                          Otherwise, it must exist.
+ * \return                  A new mapped file, or NULL on error or if
+ *                          mapping files is not supported.
+ */
+sc_pages_file_t    *sc_pages_file_open (const char *filename, int create);
+
+/** Change the length of a mapped file and of its mapping.
+ * The mapping is moved if necessary, and the contents are preserved.
+ * \param [in,out] file     Mapped file.  Aborts if it cannot be resized.
+ * \param [in] length       The new length in bytes.
+ */
+void                sc_pages_file_resize (sc_pages_file_t * file,
+                                          size_t length);
+
+/** Write the beginning of the mapped contents to the file and wait.
+ * \param [in] file         Mapped file.
+ * \param [in] length       Number of bytes at the beginning to synchronize.
+ * \return                  0 on success, -1 on error.
+ */
+int                 sc_pages_file_sync (sc_pages_file_t * file,
+                                        size_t length);
+
+/** Unmap a file, cut it to a final length, and close it.
+ * \param [in] file         The mapped file is freed.
+ * \param [in] length       Final length in bytes, at most the current one.
+ */
+void                sc_pages_file_close (sc_pages_file_t * file,
+                                         size_t length);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_PAGES_H */
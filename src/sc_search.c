@@ -141,3 +141,227 @@ sc_bsearch_range (const void *key, const void *base, size_t nmemb,
   SC_ASSERT (compar (ckey, cbase + (guess + 1) * size) < 0);
   return guess;
 }
+
+/** Cache line size assumed for aligning and prefetching the index. */
+#define SC_SEARCH_INDEX_LINE 64
+
+/** Number of searches interleaved by the batched queries. */
+#define SC_SEARCH_INDEX_BATCH 16
+
+#ifdef __GNUC__
+#define SC_SEARCH_INDEX_PREFETCH(p) __builtin_prefetch (p)
+#else
+#define SC_SEARCH_INDEX_PREFETCH(p) ((void) 0)
+#endif
+
+/** Copy the sorted elements into the subtree below node k in order. */
+static void
+sc_search_index_fill (sc_search_index_t * index, const char *sorted,
+                      size_t *next, size_t k)
+{
+  const size_t        es = index->elem_size;
+
+  if (k <= index->nmemb) {
+    sc_search_index_fill (index, sorted, next, 2 * k);
+    memcpy (index->tree + k * es, sorted + *next * es, es);
+    index->position[k] = (*next)++;
+    sc_search_index_fill (index, sorted, next, 2 * k + 1);
+  }
+}
+
+static sc_search_index_t *
+sc_search_index_build (const void *sorted, size_t nmemb, size_t elem_size,
+                       int (*compar) (const void *, const void *))
+{
+  size_t              next;
+  sc_search_index_t  *index;
+
+  SC_ASSERT (elem_size > 0);
+
+  index = SC_ALLOC (sc_search_index_t, 1);
+  index->nmemb = nmemb;
+  index->elem_size = elem_size;
+  index->compar = compar;
+  index->stride = SC_MAX (SC_SEARCH_INDEX_LINE / elem_size, 1);
+  for (index->levels = 0;
+       ((size_t) 1 << (index->levels + 1)) - 1 <= nmemb; ++index->levels);
+
+  /* node 0 is a sentinel and the tree is aligned to the cache lines */
+  index->alloc = SC_ALLOC (char, (nmemb + 1) * elem_size +
+                           SC_SEARCH_INDEX_LINE);
+  index->tree = index->alloc + SC_SEARCH_INDEX_LINE -
+    (size_t) index->alloc % SC_SEARCH_INDEX_LINE;
+  memset (index->tree, 0, elem_size);
+  index->position = SC_ALLOC (size_t, nmemb + 1);
+  index->position[0] = 0;
+
+  next = 0;
+  sc_search_index_fill (index, (const char *) sorted, &next, 1);
+  SC_ASSERT (next == nmemb);
+
+  return index;
+}
+
+sc_search_index_t  *
+sc_search_index_new (sc_array_t * array,
+                     int (*compar) (const void *, const void *))
+{
+  SC_ASSERT (compar != NULL);
+
+  return sc_search_index_build (array->array, array->elem_count,
+                                array->elem_size, compar);
+}
+
+sc_search_index_t  *
+sc_search_index_new64 (const int64_t * array, size_t nmemb)
+{
+  return sc_search_index_build (array, nmemb, sizeof (int64_t), NULL);
+}
+
+void
+sc_search_index_destroy (sc_search_index_t * index)
+{
+  SC_FREE (index->alloc);
+  SC_FREE (index->position);
+  SC_FREE (index);
+}
+
+/** Translate the node after the descent into a sorted position.
+ * The descent went right from the result and left everywhere below it,
+ * so we strip the trailing right turns and the final left turn.
+ */
+static inline ssize_t
+sc_search_index_result (sc_search_index_t * index, size_t k)
+{
+#ifdef __GNUC__
+  k >>= __builtin_ctzll (~(unsigned long long) k) + 1;
+#else
+  while (k & 1) {
+    k >>= 1;
+  }
+  k >>= 1;
+#endif
+  return k == 0 ? -1 : (ssize_t) index->position[k];
+}
+
+ssize_t
+sc_search_index_lower_bound (sc_search_index_t * index, const void *key)
+{
+  const size_t        es = index->elem_size;
+  const char         *tree = index->tree;
+  size_t              k;
+  int                 level;
+
+  SC_ASSERT (index->compar != NULL);
+
+  k = 1;
+  for (level = 0; level < index->levels; ++level) {
+    SC_SEARCH_INDEX_PREFETCH (tree + k * index->stride * es);
+    k = 2 * k + (index->compar (tree + k * es, key) < 0);
+  }
+
+  /* the last level may be incomplete; the user's comparison must not see
+   * the zeroed sentinel node, since it may dereference the contents */
+  if (k <= index->nmemb) {
+    k = 2 * k + (index->compar (tree + k * es, key) < 0);
+  }
+  return sc_search_index_result (index, k);
+}
+
+ssize_t
+sc_search_index_lower_bound64 (sc_search_index_t * index, int64_t target)
+{
+  const int64_t      *tree = (const int64_t *) index->tree;
+  size_t              k, c;
+  int                 level;
+
+  SC_ASSERT (index->compar == NULL);
+
+  k = 1;
+  for (level = 0; level < index->levels; ++level) {
+    SC_SEARCH_INDEX_PREFETCH (tree + k * index->stride);
+    k = 2 * k + (tree[k] < target);
+  }
+
+  /* the last level may be incomplete; then compare to the sentinel node,
+   * which is harmless to read for plain integers and avoids a branch */
+  c = k <= index->nmemb;
+  k = (k << c) | (c & (size_t) (tree[c * k] < target));
+  return sc_search_index_result (index, k);
+}
+
+void
+sc_search_index_lower_bound_batch (sc_search_index_t * index,
+                                   const void *keys, size_t num_keys,
+                                   ssize_t * positions)
+{
+  const size_t        es = index->elem_size;
+  const char         *tree = index->tree;
+  const char         *ckeys = (const char *) keys;
+  size_t              k[SC_SEARCH_INDEX_BATCH];
+  size_t              first, num, j;
+  int                 level;
+
+  SC_ASSERT (index->compar != NULL);
+
+  for (first = 0; first < num_keys; first += num) {
+    num = SC_MIN (num_keys - first, SC_SEARCH_INDEX_BATCH);
+    for (j = 0; j < num; ++j) {
+      k[j] = 1;
+    }
+
+    /* advance all searches of the batch by one level at a time */
+    for (level = 0; level < index->levels; ++level) {
+      for (j = 0; j < num; ++j) {
+        SC_SEARCH_INDEX_PREFETCH (tree + k[j] * index->stride * es);
+        k[j] = 2 * k[j] +
+          (index->compar (tree + k[j] * es, ckeys + (first + j) * es) < 0);
+      }
+    }
+
+    /* the last level may be incomplete; skip the sentinel as above */
+    for (j = 0; j < num; ++j) {
+      if (k[j] <= index->nmemb) {
+        k[j] = 2 * k[j] +
+          (index->compar (tree + k[j] * es, ckeys + (first + j) * es) < 0);
+      }
+      positions[first + j] = sc_search_index_result (index, k[j]);
+    }
+  }
+}
+
+void
+sc_search_index_lower_bound64_batch (sc_search_index_t * index,
+                                     const int64_t * targets,
+                                     size_t num_targets, ssize_t * positions)
+{
+  const int64_t      *tree = (const int64_t *) index->tree;
+  size_t              k[SC_SEARCH_INDEX_BATCH];
+  size_t              first, num, j, c;
+  int                 level;
+
+  SC_ASSERT (index->compar == NULL);
+
+  for (first = 0; first < num_targets; first += num) {
+    num = SC_MIN (num_targets - first, SC_SEARCH_INDEX_BATCH);
+    for (j = 0; j < num; ++j) {
+      k[j] = 1;
+    }
+
+    /* advance all searches of the batch by one level at a time */
+    for (level = 0; level < index->levels; ++level) {
+      for (j = 0; j < num; ++j) {
+        SC_SEARCH_INDEX_PREFETCH (tree + k[j] * index->stride);
+        k[j] = 2 * k[j] + (tree[k[j]] < targets[first + j]);
+      }
+    }
+
+    /* the last level may be incomplete as above */
+    for (j = 0; j < num; ++j) {
+      c = k[j] <= index->nmemb;
+      k[j] = (k[j] << c) | (c & (size_t) (tree[c * k[j]] <
+                                          targets[first + j]));
+      positions[first + j] = sc_search_index_result (index, k[j]);
+    }
+  }
+}
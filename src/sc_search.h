@@ -24,7 +24,7 @@
 #ifndef SC_SEARCH_H
 #define SC_SEARCH_H
 
-#include <sc.h>
+#include <sc_containers.h>
 
 SC_EXTERN_C_BEGIN;
 
@@ -67,6 +67,98 @@ size_t              sc_bsearch_range (const void *key, const void *base,
                                       int (*compar) (const void *,
                                                      const void *));
 
+/** A read-only search index for a sorted array.
+ * The elements are copied into the breadth-first order of a binary search
+ * tree (Eytzinger layout), such that the first levels of every search share
+ * the same few cache lines and the nodes of later levels can be prefetched.
+ * The queries descend the tree without data-dependent branches.
+ */
+typedef struct sc_search_index
+{
+  size_t              nmemb;            /**< Number of indexed elements */
+  size_t              elem_size;        /**< Size of one element in bytes */
+  int                 (*compar) (const void *, const void *);
+                                        /**< Comparison, NULL for int64_t */
+  int                 levels;           /**< Number of complete tree levels */
+  size_t              stride;           /**< Tree nodes per cache line */
+  char               *tree;             /**< Nodes from index 1, aligned */
+  size_t             *position;         /**< Sorted position of each node */
+  char               *alloc;            /**< Memory of the tree */
+}
+sc_search_index_t;
+
+/** Create a search index from a copy of a sorted array.
+ * \param [in] array   Array sorted with respect to \a compar.
+ *                     It may be modified or destroyed afterwards.
+ * \param [in] compar  Comparison function as used for sorting.
+ * \return             A new search index.
+ */
+sc_search_index_t  *sc_search_index_new (sc_array_t * array,
+                                         int (*compar) (const void *,
+                                                        const void *));
+
+/** Create a search index from a copy of a sorted int64_t array.
+ * This may be a partition array, and the queries are specialized to int64_t.
+ * \param [in] array   The sorted 64bit integer array to index.
+ * \param [in] nmemb   The number of int64_t's in the array.
+ * \return             A new search index.
+ */
+sc_search_index_t  *sc_search_index_new64 (const int64_t * array,
+                                           size_t nmemb);
+
+/** Free the memory of a search index.
+ * \param [in] index   The search index is invalid after this call.
+ */
+void                sc_search_index_destroy (sc_search_index_t * index);
+
+/** Find lowest position k in the indexed array such that array[k] >= key.
+ * \param [in] index   A search index created by sc_search_index_new.
+ * \param [in] key     Pointer to the key, which is passed to the comparison.
+ * \return  Returns the matching position in the sorted array,
+ *          or -1 if array[nmemb-1] < key or if nmemb == 0.
+ */
+ssize_t             sc_search_index_lower_bound (sc_search_index_t * index,
+                                                 const void *key);
+
+/** Find lowest position k in the indexed array such that array[k] >= target.
+ * \param [in] index   A search index created by sc_search_index_new64.
+ * \param [in] target  The target lower bound to search for.
+ * \return  Returns the matching position as sc_search_lower_bound64 would.
+ */
+ssize_t             sc_search_index_lower_bound64 (sc_search_index_t *
+                                                   index, int64_t target);
+
+/** Find the lower bounds of many keys at once.
+ * The searches are interleaved to overlap the latency of their memory
+ * accesses, which is faster than calling sc_search_index_lower_bound in a
+ * loop when the keys are not sorted.
+ * \param [in] index       A search index created by sc_search_index_new.
+ * \param [in] keys        Array of \a num_keys keys of the indexed size.
+ * \param [in] num_keys    Number of keys to search for.
+ * \param [out] positions  Array of \a num_keys results, each one as
+ *                         returned by sc_search_index_lower_bound.
+ */
+void                sc_search_index_lower_bound_batch (sc_search_index_t *
+                                                       index,
+                                                       const void *keys,
+                                                       size_t num_keys,
+                                                       ssize_t * positions);
+
+/** Find the lower bounds of many int64_t targets at once.
+ * \param [in] index       A search index created by sc_search_index_new64.
+ * \param [in] targets     Array of \a num_targets targets.
+ * \param [in] num_targets Number of targets to search for.
+ * \param [out] positions  Array of \a num_targets results, each one as
+ *                         returned by sc_search_index_lower_bound64.
+ */
+void                sc_search_index_lower_bound64_batch (sc_search_index_t
+                                                         * index,
+                                                         const int64_t *
+                                                         targets,
+                                                         size_t num_targets,
+                                                         ssize_t *
+                                                         positions);
+
 SC_EXTERN_C_END;
 
 #endif /* !SC_SEARCH_H */
@@ -0,0 +1,191 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_thread.h>
+#ifdef SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+void
+sc_thread_mutex_init (sc_thread_mutex_t * mutex)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_init (&mutex->mutex, NULL);
+  SC_CHECK_ABORT (pth == 0, "sc_thread_mutex_init");
+#elif defined SC_ENABLE_OPENMP
+  omp_init_lock (&mutex->mutex);
+#else
+  mutex->mutex = 0;
+#endif
+}
+
+void
+sc_thread_mutex_destroy (sc_thread_mutex_t * mutex)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_destroy (&mutex->mutex);
+  SC_CHECK_ABORT (pth == 0, "sc_thread_mutex_destroy");
+#elif defined SC_ENABLE_OPENMP
+  omp_destroy_lock (&mutex->mutex);
+#else
+  SC_ASSERT (mutex->mutex == 0);
+#endif
+}
+
+void
+sc_thread_mutex_lock (sc_thread_mutex_t * mutex)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_lock (&mutex->mutex);
+  SC_CHECK_ABORT (pth == 0, "sc_thread_mutex_lock");
+#elif defined SC_ENABLE_OPENMP
+  omp_set_lock (&mutex->mutex);
+#else
+  SC_ASSERT (mutex->mutex == 0);
+  SC_EXECUTE_ASSERT_TRUE (++mutex->mutex);
+#endif
+}
+
+void
+sc_thread_mutex_unlock (sc_thread_mutex_t * mutex)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 pth;
+
+  pth = pthread_mutex_unlock (&mutex->mutex);
+  SC_CHECK_ABORT (pth == 0, "sc_thread_mutex_unlock");
+#elif defined SC_ENABLE_OPENMP
+  omp_unset_lock (&mutex->mutex);
+#else
+  SC_ASSERT (mutex->mutex == 1);
+  SC_EXECUTE_ASSERT_FALSE (--mutex->mutex);
+#endif
+}
+
+int
+sc_thread_is_parallel (void)
+{
+#if defined SC_ENABLE_PTHREAD || defined SC_ENABLE_OPENMP
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+int
+sc_thread_max_threads (void)
+{
+#ifdef SC_ENABLE_OPENMP
+  return omp_get_max_threads ();
+#elif defined SC_ENABLE_PTHREAD
+  long                nproc;
+
+  nproc = sysconf (_SC_NPROCESSORS_ONLN);
+  return nproc > 0 ? (int) nproc : 1;
+#else
+  return 1;
+#endif
+}
+
+#ifdef SC_ENABLE_PTHREAD
+
+typedef struct sc_thread_member
+{
+  pthread_t           thread;
+  int                 thread_id;
+  int                 num_threads;
+  sc_thread_team_fn_t fn;
+  void               *data;
+}
+sc_thread_member_t;
+
+static void        *
+sc_thread_member_start (void *v)
+{
+  sc_thread_member_t *member = (sc_thread_member_t *) v;
+
+  member->fn (member->thread_id, member->num_threads, member->data);
+  return NULL;
+}
+
+#endif /* SC_ENABLE_PTHREAD */
+
+void
+sc_thread_team_run (int num_threads, sc_thread_team_fn_t fn, void *data)
+{
+#ifdef SC_ENABLE_PTHREAD
+  int                 i;
+  int                 pth;
+  sc_thread_member_t *members;
+#elif !defined SC_ENABLE_OPENMP
+  int                 i;
+#endif
+
+  SC_ASSERT (num_threads >= 1);
+
+  if (num_threads == 1) {
+    fn (0, 1, data);
+    return;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  /* the calling thread executes member 0 itself */
+  members = SC_ALLOC (sc_thread_member_t, num_threads);
+  for (i = 1; i < num_threads; ++i) {
+    members[i].thread_id = i;
+    members[i].num_threads = num_threads;
+    members[i].fn = fn;
+    members[i].data = data;
+    pth = pthread_create (&members[i].thread, NULL,
+                          sc_thread_member_start, &members[i]);
+    SC_CHECK_ABORT (pth == 0, "sc_thread_team_run create");
+  }
+  fn (0, num_threads, data);
+  for (i = 1; i < num_threads; ++i) {
+    pth = pthread_join (members[i].thread, NULL);
+    SC_CHECK_ABORT (pth == 0, "sc_thread_team_run join");
+  }
+  SC_FREE (members);
+#elif defined SC_ENABLE_OPENMP
+#pragma omp parallel num_threads (num_threads)
+  {
+    /* the runtime may provide fewer threads than requested */
+    int                 t;
+
+    for (t = omp_get_thread_num (); t < num_threads;
+         t += omp_get_num_threads ()) {
+      fn (t, num_threads, data);
+    }
+  }
+#else
+  for (i = 0; i < num_threads; ++i) {
+    fn (i, num_threads, data);
+  }
+#endif
+}
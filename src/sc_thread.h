@@ -0,0 +1,110 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+/** \file sc_thread.h
+ *
+ * Minimal threading support shared by the thread-aware containers.
+ * It provides a mutex and a way to run a function on a team of threads.
+ * With --enable-pthread, mutexes are POSIX mutexes and teams are POSIX
+ * threads.  With only --enable-openmp, both are provided by OpenMP.
+ * Without either, mutexes do nothing and a team executes its members one
+ * after the other, which is correct for algorithms that do not need the
+ * members to wait for each other.
+ */
+
+#ifndef SC_THREAD_H
+#define SC_THREAD_H
+
+#include <sc.h>
+
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#elif defined SC_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+SC_EXTERN_C_BEGIN;
+
+/** A mutex that works with the configured threading backend. */
+typedef struct sc_thread_mutex
+{
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_t     mutex;
+#elif defined SC_ENABLE_OPENMP
+  omp_lock_t          mutex;
+#else
+  int                 mutex;
+#endif
+}
+sc_thread_mutex_t;
+
+/** Function executed by every member of a thread team.
+ * \param [in] thread_id    Number of this member from 0 to num_threads - 1.
+ * \param [in] num_threads  Number of members of the team.
+ * \param [in,out] data     User data passed to \ref sc_thread_team_run.
+ */
+typedef void        (*sc_thread_team_fn_t) (int thread_id, int num_threads,
+                                            void *data);
+
+/** Initialize a mutex.
+ * \param [out] mutex       The mutex is unlocked on output.
+ */
+void                sc_thread_mutex_init (sc_thread_mutex_t * mutex);
+
+/** Destroy a mutex that is not locked.
+ * \param [in,out] mutex    The mutex must not be used afterwards.
+ */
+void                sc_thread_mutex_destroy (sc_thread_mutex_t * mutex);
+
+/** Lock a mutex, waiting for other threads to release it if necessary.
+ * \param [in,out] mutex    Initialized mutex.
+ */
+void                sc_thread_mutex_lock (sc_thread_mutex_t * mutex);
+
+/** Unlock a mutex held by the calling thread.
+ * \param [in,out] mutex    Mutex locked by the calling thread.
+ */
+void                sc_thread_mutex_unlock (sc_thread_mutex_t * mutex);
+
+/** Return true if a team may execute its members concurrently. */
+int                 sc_thread_is_parallel (void);
+
+/** Return the default number of threads for a team.
+ * This is the OpenMP maximum thread count if OpenMP is enabled, otherwise
+ * the number of online processors with POSIX threads, and 1 without threads.
+ */
+int                 sc_thread_max_threads (void);
+
+/** Run a function on a team of threads and wait for all of them to return.
+ * The calling thread participates as member 0.  The members must not wait
+ * for each other, since the team may be executed sequentially.
+ * \param [in] num_threads  Number of members, at least 1.
+ * \param [in] fn           Function executed by every member.
+ * \param [in,out] data     Passed through to the function.
+ */
+void                sc_thread_team_run (int num_threads,
+                                        sc_thread_team_fn_t fn, void *data);
+
+SC_EXTERN_C_END;
+
+#endif /* !SC_THREAD_H */
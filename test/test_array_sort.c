@@ -0,0 +1,355 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_uint128.h>
+
+/* #define THEBIGTEST */
+
+/** A record whose key is in the middle. */
+typedef struct test_small
+{
+  double              value;
+  int64_t             key;
+  size_t              position;
+}
+test_small_t;
+
+/** A record large enough to be sorted by way of indices. */
+typedef struct test_large
+{
+  char                payload[40];
+  int32_t             key;
+  size_t              position;
+}
+test_large_t;
+
+static uint64_t
+test_random (uint64_t * state)
+{
+  /* xorshift64* */
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+static int
+test_int32_compare (const void *v1, const void *v2)
+{
+  const int32_t       i1 = *(const int32_t *) v1;
+  const int32_t       i2 = *(const int32_t *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+static int
+test_small_compare (const void *v1, const void *v2)
+{
+  const test_small_t *s1 = (const test_small_t *) v1;
+  const test_small_t *s2 = (const test_small_t *) v2;
+
+  if (s1->key != s2->key) {
+    return s1->key < s2->key ? -1 : 1;
+  }
+  return s1->position < s2->position ? -1 : s1->position > s2->position;
+}
+
+static int
+test_large_compare (const void *v1, const void *v2)
+{
+  const test_large_t *l1 = (const test_large_t *) v1;
+  const test_large_t *l2 = (const test_large_t *) v2;
+
+  if (l1->key != l2->key) {
+    return l1->key < l2->key ? -1 : 1;
+  }
+  return l1->position < l2->position ? -1 : l1->position > l2->position;
+}
+
+/** Sort a copy with qsort and with both radix variants and compare.
+ * \param [in] compar   Must order the elements totally.
+ */
+static void
+test_sort_compare (const char *name, sc_array_t * input,
+                   int (*compar) (const void *, const void *),
+                   sc_array_key_t key_type, size_t key_offset,
+                   int (*key_compar) (const void *, const void *))
+{
+  size_t              zz;
+  double              elapsed_qsort, elapsed_stable, elapsed_msd;
+  sc_array_t         *expected, *sorted;
+
+  expected = sc_array_new_count (input->elem_size, input->elem_count);
+  sorted = sc_array_new_count (input->elem_size, input->elem_count);
+
+  sc_array_copy (expected, input);
+  elapsed_qsort = -sc_MPI_Wtime ();
+  sc_array_sort (expected, compar);
+  elapsed_qsort += sc_MPI_Wtime ();
+
+  /* the stable sort reproduces the total order */
+  sc_array_copy (sorted, input);
+  elapsed_stable = -sc_MPI_Wtime ();
+  sc_array_sort_radix (sorted, key_type, key_offset, 1);
+  elapsed_stable += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (sc_array_is_equal (sorted, expected), "Radix stable");
+
+  /* the unstable sort agrees in the keys */
+  sc_array_copy (sorted, input);
+  elapsed_msd = -sc_MPI_Wtime ();
+  sc_array_sort_radix (sorted, key_type, key_offset, 0);
+  elapsed_msd += sc_MPI_Wtime ();
+  for (zz = 0; zz < input->elem_count; ++zz) {
+    SC_CHECK_ABORT (!key_compar (sc_array_index (sorted, zz),
+                                 sc_array_index (expected, zz)),
+                    "Radix unstable");
+  }
+  sc_array_sort (sorted, compar);
+  SC_CHECK_ABORT (sc_array_is_equal (sorted, expected), "Radix content");
+
+  SC_GLOBAL_STATISTICSF ("Sort %s count %lu qsort %g radix stable %g"
+                         " in place %g\n", name,
+                         (unsigned long) input->elem_count,
+                         elapsed_qsort, elapsed_stable, elapsed_msd);
+
+  sc_array_destroy (sorted);
+  sc_array_destroy (expected);
+}
+
+static int
+test_small_key_compare (const void *v1, const void *v2)
+{
+  return ((const test_small_t *) v1)->key != ((const test_small_t *) v2)->key;
+}
+
+static int
+test_large_key_compare (const void *v1, const void *v2)
+{
+  return ((const test_large_t *) v1)->key != ((const test_large_t *) v2)->key;
+}
+
+static void
+test_radix (size_t count)
+{
+  size_t              zz;
+  uint64_t            state = 0x2545F4914F6CDD1DULL;
+  int32_t            *pi;
+  int64_t            *pl;
+  sc_uint128_t       *pu;
+  test_small_t       *ps;
+  test_large_t       *pg;
+  sc_array_t         *a;
+
+  /* plain signed integers with duplicates */
+  a = sc_array_new_count (sizeof (int32_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    pi = (int32_t *) sc_array_index (a, zz);
+    *pi = (int32_t) (test_random (&state) % (count / 2 + 1)) -
+      (int32_t) (count / 4);
+  }
+  test_sort_compare ("int32", a, test_int32_compare,
+                     SC_ARRAY_KEY_INT32, 0, test_int32_compare);
+  sc_array_destroy (a);
+
+  /* plain 64-bit integers over the full range */
+  a = sc_array_new_count (sizeof (int64_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    pl = (int64_t *) sc_array_index (a, zz);
+    *pl = (int64_t) test_random (&state);
+  }
+  test_sort_compare ("int64", a, sc_int64_compare,
+                     SC_ARRAY_KEY_INT64, 0, sc_int64_compare);
+  sc_array_destroy (a);
+
+  /* 128-bit integers that differ in both halves */
+  a = sc_array_new_count (sizeof (sc_uint128_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    pu = (sc_uint128_t *) sc_array_index (a, zz);
+    sc_uint128_init (pu, test_random (&state) % 7, test_random (&state));
+  }
+  test_sort_compare ("uint128", a, sc_uint128_compare,
+                     SC_ARRAY_KEY_UINT128, 0, sc_uint128_compare);
+  sc_array_destroy (a);
+
+  /* records with a key at an offset */
+  a = sc_array_new_count (sizeof (test_small_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    ps = (test_small_t *) sc_array_index (a, zz);
+    ps->value = (double) zz;
+    ps->key = (int64_t) (test_random (&state) % 1000) - 500;
+    ps->position = zz;
+  }
+  test_sort_compare ("small", a, test_small_compare, SC_ARRAY_KEY_INT64,
+                     offsetof (test_small_t, key), test_small_key_compare);
+  sc_array_destroy (a);
+
+  a = sc_array_new_count (sizeof (test_large_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    pg = (test_large_t *) sc_array_index (a, zz);
+    memset (pg->payload, (int) zz, sizeof (pg->payload));
+    pg->key = (int32_t) (test_random (&state) % 100000) - 50000;
+    pg->position = zz;
+  }
+  test_sort_compare ("large", a, test_large_compare, SC_ARRAY_KEY_INT32,
+                     offsetof (test_large_t, key), test_large_key_compare);
+  sc_array_destroy (a);
+}
+
+static int
+test_small_order (const void *v1, const void *v2)
+{
+  const test_small_t *s1 = (const test_small_t *) v1;
+  const test_small_t *s2 = (const test_small_t *) v2;
+
+  return s1->key < s2->key ? -1 : s1->key > s2->key;
+}
+
+static size_t
+test_small_type (sc_array_t * array, size_t index, void *data)
+{
+  const test_small_t *ps = (const test_small_t *) sc_array_index (array,
+                                                                   index);
+
+  return (size_t) (ps->key + 500) / *(size_t *) data;
+}
+
+/** Compare the threaded sort, uniq and split with the serial ones. */
+static void
+test_threads (size_t count)
+{
+  const int           thread_counts[] = { 1, 2, 3, 4, 8 };
+  int                 i, num_threads;
+  size_t              zz, num_types, width;
+  size_t             *zp;
+  uint64_t            state = 0x9E3779B97F4A7C15ULL;
+  double              elapsed_sort, elapsed_uniq, elapsed_split;
+  test_small_t       *ps;
+  sc_array_t         *input, *expected, *sorted;
+  sc_array_t         *offsets, *expected_offsets;
+
+  input = sc_array_new_count (sizeof (test_small_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    ps = (test_small_t *) sc_array_index (input, zz);
+    ps->value = (double) zz;
+    ps->key = (int64_t) (test_random (&state) % 1000) - 500;
+    ps->position = zz;
+  }
+  expected = sc_array_new_count (sizeof (test_small_t), count);
+  sorted = sc_array_new_count (sizeof (test_small_t), count);
+  offsets = sc_array_new (sizeof (size_t));
+  expected_offsets = sc_array_new (sizeof (size_t));
+  width = 7;
+  num_types = 1000 / width + 1;
+
+  for (i = 0; i < (int) (sizeof (thread_counts) / sizeof (int)); ++i) {
+    num_threads = thread_counts[i];
+
+    /* sorting by key alone must keep the input order of equal keys */
+    sc_array_copy (expected, input);
+    sc_array_sort (expected, test_small_compare);
+    sc_array_copy (sorted, input);
+    elapsed_sort = -sc_MPI_Wtime ();
+    sc_array_sort_threads (sorted, test_small_order, num_threads);
+    elapsed_sort += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (sc_array_is_equal (sorted, expected), "Sort threads");
+
+    /* removing duplicate keys */
+    sc_array_uniq (expected, test_small_order);
+    elapsed_uniq = -sc_MPI_Wtime ();
+    sc_array_uniq_threads (sorted, test_small_order, num_threads);
+    elapsed_uniq += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (sc_array_is_equal (sorted, expected), "Uniq threads");
+
+    /* splitting sorted input leaves it unchanged */
+    sc_array_copy (expected, input);
+    sc_array_sort (expected, test_small_compare);
+    sc_array_copy (sorted, expected);
+    sc_array_split (expected, expected_offsets, num_types,
+                    test_small_type, &width);
+    sc_array_split_threads (sorted, offsets, num_types,
+                            test_small_type, &width, num_threads);
+    SC_CHECK_ABORT (sc_array_is_equal (sorted, expected), "Split sorted");
+    SC_CHECK_ABORT (sc_array_is_equal (offsets, expected_offsets),
+                    "Split sorted offsets");
+
+    /* splitting unsorted input groups by type in the input order */
+    sc_array_copy (sorted, input);
+    elapsed_split = -sc_MPI_Wtime ();
+    sc_array_split_threads (sorted, offsets, num_types,
+                            test_small_type, &width, num_threads);
+    elapsed_split += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (sc_array_is_equal (offsets, expected_offsets),
+                    "Split offsets");
+    zp = (size_t *) offsets->array;
+    for (zz = 0; zz < count; ++zz) {
+      ps = (test_small_t *) sc_array_index (sorted, zz);
+      while (zz >= zp[1]) {
+        ++zp;
+      }
+      SC_CHECK_ABORT (test_small_type (sorted, zz, &width) ==
+                      (size_t) (zp - (size_t *) offsets->array), "Split type");
+      SC_CHECK_ABORT (zz == zp[0] ||
+                      ps[-1].position < ps->position, "Split order");
+    }
+
+    SC_GLOBAL_STATISTICSF ("Threads %d count %lu sort %g uniq %g split %g\n",
+                           num_threads, (unsigned long) count,
+                           elapsed_sort, elapsed_uniq, elapsed_split);
+  }
+
+  sc_array_destroy (expected_offsets);
+  sc_array_destroy (offsets);
+  sc_array_destroy (sorted);
+  sc_array_destroy (expected);
+  sc_array_destroy (input);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              count;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef THEBIGTEST
+  count = 20000000;
+#else
+  count = 200000;
+#endif
+  test_radix (17);
+  test_radix (count);
+  test_threads (17);
+  test_threads (count);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -23,6 +23,8 @@
 
 #include <sc_containers.h>
 
+/* #define THEBIGTEST */
+
 static              ssize_t
 sc_array_bsearch_range (sc_array_t * array, size_t begin, size_t end,
                         const void *key, int (*compar) (const void *,
@@ -144,10 +146,274 @@ test_mstamp (void)
   }
 }
 
+/** A 24-byte record that knows its original position. */
+typedef struct test_record
+{
+  size_t              position;
+  double              value;
+  int                 tag;
+}
+test_record_t;
+
+static void
+test_policy (int huge, int numa_node, int first_touch)
+{
+  const size_t        N = 3 * SC_PAGES_HUGE_SIZE / sizeof (size_t);
+  size_t              zz, stamp_size, min_size;
+  size_t             *ps;
+  sc_pages_policy_t   policy;
+  sc_array_t         *a;
+  sc_mempool_t       *mempool;
+  sc_mstamp_t         mst;
+
+  sc_pages_policy_init (&policy);
+  policy.huge = huge;
+  policy.numa_node = numa_node;
+  policy.first_touch = first_touch;
+
+  /* a small array is moved into mapped memory when it grows */
+  a = sc_array_new_count (sizeof (size_t), 100);
+  for (zz = 0; zz < 100; ++zz) {
+    *(size_t *) sc_array_index (a, zz) = zz;
+  }
+  sc_array_set_policy (a, &policy);
+  sc_array_resize (a, N);
+  for (zz = 0; zz < N; ++zz) {
+    ps = (size_t *) sc_array_index (a, zz);
+    SC_CHECK_ABORT (zz >= 100 || *ps == zz, "Policy resize");
+    *ps = zz;
+  }
+  SC_GLOBAL_INFOF ("Policy %d array bytes %lld huge %lld\n", huge,
+                   (long long) a->byte_alloc,
+                   (long long) sc_array_huge_bytes (a));
+  sc_array_resize (a, N / 4);
+  for (zz = 0; zz < N / 4; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (a, zz) == zz,
+                    "Policy shrink");
+  }
+  sc_array_set_policy (a, NULL);
+  for (zz = 0; zz < N / 4; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (a, zz) == zz,
+                    "Policy unset");
+  }
+  sc_array_destroy (a);
+
+  /* the stamps of a pool are enlarged to the mapping unit */
+  for (zz = 0; zz < 2; ++zz) {
+    /* the second pool keeps an intrusive free list */
+    mempool = zz == 0 ? sc_mempool_new (sizeof (size_t)) :
+      sc_mempool_new_intrusive (sizeof (size_t));
+    sc_mempool_free (mempool, sc_mempool_alloc (mempool));
+    sc_mempool_set_policy (mempool, &policy);
+    ps = (size_t *) sc_mempool_alloc (mempool);
+    *ps = zz;
+    sc_mempool_free (mempool, ps);
+    sc_mempool_destroy (mempool);
+  }
+  mempool = sc_mempool_new (sizeof (size_t));
+  sc_mempool_set_policy (mempool, &policy);
+  for (zz = 0; zz < N; ++zz) {
+    ps = (size_t *) sc_mempool_alloc (mempool);
+    *ps = zz;
+  }
+  SC_GLOBAL_INFOF ("Policy %d mempool bytes %lld huge %lld\n", huge,
+                   (long long) sc_mempool_memory_used (mempool),
+                   (long long) sc_mempool_huge_bytes (mempool));
+  sc_mempool_destroy (mempool);
+
+  /* stamps of items that do not divide the unit are rounded up */
+  min_size = SC_MAX (sc_pages_unit (&policy), policy.min_bytes);
+  sc_mstamp_init (&mst, 4096, sizeof (test_record_t));
+  stamp_size = mst.stamp_size;
+  sc_mstamp_set_policy (&mst, &policy);
+  SC_CHECK_ABORT (mst.stamp_size >= min_size &&
+                  mst.stamp_size == mst.per_stamp * sizeof (test_record_t),
+                  "Policy stamp size");
+  sc_mstamp_set_policy (&mst, NULL);
+  SC_CHECK_ABORT (mst.stamp_size == stamp_size, "Policy stamp unset");
+  sc_mstamp_reset (&mst);
+
+  mempool = sc_mempool_new (sizeof (test_record_t));
+  sc_mempool_set_policy (mempool, &policy);
+#ifdef SC_MEMPOOL_MSTAMP
+  SC_CHECK_ABORT (mempool->mstamp.stamp_size >= min_size,
+                  "Policy mempool stamp size");
+#endif
+  for (zz = 0; zz < N; ++zz) {
+    ((test_record_t *) sc_mempool_alloc (mempool))->position = zz;
+  }
+  SC_GLOBAL_INFOF ("Policy %d record mempool bytes %lld huge %lld\n", huge,
+                   (long long) sc_mempool_memory_used (mempool),
+                   (long long) sc_mempool_huge_bytes (mempool));
+  sc_mempool_destroy (mempool);
+}
+
+/** Compare the in-place and bucketed permutations and their validation. */
+static void
+test_permute (size_t count)
+{
+  const int           thread_counts[] = { 1, 2, 3, 4 };
+  int                 i;
+  size_t              zz, zj, swap;
+  size_t             *perm;
+  double              elapsed_inplace, elapsed_copy, elapsed_is;
+  test_record_t      *pr;
+  sc_array_t         *a, *expected, *b, *p;
+
+  /* a random permutation */
+  p = sc_array_new_count (sizeof (size_t), count);
+  perm = (size_t *) p->array;
+  for (zz = 0; zz < count; ++zz) {
+    perm[zz] = zz;
+  }
+  for (zz = count; zz > 1; --zz) {
+    zj = (size_t) rand () * ((size_t) RAND_MAX + 1) + (size_t) rand ();
+    zj %= zz;
+    swap = perm[zz - 1];
+    perm[zz - 1] = perm[zj];
+    perm[zj] = swap;
+  }
+
+  a = sc_array_new_count (sizeof (test_record_t), count);
+  for (zz = 0; zz < count; ++zz) {
+    pr = (test_record_t *) sc_array_index (a, zz);
+    pr->position = zz;
+    pr->value = (double) zz;
+    pr->tag = (int) zz;
+  }
+
+  /* the in-place cycles are the reference */
+  expected = sc_array_new (sizeof (test_record_t));
+  sc_array_copy (expected, a);
+  elapsed_inplace = -sc_MPI_Wtime ();
+  sc_array_permute (expected, p, 1);
+  elapsed_inplace += sc_MPI_Wtime ();
+  for (zz = 0; zz < count; ++zz) {
+    pr = (test_record_t *) sc_array_index (expected, perm[zz]);
+    SC_CHECK_ABORT (pr->position == zz, "Permute in place");
+  }
+
+  b = sc_array_new (sizeof (test_record_t));
+  for (i = 0; i < (int) (sizeof (thread_counts) / sizeof (int)); ++i) {
+    elapsed_copy = -sc_MPI_Wtime ();
+    sc_array_permute_copy (b, a, p, thread_counts[i]);
+    elapsed_copy += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (sc_array_is_equal (b, expected), "Permute copy");
+
+    elapsed_is = -sc_MPI_Wtime ();
+    SC_CHECK_ABORT (sc_array_is_permutation_threads (p, thread_counts[i]),
+                    "Is permutation");
+    elapsed_is += sc_MPI_Wtime ();
+
+    SC_GLOBAL_STATISTICSF ("Permute count %lu threads %d in place %g"
+                           " copy %g check %g\n", (unsigned long) count,
+                           thread_counts[i], elapsed_inplace, elapsed_copy,
+                           elapsed_is);
+  }
+
+  /* a duplicate and an index out of range are detected */
+  if (count > 1) {
+    swap = perm[count - 1];
+    perm[count - 1] = perm[0];
+    SC_CHECK_ABORT (!sc_array_is_permutation_threads (p, 2), "Duplicate");
+    SC_CHECK_ABORT (!sc_array_is_permutation (p), "Duplicate serial");
+    perm[count - 1] = count;
+    SC_CHECK_ABORT (!sc_array_is_permutation_threads (p, 3), "Range");
+    perm[count - 1] = swap;
+    SC_CHECK_ABORT (sc_array_is_permutation_threads (p, 3), "Restored");
+  }
+
+  sc_array_destroy (b);
+  sc_array_destroy (expected);
+  sc_array_destroy (a);
+  sc_array_destroy (p);
+}
+
+/** Grow an array by doubling and time the reallocations of its memory. */
+static void
+test_grow (size_t bytes)
+{
+  size_t              count, old_count, zz;
+  double              elapsed_resize, elapsed_touch;
+  double             *pd;
+  sc_array_t         *a;
+
+  a = sc_array_new (sizeof (double));
+  elapsed_resize = elapsed_touch = 0.;
+  for (count = 1; count * sizeof (double) <= bytes; count *= 2) {
+    old_count = a->elem_count;
+    elapsed_resize -= sc_MPI_Wtime ();
+    sc_array_resize (a, count);
+    elapsed_resize += sc_MPI_Wtime ();
+
+    /* write the new elements such that their pages exist when growing */
+    elapsed_touch -= sc_MPI_Wtime ();
+    pd = (double *) a->array;
+    for (zz = old_count; zz < count; ++zz) {
+      pd[zz] = (double) zz;
+    }
+    elapsed_touch += sc_MPI_Wtime ();
+  }
+  pd = (double *) a->array;
+  for (zz = 1; zz < a->elem_count; zz *= 3) {
+    SC_CHECK_ABORT (pd[zz] == (double) zz, "Grow contents");
+  }
+  SC_GLOBAL_STATISTICSF ("Grow array to %llu MiB resize %g write %g\n",
+                         (unsigned long long) (sc_array_memory_used (a, 0)
+                                               >> 20), elapsed_resize,
+                         elapsed_touch);
+  sc_array_destroy (a);
+}
+
+/** Write an array to a mapped file, grow, shrink, and open it again. */
+static void
+test_file (const char *filename)
+{
+  int                 i;
+  const int           N = 100000;
+  int                *pe;
+  sc_array_t         *a, *v;
+
+  a = sc_array_new_file (filename, sizeof (int), 1);
+  SC_CHECK_ABORT (a != NULL && a->elem_count == 0, "File create");
+  for (i = 0; i < N; ++i) {
+    *(int *) sc_array_push (a) = i;
+  }
+  v = sc_array_new_view (a, N / 2, N / 4);
+  SC_CHECK_ABORT (*(int *) sc_array_index (v, 1) == N / 2 + 1, "File view");
+  sc_array_destroy (v);
+  SC_CHECK_ABORT (sc_array_flush (a) == 0, "File flush");
+  sc_array_destroy (a);
+
+  /* the file contains exactly the elements */
+  a = sc_array_new_file (filename, sizeof (int), 0);
+  SC_CHECK_ABORT (a != NULL && a->elem_count == (size_t) N, "File open");
+  for (i = 0; i < N; ++i) {
+    pe = (int *) sc_array_index_int (a, i);
+    SC_CHECK_ABORT (*pe == i, "File contents");
+    *pe = -i;
+  }
+  sc_array_resize (a, N / 3);
+  sc_array_resize (a, 0);
+  SC_CHECK_ABORT (a->elem_count == 0 && a->backing != NULL, "File empty");
+  sc_array_resize (a, N / 3);
+  memset (a->array, 0, a->elem_count * a->elem_size);
+  sc_array_rewind (a, 5);
+  sc_array_destroy (a);
+
+  a = sc_array_new_file (filename, sizeof (int), 0);
+  SC_CHECK_ABORT (a != NULL && a->elem_count == 5, "File reopen");
+  sc_array_destroy (a);
+  SC_CHECK_ABORT (sc_array_new_file (filename, 3, 0) == NULL, "File size");
+  SC_CHECK_ABORT (remove (filename) == 0, "File remove");
+  SC_CHECK_ABORT (sc_array_new_file (filename, 3, 0) == NULL, "File exist");
+}
+
 int
 main (int argc, char **argv)
 {
   const int           N = 29;
+  int                 mpiret, rank;
   int                 i, j, s, c;
   int                *pe;
   size_t              b1, b2;
@@ -155,8 +421,14 @@ main (int argc, char **argv)
   sc_array_t         *a, *p;
   size_t             *perm;
   int                *data;
+  char                filename[BUFSIZ];
 
-  sc_init (sc_MPI_COMM_NULL, 1, 1, NULL, SC_LP_DEFAULT);
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &rank);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
 
   a = sc_array_new (sizeof (int));
   sc_array_resize (a, (size_t) N);
@@ -271,9 +543,27 @@ main (int argc, char **argv)
   SC_FREE (perm);
   SC_FREE (data);
 
+  test_permute (0);
+  test_permute (17);
+  test_permute (1000000);
+#ifdef THEBIGTEST
+  test_grow ((size_t) 1 << 32);
+#else
+  /* one step beyond the 32 MiB mapping threshold of the aligned malloc */
+  test_grow ((size_t) 1 << 26);
+#endif
+  /* every process works on a file of its own */
+  snprintf (filename, BUFSIZ, "sc_test_arrays_file_%d.bin", rank);
+  test_file (filename);
   test_mstamp ();
+  test_policy (SC_PAGES_NORMAL, -1, 0);
+  test_policy (SC_PAGES_TRANSPARENT, -1, 2);
+  test_policy (SC_PAGES_EXPLICIT, 0, 0);
 
   sc_finalize ();
 
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
   return 0;
 }
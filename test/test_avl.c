@@ -0,0 +1,201 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_avl.h>
+
+/* #define THEBIGTEST */
+
+static int
+test_compare (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+/** Verify links and counts of a subtree and return its height. */
+static int
+test_height (avl_node_t * node, avl_node_t * parent)
+{
+  int                 hl, hr;
+
+  if (node == NULL) {
+    return 0;
+  }
+  SC_CHECK_ABORT (node->parent == parent, "Parent");
+  hl = test_height (node->left, node);
+  hr = test_height (node->right, node);
+  SC_CHECK_ABORT (node->count ==
+                  (node->left != NULL ? node->left->count : 0) +
+                  (node->right != NULL ? node->right->count : 0) + 1,
+                  "Subtree count");
+  return SC_MAX (hl, hr) + 1;
+}
+
+/** Check that the tree contains exactly the given values in order. */
+static void
+test_check (avl_tree_t * tree, const int *values, int count)
+{
+  int                 i, height;
+  avl_node_t         *node;
+
+  SC_CHECK_ABORT ((int) avl_count (tree) == count, "Count");
+  for (i = 0, node = tree->head; i < count; ++i, node = node->next) {
+    SC_CHECK_ABORT (node != NULL && *(int *) node->item == values[i],
+                    "Order");
+    SC_CHECK_ABORT ((int) avl_index (node) == i, "Index");
+    SC_CHECK_ABORT (avl_at (tree, (unsigned) i) == node, "At");
+    SC_CHECK_ABORT (avl_search (tree, values + i) == node, "Search");
+  }
+  SC_CHECK_ABORT (node == NULL, "Order end");
+  height = test_height (tree->top, NULL);
+  SC_CHECK_ABORT (count == 0 || (1 << (height - 1)) <= count, "Balance");
+}
+
+static void
+test_from_array (int count, sc_mempool_t * pool)
+{
+  int                 i, *values;
+  sc_array_t         *items;
+  avl_tree_t         *tree;
+
+  values = SC_ALLOC (int, count + 1);
+  items = sc_array_new_count (sizeof (void *), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    values[i] = 3 * i;
+    *(int **) sc_array_index_int (items, i) = values + i;
+  }
+
+  tree = avl_alloc_tree_pool (test_compare, NULL, pool);
+  avl_from_array (tree, items);
+  test_check (tree, values, count);
+
+  /* the tree remains fully functional */
+  values[count] = -1;
+  SC_CHECK_ABORT (avl_insert (tree, values + count) != NULL, "Insert");
+  SC_CHECK_ABORT (avl_insert (tree, values) == NULL, "Duplicate");
+  SC_CHECK_ABORT (avl_delete (tree, values + count) == values + count,
+                  "Delete");
+  for (i = 0; i < count; i += 2) {
+    avl_delete (tree, values + i);
+  }
+  for (i = 0; i < count; i += 2) {
+    avl_insert (tree, values + i);
+  }
+  test_check (tree, values, count);
+
+  /* round trip through an array */
+  sc_array_reset (items);
+  avl_to_array (tree, items);
+  avl_free_nodes (tree);
+  SC_CHECK_ABORT (pool == NULL || pool->elem_count == 0, "Pool truncate");
+  avl_from_array (tree, items);
+  test_check (tree, values, count);
+
+  avl_free_tree (tree);
+  sc_array_destroy (items);
+  SC_FREE (values);
+}
+
+/** Compare repeated insertion with the bulk load. */
+static void
+test_benchmark (int count)
+{
+  int                 i, *values;
+  double              elapsed_insert, elapsed_bulk, elapsed_pool;
+  sc_array_t         *items;
+  sc_mempool_t       *pool;
+  avl_tree_t         *tree;
+
+  values = SC_ALLOC (int, count);
+  items = sc_array_new_count (sizeof (void *), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    values[i] = i;
+    *(int **) sc_array_index_int (items, i) = values + i;
+  }
+
+  elapsed_insert = -sc_MPI_Wtime ();
+  tree = avl_alloc_tree (test_compare, NULL);
+  for (i = 0; i < count; ++i) {
+    avl_insert (tree, values + i);
+  }
+  avl_free_tree (tree);
+  elapsed_insert += sc_MPI_Wtime ();
+
+  elapsed_bulk = -sc_MPI_Wtime ();
+  tree = avl_alloc_tree (test_compare, NULL);
+  avl_from_array (tree, items);
+  avl_free_tree (tree);
+  elapsed_bulk += sc_MPI_Wtime ();
+
+  pool = sc_mempool_new (sizeof (avl_node_t));
+  elapsed_pool = -sc_MPI_Wtime ();
+  tree = avl_alloc_tree_pool (test_compare, NULL, pool);
+  avl_from_array (tree, items);
+  avl_free_tree (tree);
+  elapsed_pool += sc_MPI_Wtime ();
+  sc_mempool_destroy (pool);
+
+  SC_GLOBAL_STATISTICSF ("Benchmark count %d insert %g bulk %g"
+                         " bulk with pool %g\n", count, elapsed_insert,
+                         elapsed_bulk, elapsed_pool);
+
+  sc_array_destroy (items);
+  SC_FREE (values);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 count;
+  sc_mempool_t       *pool;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  pool = sc_mempool_new (sizeof (avl_node_t));
+  for (count = 0; count < 70; ++count) {
+    test_from_array (count, NULL);
+    test_from_array (count, pool);
+  }
+  test_from_array (12345, NULL);
+  test_from_array (12345, pool);
+  sc_mempool_destroy (pool);
+
+#ifdef THEBIGTEST
+  test_benchmark (10000000);
+#else
+  test_benchmark (1000000);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
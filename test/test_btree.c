@@ -0,0 +1,308 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_avl.h>
+#include <sc_btree.h>
+
+/* #define THEBIGTEST */
+
+static int
+test_compare (const void *v1, const void *v2)
+{
+  const int           i1 = *(const int *) v1;
+  const int           i2 = *(const int *) v2;
+
+  return i1 < i2 ? -1 : i1 > i2;
+}
+
+/** Compare the contents of a tree with a sorted array of the values. */
+static void
+test_check (sc_btree_t * tree, sc_array_t * sorted)
+{
+  size_t              zz;
+  int                *pi, i, cmp;
+  sc_btree_iter_t     iter;
+  sc_array_t         *items;
+
+  SC_CHECK_ABORT (tree->count == sorted->elem_count, "Count");
+
+  /* iteration in both directions */
+  pi = (int *) sc_btree_first (tree, &iter);
+  for (zz = 0; zz < sorted->elem_count; ++zz) {
+    SC_CHECK_ABORT (pi != NULL &&
+                    *pi == *(int *) sc_array_index (sorted, zz), "Next");
+    SC_CHECK_ABORT (sc_btree_index (&iter) == zz, "Index");
+    pi = (int *) sc_btree_next (&iter);
+  }
+  SC_CHECK_ABORT (pi == NULL && sc_btree_item (&iter) == NULL, "Next end");
+  pi = (int *) sc_btree_last (tree, &iter);
+  for (zz = sorted->elem_count; zz-- > 0;) {
+    SC_CHECK_ABORT (pi != NULL &&
+                    *pi == *(int *) sc_array_index (sorted, zz), "Prev");
+    pi = (int *) sc_btree_prev (&iter);
+  }
+  SC_CHECK_ABORT (pi == NULL, "Prev end");
+
+  /* access by rank and copying */
+  items = sc_array_new (sizeof (void *));
+  sc_btree_to_array (tree, items);
+  for (zz = 0; zz < sorted->elem_count; zz += 7) {
+    pi = (int *) sc_btree_at (tree, zz, &iter);
+    SC_CHECK_ABORT (pi == *(int **) sc_array_index (items, zz), "At");
+    SC_CHECK_ABORT (sc_btree_index (&iter) == zz, "At index");
+  }
+  SC_CHECK_ABORT (sc_btree_at (tree, zz + sorted->elem_count, NULL) == NULL,
+                  "At end");
+  sc_array_destroy (items);
+
+  /* closest search for values in and between the items */
+  for (zz = 0; zz < sorted->elem_count; zz += 5) {
+    i = *(int *) sc_array_index (sorted, zz) - 1;
+    cmp = sc_btree_search_closest (tree, &i, &iter);
+    pi = (int *) sc_btree_item (&iter);
+    if (zz > 0 && *(int *) sc_array_index (sorted, zz - 1) == i) {
+      SC_CHECK_ABORT (cmp == 0 && *pi == i, "Closest equal");
+    }
+    else {
+      SC_CHECK_ABORT (cmp == -1 && sc_btree_index (&iter) == zz,
+                      "Closest greater");
+      SC_CHECK_ABORT (sc_btree_rank (tree, &i) == zz, "Rank");
+    }
+  }
+  if (sorted->elem_count > 0) {
+    i = *(int *) sc_array_index (sorted, sorted->elem_count - 1) + 1;
+    cmp = sc_btree_search_closest (tree, &i, &iter);
+    SC_CHECK_ABORT (cmp == 1 &&
+                    sc_btree_index (&iter) == sorted->elem_count - 1,
+                    "Closest smaller");
+    SC_CHECK_ABORT (sc_btree_rank (tree, &i) == sorted->elem_count, "Rank");
+  }
+}
+
+static void
+test_btree (int count)
+{
+  int                 i, j, *values;
+  size_t              zz;
+  sc_btree_iter_t     iter;
+  sc_btree_t         *tree;
+  sc_array_t         *sorted;
+
+  /* insert a permutation of the even numbers, every value twice */
+  values = SC_ALLOC (int, count);
+  for (i = 0; i < count; ++i) {
+    values[i] = 2 * (int) ((7919 * (long) i) % count);
+  }
+  tree = sc_btree_new (test_compare, NULL);
+  for (i = 0; i < count; ++i) {
+    SC_CHECK_ABORT (sc_btree_insert (tree, values + i, &iter), "Insert");
+    SC_CHECK_ABORT (sc_btree_item (&iter) == values + i, "Insert iter");
+    SC_CHECK_ABORT (!sc_btree_insert (tree, values + i, NULL), "Duplicate");
+  }
+  sorted = sc_array_new_count (sizeof (int), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_index_int (sorted, i) = 2 * i;
+  }
+  test_check (tree, sorted);
+
+  /* delete every third value in a scattered order */
+  for (i = 0; i < count; ++i) {
+    j = 2 * (int) ((104729 * (long) i) % count);
+    if (j % 3 == 0) {
+      SC_CHECK_ABORT (sc_btree_search (tree, &j, NULL) != NULL, "Search");
+      SC_CHECK_ABORT (*(int *) sc_btree_delete (tree, &j) == j, "Delete");
+      SC_CHECK_ABORT (sc_btree_search (tree, &j, NULL) == NULL, "Deleted");
+      SC_CHECK_ABORT (sc_btree_delete (tree, &j) == NULL, "Delete twice");
+    }
+  }
+  for (i = 0, zz = 0; i < count; ++i) {
+    if ((2 * i) % 3 != 0) {
+      *(int *) sc_array_index (sorted, zz++) = 2 * i;
+    }
+  }
+  sc_array_resize (sorted, zz);
+  test_check (tree, sorted);
+
+  /* delete all remaining values from the front through positions */
+  while (sc_btree_first (tree, &iter) != NULL) {
+    sc_btree_delete_iter (tree, &iter);
+  }
+  SC_CHECK_ABORT (tree->count == 0 && tree->height == 0, "Empty");
+  sc_array_resize (sorted, 0);
+  test_check (tree, sorted);
+
+  sc_btree_destroy (tree);
+  sc_array_destroy (sorted);
+  SC_FREE (values);
+}
+
+/** Delete items that the tree frees and look up the remaining ones. */
+static void
+test_freeitem (int count)
+{
+  int                 i, *pi;
+  sc_btree_t         *tree;
+  sc_array_t         *sorted;
+
+  tree = sc_btree_new (test_compare, free);
+  for (i = 0; i < count; ++i) {
+    pi = (int *) malloc (sizeof (int));
+    *pi = (int) ((7919 * (long) i) % count);
+    SC_CHECK_ABORT (sc_btree_insert (tree, pi, NULL), "Insert freeitem");
+  }
+
+  /* the deleted items may be separators in the inner nodes */
+  for (i = 0; i < count; i += 16) {
+    SC_CHECK_ABORT (sc_btree_delete (tree, &i) == NULL, "Delete freeitem");
+  }
+  sorted = sc_array_new (sizeof (int));
+  for (i = 0; i < count; ++i) {
+    pi = (int *) sc_btree_search (tree, &i, NULL);
+    if (i % 16 == 0) {
+      SC_CHECK_ABORT (pi == NULL, "Search freed");
+    }
+    else {
+      SC_CHECK_ABORT (pi != NULL && *pi == i, "Search kept");
+      *(int *) sc_array_push (sorted) = i;
+    }
+  }
+  test_check (tree, sorted);
+
+  /* delete the rest, which again passes through the updated separators */
+  for (i = 0; i < count; ++i) {
+    sc_btree_delete (tree, &i);
+  }
+  SC_CHECK_ABORT (tree->count == 0, "Empty freeitem");
+
+  sc_btree_destroy (tree);
+  sc_array_destroy (sorted);
+}
+
+/** Compare the timings of the AVL and the B+-tree. */
+static void
+test_benchmark (int count)
+{
+  int                 i, *values, key;
+  size_t              sum;
+  double              elapsed_insert, elapsed_search, elapsed_at;
+  double              elapsed_delete;
+  avl_node_t         *node;
+  avl_tree_t         *avl;
+  sc_btree_t         *tree;
+
+  values = SC_ALLOC (int, count);
+  for (i = 0; i < count; ++i) {
+    values[i] = (int) ((1103515245 * (long) i + 12345) % 2147483647);
+  }
+
+  avl = avl_alloc_tree (test_compare, NULL);
+  elapsed_insert = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    avl_insert (avl, values + i);
+  }
+  elapsed_insert += sc_MPI_Wtime ();
+  elapsed_search = -sc_MPI_Wtime ();
+  for (i = 0, sum = 0; i < count; ++i) {
+    key = values[(7 * (long) i) % count] + 1;
+    sum += avl_search_closest (avl, &key, &node) + 1;
+  }
+  elapsed_search += sc_MPI_Wtime ();
+  elapsed_at = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    node = avl_at (avl, (unsigned) ((7 * (long) i) % avl_count (avl)));
+    sum += avl_index (node);
+  }
+  elapsed_at += sc_MPI_Wtime ();
+  elapsed_delete = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    avl_delete (avl, values + i);
+  }
+  elapsed_delete += sc_MPI_Wtime ();
+  avl_free_tree (avl);
+  SC_GLOBAL_STATISTICSF ("Benchmark count %d avl insert %g closest %g"
+                         " at %g delete %g\n", count, elapsed_insert,
+                         elapsed_search, elapsed_at, elapsed_delete);
+
+  tree = sc_btree_new (test_compare, NULL);
+  elapsed_insert = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    sc_btree_insert (tree, values + i, NULL);
+  }
+  elapsed_insert += sc_MPI_Wtime ();
+  elapsed_search = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    key = values[(7 * (long) i) % count] + 1;
+    sum += sc_btree_search_closest (tree, &key, NULL) + 1;
+  }
+  elapsed_search += sc_MPI_Wtime ();
+  elapsed_at = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    sc_btree_iter_t     iter;
+
+    sc_btree_at (tree, (size_t) ((7 * (long) i) % tree->count), &iter);
+    sum += sc_btree_index (&iter);
+  }
+  elapsed_at += sc_MPI_Wtime ();
+  elapsed_delete = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    sc_btree_delete (tree, values + i);
+  }
+  elapsed_delete += sc_MPI_Wtime ();
+  sc_btree_destroy (tree);
+  SC_GLOBAL_STATISTICSF ("Benchmark count %d btree insert %g closest %g"
+                         " at %g delete %g\n", count, elapsed_insert,
+                         elapsed_search, elapsed_at, elapsed_delete);
+  SC_LDEBUGF ("Benchmark checksum %lu\n", (unsigned long) sum);
+
+  SC_FREE (values);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_btree (1);
+  test_btree (33);
+  test_btree (5003);
+  test_btree (100003);
+  test_freeitem (2000);
+  test_freeitem (100003);
+#ifdef THEBIGTEST
+  test_benchmark (10000000);
+#else
+  test_benchmark (1000000);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
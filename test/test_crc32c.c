@@ -0,0 +1,178 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_crc32c.h>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/* #define THEBIGTEST */
+
+/** Compute the checksum bit by bit as a reference. */
+static uint32_t
+test_crc32c_bits (uint32_t crc, const unsigned char *p, size_t length)
+{
+  int                 k;
+
+  crc = ~crc;
+  while (length-- > 0) {
+    crc ^= *p++;
+    for (k = 0; k < 8; ++k) {
+      crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78U : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+static void
+test_buffers (void)
+{
+  const char         *check = "123456789";
+  size_t              size, offset, split;
+  uint32_t            crc, crc1, crc2;
+  unsigned char      *buffer;
+
+  SC_CHECK_ABORT (sc_crc32c (0, check, strlen (check)) == 0xe3069283U,
+                  "Check value");
+  SC_CHECK_ABORT (sc_crc32c (0, NULL, 0) == 0, "Empty");
+
+  /* lengths and alignments around the word and block boundaries */
+  size = 3 * 4096 * 3 + 100;
+  buffer = SC_ALLOC (unsigned char, size);
+  for (offset = 0; offset < size; ++offset) {
+    buffer[offset] = (unsigned char) (offset * 2654435761U >> 13);
+  }
+  for (offset = 0; offset < 9; ++offset) {
+    for (split = 0; split < 20; ++split) {
+      crc = sc_crc32c (0, buffer + offset, split);
+      SC_CHECK_ABORT (crc == test_crc32c_bits (0, buffer + offset, split),
+                      "Short buffers");
+    }
+    crc = sc_crc32c (0, buffer + offset, size - offset);
+    SC_CHECK_ABORT (crc == test_crc32c_bits (0, buffer + offset,
+                                             size - offset), "Long buffer");
+
+    /* continuing and combining agree with the whole buffer */
+    split = 12345 + offset;
+    crc1 = sc_crc32c (0, buffer, split);
+    crc2 = sc_crc32c (0, buffer + split, size - split);
+    SC_CHECK_ABORT (sc_crc32c (crc1, buffer + split, size - split) ==
+                    sc_crc32c (0, buffer, size), "Continue");
+    SC_CHECK_ABORT (sc_crc32c_combine (crc1, crc2, size - split) ==
+                    sc_crc32c (0, buffer, size), "Combine");
+  }
+  SC_FREE (buffer);
+}
+
+static void
+test_array (sc_MPI_Comm mpicomm, size_t count)
+{
+  int                 mpiret, mpirank, mpisize, num_threads, q;
+  size_t              zz, offset;
+  uint32_t            crc, expected;
+  uint64_t           *pu;
+  double              elapsed_adler, elapsed_crc, elapsed_threads;
+  sc_array_t         *a, *global;
+
+  mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* every rank owns a different number of elements of a global array */
+  offset = 0;
+  global = sc_array_new (sizeof (uint64_t));
+  for (q = 0; q < mpisize; ++q) {
+    if (q == mpirank) {
+      offset = global->elem_count;
+    }
+    for (zz = 0; zz < count + q; ++zz) {
+      pu = (uint64_t *) sc_array_push (global);
+      *pu = (uint64_t) global->elem_count * 0x9E3779B97F4A7C15ULL;
+    }
+  }
+  a = sc_array_new_view (global, offset, count + mpirank);
+
+  /* the local checksum does not depend on the number of threads */
+  elapsed_crc = -sc_MPI_Wtime ();
+  expected = sc_crc32c (0, a->array, a->elem_count * a->elem_size);
+  elapsed_crc += sc_MPI_Wtime ();
+  for (num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    elapsed_threads = -sc_MPI_Wtime ();
+    crc = sc_array_checksum_crc32c (a, num_threads);
+    elapsed_threads += sc_MPI_Wtime ();
+    SC_CHECK_ABORT (crc == expected, "Threads");
+    SC_GLOBAL_STATISTICSF ("Checksum bytes %lu threads %d crc32c %g\n",
+                           (unsigned long) (a->elem_count * a->elem_size),
+                           num_threads, elapsed_threads);
+  }
+
+  /* the global checksum equals that of the concatenated array */
+  crc = sc_array_checksum_crc32c_global (a, mpicomm, 0);
+  SC_CHECK_ABORT (crc == sc_crc32c (0, global->array, global->elem_count *
+                                    global->elem_size), "Global");
+
+  elapsed_adler = 0.;
+#ifdef SC_HAVE_ZLIB
+  elapsed_adler = -sc_MPI_Wtime ();
+  sc_array_checksum (a);
+  elapsed_adler += sc_MPI_Wtime ();
+#endif
+  SC_GLOBAL_STATISTICSF ("Checksum bytes %lu hardware %d crc32c %g"
+                         " adler32 %g\n",
+                         (unsigned long) (a->elem_count * a->elem_size),
+                         sc_crc32c_hardware (), elapsed_crc, elapsed_adler);
+
+  sc_array_destroy (a);
+  sc_array_destroy (global);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpicomm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+  mpicomm = sc_MPI_COMM_WORLD;
+
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
+  test_buffers ();
+  test_array (mpicomm, 0);
+  test_array (mpicomm, 1000);
+#ifdef THEBIGTEST
+  test_array (mpicomm, (size_t) 1 << 28);
+#else
+  test_array (mpicomm, (size_t) 1 << 22);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,250 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+/* #define THEBIGTEST */
+
+/** xorshift64* pseudo random numbers. */
+static              uint64_t
+test_random (uint64_t * state)
+{
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+/** Compare a deque with the range [lo, hi) of a reference array. */
+static void
+test_check (sc_deque_t * deque, const long *ref, size_t lo, size_t hi)
+{
+  size_t              zz, iz, count;
+  long               *pl;
+
+  SC_CHECK_ABORT (deque->elem_count == hi - lo, "Count");
+  for (zz = 0; zz < deque->elem_count; ++zz) {
+    SC_CHECK_ABORT (*(long *) sc_deque_index (deque, zz) == ref[lo + zz],
+                    "Index");
+  }
+  for (iz = 0; iz < deque->elem_count; iz += count) {
+    pl = (long *) sc_deque_chunk (deque, iz, &count);
+    SC_CHECK_ABORT (count > 0, "Chunk count");
+    for (zz = 0; zz < count; ++zz) {
+      SC_CHECK_ABORT (pl[zz] == ref[lo + iz + zz], "Chunk");
+    }
+  }
+  SC_CHECK_ABORT (iz == deque->elem_count, "Chunk end");
+}
+
+/** Random pushes and pops at both ends against a reference array. */
+static void
+test_deque (size_t num_ops, uint64_t seed)
+{
+  const size_t        ref_size = 2 * num_ops + 1;
+  size_t              zz, lo, hi;
+  long               *ref, value;
+  uint64_t            r;
+  sc_deque_t          deque;
+
+  ref = SC_ALLOC (long, ref_size);
+  lo = hi = num_ops;
+  value = 0;
+
+  sc_deque_init (&deque, sizeof (long));
+  for (zz = 0; zz < num_ops; ++zz) {
+    r = test_random (&seed) >> 32;
+
+    /* grow with probability 5/8 during the first half, then shrink */
+    if ((r & 7) < (zz < num_ops / 2 ? 5U : 3U) || lo == hi) {
+      if (r & 8) {
+        *(long *) sc_deque_push_back (&deque) = ref[hi++] = ++value;
+      }
+      else {
+        *(long *) sc_deque_push_front (&deque) = ref[--lo] = ++value;
+      }
+    }
+    else {
+      if (r & 8) {
+        SC_CHECK_ABORT (*(long *) sc_deque_pop_back (&deque) == ref[--hi],
+                        "Pop back");
+      }
+      else {
+        SC_CHECK_ABORT (*(long *) sc_deque_pop_front (&deque) == ref[lo++],
+                        "Pop front");
+      }
+    }
+    if (zz % 997 == 0) {
+      test_check (&deque, ref, lo, hi);
+    }
+  }
+  test_check (&deque, ref, lo, hi);
+  SC_CHECK_ABORT (sc_deque_memory_used (&deque, 0) >=
+                  deque.elem_count * sizeof (long), "Memory");
+
+  /* a truncated deque reuses its chunks as a FIFO queue */
+  sc_deque_truncate (&deque);
+  zz = deque.chunk_count;
+  lo = hi = 0;
+  for (value = 0; value < (long) num_ops; ++value) {
+    *(long *) sc_deque_push_back (&deque) = ref[hi++] = value;
+    if (value % 3 == 2) {
+      SC_CHECK_ABORT (*(long *) sc_deque_pop_front (&deque) == ref[lo++],
+                      "Queue");
+      SC_CHECK_ABORT (*(long *) sc_deque_pop_front (&deque) == ref[lo++],
+                      "Queue");
+    }
+  }
+  test_check (&deque, ref, lo, hi);
+  SC_CHECK_ABORT (deque.chunk_count >= zz, "Chunks kept");
+
+  sc_deque_reset (&deque);
+  SC_CHECK_ABORT (sc_deque_memory_used (&deque, 0) == 0, "Reset");
+  SC_FREE (ref);
+}
+
+/** Element pointers survive pushes until a push grows the queue. */
+static void
+test_pointers (void)
+{
+  const size_t        num_pop = 10;
+  size_t              zz, capacity;
+  long              **ptrs;
+  long               *last;
+  sc_deque_t          deque;
+
+  sc_deque_init (&deque, sizeof (long));
+  *(long *) sc_deque_push_back (&deque) = 0;
+  capacity = (size_t) 1 << deque.chunk_shift;
+  for (zz = 1; zz < capacity; ++zz) {
+    *(long *) sc_deque_push_back (&deque) = (long) zz;
+  }
+  ptrs = SC_ALLOC (long *, capacity);
+  for (zz = 0; zz < capacity; ++zz) {
+    ptrs[zz] = (long *) sc_deque_index (&deque, zz);
+  }
+
+  /* the pushes wrap around within the capacity and move nothing */
+  for (zz = 0; zz < num_pop; ++zz) {
+    sc_deque_pop_front (&deque);
+  }
+  for (zz = 0; zz < num_pop; ++zz) {
+    *(long *) sc_deque_push_back (&deque) = (long) (capacity + zz);
+  }
+  for (zz = num_pop; zz < capacity; ++zz) {
+    SC_CHECK_ABORT (sc_deque_index (&deque, zz - num_pop) == ptrs[zz],
+                    "Pointer kept");
+  }
+
+  /* the next push grows the queue and moves the wrapped elements */
+  last = (long *) sc_deque_index (&deque, capacity - 1);
+  *(long *) sc_deque_push_back (&deque) = (long) (capacity + num_pop);
+  SC_CHECK_ABORT (sc_deque_index (&deque, capacity - 1) != (void *) last,
+                  "Pointer invalidated");
+  for (zz = 0; zz <= capacity; ++zz) {
+    SC_CHECK_ABORT (*(long *) sc_deque_index (&deque, zz) ==
+                    (long) (zz + num_pop), "Grown contents");
+  }
+
+  SC_FREE (ptrs);
+  sc_deque_reset (&deque);
+}
+
+/** Compare the deque with the linked list as a FIFO queue. */
+static void
+test_benchmark (size_t count)
+{
+  size_t              zz, sum;
+  double              elapsed_list, elapsed_deque;
+  sc_list_t          *list;
+  sc_deque_t         *deque;
+
+  /* breadth-first pattern: each popped item pushes one or two more */
+  sum = 0;
+  elapsed_list = -sc_MPI_Wtime ();
+  list = sc_list_new (NULL);
+  sc_list_append (list, (void *) 1);
+  for (zz = 0; zz < count; ++zz) {
+    sum += (size_t) sc_list_pop (list);
+    sc_list_append (list, (void *) zz);
+    if (zz & 1) {
+      sc_list_append (list, (void *) zz);
+    }
+  }
+  SC_GLOBAL_STATISTICSF ("Benchmark list memory %llu\n",
+                         (unsigned long long)
+                         sc_list_memory_used (list, 1));
+  sc_list_destroy (list);
+  elapsed_list += sc_MPI_Wtime ();
+
+  elapsed_deque = -sc_MPI_Wtime ();
+  deque = sc_deque_new (sizeof (void *));
+  *(void **) sc_deque_push_back (deque) = (void *) 1;
+  for (zz = 0; zz < count; ++zz) {
+    sum -= (size_t) *(void **) sc_deque_pop_front (deque);
+    *(void **) sc_deque_push_back (deque) = (void *) zz;
+    if (zz & 1) {
+      *(void **) sc_deque_push_back (deque) = (void *) zz;
+    }
+  }
+  SC_GLOBAL_STATISTICSF ("Benchmark deque memory %llu\n",
+                         (unsigned long long)
+                         sc_deque_memory_used (deque, 1));
+  sc_deque_destroy (deque);
+  elapsed_deque += sc_MPI_Wtime ();
+
+  SC_CHECK_ABORT (sum == 0, "Benchmark queue order");
+  SC_GLOBAL_STATISTICSF ("Benchmark count %llu list %g deque %g\n",
+                         (unsigned long long) count,
+                         elapsed_list, elapsed_deque);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  uint64_t            seed;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (seed = 1; seed <= 8; ++seed) {
+    test_deque (seed * seed * 1000, seed);
+  }
+  test_pointers ();
+#ifdef THEBIGTEST
+  test_deque (10000000, 9);
+  test_benchmark (100000000);
+#else
+  test_benchmark (10000000);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,526 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+
+/* #define THEBIGTEST */
+
+static unsigned int
+test_hash_fn (const void *v, const void *u)
+{
+  /* deliberately weak: the tables must cope with the identity */
+  return (unsigned int) *(const long *) v;
+}
+
+static int
+test_equal_fn (const void *v1, const void *v2, const void *u)
+{
+  return *(const long *) v1 == *(const long *) v2;
+}
+
+static int
+test_count_fn (void **v, const void *u)
+{
+  sc_array_t         *counts = (sc_array_t *) u;
+
+  ++*(size_t *) sc_array_index (counts, (size_t) * (long *) *v);
+  return 1;
+}
+
+/** Generate a sequence of keys with many duplicates. */
+static void
+test_keys (sc_array_t * keys, size_t count)
+{
+  size_t              zz;
+
+  sc_array_resize (keys, count);
+  for (zz = 0; zz < count; ++zz) {
+    *(long *) sc_array_index (keys, zz) =
+      (long) ((zz * 2654435761UL) % (3 * count / 4 + 1)) * 64;
+  }
+}
+
+/** Compare a frozen copy of a hash table with the original. */
+static void
+test_hash_freeze (sc_hash_t * hash, sc_array_t * keys)
+{
+  int                 contained;
+  size_t              zz;
+  long                absent;
+  long               *key;
+  void               *found;
+  double              elapsed_freeze;
+  sc_hash_frozen_t   *frozen;
+
+  elapsed_freeze = -sc_MPI_Wtime ();
+  frozen = sc_hash_freeze (hash);
+  elapsed_freeze += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (frozen->elem_count == hash->elem_count, "Frozen count");
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = (long *) sc_array_index (keys, zz);
+    contained = sc_hash_lookup (hash, key, NULL);
+    SC_CHECK_ABORT (contained == sc_hash_frozen_lookup (frozen, key, &found),
+                    "Frozen lookup");
+    SC_CHECK_ABORT (!contained || *(long *) found == *key, "Frozen object");
+
+    /* the keys are multiples of 64 */
+    absent = *key + 1;
+    SC_CHECK_ABORT (!sc_hash_frozen_lookup (frozen, &absent, NULL),
+                    "Frozen absent");
+  }
+  SC_GLOBAL_STATISTICSF ("Frozen hash memory %lu chained %lu time %g\n",
+                         (unsigned long) sc_hash_frozen_memory_used (frozen),
+                         (unsigned long) sc_hash_memory_used (hash),
+                         elapsed_freeze);
+  sc_hash_frozen_destroy (frozen);
+}
+
+static unsigned int
+test_weak_hash_fn (const void *v, const void *u)
+{
+  /* produce many repeated hash values */
+  return (unsigned int) (*(const long *) v % 997);
+}
+
+/** Freeze a hash array whose hash function has many collisions. */
+static void
+test_hash_array_freeze (size_t count)
+{
+  size_t              zz, position;
+  long                key;
+  sc_hash_array_t    *ha;
+  sc_hash_array_frozen_t *fha;
+
+  ha = sc_hash_array_new (sizeof (long), test_weak_hash_fn, test_equal_fn,
+                          NULL);
+  for (zz = 0; zz < count; ++zz) {
+    key = (long) (zz * 7 % count);
+    *(long *) sc_hash_array_insert_unique (ha, &key, &position) = key;
+    SC_CHECK_ABORT (position == zz, "Hash array insert");
+  }
+  fha = sc_hash_array_freeze (ha);
+  SC_CHECK_ABORT (fha->a.elem_count == count, "Frozen array count");
+  SC_CHECK_ABORT (fha->f->num_overflow + fha->f->num_slots == count,
+                  "Frozen array overflow");
+  for (zz = 0; zz < count; ++zz) {
+    key = (long) (zz * 7 % count);
+    SC_CHECK_ABORT (sc_hash_array_frozen_lookup (fha, &key, &position) &&
+                    position == zz, "Frozen array lookup");
+  }
+  key = (long) count;
+  SC_CHECK_ABORT (!sc_hash_array_frozen_lookup (fha, &key, NULL),
+                  "Frozen array absent");
+  sc_hash_array_frozen_destroy (fha);
+}
+
+/** Compare batched with one-by-one insertion into a hash array. */
+static void
+test_hash_array_batch (sc_array_t * keys)
+{
+  size_t              zz, position, num_added, num_found;
+  long                absent;
+  void               *v, *p;
+  double              elapsed_single, elapsed_batch;
+  sc_array_t         *positions, *single, *extra;
+  sc_hash_array_t    *ha, *hb;
+
+  /* reference: insert one key at a time */
+  single = sc_array_new_count (sizeof (size_t), keys->elem_count);
+  elapsed_single = -sc_MPI_Wtime ();
+  ha = sc_hash_array_new (sizeof (long), sc_hash_function_bytes8,
+                          test_equal_fn, NULL);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    v = sc_array_index (keys, zz);
+    if ((p = sc_hash_array_insert_unique (ha, v, &position)) != NULL) {
+      memcpy (p, v, sizeof (long));
+    }
+    *(size_t *) sc_array_index (single, zz) = position;
+  }
+  elapsed_single += sc_MPI_Wtime ();
+
+  /* insert the first half and then all keys as batches */
+  positions = sc_array_new (sizeof (size_t));
+  elapsed_batch = -sc_MPI_Wtime ();
+  hb = sc_hash_array_new (sizeof (long), sc_hash_function_bytes8,
+                          test_equal_fn, NULL);
+  extra = sc_array_new_view (keys, 0, keys->elem_count / 2);
+  num_added = sc_hash_array_insert_batch (hb, extra, NULL);
+  sc_array_destroy (extra);
+  num_added += sc_hash_array_insert_batch (hb, keys, positions);
+  elapsed_batch += sc_MPI_Wtime ();
+
+  SC_CHECK_ABORT (num_added == ha->a.elem_count, "Batch count");
+  SC_CHECK_ABORT (sc_array_is_equal (&ha->a, &hb->a), "Batch order");
+  SC_CHECK_ABORT (sc_array_is_equal (single, positions), "Batch positions");
+  SC_CHECK_ABORT (sc_hash_array_is_valid (hb), "Batch valid");
+  SC_GLOBAL_STATISTICSF ("Hash array timings single %g batch %g\n",
+                         elapsed_single, elapsed_batch);
+
+  /* look up the keys and some that are not contained */
+  num_found = sc_hash_array_lookup_batch (hb, keys, positions);
+  SC_CHECK_ABORT (num_found == keys->elem_count, "Batch found");
+  SC_CHECK_ABORT (sc_array_is_equal (single, positions), "Batch lookup");
+  extra = sc_array_new_count (sizeof (long), 2);
+  absent = -1;
+  memcpy (sc_array_index (extra, 0), &absent, sizeof (long));
+  memcpy (sc_array_index (extra, 1), keys->array, sizeof (long));
+  num_found = sc_hash_array_lookup_batch (hb, extra, positions);
+  SC_CHECK_ABORT (num_found == 1, "Batch absent");
+  SC_CHECK_ABORT (*(size_t *) sc_array_index (positions, 0) == (size_t) -1 &&
+                  *(size_t *) sc_array_index (positions, 1) == 0,
+                  "Batch absent positions");
+  sc_array_destroy (extra);
+
+  sc_hash_array_destroy (hb);
+  sc_hash_array_destroy (ha);
+  sc_array_destroy (positions);
+  sc_array_destroy (single);
+}
+
+/** A batch with many duplicates does not oversize the hash table. */
+static void
+test_hash_array_batch_duplicates (size_t count, size_t distinct)
+{
+  size_t              zz, position, num_added;
+  long                key;
+  sc_array_t         *keys;
+  sc_hash_array_t    *ha, *hb;
+
+  keys = sc_array_new_count (sizeof (long), count);
+  ha = sc_hash_array_new (sizeof (long), sc_hash_function_bytes8,
+                          test_equal_fn, NULL);
+  for (zz = 0; zz < count; ++zz) {
+    key = (long) ((zz * 7919) % distinct);
+    *(long *) sc_array_index (keys, zz) = key;
+    if (zz < distinct) {
+      *(long *) sc_hash_array_insert_unique (ha, &key, &position) = key;
+    }
+  }
+
+  hb = sc_hash_array_new (sizeof (long), sc_hash_function_bytes8,
+                          test_equal_fn, NULL);
+  num_added = sc_hash_array_insert_batch (hb, keys, NULL);
+  SC_CHECK_ABORT (num_added == distinct, "Batch duplicates count");
+  SC_CHECK_ABORT (hb->h->slots->elem_count <= ha->h->slots->elem_count,
+                  "Batch duplicates presize");
+
+  sc_hash_array_destroy (hb);
+  sc_hash_array_destroy (ha);
+  sc_array_destroy (keys);
+}
+
+static void
+test_hash_chained (sc_array_t * keys, sc_mempool_t * allocator,
+                   size_t *added, size_t *removed)
+{
+  size_t              zz;
+  void              **found, **first;
+  void               *removed_object;
+  long               *key;
+  sc_hash_t          *hash;
+
+  hash = sc_hash_new (test_hash_fn, test_equal_fn, NULL, allocator);
+  *added = *removed = 0;
+  first = NULL;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = (long *) sc_array_index (keys, zz);
+    if (sc_hash_insert_unique (hash, key, &found)) {
+      ++*added;
+      SC_CHECK_ABORT (*found == key, "Chained insert");
+    }
+    else {
+      SC_CHECK_ABORT (*(long *) *found == *key, "Chained duplicate");
+    }
+    if (zz == 0) {
+      first = found;
+    }
+    if (hash->old_slots != NULL) {
+      /* objects are found in both the old and new slots during a resize */
+      SC_CHECK_ABORT (sc_hash_lookup (hash, keys->array, &found) &&
+                      found == first, "Chained migration");
+    }
+  }
+  SC_CHECK_ABORT (hash->elem_count == *added, "Chained count");
+  SC_CHECK_ABORT (hash->resize_actions > 0, "Chained resize");
+  SC_CHECK_ABORT (*first == keys->array, "Chained address");
+  for (zz = 0; zz < keys->elem_count; zz += 2) {
+    key = (long *) sc_array_index (keys, zz);
+    SC_CHECK_ABORT (sc_hash_lookup (hash, key, NULL), "Chained lookup");
+    if (sc_hash_remove (hash, key, &removed_object)) {
+      ++*removed;
+      SC_CHECK_ABORT (*(long *) removed_object == *key, "Chained remove");
+    }
+  }
+  SC_CHECK_ABORT (hash->elem_count == *added - *removed, "Chained count");
+  sc_hash_print_statistics (sc_package_id, SC_LP_STATISTICS, hash);
+  test_hash_freeze (hash, keys);
+  sc_hash_destroy (hash);
+}
+
+static void
+test_hash_open (sc_array_t * keys, size_t added, size_t removed)
+{
+  size_t              zz, count;
+  void              **found;
+  void               *removed_object;
+  long               *key;
+  sc_hash_open_t     *hash;
+
+  hash = sc_hash_open_new (test_hash_fn, test_equal_fn, NULL);
+  count = 0;
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    key = (long *) sc_array_index (keys, zz);
+    if (sc_hash_open_insert_unique (hash, key, &found)) {
+      ++count;
+      SC_CHECK_ABORT (*found == key, "Open insert");
+    }
+    else {
+      SC_CHECK_ABORT (*(long *) *found == *key, "Open duplicate");
+    }
+  }
+  SC_CHECK_ABORT (count == added && hash->elem_count == added, "Open count");
+  for (zz = 0, count = 0; zz < keys->elem_count; zz += 2) {
+    key = (long *) sc_array_index (keys, zz);
+    SC_CHECK_ABORT (sc_hash_open_lookup (hash, key, NULL), "Open lookup");
+    if (sc_hash_open_remove (hash, key, &removed_object)) {
+      ++count;
+      SC_CHECK_ABORT (*(long *) removed_object == *key, "Open remove");
+      SC_CHECK_ABORT (!sc_hash_open_lookup (hash, key, NULL),
+                      "Open lookup");
+    }
+  }
+  SC_CHECK_ABORT (count == removed, "Open removed");
+  SC_CHECK_ABORT (hash->elem_count == added - removed, "Open count");
+  sc_hash_open_print_statistics (sc_package_id, SC_LP_STATISTICS, hash);
+  SC_GLOBAL_STATISTICSF ("Open hash memory %lu\n",
+                         (unsigned long) sc_hash_open_memory_used (hash));
+
+  sc_hash_open_truncate (hash);
+  SC_CHECK_ABORT (hash->elem_count == 0, "Open truncate");
+  sc_hash_open_destroy (hash);
+}
+
+static void
+test_hash_open_foreach (sc_array_t * keys)
+{
+  size_t              zz;
+  sc_array_t         *counts;
+  sc_hash_open_t     *hash;
+
+  /* every key is visited exactly once */
+  counts = sc_array_new_count (sizeof (size_t), keys->elem_count);
+  sc_array_memset (counts, 0);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    *(long *) sc_array_index (keys, zz) = (long) zz;
+  }
+  hash = sc_hash_open_new (test_hash_fn, test_equal_fn, counts);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    SC_EXECUTE_ASSERT_TRUE (sc_hash_open_insert_unique
+                            (hash, sc_array_index (keys, zz), NULL));
+  }
+  sc_hash_open_foreach (hash, test_count_fn);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) sc_array_index (counts, zz) == 1,
+                    "Open foreach");
+  }
+  sc_array_destroy (counts);
+  sc_hash_open_destroy (hash);
+}
+
+static int
+test_unsigned_compare (const void *v1, const void *v2)
+{
+  const unsigned int  u1 = *(const unsigned int *) v1;
+  const unsigned int  u2 = *(const unsigned int *) v2;
+
+  return u1 < u2 ? -1 : u1 > u2 ? 1 : 0;
+}
+
+/** Report the collisions of a hash function on a set of keys.
+ * We count repeated 32-bit values and the chi-square deviation of the
+ * occupancy of 2^16 buckets from the uniform distribution.
+ */
+static void
+test_hash_quality (const char *name, sc_array_t * keys,
+                   sc_hash_function_t fn, const void *u)
+{
+  const size_t        num_buckets = 1 << 16;
+  size_t              zz, collisions;
+  double              expected, chisq, d;
+  unsigned int       *hv;
+  sc_array_t         *hvals, *buckets;
+
+  hvals = sc_array_new_count (sizeof (unsigned int), keys->elem_count);
+  buckets = sc_array_new_count (sizeof (size_t), num_buckets);
+  sc_array_memset (buckets, 0);
+  for (zz = 0; zz < keys->elem_count; ++zz) {
+    hv = (unsigned int *) sc_array_index (hvals, zz);
+    *hv = fn (*(void **) sc_array_index (keys, zz), u);
+    ++*(size_t *) sc_array_index (buckets, *hv % num_buckets);
+  }
+  sc_array_sort (hvals, test_unsigned_compare);
+  sc_array_uniq (hvals, test_unsigned_compare);
+  collisions = keys->elem_count - hvals->elem_count;
+
+  expected = keys->elem_count / (double) num_buckets;
+  for (zz = 0, chisq = 0.; zz < num_buckets; ++zz) {
+    d = *(size_t *) sc_array_index (buckets, zz) - expected;
+    chisq += d * d / expected;
+  }
+  SC_GLOBAL_STATISTICSF ("Hash quality %s collisions %lu chisq/dof %.3g\n",
+                         name, (unsigned long) collisions,
+                         chisq / (num_buckets - 1));
+
+  sc_array_destroy (buckets);
+  sc_array_destroy (hvals);
+}
+
+/** Time a hash function on a set of keys. */
+static double
+test_hash_throughput (sc_array_t * keys, sc_hash_function_t fn,
+                      const void *u, int repeat)
+{
+  int                 r;
+  size_t              zz;
+  unsigned int        sum;
+  double              start;
+
+  start = -sc_MPI_Wtime ();
+  for (r = 0, sum = 0; r < repeat; ++r) {
+    for (zz = 0; zz < keys->elem_count; ++zz) {
+      sum += fn (*(void **) sc_array_index (keys, zz), u);
+    }
+  }
+  SC_LDEBUGF ("Hash checksum %u\n", sum);
+  return start + sc_MPI_Wtime ();
+}
+
+static void
+test_hash_functions (size_t count)
+{
+  const size_t        key_size = 24;
+  const int           repeat = 10;
+  size_t              zz;
+  int64_t            *tuple;
+  char               *str;
+  double              elapsed_string, elapsed_string64;
+  double              elapsed_bytes, elapsed_bytes24;
+  sc_array_t         *strings, *tuples, *keys;
+
+  /* short string keys as used with sc_keyvalue and sc_statistics */
+  strings = sc_array_new_count (32, count);
+  tuples = sc_array_new_count (key_size, count);
+  keys = sc_array_new_count (sizeof (void *), count);
+  for (zz = 0; zz < count; ++zz) {
+    str = (char *) sc_array_index (strings, zz);
+    snprintf (str, 32, "%s%lu", zz % 3 ? "Option" : "Var", (unsigned long) zz);
+    *(void **) sc_array_index (keys, zz) = str;
+  }
+  test_hash_quality ("string", keys, sc_hash_function_string, NULL);
+  test_hash_quality ("string64", keys, sc_hash_function_string64, NULL);
+  elapsed_string = test_hash_throughput (keys, sc_hash_function_string,
+                                         NULL, repeat);
+  elapsed_string64 = test_hash_throughput (keys, sc_hash_function_string64,
+                                           NULL, repeat);
+  SC_GLOBAL_STATISTICSF ("Hash timings string %g string64 %g\n",
+                         elapsed_string, elapsed_string64);
+
+  /* integer tuples on a regular grid as used for node numbering */
+  for (zz = 0; zz < count; ++zz) {
+    tuple = (int64_t *) sc_array_index (tuples, zz);
+    tuple[0] = (int64_t) (zz % 64);
+    tuple[1] = (int64_t) (zz / 64 % 64);
+    tuple[2] = (int64_t) (zz / 4096);
+    *(void **) sc_array_index (keys, zz) = tuple;
+    SC_CHECK_ABORT (sc_hash_bytes24 (tuple) ==
+                    sc_hash_bytes (tuple, key_size, 0), "Hash bytes24");
+    SC_CHECK_ABORT (sc_hash_bytes16 (tuple) ==
+                    sc_hash_bytes (tuple, 16, 0), "Hash bytes16");
+    SC_CHECK_ABORT (sc_hash_bytes8 (tuple) ==
+                    sc_hash_bytes (tuple, 8, 0), "Hash bytes8");
+  }
+  test_hash_quality ("bytes24", keys, sc_hash_function_bytes24, NULL);
+  elapsed_bytes = test_hash_throughput (keys, sc_hash_function_bytes,
+                                        &key_size, repeat);
+  elapsed_bytes24 = test_hash_throughput (keys, sc_hash_function_bytes24,
+                                          NULL, repeat);
+  SC_GLOBAL_STATISTICSF ("Hash timings bytes %g bytes24 %g\n",
+                         elapsed_bytes, elapsed_bytes24);
+
+  sc_array_destroy (keys);
+  sc_array_destroy (tuples);
+  sc_array_destroy (strings);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  size_t              count, added, removed;
+  double              start, elapsed_chained, elapsed_open;
+  sc_array_t         *keys;
+  sc_mempool_t       *links;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef THEBIGTEST
+  count = 10000000;
+#else
+  count = 100000;
+#endif
+  keys = sc_array_new (sizeof (long));
+
+  test_keys (keys, count);
+  test_hash_array_batch (keys);
+  test_hash_array_batch_duplicates (200000, 2000);
+  start = -sc_MPI_Wtime ();
+  test_hash_chained (keys, NULL, &added, &removed);
+  elapsed_chained = start + sc_MPI_Wtime ();
+
+  /* tables sharing an allocator for sc_link_t do not cache hash values */
+  links = sc_mempool_new (sizeof (sc_link_t));
+  test_hash_chained (keys, links, &added, &removed);
+  SC_CHECK_ABORT (links->elem_count == 0, "Shared links");
+  sc_mempool_destroy (links);
+
+  start = -sc_MPI_Wtime ();
+  test_hash_open (keys, added, removed);
+  elapsed_open = start + sc_MPI_Wtime ();
+
+  SC_GLOBAL_STATISTICSF ("Hash timings chained %g open %g\n",
+                         elapsed_chained, elapsed_open);
+  test_hash_open_foreach (keys);
+  test_hash_array_freeze (SC_MIN (count, (size_t) 10007));
+  test_hash_functions (count);
+
+  sc_array_destroy (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_hash_sharded.h>
+
+/* #define THEBIGTEST */
+
+typedef struct test_sharded
+{
+  sc_hash_sharded_t  *hash;
+  sc_array_t         *keys;     /* the first unique entries are distinct */
+  size_t              unique;
+  size_t             *added;    /* one counter per thread */
+}
+test_sharded_t;
+
+static int
+test_equal_fn (const void *v1, const void *v2, const void *u)
+{
+  return *(const long *) v1 == *(const long *) v2;
+}
+
+/** Every thread inserts all keys, starting at a different offset. */
+static void
+test_insert (int thread_id, int num_threads, void *data)
+{
+  test_sharded_t     *ts = (test_sharded_t *) data;
+  const size_t        count = ts->keys->elem_count;
+  size_t              zz, i, added;
+  long               *key;
+  void               *found;
+
+  added = 0;
+  for (zz = 0; zz < count; ++zz) {
+    i = (zz + thread_id * (count / num_threads)) % count;
+    key = (long *) sc_array_index (ts->keys, i);
+    if (sc_hash_sharded_insert_unique (ts->hash, key, &found)) {
+      ++added;
+    }
+    SC_CHECK_ABORT (*(long *) found == *key, "Sharded insert");
+  }
+  ts->added[thread_id] = added;
+}
+
+/** The threads remove disjoint ranges of the distinct keys. */
+static void
+test_remove (int thread_id, int num_threads, void *data)
+{
+  test_sharded_t     *ts = (test_sharded_t *) data;
+  const size_t        count = ts->unique;
+  size_t              zz, removed;
+  long               *key;
+
+  removed = 0;
+  for (zz = thread_id * count / num_threads;
+       zz < (thread_id + 1) * count / num_threads; ++zz) {
+    key = (long *) sc_array_index (ts->keys, zz);
+    SC_CHECK_ABORT (sc_hash_sharded_lookup (ts->hash, key, NULL),
+                    "Sharded lookup");
+    if (sc_hash_sharded_remove (ts->hash, key, NULL)) {
+      ++removed;
+    }
+  }
+  ts->added[thread_id] = removed;
+}
+
+static int
+test_count_fn (void **v, const void *u)
+{
+  ++*(size_t *) u;
+  return 1;
+}
+
+static void
+test_run (sc_array_t * keys, size_t unique, int num_threads)
+{
+  int                 t;
+  size_t              total, visited;
+  double              elapsed_insert, elapsed_remove;
+  test_sharded_t      ts;
+
+  ts.keys = keys;
+  ts.unique = unique;
+  ts.added = SC_ALLOC (size_t, num_threads);
+  ts.hash = sc_hash_sharded_new (sc_hash_function_bytes8, test_equal_fn,
+                                 &visited, 0);
+
+  /* each thread attempts to insert every key */
+  elapsed_insert = -sc_MPI_Wtime ();
+  sc_thread_team_run (num_threads, test_insert, &ts);
+  elapsed_insert += sc_MPI_Wtime ();
+  for (t = 0, total = 0; t < num_threads; ++t) {
+    total += ts.added[t];
+  }
+  SC_CHECK_ABORT (total == unique, "Sharded unique");
+  SC_CHECK_ABORT (sc_hash_sharded_count (ts.hash) == unique, "Sharded count");
+  visited = 0;
+  sc_hash_sharded_foreach (ts.hash, test_count_fn);
+  SC_CHECK_ABORT (visited == unique, "Sharded foreach");
+  sc_hash_sharded_print_statistics (sc_package_id, SC_LP_STATISTICS, ts.hash);
+
+  /* the threads remove all keys */
+  elapsed_remove = -sc_MPI_Wtime ();
+  sc_thread_team_run (num_threads, test_remove, &ts);
+  elapsed_remove += sc_MPI_Wtime ();
+  for (t = 0, total = 0; t < num_threads; ++t) {
+    total += ts.added[t];
+  }
+  SC_CHECK_ABORT (total == unique, "Sharded removed");
+  SC_CHECK_ABORT (sc_hash_sharded_count (ts.hash) == 0, "Sharded empty");
+
+  SC_GLOBAL_STATISTICSF ("Sharded hash threads %d insert %g remove %g\n",
+                         num_threads, elapsed_insert, elapsed_remove);
+
+  sc_hash_sharded_destroy (ts.hash);
+  SC_FREE (ts.added);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_threads, max_threads;
+  size_t              zz, count, unique;
+  sc_array_t         *keys;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef THEBIGTEST
+  count = 4000000;
+#else
+  count = 40000;
+#endif
+  keys = sc_array_new_count (sizeof (long), count);
+  unique = count / 2;
+  for (zz = 0; zz < count; ++zz) {
+    *(long *) sc_array_index (keys, zz) = (long) (zz % unique);
+  }
+
+  /* measure the scaling from one thread to the default thread count */
+  max_threads = SC_MAX (sc_thread_max_threads (), 4);
+  for (num_threads = 1;; num_threads *= 2) {
+    num_threads = SC_MIN (num_threads, max_threads);
+    test_run (keys, unique, num_threads);
+    if (num_threads == max_threads) {
+      break;
+    }
+  }
+
+  sc_array_destroy (keys);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
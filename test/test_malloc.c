@@ -0,0 +1,368 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_arena.h>
+#include <sc_thread.h>
+
+/* #define THEBIGTEST */
+
+/** Number of blocks a thread holds at the same time. */
+#define TEST_MALLOC_BATCH 64
+
+typedef struct test_malloc
+{
+  int                 use_sc;   /**< sc_malloc family or plain malloc */
+  int                 package;  /**< package passed to sc_malloc */
+  int                 rounds;   /**< rounds of allocating a batch */
+  void              **blocks;   /**< TEST_MALLOC_BATCH blocks per thread */
+}
+test_malloc_t;
+
+/** Allocate and free batches of blocks of varying size. */
+static void
+test_malloc_fn (int thread_id, int num_threads, void *data)
+{
+  test_malloc_t      *tm = (test_malloc_t *) data;
+  void              **blocks = tm->blocks + thread_id * TEST_MALLOC_BATCH;
+  int                 r, i;
+  size_t              size;
+
+  for (r = 0; r < tm->rounds; ++r) {
+    for (i = 0; i < TEST_MALLOC_BATCH; ++i) {
+      size = (size_t) (16 + 8 * ((r + i * 7) % 61));
+      blocks[i] = tm->use_sc ? sc_malloc (tm->package, size) : malloc (size);
+      *(char *) blocks[i] = (char) i;
+    }
+    for (i = 0; i < TEST_MALLOC_BATCH; ++i) {
+      if (tm->use_sc) {
+        sc_free (tm->package, blocks[i]);
+      }
+      else {
+        free (blocks[i]);
+      }
+    }
+  }
+}
+
+/** Only allocate and leave the blocks to be checked and freed later. */
+static void
+test_alloc_fn (int thread_id, int num_threads, void *data)
+{
+  test_malloc_t      *tm = (test_malloc_t *) data;
+  void              **blocks = tm->blocks + thread_id * TEST_MALLOC_BATCH;
+  int                 i;
+
+  for (i = 0; i < TEST_MALLOC_BATCH; ++i) {
+    blocks[i] = i % 2 ? SC_ALLOC (int, i + 1) : SC_ALLOC_ZERO (int, i + 1);
+  }
+}
+
+static void
+test_free_fn (int thread_id, int num_threads, void *data)
+{
+  test_malloc_t      *tm = (test_malloc_t *) data;
+  void              **blocks = tm->blocks + thread_id * TEST_MALLOC_BATCH;
+  int                 i;
+
+  for (i = 0; i < TEST_MALLOC_BATCH; ++i) {
+    SC_FREE (blocks[i]);
+  }
+}
+
+/** Verify that concurrent allocations are counted exactly. */
+static void
+test_counts (int num_threads)
+{
+  int                 status;
+  test_malloc_t       held, churn;
+
+  status = sc_memory_status (sc_package_id);
+  held.blocks = (void **) malloc (sizeof (void *) * TEST_MALLOC_BATCH *
+                                  (size_t) num_threads);
+  churn.use_sc = 1;
+  churn.package = sc_package_id;
+  churn.rounds = 1000;
+  churn.blocks = (void **) malloc (sizeof (void *) * TEST_MALLOC_BATCH *
+                                   (size_t) num_threads);
+
+  sc_thread_team_run (num_threads, test_alloc_fn, &held);
+  SC_CHECK_ABORT (sc_memory_status (sc_package_id) ==
+                  status + num_threads * TEST_MALLOC_BATCH, "Alloc count");
+  sc_thread_team_run (num_threads, test_malloc_fn, &churn);
+  SC_CHECK_ABORT (sc_memory_status (sc_package_id) ==
+                  status + num_threads * TEST_MALLOC_BATCH, "Balance");
+  sc_thread_team_run (num_threads, test_free_fn, &held);
+  SC_CHECK_ABORT (sc_memory_status (sc_package_id) == status, "Free count");
+
+  free (churn.blocks);
+  free (held.blocks);
+}
+
+/** Verify the live and peak bytes of a separate package. */
+static void
+test_bytes (void)
+{
+  int                 package_id, i;
+  size_t              peak;
+  char               *blocks[10];
+
+  package_id = sc_package_register (NULL, SC_LP_DEFAULT, "test_malloc",
+                                    "Test memory tracking");
+  SC_CHECK_ABORT (sc_memory_bytes (package_id) == 0 &&
+                  sc_memory_bytes_peak (package_id) == 0, "Initial bytes");
+
+  for (i = 0; i < 10; ++i) {
+    blocks[i] = (char *) sc_malloc (package_id, 1000);
+  }
+  peak = sc_memory_bytes_peak (package_id);
+#ifdef SC_ENABLE_MEMTRACK
+  SC_CHECK_ABORT (sc_memory_bytes (package_id) >= 10000, "Live bytes");
+  SC_CHECK_ABORT (peak == sc_memory_bytes (package_id), "Peak bytes");
+#endif
+  for (i = 0; i < 5; ++i) {
+    sc_free (package_id, blocks[i]);
+  }
+  SC_CHECK_ABORT (sc_memory_bytes (package_id) <= peak / 2 + 100 &&
+                  sc_memory_bytes_peak (package_id) == peak, "Freed bytes");
+  for (i = 5; i < 10; ++i) {
+    blocks[i] = (char *) sc_realloc (package_id, blocks[i], 3000);
+  }
+#ifdef SC_ENABLE_MEMTRACK
+  SC_CHECK_ABORT (sc_memory_bytes (package_id) >= 15000, "Realloc bytes");
+  SC_CHECK_ABORT (sc_memory_bytes_peak (package_id) >= 15000, "Realloc peak");
+#endif
+  for (i = 5; i < 10; ++i) {
+    sc_free (package_id, blocks[i]);
+  }
+  SC_CHECK_ABORT (sc_memory_bytes (package_id) == 0, "Final bytes");
+
+  sc_package_print_summary (SC_LP_PRODUCTION);
+  sc_package_print_memory (SC_LP_PRODUCTION);
+  sc_package_unregister (package_id);
+}
+
+/** Allocate from two sites with a known ratio of volume and report. */
+static void
+test_memprof (void)
+{
+  int                 i;
+  char               *large, *small;
+
+  sc_memprof_set_interval (4096);
+  for (i = 0; i < 1000; ++i) {
+    large = SC_ALLOC (char, 3000);
+    small = SC_ALLOC_ZERO (char, 1000);
+    large = SC_REALLOC (large, char, 6000);
+    SC_FREE (small);
+    SC_FREE (large);
+  }
+  sc_memprof_report (SC_LP_PRODUCTION, 1);
+  sc_memprof_set_interval (512 * 1024);
+}
+
+/** A backend that counts the calls into the system allocator. */
+static void        *
+test_backend_alloc (size_t size, void *user)
+{
+  ++*(int *) user;
+  return malloc (size);
+}
+
+static void        *
+test_backend_realloc (void *ptr, size_t size, void *user)
+{
+  return realloc (ptr, size);
+}
+
+static void
+test_backend_free (void *ptr, void *user)
+{
+  --*(int *) user;
+  free (ptr);
+}
+
+/** Check the contents of blocks resized by the arena backend. */
+static void
+test_arena_fn (int thread_id, int num_threads, void *data)
+{
+  test_malloc_t      *tm = (test_malloc_t *) data;
+  int                 r, i;
+  size_t              size, zz;
+  unsigned char      *block;
+
+  for (r = 0; r < tm->rounds; ++r) {
+    /* sizes from a few bytes to beyond the largest class */
+    size = (size_t) 1 << (r % 19);
+    block = (unsigned char *) sc_malloc (tm->package, size);
+    for (zz = 0; zz < size; ++zz) {
+      block[zz] = (unsigned char) (zz + thread_id);
+    }
+    for (i = 0; i < 3; ++i) {
+      block = (unsigned char *) sc_realloc (tm->package, block,
+                                            size * (i + 2) / 2);
+      SC_CHECK_ABORT (sc_arena_size (block) >= size * (i + 2) / 2,
+                      "Arena size");
+      for (zz = 0; zz < size; ++zz) {
+        SC_CHECK_ABORT (block[zz] == (unsigned char) (zz + thread_id),
+                        "Arena realloc");
+      }
+    }
+    sc_free (tm->package, block);
+  }
+}
+
+/** Verify package and global backends and the reference arena. */
+static void
+test_backend (void)
+{
+  int                 package_id, calls = 0, i;
+  void               *blocks[10];
+  sc_alloc_backend_t  counting, arena_backend;
+  sc_arena_t         *arena;
+  test_malloc_t       tm;
+
+  package_id = sc_package_register (NULL, SC_LP_DEFAULT, "test_backend",
+                                    "Test allocator backends");
+  counting.alloc = test_backend_alloc;
+  counting.realloc = test_backend_realloc;
+  counting.free = test_backend_free;
+  counting.size = NULL;
+  counting.user = &calls;
+
+  /* a package backend overrides the global one */
+  arena = sc_arena_new ();
+  sc_arena_backend (arena, &arena_backend);
+  sc_set_alloc_backend (&arena_backend);
+  sc_package_set_alloc_backend (package_id, &counting);
+  for (i = 0; i < 10; ++i) {
+    blocks[i] = sc_calloc (package_id, 10, 10);
+    SC_CHECK_ABORT (((char *) blocks[i])[99] == 0, "Backend calloc");
+  }
+  SC_CHECK_ABORT (calls == 10 && sc_memory_status (package_id) == 10,
+                  "Backend alloc");
+  for (i = 0; i < 10; ++i) {
+    blocks[i] = sc_realloc (package_id, blocks[i], 1000);
+    sc_free (package_id, blocks[i]);
+  }
+  SC_CHECK_ABORT (calls == 0 && sc_memory_status (package_id) == 0,
+                  "Backend free");
+
+  /* without its own backend the package uses the global one */
+  sc_package_set_alloc_backend (package_id, NULL);
+  tm.package = package_id;
+  tm.rounds = 200;
+  sc_thread_team_run (sc_thread_max_threads (), test_arena_fn, &tm);
+  SC_CHECK_ABORT (sc_memory_status (package_id) == 0, "Arena balance");
+
+  /* threads that exit return their caches to the arena */
+  sc_thread_team_run (4, test_arena_fn, &tm);
+  sc_thread_team_run (4, test_arena_fn, &tm);
+  SC_CHECK_ABORT (sc_memory_status (package_id) == 0, "Arena exit balance");
+  SC_CHECK_ABORT (sc_arena_memory_used (arena) > 0, "Arena memory");
+  sc_set_alloc_backend (NULL);
+
+  sc_arena_destroy (arena);
+  sc_package_unregister (package_id);
+}
+
+/** Measure the allocation throughput for increasing thread counts. */
+static void
+test_benchmark (int rounds)
+{
+  int                 num_threads, max_threads;
+  double              elapsed_sc, elapsed_libc, elapsed_arena, ops;
+  sc_alloc_backend_t  backend;
+  sc_arena_t         *arena;
+  test_malloc_t       tm;
+
+  max_threads = sc_thread_max_threads ();
+  arena = sc_arena_new ();
+  sc_arena_backend (arena, &backend);
+  tm.package = sc_package_register (NULL, SC_LP_DEFAULT, "test_bench",
+                                    "Test allocation benchmark");
+  tm.rounds = rounds;
+  tm.blocks = (void **) malloc (sizeof (void *) * TEST_MALLOC_BATCH *
+                                (size_t) max_threads);
+  for (num_threads = 1;; num_threads = SC_MIN (2 * num_threads,
+                                               max_threads)) {
+    tm.use_sc = 0;
+    elapsed_libc = -sc_MPI_Wtime ();
+    sc_thread_team_run (num_threads, test_malloc_fn, &tm);
+    elapsed_libc += sc_MPI_Wtime ();
+
+    tm.use_sc = 1;
+    elapsed_sc = -sc_MPI_Wtime ();
+    sc_thread_team_run (num_threads, test_malloc_fn, &tm);
+    elapsed_sc += sc_MPI_Wtime ();
+
+    sc_package_set_alloc_backend (tm.package, &backend);
+    elapsed_arena = -sc_MPI_Wtime ();
+    sc_thread_team_run (num_threads, test_malloc_fn, &tm);
+    elapsed_arena += sc_MPI_Wtime ();
+    sc_package_set_alloc_backend (tm.package, NULL);
+
+    ops = 2. * TEST_MALLOC_BATCH * rounds * num_threads;
+    SC_GLOBAL_STATISTICSF ("Benchmark threads %d malloc/free"
+                           " %.3g Mop/s arena %.3g Mop/s libc %.3g Mop/s\n",
+                           num_threads, 1e-6 * ops / elapsed_sc,
+                           1e-6 * ops / elapsed_arena,
+                           1e-6 * ops / elapsed_libc);
+    if (num_threads == max_threads) {
+      break;
+    }
+  }
+  sc_package_unregister (tm.package);
+  sc_arena_destroy (arena);
+  free (tm.blocks);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_threads;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+  for (num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    test_counts (num_threads);
+  }
+  test_bytes ();
+  test_memprof ();
+  test_backend ();
+#ifdef THEBIGTEST
+  test_benchmark (100000);
+#else
+  test_benchmark (10000);
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
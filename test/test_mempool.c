@@ -0,0 +1,344 @@
+/*
+  This file is part of the SC Library.
+  The SC Library provides support for parallel scientific applications.
+
+  Copyright (C) 2010 The University of Texas System
+  Additional copyright (C) 2011 individual authors
+
+  The SC Library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  The SC Library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with the SC Library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include <sc_containers.h>
+#include <sc_thread.h>
+
+/* #define THEBIGTEST */
+
+typedef struct test_pool
+{
+  sc_mempool_t       *mempool;
+  size_t              per_thread;
+  void              **elems;    /* per_thread entries per thread */
+}
+test_pool_t;
+
+static void
+test_mempool_serial (size_t count)
+{
+  size_t              zz;
+  int                *p;
+  sc_mempool_t       *mempool;
+  sc_array_t         *elems;
+
+  mempool = sc_mempool_new (sizeof (int));
+  elems = sc_array_new_count (sizeof (int *), count);
+  for (zz = 0; zz < count; ++zz) {
+    p = (int *) sc_mempool_alloc (mempool);
+    *p = (int) zz;
+    *(int **) sc_array_index (elems, zz) = p;
+  }
+  SC_CHECK_ABORT (mempool->elem_count == count, "Mempool count");
+  for (zz = 0; zz < count; zz += 2) {
+    p = *(int **) sc_array_index (elems, zz);
+    SC_CHECK_ABORT (*p == (int) zz, "Mempool content");
+    sc_mempool_free (mempool, p);
+  }
+  SC_CHECK_ABORT (mempool->elem_count == count / 2, "Mempool free");
+  sc_mempool_print_statistics (sc_package_id, SC_LP_STATISTICS, mempool);
+
+  sc_array_destroy (elems);
+  sc_mempool_destroy (mempool);
+}
+
+static void
+test_mempool_bulk (size_t count, int intrusive)
+{
+  size_t              zz, half;
+  double              elapsed_single, elapsed_bulk;
+  void              **elems;
+  sc_mempool_t       *mempool;
+
+  mempool = intrusive ? sc_mempool_new_intrusive (sizeof (size_t)) :
+    sc_mempool_new (sizeof (size_t));
+  SC_CHECK_ABORT (mempool->intrusive == intrusive, "Mempool intrusive");
+  elems = SC_ALLOC (void *, 2 * count);
+
+  /* allocate and free one element at a time */
+  elapsed_single = -sc_MPI_Wtime ();
+  for (zz = 0; zz < count; ++zz) {
+    elems[zz] = sc_mempool_alloc (mempool);
+  }
+  for (zz = 0; zz < count; ++zz) {
+    sc_mempool_free (mempool, elems[zz]);
+  }
+  elapsed_single += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (mempool->elem_count == 0, "Mempool single");
+
+  /* the same in bulk from a fresh pool */
+  sc_mempool_truncate (mempool);
+  elapsed_bulk = -sc_MPI_Wtime ();
+  sc_mempool_alloc_n (mempool, count, elems);
+  sc_mempool_free_n (mempool, count, elems);
+  elapsed_bulk += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (mempool->elem_count == 0, "Mempool bulk");
+
+  /* recycle the freed elements and take the rest from the stamps */
+  half = count / 2;
+  sc_mempool_alloc_n (mempool, half, elems);
+  sc_mempool_alloc_n (mempool, 2 * count - half, elems + half);
+  SC_CHECK_ABORT (mempool->elem_count == 2 * count, "Mempool bulk count");
+
+  /* the elements must be distinct */
+  for (zz = 0; zz < 2 * count; ++zz) {
+    *(size_t *) elems[zz] = zz;
+  }
+  for (zz = 0; zz < 2 * count; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) elems[zz] == zz, "Mempool distinct");
+  }
+
+  /* the bulk and single calls may be mixed */
+  sc_mempool_free_n (mempool, count, elems);
+  for (zz = count; zz < 2 * count; ++zz) {
+    sc_mempool_free (mempool, elems[zz]);
+  }
+  SC_CHECK_ABORT (mempool->elem_count == 0, "Mempool mixed");
+  sc_mempool_alloc_n (mempool, count, elems);
+  for (zz = 0; zz < count; ++zz) {
+    *(size_t *) elems[zz] = zz;
+    elems[count + zz] = sc_mempool_alloc (mempool);
+    *(size_t *) elems[count + zz] = count + zz;
+  }
+  for (zz = 0; zz < 2 * count; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) elems[zz] == zz, "Mempool mixed distinct");
+  }
+  sc_mempool_print_statistics (sc_package_id, SC_LP_STATISTICS, mempool);
+  SC_GLOBAL_STATISTICSF ("Mempool intrusive %d single %g bulk %g\n",
+                         intrusive, elapsed_single, elapsed_bulk);
+
+  SC_FREE (elems);
+  sc_mempool_destroy (mempool);
+}
+
+/** Update the pointer to an element after it has been moved. */
+static void
+test_relocate (void *from, void *to, void *user_data)
+{
+  size_t              id = *(size_t *) to;
+  void              **elems = (void **) user_data;
+
+  SC_CHECK_ABORT (elems[id] == from, "Mempool relocate");
+  elems[id] = to;
+}
+
+static void
+test_mempool_compact (size_t count, int intrusive, int threads)
+{
+  size_t              zz, live, before, released;
+  void              **elems;
+  sc_mempool_t       *mempool;
+
+  mempool = threads ? sc_mempool_new_threads (sizeof (size_t), 1) :
+    intrusive ? sc_mempool_new_intrusive (sizeof (size_t)) :
+    sc_mempool_new (sizeof (size_t));
+  elems = SC_ALLOC (void *, count);
+  for (zz = 0; zz < count; ++zz) {
+    elems[zz] = threads ? sc_mempool_alloc_thread (mempool, 0) :
+      sc_mempool_alloc (mempool);
+    *(size_t *) elems[zz] = zz;
+  }
+
+  /* free the first half entirely, then all but every tenth element */
+  for (zz = 0, live = 0; zz < count; ++zz) {
+    if (zz < count / 2 || zz % 10 != 0) {
+      if (threads) {
+        sc_mempool_free_thread (mempool, 0, elems[zz]);
+      }
+      else {
+        sc_mempool_free (mempool, elems[zz]);
+      }
+      elems[zz] = NULL;
+    }
+    else {
+      ++live;
+    }
+  }
+  SC_CHECK_ABORT (sc_mempool_count_threads (mempool) == live,
+                  "Mempool compact count");
+
+  /* release the empty stamps without moving any element */
+  before = sc_mempool_memory_used (mempool);
+  released = sc_mempool_compact (mempool, NULL, NULL);
+  SC_CHECK_ABORT (released > 0 || count < 4096, "Mempool compact free");
+
+  /* move the remaining elements together */
+  released += sc_mempool_compact (mempool, test_relocate, elems);
+  SC_CHECK_ABORT (sc_mempool_memory_used (mempool) < before,
+                  "Mempool compact memory");
+  for (zz = 0; zz < count; ++zz) {
+    SC_CHECK_ABORT (elems[zz] == NULL || *(size_t *) elems[zz] == zz,
+                    "Mempool compact content");
+  }
+  SC_GLOBAL_STATISTICSF ("Mempool compact live %lu released %lu\n",
+                         (unsigned long) live, (unsigned long) released);
+
+  /* the pool remains usable */
+  for (zz = 0; zz < count; ++zz) {
+    if (elems[zz] == NULL) {
+      elems[zz] = threads ? sc_mempool_alloc_thread (mempool, 0) :
+        sc_mempool_alloc (mempool);
+      *(size_t *) elems[zz] = zz;
+    }
+  }
+  for (zz = 0; zz < count; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) elems[zz] == zz, "Mempool compact reuse");
+  }
+  SC_CHECK_ABORT (sc_mempool_count_threads (mempool) == count,
+                  "Mempool compact recount");
+
+  SC_FREE (elems);
+  sc_mempool_destroy (mempool);
+}
+
+/** Every thread allocates its elements and writes their positions. */
+static void
+test_alloc (int thread_id, int num_threads, void *data)
+{
+  test_pool_t        *tp = (test_pool_t *) data;
+  size_t              zz, offset;
+  size_t             *p;
+
+  offset = thread_id * tp->per_thread;
+  for (zz = offset; zz < offset + tp->per_thread; ++zz) {
+    p = (size_t *) sc_mempool_alloc_thread (tp->mempool, thread_id);
+    *p = zz;
+    tp->elems[zz] = p;
+  }
+}
+
+/** Every thread frees the elements allocated by its neighbor. */
+static void
+test_free (int thread_id, int num_threads, void *data)
+{
+  test_pool_t        *tp = (test_pool_t *) data;
+  size_t              zz, offset;
+
+  offset = ((thread_id + 1) % num_threads) * tp->per_thread;
+  for (zz = offset; zz < offset + tp->per_thread; ++zz) {
+    SC_CHECK_ABORT (*(size_t *) tp->elems[zz] == zz, "Mempool thread");
+    sc_mempool_free_thread (tp->mempool, thread_id, tp->elems[zz]);
+  }
+}
+
+/** Every thread repeatedly allocates and frees a small working set. */
+static void
+test_churn (int thread_id, int num_threads, void *data)
+{
+  test_pool_t        *tp = (test_pool_t *) data;
+  size_t              zz, round;
+  void              **elems = tp->elems + thread_id * tp->per_thread;
+
+  for (round = 0; round < 16; ++round) {
+    for (zz = 0; zz < tp->per_thread; ++zz) {
+      elems[zz] = sc_mempool_alloc_thread (tp->mempool, thread_id);
+    }
+    for (zz = 0; zz < tp->per_thread; ++zz) {
+      sc_mempool_free_thread (tp->mempool, thread_id, elems[zz]);
+    }
+  }
+}
+
+static void
+test_mempool_threads (size_t per_thread, int num_threads)
+{
+  size_t              count;
+  double              elapsed_cross, elapsed_churn;
+  test_pool_t         tp;
+
+  count = per_thread * num_threads;
+  tp.mempool = sc_mempool_new_threads (sizeof (size_t), num_threads);
+  tp.per_thread = per_thread;
+  tp.elems = SC_ALLOC (void *, count);
+
+  /* allocate on one thread and free on another */
+  elapsed_cross = -sc_MPI_Wtime ();
+  sc_thread_team_run (num_threads, test_alloc, &tp);
+  SC_CHECK_ABORT (sc_mempool_count_threads (tp.mempool) == count,
+                  "Mempool thread count");
+  sc_thread_team_run (num_threads, test_free, &tp);
+  elapsed_cross += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (sc_mempool_count_threads (tp.mempool) == 0,
+                  "Mempool thread empty");
+
+  /* the elements are recycled through the thread caches */
+  elapsed_churn = -sc_MPI_Wtime ();
+  sc_thread_team_run (num_threads, test_churn, &tp);
+  elapsed_churn += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (sc_mempool_count_threads (tp.mempool) == 0,
+                  "Mempool thread churn");
+
+  sc_mempool_print_statistics (sc_package_id, SC_LP_STATISTICS, tp.mempool);
+  SC_GLOBAL_STATISTICSF ("Mempool threads %d cross %g churn %g\n",
+                         num_threads, elapsed_cross, elapsed_churn);
+
+  /* the pool can be reused after truncation */
+  sc_mempool_truncate (tp.mempool);
+  sc_thread_team_run (num_threads, test_alloc, &tp);
+  SC_CHECK_ABORT (sc_mempool_count_threads (tp.mempool) == count,
+                  "Mempool thread truncate");
+
+  SC_FREE (tp.elems);
+  sc_mempool_destroy (tp.mempool);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 num_threads, max_threads;
+  size_t              count;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_DEFAULT);
+
+#ifdef THEBIGTEST
+  count = 1000000;
+#else
+  count = 10000;
+#endif
+  test_mempool_serial (count);
+  test_mempool_bulk (count, 0);
+  test_mempool_bulk (count, 1);
+  test_mempool_compact (count, 0, 0);
+  test_mempool_compact (count, 1, 0);
+  test_mempool_compact (count, 0, 1);
+
+  max_threads = SC_MAX (sc_thread_max_threads (), 4);
+  for (num_threads = 1;; num_threads *= 2) {
+    num_threads = SC_MIN (num_threads, max_threads);
+    test_mempool_threads (count, num_threads);
+    if (num_threads == max_threads) {
+      break;
+    }
+  }
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -34,6 +34,191 @@ compar (const void *p1, const void *p2)
   return i1 - i2;
 }
 
+/** A node of a graph search whose key may be decreased. */
+typedef struct test_node
+{
+  int                 key;
+  int                 id;
+}
+test_node_t;
+
+static int
+test_node_compar (const void *p1, const void *p2)
+{
+  const test_node_t  *n1 = (const test_node_t *) p1;
+  const test_node_t  *n2 = (const test_node_t *) p2;
+
+  return n1->key - n2->key;
+}
+
+/** Verify the heap order and the consistency of the handles. */
+static void
+test_dheap_check (sc_dheap_t * heap)
+{
+  size_t              zz, handle;
+
+  for (zz = 1; zz < sc_dheap_count (heap); ++zz) {
+    SC_CHECK_ABORT (heap->compar (sc_array_index (&heap->elems, zz),
+                                  sc_array_index (&heap->elems,
+                                                  (zz - 1) / heap->arity))
+                    >= 0, "dheap order");
+  }
+  for (zz = 0; zz < sc_dheap_count (heap); ++zz) {
+    handle = *(size_t *) sc_array_index (&heap->handles, zz);
+    SC_CHECK_ABORT (sc_dheap_contains (heap, handle) &&
+                    sc_dheap_lookup (heap, handle) ==
+                    sc_array_index (&heap->elems, zz), "dheap handle");
+  }
+}
+
+/** Run a graph-search-like workload with decrease-key and check it. */
+static void
+test_dheap (int count, size_t arity)
+{
+  int                 i, last;
+  size_t              zz, handle, *handles;
+  test_node_t         node, *pn;
+  sc_array_t         *a, *out;
+  sc_dheap_t         *heap;
+
+  /* push nodes and decrease the keys of some */
+  heap = sc_dheap_new (sizeof (test_node_t), arity, test_node_compar);
+  handles = SC_ALLOC (size_t, count);
+  for (i = 0; i < count; ++i) {
+    node.key = (int) ((7919 * (long) i) % 100003);
+    node.id = i;
+    handles[i] = sc_dheap_push (heap, &node);
+  }
+  test_dheap_check (heap);
+  for (i = 0; i < count; i += 3) {
+    node = *(test_node_t *) sc_dheap_lookup (heap, handles[i]);
+    SC_CHECK_ABORT (node.id == i, "dheap lookup");
+    node.key -= (int) ((31 * (long) i) % 1000);
+    sc_dheap_update (heap, handles[i], &node);
+  }
+  for (i = 1; i < count; i += 7) {
+    node = *(test_node_t *) sc_dheap_lookup (heap, handles[i]);
+    node.key += 500;
+    sc_dheap_update (heap, handles[i], &node);
+  }
+  test_dheap_check (heap);
+
+  /* pop half and the rest at once, and check the handles */
+  out = sc_array_new (sizeof (test_node_t));
+  last = -1000;
+  for (i = 0; i < count / 2; ++i) {
+    pn = (test_node_t *) sc_dheap_top (heap, &handle);
+    SC_CHECK_ABORT (handle == handles[pn->id], "dheap top");
+    handle = sc_dheap_pop (heap, &node);
+    SC_CHECK_ABORT (handle == handles[node.id], "dheap pop handle");
+    SC_CHECK_ABORT (!sc_dheap_contains (heap, handle), "dheap contains");
+    SC_CHECK_ABORT (node.key >= last, "dheap pop order");
+    last = node.key;
+  }
+  test_dheap_check (heap);
+  zz = sc_dheap_pop_n (heap, (size_t) count, out);
+  SC_CHECK_ABORT (zz == (size_t) (count - count / 2), "dheap pop all");
+  SC_CHECK_ABORT (sc_dheap_count (heap) == 0, "dheap empty");
+  for (zz = 0; zz < out->elem_count; ++zz) {
+    pn = (test_node_t *) sc_array_index (out, zz);
+    SC_CHECK_ABORT (pn->key >= last, "dheap pop all order");
+    last = pn->key;
+  }
+  sc_dheap_destroy (heap);
+
+  /* heapify an array and pop it in chunks */
+  a = sc_array_new_count (sizeof (test_node_t), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    pn = (test_node_t *) sc_array_index_int (a, i);
+    pn->key = (int) ((104729 * (long) i) % 1009);
+    pn->id = i;
+  }
+  heap = sc_dheap_new_array (a, arity, test_node_compar);
+  test_dheap_check (heap);
+  sc_array_sort (a, test_node_compar);
+  sc_array_reset (out);
+  while (sc_dheap_count (heap) > 0) {
+    zz = sc_dheap_pop_n (heap, 100, out);
+    test_dheap_check (heap);
+  }
+  SC_CHECK_ABORT (out->elem_count == (size_t) count, "dheap chunks");
+  for (zz = 0; zz < out->elem_count; ++zz) {
+    SC_CHECK_ABORT (test_node_compar (sc_array_index (out, zz),
+                                      sc_array_index (a, zz)) == 0,
+                    "dheap chunk order");
+  }
+
+  /* handles are reused */
+  node.key = 0;
+  node.id = 0;
+  handle = sc_dheap_push (heap, &node);
+  SC_CHECK_ABORT (handle < (size_t) count, "dheap handle reuse");
+  sc_dheap_destroy (heap);
+
+  sc_array_destroy (out);
+  sc_array_destroy (a);
+  SC_FREE (handles);
+}
+
+/** Compare the timings of the binary pqueue and of the d-ary heaps. */
+static void
+test_benchmark (int count)
+{
+  int                 i, temp, value;
+  size_t              arity;
+  double              elapsed_add, elapsed_pop, elapsed_heapify;
+  sc_array_t         *a, *b;
+  sc_dheap_t         *heap;
+
+  a = sc_array_new (sizeof (int));
+  b = sc_array_new_count (sizeof (int), (size_t) count);
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_index_int (b, i) =
+      (int) ((1103515245 * (long) i + 12345) % 1000003);
+  }
+
+  elapsed_add = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    *(int *) sc_array_push (a) = *(int *) sc_array_index_int (b, i);
+    sc_array_pqueue_add (a, &temp, compar);
+  }
+  elapsed_add += sc_MPI_Wtime ();
+  elapsed_pop = -sc_MPI_Wtime ();
+  for (i = 0; i < count; ++i) {
+    sc_array_pqueue_pop (a, &value, compar);
+  }
+  elapsed_pop += sc_MPI_Wtime ();
+  SC_GLOBAL_STATISTICSF ("Benchmark count %d pqueue add %g pop %g\n",
+                         count, elapsed_add, elapsed_pop);
+
+  for (arity = 2; arity <= 8; arity *= 2) {
+    heap = sc_dheap_new (sizeof (int), arity, compar);
+    elapsed_add = -sc_MPI_Wtime ();
+    for (i = 0; i < count; ++i) {
+      sc_dheap_push (heap, sc_array_index_int (b, i));
+    }
+    elapsed_add += sc_MPI_Wtime ();
+    elapsed_pop = -sc_MPI_Wtime ();
+    for (i = 0; i < count; ++i) {
+      sc_dheap_pop (heap, &value);
+    }
+    elapsed_pop += sc_MPI_Wtime ();
+    sc_dheap_destroy (heap);
+
+    elapsed_heapify = -sc_MPI_Wtime ();
+    heap = sc_dheap_new_array (b, arity, compar);
+    elapsed_heapify += sc_MPI_Wtime ();
+    sc_dheap_destroy (heap);
+
+    SC_GLOBAL_STATISTICSF ("Benchmark count %d dheap %d push %g pop %g"
+                           " heapify %g\n", count, (int) arity,
+                           elapsed_add, elapsed_pop, elapsed_heapify);
+  }
+
+  sc_array_destroy (b);
+  sc_array_destroy (a);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -147,6 +332,17 @@ main (int argc, char **argv)
                   elapsed_pqueue, 3. * elapsed_qsort);
 
   sc_array_destroy (a4);
+
+  test_dheap (1, 0);
+  test_dheap (count, 2);
+  test_dheap (count, 0);
+  test_dheap (count, 7);
+#ifdef THEBIGTEST
+  test_benchmark (10000000);
+#else
+  test_benchmark (200000);
+#endif
+
   sc_finalize ();
 
   mpiret = sc_MPI_Finalize ();
@@ -23,6 +23,145 @@
 
 #include <sc_search.h>
 
+/* #define THEBIGTEST */
+
+static uint64_t
+test_random (uint64_t * state)
+{
+  /* xorshift64* */
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 2685821657736338717ULL;
+}
+
+/** Compare the search index with the binary searches on the plain array. */
+static void
+test_index (size_t nmemb, size_t num_queries)
+{
+  size_t              zz;
+  uint64_t            state = 0x2545F4914F6CDD1DULL;
+  int64_t            *targets;
+  ssize_t            *expected, *positions;
+  double              elapsed_plain, elapsed_index, elapsed_batch;
+  double              elapsed_generic;
+  sc_array_t         *a;
+  sc_search_index_t  *index, *generic;
+
+  /* a sorted array with duplicates and gaps */
+  a = sc_array_new_count (sizeof (int64_t), nmemb);
+  for (zz = 0; zz < nmemb; ++zz) {
+    *(int64_t *) sc_array_index (a, zz) =
+      (int64_t) (test_random (&state) % (2 * nmemb + 1)) - (int64_t) nmemb;
+  }
+  sc_array_sort (a, sc_int64_compare);
+  targets = SC_ALLOC (int64_t, num_queries);
+  for (zz = 0; zz < num_queries; ++zz) {
+    targets[zz] =
+      (int64_t) (test_random (&state) % (2 * nmemb + 5)) -
+      (int64_t) nmemb - 2;
+  }
+  expected = SC_ALLOC (ssize_t, num_queries);
+  positions = SC_ALLOC (ssize_t, num_queries);
+
+  elapsed_plain = -sc_MPI_Wtime ();
+  for (zz = 0; zz < num_queries; ++zz) {
+    expected[zz] = sc_search_lower_bound64
+      (targets[zz], (const int64_t *) a->array, nmemb, nmemb / 2);
+  }
+  elapsed_plain += sc_MPI_Wtime ();
+
+  index = sc_search_index_new64 ((const int64_t *) a->array, nmemb);
+  elapsed_index = -sc_MPI_Wtime ();
+  for (zz = 0; zz < num_queries; ++zz) {
+    positions[zz] = sc_search_index_lower_bound64 (index, targets[zz]);
+  }
+  elapsed_index += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (positions, expected,
+                           num_queries * sizeof (ssize_t)), "Index64");
+
+  memset (positions, 0, num_queries * sizeof (ssize_t));
+  elapsed_batch = -sc_MPI_Wtime ();
+  sc_search_index_lower_bound64_batch (index, targets, num_queries,
+                                       positions);
+  elapsed_batch += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (positions, expected,
+                           num_queries * sizeof (ssize_t)), "Batch64");
+  sc_search_index_destroy (index);
+
+  /* the generic index copies the array */
+  generic = sc_search_index_new (a, sc_int64_compare);
+  sc_array_reset (a);
+  elapsed_generic = -sc_MPI_Wtime ();
+  for (zz = 0; zz < num_queries; ++zz) {
+    positions[zz] = sc_search_index_lower_bound (generic, targets + zz);
+  }
+  elapsed_generic += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (!memcmp (positions, expected,
+                           num_queries * sizeof (ssize_t)), "Index");
+  memset (positions, 0, num_queries * sizeof (ssize_t));
+  sc_search_index_lower_bound_batch (generic, targets, num_queries,
+                                     positions);
+  SC_CHECK_ABORT (!memcmp (positions, expected,
+                           num_queries * sizeof (ssize_t)), "Batch");
+  sc_search_index_destroy (generic);
+
+  SC_GLOBAL_STATISTICSF ("Search count %lu queries %lu binary %g index %g"
+                         " batch %g generic %g\n", (unsigned long) nmemb,
+                         (unsigned long) num_queries, elapsed_plain,
+                         elapsed_index, elapsed_batch, elapsed_generic);
+
+  SC_FREE (positions);
+  SC_FREE (expected);
+  SC_FREE (targets);
+  sc_array_destroy (a);
+}
+
+/** Compare two elements that are pointers to strings. */
+static int
+test_string_compare (const void *v1, const void *v2)
+{
+  return strcmp (*(const char *const *) v1, *(const char *const *) v2);
+}
+
+/** The comparison never sees the sentinel of an incomplete last level. */
+static void
+test_index_strings (void)
+{
+  const char         *words[] = { "ant", "bee", "cat", "dog", "eel",
+    "fox", "gnu", "hen", "ibis"
+  };
+  const char         *keys[] = { "", "a", "bee", "cow", "ewe", "hen",
+    "ibis", "jay", "zz"
+  };
+  const size_t        num_words = sizeof (words) / sizeof (words[0]);
+  const size_t        num_keys = sizeof (keys) / sizeof (keys[0]);
+  size_t              nmemb, zk, zz;
+  ssize_t             expected, positions[sizeof (keys) / sizeof (keys[0])];
+  sc_array_t         *a;
+  sc_search_index_t  *index;
+
+  for (nmemb = 0; nmemb <= num_words; ++nmemb) {
+    a = sc_array_new_data ((void *) words, sizeof (const char *), nmemb);
+    index = sc_search_index_new (a, test_string_compare);
+    sc_search_index_lower_bound_batch (index, keys, num_keys, positions);
+    for (zk = 0; zk < num_keys; ++zk) {
+      expected = -1;
+      for (zz = 0; zz < nmemb; ++zz) {
+        if (strcmp (words[zz], keys[zk]) >= 0) {
+          expected = (ssize_t) zz;
+          break;
+        }
+      }
+      SC_CHECK_ABORT (sc_search_index_lower_bound (index, keys + zk) ==
+                      expected, "String index");
+      SC_CHECK_ABORT (positions[zk] == expected, "String batch");
+    }
+    sc_search_index_destroy (index);
+    sc_array_destroy (a);
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -30,12 +169,15 @@ main (int argc, char **argv)
   int                 mpirank, mpisize;
   int                 maxlevel, level, target;
   int                 i, position;
+  size_t              nmemb;
   sc_MPI_Comm         mpicomm;
 
   mpiret = sc_MPI_Init (&argc, &argv);
   SC_CHECK_MPI (mpiret);
 
   mpicomm = sc_MPI_COMM_WORLD;
+  sc_init (mpicomm, 1, 1, NULL, SC_LP_DEFAULT);
+
   mpiret = sc_MPI_Comm_size (mpicomm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (mpicomm, &mpirank);
@@ -56,6 +198,18 @@ main (int argc, char **argv)
     }
   }
 
+  for (nmemb = 0; nmemb < 40; ++nmemb) {
+    test_index (nmemb, 100);
+  }
+  test_index_strings ();
+#ifdef THEBIGTEST
+  test_index ((size_t) 1 << 26, (size_t) 1 << 24);
+#else
+  test_index ((size_t) 1 << 22, (size_t) 1 << 20);
+#endif
+
+  sc_finalize ();
+
   mpiret = sc_MPI_Finalize ();
   SC_CHECK_MPI (mpiret);
 